@@ -406,9 +406,68 @@ static void linphone_create_call_log_table(sqlite3* db) {
 	}
 }
 
+/*
+ * Addresses are matched on their username and domain only, so that the display name and the uri parameters
+ * do not prevent to use the indexes.
+ */
+static char *linphone_call_log_address_key(const LinphoneAddress *addr) {
+	const char *username;
+	const char *domain;
+
+	if (!addr) return NULL;
+	username = linphone_address_get_username(addr);
+	domain = linphone_address_get_domain(addr);
+	return ms_strdup_printf("%s@%s", username ? username : "", domain ? domain : "");
+}
+
+static void linphone_call_log_get_address_keys(LinphoneCallDir dir, const LinphoneAddress *from, const LinphoneAddress *to, char **remote_key, char **local_key) {
+	*remote_key = linphone_call_log_address_key(dir == LinphoneCallOutgoing ? to : from);
+	*local_key = linphone_call_log_address_key(dir == LinphoneCallOutgoing ? from : to);
+}
+
+static void linphone_fill_call_log_address_keys(sqlite3 *db) {
+	sqlite3_stmt *select_stmt = NULL;
+	sqlite3_stmt *update_stmt = NULL;
+	int count = 0;
+
+	if (sqlite3_prepare_v2(db, "SELECT id, caller, callee, direction FROM call_history WHERE remote_key IS NULL OR local_key IS NULL;", -1, &select_stmt, NULL) != SQLITE_OK
+		|| sqlite3_prepare_v2(db, "UPDATE call_history SET remote_key = ?, local_key = ? WHERE id = ?;", -1, &update_stmt, NULL) != SQLITE_OK) {
+		ms_error("Unable to fill call_history address keys: %s.", sqlite3_errmsg(db));
+		sqlite3_finalize(select_stmt);
+		sqlite3_finalize(update_stmt);
+		return;
+	}
+
+	sqlite3_exec(db, "BEGIN TRANSACTION;", NULL, NULL, NULL);
+	while (sqlite3_step(select_stmt) == SQLITE_ROW) {
+		LinphoneAddress *from = linphone_address_new((const char *)sqlite3_column_text(select_stmt, 1));
+		LinphoneAddress *to = linphone_address_new((const char *)sqlite3_column_text(select_stmt, 2));
+		char *remote_key = NULL;
+		char *local_key = NULL;
+
+		linphone_call_log_get_address_keys((LinphoneCallDir)sqlite3_column_int(select_stmt, 3), from, to, &remote_key, &local_key);
+		sqlite3_bind_text(update_stmt, 1, remote_key, -1, SQLITE_TRANSIENT);
+		sqlite3_bind_text(update_stmt, 2, local_key, -1, SQLITE_TRANSIENT);
+		sqlite3_bind_int64(update_stmt, 3, sqlite3_column_int64(select_stmt, 0));
+		if (sqlite3_step(update_stmt) == SQLITE_DONE) count++;
+		sqlite3_reset(update_stmt);
+
+		if (remote_key) ms_free(remote_key);
+		if (local_key) ms_free(local_key);
+		if (from) linphone_address_unref(from);
+		if (to) linphone_address_unref(to);
+	}
+	sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL);
+
+	sqlite3_finalize(select_stmt);
+	sqlite3_finalize(update_stmt);
+	ms_message("Filled address keys of %i call logs.", count);
+}
+
 static void linphone_update_call_log_table(sqlite3* db) {
 	char* errmsg=NULL;
 	int ret;
+	bool_t keys_added = FALSE;
 
 	// for image url storage
 	ret=sqlite3_exec(db,"ALTER TABLE call_history ADD COLUMN call_id TEXT;",NULL,NULL,&errmsg);
@@ -424,6 +483,36 @@ static void linphone_update_call_log_table(sqlite3* db) {
 			ms_debug("Table call_history updated successfully for call_id and refkey.");
 		}
 	}
+
+	// for indexed lookups by remote and local address
+	ret=sqlite3_exec(db,"ALTER TABLE call_history ADD COLUMN remote_key TEXT;",NULL,NULL,&errmsg);
+	if(ret != SQLITE_OK) {
+		ms_message("Table already up to date: %s.", errmsg);
+		sqlite3_free(errmsg);
+	} else {
+		keys_added = TRUE;
+		ms_debug("Table call_history updated successfully for remote_key.");
+	}
+	ret=sqlite3_exec(db,"ALTER TABLE call_history ADD COLUMN local_key TEXT;",NULL,NULL,&errmsg);
+	if(ret != SQLITE_OK) {
+		ms_message("Table already up to date: %s.", errmsg);
+		sqlite3_free(errmsg);
+	} else {
+		keys_added = TRUE;
+		ms_debug("Table call_history updated successfully for local_key.");
+	}
+	if (keys_added)
+		linphone_fill_call_log_address_keys(db);
+
+	ret=sqlite3_exec(db,
+		"CREATE INDEX IF NOT EXISTS call_history_call_id ON call_history (call_id);"
+		"CREATE INDEX IF NOT EXISTS call_history_remote_key ON call_history (remote_key, local_key);"
+		"CREATE INDEX IF NOT EXISTS call_history_local_key ON call_history (local_key);",
+		NULL,NULL,&errmsg);
+	if(ret != SQLITE_OK) {
+		ms_error("Error in call_history indexes creation: %s.", errmsg);
+		sqlite3_free(errmsg);
+	}
 }
 
 void linphone_core_call_log_storage_init(LinphoneCore *lc) {
@@ -515,7 +604,7 @@ static int create_call_log(void *data, int argc, char **argv, char **colName) {
 		if (argv[10] != NULL) {
 			log->call_id = ms_strdup(argv[10]);
 		}
-		if (argv[10] != NULL) {
+		if (argv[11] != NULL) {
 			log->refkey = ms_strdup(argv[11]);
 		}
 	}
@@ -555,14 +644,49 @@ static int linphone_sql_request_generic(sqlite3* db, const char *stmt) {
 	return ret;
 }
 
+/*
+ * When the call logs are stored in a database, only the most recent ones are kept in memory. The size of this
+ * window is the [misc] history_cache_size config entry, bounded by the history max size.
+ */
+static int linphone_core_get_call_logs_window_size(const LinphoneCore *lc) {
+	int size = linphone_config_get_int(lc->config, "misc", "history_cache_size", LINPHONE_MAX_CALL_HISTORY_UNLIMITED);
+	if (size < 0 || (lc->max_call_logs != LINPHONE_MAX_CALL_HISTORY_UNLIMITED && lc->max_call_logs < size))
+		return lc->max_call_logs;
+	return size;
+}
+
+static void linphone_core_trim_call_logs_window(LinphoneCore *lc) {
+	bctbx_list_t *last;
+	bctbx_list_t *removed;
+	int size = linphone_core_get_call_logs_window_size(lc);
+	int i;
+
+	if (size == LINPHONE_MAX_CALL_HISTORY_UNLIMITED) return;
+	if (size == 0) {
+		lc->call_logs = bctbx_list_free_with_data(lc->call_logs, (bctbx_list_free_func)linphone_call_log_unref);
+		return;
+	}
+
+	for (last = lc->call_logs, i = 1; last != NULL && i < size; last = bctbx_list_next(last), i++);
+	if (!last || !last->next) return;
+
+	removed = last->next;
+	removed->prev = NULL;
+	last->next = NULL;
+	bctbx_list_free_with_data(removed, (bctbx_list_free_func)linphone_call_log_unref);
+}
+
 void linphone_core_store_call_log(LinphoneCore *lc, LinphoneCallLog *log) {
 	if (lc && lc->logs_db){
 		char *from = NULL, *to = NULL;
+		char *remote_key = NULL, *local_key = NULL;
 		char *buf = NULL;
 
 		if (log->from) from = linphone_address_as_string(log->from);
 		if (log->to) to = linphone_address_as_string(log->to);
-		buf = sqlite3_mprintf("INSERT INTO call_history VALUES(NULL,%Q,%Q,%i,%i,%lld,%lld,%i,%i,%f,%Q,%Q);",
+		linphone_call_log_get_address_keys(log->dir, log->from, log->to, &remote_key, &local_key);
+		buf = sqlite3_mprintf("INSERT INTO call_history (caller,callee,direction,duration,start_time,connected_time,status,videoEnabled,quality,call_id,refkey,remote_key,local_key) "
+						"VALUES(%Q,%Q,%i,%i,%lld,%lld,%i,%i,%f,%Q,%Q,%Q,%Q);",
 						from,
 						to,
 						log->dir,
@@ -573,18 +697,24 @@ void linphone_core_store_call_log(LinphoneCore *lc, LinphoneCallLog *log) {
 						log->video_enabled ? 1 : 0,
 						log->quality,
 						log->call_id,
-						log->refkey
+						log->refkey,
+						remote_key,
+						local_key
 					);
-		linphone_sql_request_generic(lc->logs_db, buf);
+		int ret = linphone_sql_request_generic(lc->logs_db, buf);
 		sqlite3_free(buf);
 		if (from) ms_free(from);
 		if (to) ms_free(to);
+		if (remote_key) ms_free(remote_key);
+		if (local_key) ms_free(local_key);
 
-		log->storage_id = (unsigned int)sqlite3_last_insert_rowid(lc->logs_db);
+		if (ret == SQLITE_OK)
+			log->storage_id = (unsigned int)sqlite3_last_insert_rowid(lc->logs_db);
 	}
 
 	if (lc) {
 		lc->call_logs = bctbx_list_prepend(lc->call_logs, linphone_call_log_ref(log));
+		if (lc->logs_db) linphone_core_trim_call_logs_window(lc);
 	}
 }
 
@@ -593,11 +723,14 @@ const bctbx_list_t *linphone_core_get_call_history(LinphoneCore *lc) {
 	uint64_t begin,end;
 	CallLogStorageResult clsres;
 
+	int window_size;
+
 	if (!lc || lc->logs_db == NULL) return NULL;
 	if (lc->call_logs != NULL) return lc->call_logs;
 
-	if (lc->max_call_logs != LINPHONE_MAX_CALL_HISTORY_UNLIMITED){
-		buf = sqlite3_mprintf("SELECT * FROM call_history ORDER BY id DESC LIMIT %i", lc->max_call_logs);
+	window_size = linphone_core_get_call_logs_window_size(lc);
+	if (window_size != LINPHONE_MAX_CALL_HISTORY_UNLIMITED){
+		buf = sqlite3_mprintf("SELECT * FROM call_history ORDER BY id DESC LIMIT %i", window_size);
 	}else{
 		buf = sqlite3_mprintf("SELECT * FROM call_history ORDER BY id DESC");
 	}
@@ -614,6 +747,46 @@ const bctbx_list_t *linphone_core_get_call_history(LinphoneCore *lc) {
 	return lc->call_logs;
 }
 
+bctbx_list_t *linphone_core_get_call_history_page(LinphoneCore *lc, const LinphoneCallLog *last, int count) {
+	char *buf;
+	uint64_t begin,end;
+	CallLogStorageResult clsres;
+
+	if (!lc || count <= 0) return NULL;
+
+	if (!lc->logs_db) {
+		bctbx_list_t *result = NULL;
+		const bctbx_list_t *item = lc->call_logs;
+		if (last) {
+			item = bctbx_list_find(lc->call_logs, last);
+			if (item) item = bctbx_list_next(item);
+		}
+		for (; item != NULL && count > 0; item = bctbx_list_next(item), count--)
+			result = bctbx_list_append(result, linphone_call_log_ref((LinphoneCallLog *)bctbx_list_get_data(item)));
+		return result;
+	}
+
+	if (last) {
+		if (last->storage_id == 0) {
+			ms_warning("%s(): call log [%p] isn't stored in the database", __FUNCTION__, last);
+			return NULL;
+		}
+		buf = sqlite3_mprintf("SELECT * FROM call_history WHERE id < %u ORDER BY id DESC LIMIT %i", last->storage_id, count);
+	} else {
+		buf = sqlite3_mprintf("SELECT * FROM call_history ORDER BY id DESC LIMIT %i", count);
+	}
+
+	clsres.core = lc;
+	clsres.result = NULL;
+	begin = ortp_get_cur_time_ms();
+	linphone_sql_request_call_log(lc->logs_db, buf, &clsres);
+	end = ortp_get_cur_time_ms();
+	ms_message("%s(): completed in %i ms",__FUNCTION__, (int)(end-begin));
+	sqlite3_free(buf);
+
+	return clsres.result;
+}
+
 void linphone_core_delete_call_history(LinphoneCore *lc) {
 	char *buf;
 
@@ -676,9 +849,8 @@ bctbx_list_t * linphone_core_get_call_history_for_address(LinphoneCore *lc, cons
 
 	if (!lc || lc->logs_db == NULL || addr == NULL) return NULL;
 
-	/*since we want to append query parameters depending on arguments given, we use malloc instead of sqlite3_mprintf*/
-	sipAddress = linphone_address_as_string_uri_only(addr);
-	buf = sqlite3_mprintf("SELECT * FROM call_history WHERE caller LIKE '%%%q%%' OR callee LIKE '%%%q%%' ORDER BY id DESC", sipAddress, sipAddress); // The '%%%q%%' takes care of the eventual presence of a display name
+	sipAddress = linphone_call_log_address_key(addr);
+	buf = sqlite3_mprintf("SELECT * FROM call_history WHERE remote_key = %Q OR local_key = %Q ORDER BY id DESC", sipAddress, sipAddress);
 
 	clsres.core = lc;
 	clsres.result = NULL;
@@ -705,15 +877,10 @@ bctbx_list_t *linphone_core_get_call_history_2(
 
 	if (!lc || !lc->logs_db || !peer_addr || !local_addr) return NULL;
 
-	peer_addr_str = bctbx_strdup(L_GET_CPP_PTR_FROM_C_OBJECT(peer_addr)->asStringUriOnly().c_str());
-	local_addr_str = bctbx_strdup(L_GET_CPP_PTR_FROM_C_OBJECT(local_addr)->asStringUriOnly().c_str());
+	peer_addr_str = linphone_call_log_address_key(peer_addr);
+	local_addr_str = linphone_call_log_address_key(local_addr);
 	buf = sqlite3_mprintf(
-		"SELECT * FROM call_history WHERE "
-		"(caller LIKE '%%%q%%' AND callee LIKE '%%%q%%' AND direction = 0) OR "
-		"(caller LIKE '%%%q%%' AND callee LIKE '%%%q%%' AND direction = 1) "
-		"ORDER BY id DESC",
-		local_addr_str,
-		peer_addr_str,
+		"SELECT * FROM call_history WHERE remote_key = %Q AND local_key = %Q ORDER BY id DESC",
 		peer_addr_str,
 		local_addr_str
 	);
@@ -725,8 +892,8 @@ bctbx_list_t *linphone_core_get_call_history_2(
 	end = ortp_get_cur_time_ms();
 	bctbx_message("%s(): completed in %i ms", __FUNCTION__, (int)(end - begin));
 	sqlite3_free(buf);
-	bctbx_free(peer_addr_str);
-	bctbx_free(local_addr_str);
+	ms_free(peer_addr_str);
+	ms_free(local_addr_str);
 
 	return clsres.result;
 }
@@ -777,7 +944,11 @@ LinphoneCallLog * linphone_core_find_call_log(LinphoneCore *lc, const char *call
 
 	/*since we want to append query parameters depending on arguments given, we use malloc instead of sqlite3_mprintf*/
 	if (limit > 0)  {
-		buf = sqlite3_mprintf( "WITH temp AS (SELECT * FROM call_history ORDER BY id DESC LIMIT %i) SELECT * FROM temp WHERE call_id = '%q' LIMIT 1",  limit, call_id);
+		// Only the ids of the most recent logs are scanned, the call_id is then looked up in its index.
+		buf = sqlite3_mprintf(
+			"SELECT * FROM call_history WHERE call_id = '%q' AND id >= IFNULL((SELECT id FROM call_history ORDER BY id DESC LIMIT 1 OFFSET %i), 0) ORDER BY id DESC LIMIT 1",
+			call_id, limit - 1
+		);
 	} else {
 		buf = sqlite3_mprintf( "SELECT * FROM call_history WHERE call_id = '%q' ORDER BY id DESC LIMIT 1", call_id);
 	}
@@ -388,6 +388,7 @@ LinphoneStatus linphone_friend_set_address(LinphoneFriend *lf, const LinphoneAdd
 	}
 
 	ms_free(address);
+	linphone_core_update_friend_in_search_index(lf->lc, lf);
 	return 0;
 }
 
@@ -414,6 +415,7 @@ void linphone_friend_add_address(LinphoneFriend *lf, const LinphoneAddress *addr
 		else linphone_address_unref(fr);
 	}
 	ms_free(uri);
+	linphone_core_update_friend_in_search_index(lf->lc, lf);
 }
 
 const bctbx_list_t* linphone_friend_get_addresses(const LinphoneFriend *lf) {
@@ -441,6 +443,7 @@ void linphone_friend_remove_address(LinphoneFriend *lf, const LinphoneAddress *a
 		linphone_vcard_remove_sip_address(lf->vcard, address);
 	}
 	ms_free(address);
+	linphone_core_update_friend_in_search_index(lf->lc, lf);
 }
 
 void linphone_friend_add_phone_number(LinphoneFriend *lf, const char *phone) {
@@ -456,7 +459,9 @@ void linphone_friend_add_phone_number(LinphoneFriend *lf, const char *phone) {
 			linphone_friend_create_vcard(lf, phone);
 		}
 		linphone_vcard_add_phone_number(lf->vcard, phone);
+		if (lf->friend_list) linphone_friend_list_add_phone_number_to_map(lf->friend_list, lf, phone);
 	}
+	linphone_core_update_friend_in_search_index(lf->lc, lf);
 }
 
 bctbx_list_t* linphone_friend_get_phone_numbers(const LinphoneFriend *lf) {
@@ -516,11 +521,13 @@ void linphone_friend_remove_phone_number(LinphoneFriend *lf, const char *phone)
 		if (uri) {
 			remove_friend_from_list_map_if_already_in_it(lf, uri);
 		}
+		linphone_friend_list_remove_phone_number_from_map(lf->friend_list, lf, phone);
 	}
 
 	if (linphone_core_vcard_supported()) {
 		linphone_vcard_remove_phone_number(lf->vcard, phone);
 	}
+	linphone_core_update_friend_in_search_index(lf->lc, lf);
 }
 
 LinphoneStatus linphone_friend_set_name(LinphoneFriend *lf, const char *name) {
@@ -534,6 +541,7 @@ LinphoneStatus linphone_friend_set_name(LinphoneFriend *lf, const char *name) {
 		}
 		linphone_address_set_display_name(lf->uri, name);
 	}
+	linphone_core_update_friend_in_search_index(lf->lc, lf);
 	return 0;
 }
 
@@ -823,6 +831,8 @@ void linphone_friend_set_presence_model_for_uri_or_tel(LinphoneFriend *lf, const
 	} else {
 		add_presence_model_for_uri_or_tel(lf, uri_or_tel, presence);
 	}
+	/* The presence contact of a phone number is searchable. */
+	linphone_core_update_friend_in_search_index(lf->lc, lf);
 }
 
 bool_t linphone_friend_is_presence_received(const LinphoneFriend *lf) {
@@ -935,6 +945,29 @@ void linphone_friend_done(LinphoneFriend *fr) {
 	}
 	linphone_friend_apply(fr, fr->lc);
 	linphone_friend_save(fr, fr->lc);
+	linphone_core_update_friend_in_search_index(fr->lc, fr);
+}
+
+void linphone_core_update_friend_in_search_index(LinphoneCore *lc, const LinphoneFriend *lf) {
+	if (!lc || !lc->cppPtr) return;
+	const std::unique_ptr<LinphonePrivate::FriendSearchIndex> &index = L_GET_PRIVATE(lc->cppPtr)->friendSearchIndex;
+	if (!index) return; /* Built on first search. */
+
+	if (lf->friend_list && bctbx_list_find(lc->friends_lists, lf->friend_list))
+		index->updateFriend(lf);
+	else
+		index->removeFriend(lf);
+}
+
+void linphone_core_remove_friend_from_search_index(LinphoneCore *lc, const LinphoneFriend *lf) {
+	if (!lc || !lc->cppPtr) return;
+	const std::unique_ptr<LinphonePrivate::FriendSearchIndex> &index = L_GET_PRIVATE(lc->cppPtr)->friendSearchIndex;
+	if (index) index->removeFriend(lf);
+}
+
+void linphone_core_invalidate_friend_search_index(LinphoneCore *lc) {
+	if (!lc || !lc->cppPtr) return;
+	L_GET_PRIVATE(lc->cppPtr)->friendSearchIndex.reset();
 }
 
 #if __clang__ || ((__GNUC__ == 4 && __GNUC_MINOR__ >= 6) || __GNUC__ > 4)
@@ -1231,7 +1264,10 @@ void linphone_friend_set_vcard(LinphoneFriend *fr, LinphoneVcard *vcard) {
 
 	if (fr->vcard) linphone_vcard_unref(fr->vcard);
 	if (vcard) fr->vcard = linphone_vcard_ref(vcard);
+	/* Phone numbers may have changed with the vCard. */
+	if (fr->friend_list) linphone_friend_list_invalidate_phone_number_map(fr->friend_list);
 	linphone_friend_save(fr, fr->lc);
+	linphone_core_update_friend_in_search_index(fr->lc, fr);
 }
 
 bool_t linphone_friend_create_vcard(LinphoneFriend *fr, const char *name) {
@@ -1439,6 +1475,19 @@ void linphone_core_friends_storage_init(LinphoneCore *lc) {
 
 void linphone_core_friends_storage_close(LinphoneCore *lc) {
 	if (lc->friends_db) {
+		if (lc->friends_db_transaction_depth > 0) {
+			ms_warning("Closing friends database with a pending transaction, committing it");
+			lc->friends_db_transaction_depth = 1;
+			linphone_core_end_friends_db_transaction(lc);
+		}
+		if (lc->friends_insert_stmt) {
+			sqlite3_finalize(lc->friends_insert_stmt);
+			lc->friends_insert_stmt = NULL;
+		}
+		if (lc->friends_update_stmt) {
+			sqlite3_finalize(lc->friends_update_stmt);
+			lc->friends_update_stmt = NULL;
+		}
 		sqlite3_close(lc->friends_db);
 		lc->friends_db = NULL;
 	}
@@ -1558,13 +1607,44 @@ static int linphone_sql_request_generic(sqlite3* db, const char *stmt) {
 	return ret;
 }
 
+void linphone_core_begin_friends_db_transaction(LinphoneCore *lc) {
+	if (!lc || !lc->friends_db) return;
+	if (lc->friends_db_transaction_depth++ == 0)
+		linphone_sql_request_generic(lc->friends_db, "BEGIN TRANSACTION;");
+}
+
+void linphone_core_end_friends_db_transaction(LinphoneCore *lc) {
+	if (!lc || !lc->friends_db || lc->friends_db_transaction_depth == 0) return;
+	if (--lc->friends_db_transaction_depth == 0)
+		linphone_sql_request_generic(lc->friends_db, "COMMIT;");
+}
+
+static sqlite3_stmt *linphone_core_get_friends_db_stmt(LinphoneCore *lc, sqlite3_stmt **stmt, const char *sql) {
+	if (!*stmt) {
+		int ret = sqlite3_prepare_v2(lc->friends_db, sql, -1, stmt, NULL);
+		if (ret != SQLITE_OK) {
+			ms_error("linphone_core_get_friends_db_stmt: statement %s -> error sqlite3_prepare_v2(): %s.", sql, sqlite3_errmsg(lc->friends_db));
+			*stmt = NULL;
+		}
+	}
+	return *stmt;
+}
+
+static void bind_text_or_null(sqlite3_stmt *stmt, int index, const char *value) {
+	if (value)
+		sqlite3_bind_text(stmt, index, value, -1, SQLITE_STATIC);
+	else
+		sqlite3_bind_null(stmt, index);
+}
+
 void linphone_core_store_friend_in_db(LinphoneCore *lc, LinphoneFriend *lf) {
 	if (lc && lc->friends_db) {
-		char *buf;
+		sqlite3_stmt *stmt;
 		int store_friends = linphone_config_get_int(lc->config, "misc", "store_friends", 1);
 		LinphoneVcard *vcard = NULL;
 		const LinphoneAddress *addr;
 		char *addr_str = NULL;
+		int ret;
 
 		if (!store_friends) {
 			return;
@@ -1580,41 +1660,42 @@ void linphone_core_store_friend_in_db(LinphoneCore *lc, LinphoneFriend *lf) {
 			linphone_core_store_friends_list_in_db(lc, lf->friend_list);
 		}
 
-		if (linphone_core_vcard_supported()) vcard = linphone_friend_get_vcard(lf);
-		addr = linphone_friend_get_address(lf);
-		if (addr != NULL) addr_str = linphone_address_as_string(addr);
 		if (lf->storage_id > 0) {
-			buf = sqlite3_mprintf("UPDATE friends SET friend_list_id=%u,sip_uri=%Q,subscribe_policy=%i,send_subscribe=%i,ref_key=%Q,vCard=%Q,vCard_etag=%Q,vCard_url=%Q,presence_received=%i WHERE (id = %u);",
-				lf->friend_list->storage_id,
-				addr_str,
-				lf->pol,
-				lf->subscribe,
-				lf->refkey,
-				vcard ? linphone_vcard_as_vcard4_string(vcard) : NULL,
-				vcard ? linphone_vcard_get_etag(vcard) : NULL,
-				vcard ? linphone_vcard_get_url(vcard): NULL,
-				lf->presence_received,
-				lf->storage_id
+			stmt = linphone_core_get_friends_db_stmt(lc, &lc->friends_update_stmt,
+				"UPDATE friends SET friend_list_id=?,sip_uri=?,subscribe_policy=?,send_subscribe=?,ref_key=?,vCard=?,vCard_etag=?,vCard_url=?,presence_received=? WHERE (id = ?);"
 			);
 		} else {
-			buf = sqlite3_mprintf("INSERT INTO friends VALUES(NULL,%u,%Q,%i,%i,%Q,%Q,%Q,%Q,%i);",
-				lf->friend_list->storage_id,
-				addr_str,
-				lf->pol,
-				lf->subscribe,
-				lf->refkey,
-				vcard ? linphone_vcard_as_vcard4_string(vcard) : NULL,
-				vcard ? linphone_vcard_get_etag(vcard) : NULL,
-				vcard ? linphone_vcard_get_url(vcard) : NULL,
-				lf->presence_received
+			stmt = linphone_core_get_friends_db_stmt(lc, &lc->friends_insert_stmt,
+				"INSERT INTO friends VALUES(NULL,?,?,?,?,?,?,?,?,?);"
 			);
 		}
-		if (addr_str != NULL) ms_free(addr_str);
+		if (!stmt) return;
 
-		linphone_sql_request_generic(lc->friends_db, buf);
-		sqlite3_free(buf);
+		if (linphone_core_vcard_supported()) vcard = linphone_friend_get_vcard(lf);
+		addr = linphone_friend_get_address(lf);
+		if (addr != NULL) addr_str = linphone_address_as_string(addr);
 
-		if (lf->storage_id == 0) {
+		// The vCard text is cached by the vCard itself and only serialized again after a modification.
+		sqlite3_bind_int64(stmt, 1, (sqlite3_int64)lf->friend_list->storage_id);
+		bind_text_or_null(stmt, 2, addr_str);
+		sqlite3_bind_int(stmt, 3, lf->pol);
+		sqlite3_bind_int(stmt, 4, lf->subscribe);
+		bind_text_or_null(stmt, 5, lf->refkey);
+		bind_text_or_null(stmt, 6, vcard ? linphone_vcard_as_vcard4_string(vcard) : NULL);
+		bind_text_or_null(stmt, 7, vcard ? linphone_vcard_get_etag(vcard) : NULL);
+		bind_text_or_null(stmt, 8, vcard ? linphone_vcard_get_url(vcard) : NULL);
+		sqlite3_bind_int(stmt, 9, lf->presence_received);
+		if (lf->storage_id > 0)
+			sqlite3_bind_int64(stmt, 10, (sqlite3_int64)lf->storage_id);
+
+		ret = sqlite3_step(stmt);
+		if (ret != SQLITE_DONE)
+			ms_error("linphone_core_store_friend_in_db: error sqlite3_step(): %s.", sqlite3_errmsg(lc->friends_db));
+		sqlite3_reset(stmt);
+		sqlite3_clear_bindings(stmt);
+		if (addr_str != NULL) ms_free(addr_str);
+
+		if (ret == SQLITE_DONE && lf->storage_id == 0) {
 			lf->storage_id = (unsigned int)sqlite3_last_insert_rowid(lc->friends_db);
 		}
 	}
@@ -1704,6 +1785,7 @@ void linphone_friend_add_addresses_and_numbers_into_maps(LinphoneFriend *lf, Lin
 		if (uri) {
 			add_friend_to_list_map_if_not_in_it_yet(lf, uri);
 		}
+		linphone_friend_list_add_phone_number_to_map(list, lf, number);
 		iterator = bctbx_list_next(iterator);
 	}
 
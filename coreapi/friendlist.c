@@ -133,6 +133,14 @@ void linphone_friend_list_cbs_set_presence_received(LinphoneFriendListCbs *cbs,
 	cbs->presence_received_cb = cb;
 }
 
+LinphoneFriendListCbsImportProgressCb linphone_friend_list_cbs_get_import_progress(const LinphoneFriendListCbs *cbs) {
+	return cbs->import_progress_cb;
+}
+
+void linphone_friend_list_cbs_set_import_progress(LinphoneFriendListCbs *cbs, LinphoneFriendListCbsImportProgressCb cb) {
+	cbs->import_progress_cb = cb;
+}
+
 static int add_uri_entry(xmlTextWriterPtr writer, int err, const char *uri) {
 	if (err >= 0) {
 		err = xmlTextWriterStartElement(writer, (const xmlChar *)"entry");
@@ -489,6 +497,7 @@ static void linphone_friend_list_destroy(LinphoneFriendList *list) {
 	if (list->friends) list->friends = bctbx_list_free_with_data(list->friends, (void (*)(void *))_linphone_friend_release);
 	if (list->friends_map) bctbx_mmap_cchar_delete_with_data(list->friends_map, (void (*)(void *))linphone_friend_unref);
 	if (list->friends_map_uri) bctbx_mmap_cchar_delete_with_data(list->friends_map_uri, (void (*)(void *))linphone_friend_unref);
+	linphone_friend_list_invalidate_phone_number_map(list);
 }
 
 BELLE_SIP_DECLARE_NO_IMPLEMENTED_INTERFACES(LinphoneFriendList);
@@ -665,6 +674,8 @@ void linphone_friend_list_invalidate_friends_maps(LinphoneFriendList *list) {
 	list->friends_map = bctbx_mmap_cchar_new();
 	if (list->friends_map_uri) bctbx_mmap_cchar_delete_with_data(list->friends_map_uri, (void (*)(void *))linphone_friend_unref);
 	list->friends_map_uri = bctbx_mmap_cchar_new();
+	/* Rebuilt on next lookup by phone number. */
+	linphone_friend_list_invalidate_phone_number_map(list);
 	
 	const bctbx_list_t *elem;
 	for (elem = list->friends; elem != NULL; elem = bctbx_list_next(elem)) {
@@ -683,6 +694,7 @@ LinphoneFriendListStatus linphone_friend_list_import_friend(LinphoneFriendList *
 	lf->lc = list->lc;
 	list->friends = bctbx_list_prepend(list->friends, linphone_friend_ref(lf));
 	linphone_friend_add_addresses_and_numbers_into_maps(lf, list);
+	linphone_core_update_friend_in_search_index(list->lc, lf);
 
 	if (synchronize) {
 		list->dirty_friends_to_update = bctbx_list_prepend(list->dirty_friends_to_update, linphone_friend_ref(lf));
@@ -741,6 +753,7 @@ static LinphoneFriendListStatus _linphone_friend_list_remove_friend(LinphoneFrie
 	while (iterator) {
 		const char *number = (const char *)bctbx_list_get_data(iterator);
 		const char *uri = linphone_friend_phone_number_to_sip_uri(lf, number);
+		linphone_friend_list_remove_phone_number_from_map(list, lf, number);
 		if (uri) {
 			bctbx_iterator_t * it = bctbx_map_cchar_find_key(list->friends_map_uri, uri);
 			bctbx_iterator_t * end = bctbx_map_cchar_end(list->friends_map_uri);
@@ -775,6 +788,7 @@ static LinphoneFriendListStatus _linphone_friend_list_remove_friend(LinphoneFrie
 		iterator = bctbx_list_next(iterator);
 	}
 
+	linphone_core_remove_friend_from_search_index(lf->lc, lf);
 	lf->friend_list = NULL;
 	linphone_friend_unref(lf);
 	return LinphoneFriendListOK;
@@ -839,6 +853,9 @@ static void carddav_updated(LinphoneCardDavContext *cdc, LinphoneFriend *lf_new,
 			elem->data = linphone_friend_ref(lf_new);
 		}
 		linphone_core_store_friend_in_db(lf_new->lc, lf_new);
+		linphone_friend_list_invalidate_phone_number_map(list);
+		linphone_core_remove_friend_from_search_index(list->lc, lf_old);
+		linphone_core_update_friend_in_search_index(list->lc, lf_new);
 
 		if (cdc->friend_list->cbs->contact_updated_cb) {
 			cdc->friend_list->cbs->contact_updated_cb(list, lf_new, lf_old);
@@ -883,18 +900,204 @@ LinphoneFriend * linphone_friend_list_find_friend_by_address(const LinphoneFrien
 	return lf;
 }
 
-LinphoneFriend * linphone_friend_list_find_friend_by_phone_number(const LinphoneFriendList *list, const char *phoneNumber) {
-	LinphoneFriend *result = NULL;
-	
+/*
+ * The phone numbers map indexes friends by their phone numbers normalized by each account, as linphone_friend_has_phone_number()
+ * compares them. Keys are prefixed by the normalization parameters of the account: accounts with the same parameters
+ * share their keys and are only used once.
+ */
+
+static char *get_phone_number_normalization_params(LinphoneAccount *account) {
+	const LinphoneAccountParams *params = linphone_account_get_params(account);
+	const char *prefix = linphone_account_params_get_international_prefix(params);
+	return bctbx_strdup_printf("%s/%d", prefix ? prefix : "", linphone_account_params_get_dial_escape_plus_enabled(params) ? 1 : 0);
+}
+
+/* Accounts normalizing phone numbers differently, and the key of their parameters. */
+static bctbx_list_t *get_phone_number_normalization_accounts(LinphoneCore *lc, char **key) {
+	bctbx_list_t *accounts = NULL;
+	bctbx_list_t *params_list = NULL;
+	const bctbx_list_t *elem;
+
+	*key = bctbx_strdup("");
+	if (!lc) return NULL;
+
+	for (elem = linphone_core_get_account_list(lc); elem != NULL; elem = bctbx_list_next(elem)) {
+		LinphoneAccount *account = (LinphoneAccount *)bctbx_list_get_data(elem);
+		char *params = get_phone_number_normalization_params(account);
+		if (bctbx_list_find_custom(params_list, (bctbx_compare_func)strcmp, params)) {
+			bctbx_free(params);
+			continue;
+		}
+
+		char *new_key = bctbx_strdup_printf("%s;%s", *key, params);
+		bctbx_free(*key);
+		*key = new_key;
+		params_list = bctbx_list_append(params_list, params);
+		accounts = bctbx_list_append(accounts, account);
+	}
+	bctbx_list_free_with_data(params_list, (bctbx_list_free_func)bctbx_free);
+	return accounts;
+}
+
+static char *get_phone_number_map_key(LinphoneAccount *account, const char *phone_number) {
+	char *normalized = linphone_account_normalize_phone_number(account, phone_number);
+	if (!normalized) return NULL;
+
+	char *params = get_phone_number_normalization_params(account);
+	char *key = bctbx_strdup_printf("%s %s", params, normalized);
+	bctbx_free(params);
+	bctbx_free(normalized);
+	return key;
+}
+
+static void add_phone_number_to_map(LinphoneFriendList *list, LinphoneFriend *lf, const bctbx_list_t *accounts, const char *phone_number) {
+	const bctbx_list_t *elem;
+	for (elem = accounts; elem != NULL; elem = bctbx_list_next(elem)) {
+		char *key = get_phone_number_map_key((LinphoneAccount *)bctbx_list_get_data(elem), phone_number);
+		if (!key) continue;
+		bctbx_pair_t *pair = (bctbx_pair_t *)bctbx_pair_cchar_new(key, linphone_friend_ref(lf));
+		bctbx_map_cchar_insert_and_delete(list->friends_map_phone_number, pair);
+		bctbx_free(key);
+	}
+}
+
+static void build_phone_number_map(LinphoneFriendList *list, const bctbx_list_t *accounts, const char *key) {
 	const bctbx_list_t *elem;
+
+	linphone_friend_list_invalidate_phone_number_map(list);
+	list->friends_map_phone_number = bctbx_mmap_cchar_new();
+	list->friends_map_phone_number_key = bctbx_strdup(key);
+
 	for (elem = list->friends; elem != NULL; elem = bctbx_list_next(elem)) {
 		LinphoneFriend *lf = (LinphoneFriend *)bctbx_list_get_data(elem);
-		if (linphone_friend_has_phone_number(lf, phoneNumber)) {
-			result = lf;
-			break;
+		bctbx_list_t *phone_numbers = linphone_friend_get_phone_numbers(lf);
+		const bctbx_list_t *it;
+		for (it = phone_numbers; it != NULL; it = bctbx_list_next(it))
+			add_phone_number_to_map(list, lf, accounts, (const char *)bctbx_list_get_data(it));
+		if (phone_numbers) bctbx_list_free(phone_numbers);
+	}
+}
+
+void linphone_friend_list_add_phone_number_to_map(LinphoneFriendList *list, LinphoneFriend *lf, const char *phone_number) {
+	char *key;
+	bctbx_list_t *accounts;
+
+	if (!list->friends_map_phone_number || !phone_number) return;
+
+	accounts = get_phone_number_normalization_accounts(list->lc, &key);
+	if (strcmp(key, list->friends_map_phone_number_key) == 0)
+		add_phone_number_to_map(list, lf, accounts, phone_number);
+	else
+		linphone_friend_list_invalidate_phone_number_map(list);
+	bctbx_free(key);
+	bctbx_list_free(accounts);
+}
+
+void linphone_friend_list_remove_phone_number_from_map(LinphoneFriendList *list, LinphoneFriend *lf, const char *phone_number) {
+	char *key;
+	bctbx_list_t *accounts;
+	const bctbx_list_t *elem;
+
+	if (!list->friends_map_phone_number || !phone_number) return;
+
+	accounts = get_phone_number_normalization_accounts(list->lc, &key);
+	if (strcmp(key, list->friends_map_phone_number_key) != 0) {
+		linphone_friend_list_invalidate_phone_number_map(list);
+		accounts = bctbx_list_free(accounts);
+	}
+
+	for (elem = accounts; elem != NULL; elem = bctbx_list_next(elem)) {
+		char *map_key = get_phone_number_map_key((LinphoneAccount *)bctbx_list_get_data(elem), phone_number);
+		if (!map_key) continue;
+
+		bctbx_iterator_t *it = bctbx_map_cchar_find_key(list->friends_map_phone_number, map_key);
+		bctbx_iterator_t *end = bctbx_map_cchar_end(list->friends_map_phone_number);
+		// Map is sorted, check if next entry matches key otherwise stop
+		while (!bctbx_iterator_cchar_equals(it, end)) {
+			bctbx_pair_t *pair = bctbx_iterator_cchar_get_pair(it);
+			const char *pair_key = bctbx_pair_cchar_get_first(reinterpret_cast<bctbx_pair_cchar_t *>(pair));
+			if (!pair_key || strcmp(map_key, pair_key) != 0) break;
+			LinphoneFriend *lf2 = (LinphoneFriend *)bctbx_pair_cchar_get_second(pair);
+			if (lf2 == lf) {
+				linphone_friend_unref(lf2);
+				bctbx_map_cchar_erase(list->friends_map_phone_number, it);
+				break;
+			}
+			it = bctbx_iterator_cchar_get_next(it);
+		}
+		bctbx_iterator_cchar_delete(it);
+		bctbx_iterator_cchar_delete(end);
+		bctbx_free(map_key);
+	}
+	bctbx_free(key);
+	if (accounts) bctbx_list_free(accounts);
+}
+
+void linphone_friend_list_invalidate_phone_number_map(LinphoneFriendList *list) {
+	if (list->friends_map_phone_number) {
+		bctbx_mmap_cchar_delete_with_data(list->friends_map_phone_number, (void (*)(void *))linphone_friend_unref);
+		list->friends_map_phone_number = NULL;
+	}
+	if (list->friends_map_phone_number_key) {
+		bctbx_free(list->friends_map_phone_number_key);
+		list->friends_map_phone_number_key = NULL;
+	}
+}
+
+LinphoneFriend * linphone_friend_list_find_friend_by_phone_number(const LinphoneFriendList *list, const char *phoneNumber) {
+	LinphoneFriend *result = NULL;
+	char *key;
+	bctbx_list_t *accounts;
+	bctbx_list_t *candidates = NULL;
+	const bctbx_list_t *elem;
+
+	if (!list->lc || !phoneNumber) return NULL;
+
+	LinphoneAccount *account = linphone_core_get_default_account(list->lc);
+	// Account can be null, linphone_account_is_phone_number can handle it
+	if (!linphone_account_is_phone_number(account, phoneNumber)) {
+		ms_warning("Phone number [%s] isn't valid", phoneNumber);
+		return NULL;
+	}
+
+	accounts = get_phone_number_normalization_accounts(list->lc, &key);
+	if (!list->friends_map_phone_number || strcmp(key, list->friends_map_phone_number_key) != 0) {
+		/* The map is a cache, it is built and kept up to date by the list itself. */
+		build_phone_number_map(const_cast<LinphoneFriendList *>(list), accounts, key);
+	}
+
+	for (elem = accounts; elem != NULL; elem = bctbx_list_next(elem)) {
+		char *map_key = get_phone_number_map_key((LinphoneAccount *)bctbx_list_get_data(elem), phoneNumber);
+		if (!map_key) continue;
+
+		bctbx_iterator_t *it = bctbx_map_cchar_find_key(list->friends_map_phone_number, map_key);
+		bctbx_iterator_t *end = bctbx_map_cchar_end(list->friends_map_phone_number);
+		// Map is sorted, check if next entry matches key otherwise stop
+		while (!bctbx_iterator_cchar_equals(it, end)) {
+			bctbx_pair_t *pair = bctbx_iterator_cchar_get_pair(it);
+			const char *pair_key = bctbx_pair_cchar_get_first(reinterpret_cast<bctbx_pair_cchar_t *>(pair));
+			if (!pair_key || strcmp(map_key, pair_key) != 0) break;
+			LinphoneFriend *lf = (LinphoneFriend *)bctbx_pair_cchar_get_second(pair);
+			if (!bctbx_list_find(candidates, lf)) candidates = bctbx_list_append(candidates, lf);
+			it = bctbx_iterator_cchar_get_next(it);
+		}
+		bctbx_iterator_cchar_delete(it);
+		bctbx_iterator_cchar_delete(end);
+		bctbx_free(map_key);
+	}
+
+	/* Several friends share the number: return the first one of the list, as a lookup through the list would. */
+	if (candidates && !bctbx_list_next(candidates)) {
+		result = (LinphoneFriend *)bctbx_list_get_data(candidates);
+	} else if (candidates) {
+		for (elem = list->friends; elem != NULL && !result; elem = bctbx_list_next(elem)) {
+			if (bctbx_list_find(candidates, bctbx_list_get_data(elem))) result = (LinphoneFriend *)bctbx_list_get_data(elem);
 		}
 	}
 
+	bctbx_free(key);
+	if (accounts) bctbx_list_free(accounts);
+	if (candidates) bctbx_list_free(candidates);
 	return result;
 }
 
@@ -1228,9 +1431,20 @@ LinphoneCore* linphone_friend_list_get_core(const LinphoneFriendList *list) {
 	return list->lc;
 }
 
+#define FRIEND_LIST_IMPORT_PROGRESS_STEP 100
+
+static void linphone_friend_list_notify_import_progress(LinphoneFriendList *list, int imported_count, int total_count) {
+	if (list->cbs->import_progress_cb) {
+		list->cbs->import_progress_cb(list, imported_count, total_count);
+	}
+	NOTIFY_IF_EXIST(ImportProgress, import_progress, list, imported_count, total_count)
+}
+
 static LinphoneStatus linphone_friend_list_import_friends_from_vcard4(LinphoneFriendList *list, bctbx_list_t *vcards)  {
 	bctbx_list_t *vcards_iterator = NULL;
 	int count = 0;
+	int processed = 0;
+	int total;
 
 	if (!linphone_core_vcard_supported()) {
 		ms_error("vCard support wasn't enabled at compilation time");
@@ -1241,8 +1455,11 @@ static LinphoneStatus linphone_friend_list_import_friends_from_vcard4(LinphoneFr
 		return -1;
 	}
 
+	total = (int)bctbx_list_size(vcards);
 	vcards_iterator = vcards;
 
+	// Store all the friends in a single transaction, the statements are prepared once by the core.
+	linphone_core_begin_friends_db_transaction(list->lc);
 	while (vcards_iterator != NULL && bctbx_list_get_data(vcards_iterator) != NULL) {
 		LinphoneVcard *vcard = (LinphoneVcard *)bctbx_list_get_data(vcards_iterator);
 		LinphoneFriend *lf = linphone_friend_new_from_vcard(vcard);
@@ -1254,10 +1471,16 @@ static LinphoneStatus linphone_friend_list_import_friends_from_vcard4(LinphoneFr
 			}
 			linphone_friend_unref(lf);
 		}
+		processed++;
+		if (processed % FRIEND_LIST_IMPORT_PROGRESS_STEP == 0 && processed < total)
+			linphone_friend_list_notify_import_progress(list, processed, total);
 		vcards_iterator = bctbx_list_next(vcards_iterator);
 	}
 	bctbx_list_free(vcards);
 	linphone_core_store_friends_list_in_db(list->lc, list);
+	linphone_core_end_friends_db_transaction(list->lc);
+
+	linphone_friend_list_notify_import_progress(list, total, total);
 	return count;
 
 }
@@ -33,6 +33,7 @@
 #include "quality_reporting.h"
 #include "lime.h"
 #include "conference_private.h"
+#include "logger/log-collection-writer.h"
 #include "logger/logger.h"
 #include "sqlite3_bctbx_vfs.h"
 
@@ -155,6 +156,8 @@ static size_t liblinphone_log_collection_max_file_size = LOG_COLLECTION_DEFAULT_
 static ortp_mutex_t liblinphone_log_collection_mutex;
 static FILE * liblinphone_log_collection_file = NULL;
 static size_t liblinphone_log_collection_file_size = 0;
+static LinphonePrivate::LogCollectionWriter *liblinphone_log_collection_writer = NULL;
+static bool_t liblinphone_log_collection_buffering = FALSE;
 static bool_t liblinphone_serialize_logs = FALSE;
 static void set_sip_network_reachable(LinphoneCore* lc,bool_t isReachable, time_t curtime);
 static void set_media_network_reachable(LinphoneCore* lc,bool_t isReachable);
@@ -757,6 +760,48 @@ static const char* getprogname() {
 }
 #endif
 
+static void _write_log_collection_lines(const char *lines, size_t size) {
+	size_t written;
+
+	ortp_mutex_lock(&liblinphone_log_collection_mutex);
+	if (liblinphone_log_collection_file == NULL) {
+		_open_log_collection_file();
+	}
+	if (liblinphone_log_collection_file) {
+		written = fwrite(lines, 1, size, liblinphone_log_collection_file);
+		fflush(liblinphone_log_collection_file);
+		liblinphone_log_collection_file_size += written;
+		if (liblinphone_log_collection_file_size > liblinphone_log_collection_max_file_size) {
+			_close_log_collection_file();
+			_open_log_collection_file();
+		}
+	}
+	ortp_mutex_unlock(&liblinphone_log_collection_mutex);
+}
+
+/* Created on first use and never destroyed, logging threads may still reference it. */
+static LinphonePrivate::LogCollectionWriter *_get_log_collection_writer(void) {
+	if (liblinphone_log_collection_writer == NULL) {
+		liblinphone_log_collection_writer = new LinphonePrivate::LogCollectionWriter(getprogname(), _write_log_collection_lines);
+	}
+	return liblinphone_log_collection_writer;
+}
+
+static void _update_log_collection_writer(void) {
+	if (liblinphone_log_collection_buffering && liblinphone_log_collection_state != LinphoneLogCollectionDisabled) {
+		_get_log_collection_writer()->start();
+	} else if (liblinphone_log_collection_writer) {
+		liblinphone_log_collection_writer->stop();
+	}
+}
+
+/* Writes the buffered lines, to be called before touching the log collection files. */
+static void _flush_log_collection_writer(void) {
+	if (liblinphone_log_collection_writer) {
+		liblinphone_log_collection_writer->flush();
+	}
+}
+
 static void linphone_core_log_collection_handler(const char *domain, OrtpLogLevel level, const char *fmt, va_list args) {
 	const char *lname="undef";
 	char *msg;
@@ -778,10 +823,6 @@ static void linphone_core_log_collection_handler(const char *domain, OrtpLogLeve
 #endif
 	}
 
-	ortp_gettimeofday(&tp, NULL);
-	tt = (time_t)tp.tv_sec;
-	lt = localtime((const time_t*)&tt);
-
 	if ((level & ORTP_DEBUG) != 0) {
 		lname = "DEBUG";
 	} else if ((level & ORTP_MESSAGE) != 0) {
@@ -795,6 +836,15 @@ static void linphone_core_log_collection_handler(const char *domain, OrtpLogLeve
 	} else {
 		ortp_fatal("Bad level !");
 	}
+
+	if (liblinphone_log_collection_writer && liblinphone_log_collection_writer->isRunning()) {
+		liblinphone_log_collection_writer->push(domain, lname, fmt, args);
+		return;
+	}
+
+	ortp_gettimeofday(&tp, NULL);
+	tt = (time_t)tp.tv_sec;
+	lt = localtime((const time_t*)&tt);
 	msg = ortp_strdup_vprintf(fmt, args);
 
 	if (liblinphone_log_collection_file == NULL) {
@@ -833,6 +883,7 @@ void linphone_core_set_log_collection_path(const char *path) {
 		liblinphone_log_collection_path = NULL;
 	}
 	if (path != NULL) {
+		_flush_log_collection_writer();
 		ortp_mutex_lock(&liblinphone_log_collection_mutex);
 		_close_log_collection_file();
 		liblinphone_log_collection_path = ms_strdup(path);
@@ -866,6 +917,25 @@ void linphone_core_set_log_collection_max_file_size(size_t size) {
 	liblinphone_log_collection_max_file_size = size;
 }
 
+void linphone_core_enable_log_collection_buffering(bool_t enable) {
+	if (liblinphone_log_collection_buffering == enable) return;
+
+	liblinphone_log_collection_buffering = enable;
+	_update_log_collection_writer();
+}
+
+bool_t linphone_core_log_collection_buffering_enabled(void) {
+	return liblinphone_log_collection_buffering;
+}
+
+size_t linphone_core_get_log_collection_buffer_size(void) {
+	return _get_log_collection_writer()->getBufferSize();
+}
+
+void linphone_core_set_log_collection_buffer_size(size_t size) {
+	_get_log_collection_writer()->setBufferSize(size);
+}
+
 const char *linphone_core_get_log_collection_upload_server_url(LinphoneCore *core) {
 	return linphone_config_get_string(core->config, "misc", "log_collection_upload_server_url", NULL);
 }
@@ -888,8 +958,10 @@ void linphone_core_enable_log_collection(LinphoneLogCollectionState state) {
 			liblinphone_user_log_func = NULL; /*remove user log handler*/
 		}
 		bctbx_set_log_handler(liblinphone_current_log_func = linphone_core_log_collection_handler);
+		_update_log_collection_writer();
 	} else {
 		bctbx_set_log_handler(liblinphone_user_log_func); /*restaure */
+		_update_log_collection_writer();
 	}
 }
 
@@ -1082,6 +1154,7 @@ static int prepare_log_collection_file_to_upload(const char *filename) {
 	COMPRESS_FILE_PTR output_file = NULL;
 	int ret = 0;
 
+	_flush_log_collection_writer();
 	ortp_mutex_lock(&liblinphone_log_collection_mutex);
 	output_filename = ms_strdup_printf("%s/%s",
 		liblinphone_log_collection_path ? liblinphone_log_collection_path : LOG_COLLECTION_DEFAULT_PATH, filename);
@@ -1212,6 +1285,7 @@ char * linphone_core_compress_log_collection(void) {
 
 void linphone_core_reset_log_collection(void) {
 	char *filename;
+	_flush_log_collection_writer();
 	ortp_mutex_lock(&liblinphone_log_collection_mutex);
 	_close_log_collection_file();
 	clean_log_collection_upload_context(NULL);
@@ -3380,6 +3454,7 @@ void linphone_core_remove_friend_list(LinphoneCore *lc, LinphoneFriendList *list
 	if (elem == NULL) return;
 	linphone_core_remove_friends_list_from_db(lc, list);
 	linphone_core_notify_friend_list_removed(lc, list);
+	linphone_core_invalidate_friend_search_index(lc);
 	list->lc = NULL;
 	linphone_friend_list_unref(list);
 	lc->friends_lists = bctbx_list_erase_link(lc->friends_lists, elem);
@@ -3400,6 +3475,7 @@ void linphone_core_add_friend_list(LinphoneCore *lc, LinphoneFriendList *list) {
 		list->lc = lc;
 	}
 	lc->friends_lists = bctbx_list_append(lc->friends_lists, linphone_friend_list_ref(list));
+	linphone_core_invalidate_friend_search_index(lc);
 	linphone_core_store_friends_list_in_db(lc, list);
 	linphone_core_notify_friend_list_created(lc, list);
 }
@@ -4087,7 +4163,7 @@ void linphone_core_iterate(LinphoneCore *lc){
 	if (one_second_elapsed) {
 		bctbx_list_t *elem = NULL;
 		if (linphone_config_needs_commit(lc->config)) {
-			linphone_config_sync(lc->config);
+			_linphone_config_sync_in_background(lc->config);
 		}
 		for (elem = lc->friends_lists; elem != NULL; elem = bctbx_list_next(elem)) {
 			LinphoneFriendList *list = (LinphoneFriendList *)elem->data;
@@ -5883,6 +5959,7 @@ void linphone_core_remove_call_log(LinphoneCore *lc, LinphoneCallLog *cl) {
 
 void linphone_core_migrate_logs_from_rc_to_db(LinphoneCore *lc) {
 	bctbx_list_t *logs_to_migrate = NULL;
+	const bctbx_list_t *it;
 	LpConfig *lpc = NULL;
 	size_t original_logs_count, migrated_logs_count;
 	int i;
@@ -5917,11 +5994,16 @@ void linphone_core_migrate_logs_from_rc_to_db(LinphoneCore *lc) {
 		linphone_core_store_call_log(lc, log);
 	}
 
+	// Only the most recent logs are kept in lc->call_logs, count those that got a row in the db instead
 	original_logs_count = bctbx_list_size(logs_to_migrate);
-	migrated_logs_count = bctbx_list_size(lc->call_logs);
+	migrated_logs_count = 0;
+	for (it = logs_to_migrate; it != NULL; it = bctbx_list_next(it)) {
+		if (((LinphoneCallLog *)bctbx_list_get_data(it))->storage_id != 0)
+			migrated_logs_count++;
+	}
 	if (original_logs_count == migrated_logs_count) {
 		size_t i = 0;
-		ms_debug("call logs migration successful: %u logs migrated", (unsigned int)bctbx_list_size(lc->call_logs));
+		ms_debug("call logs migration successful: %u logs migrated", (unsigned int)migrated_logs_count);
 		linphone_config_set_int(lpc, "misc", "call_logs_migration_done", 1);
 
 		for (; i < original_logs_count; i++) {
@@ -7132,6 +7214,7 @@ static void codecs_config_uninit(LinphoneCore *lc)
 void friends_config_uninit(LinphoneCore* lc)
 {
 	ms_message("Destroying friends.");
+	linphone_core_invalidate_friend_search_index(lc);
 	lc->friends_lists = bctbx_list_free_with_data(lc->friends_lists, (void (*)(void*))_linphone_friend_list_release);
 	if (lc->subscribers) {
 		lc->subscribers = bctbx_list_free_with_data(lc->subscribers, (void (*)(void *))_linphone_friend_release);
@@ -7229,6 +7312,8 @@ void _linphone_core_stop_async_end(LinphoneCore *lc) {
 	sip_setup_unregister_all();
 
 	if (linphone_config_needs_commit(lc->config)) linphone_config_sync(lc->config);
+	_linphone_config_flush(lc->config);
+	_flush_log_collection_writer();
 
 	bctbx_list_for_each(lc->call_logs,(void (*)(void*))linphone_call_log_unref);
 	lc->call_logs=bctbx_list_free(lc->call_logs);
@@ -43,6 +43,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
 #if !defined(_WIN32_WCE)
 #include <errno.h>
 #include <sys/types.h>
@@ -74,14 +80,39 @@
 #include "c-wrapper/c-wrapper.h"
 #include "core/paths/paths.h"
 
+/* Hash and equality of C strings, used to index the sections and items by name. */
+struct LpStringHash {
+	size_t operator() (const char *str) const {
+		size_t hash = 2166136261u;
+		for (; *str != '\0'; str++)
+			hash = (hash ^ (unsigned char)*str) * 16777619u;
+		return hash;
+	}
+};
+
+struct LpStringEqual {
+	bool operator() (const char *a, const char *b) const {
+		return strcmp(a, b) == 0;
+	}
+};
+
 typedef struct _LpItem{
 	char *key;
 	char *value;
 	int is_comment;
 	bool_t overwrite; // If set to true, will add overwrite=true when converted to xml
 	bool_t skip; // If set to true, won't be dumped when converted to xml
+	/* Parsed values of the item, filled whenever the value is set so that the getters never write to the item. */
+	int int_value;
+	int64_t int64_value;
+	float float_value;
+	bool_t float_valid;
+	bool_t bool_value;
 } LpItem;
 
+/* The keys point to the names owned by the indexed objects. */
+typedef std::unordered_map<const char *, LpItem *, LpStringHash, LpStringEqual> LpItemIndex;
+
 typedef struct _LpSectionParam{
 	char *key;
 	char *value;
@@ -90,11 +121,33 @@ typedef struct _LpSectionParam{
 typedef struct _LpSection{
 	char *name;
 	bctbx_list_t *items;
+	LpItemIndex *items_index; // First item of each key, the items list keeps the file order and the comments.
 	bctbx_list_t *params;
+	std::string *text; // Section as written in the file, NULL when it must be serialized again.
 	bool_t overwrite; // If set to true, will add overwrite=true to all items of this section when converted to xml
 	bool_t skip; // If set to true, won't be dumped when converted to xml
 } LpSection;
 
+typedef std::unordered_map<const char *, LpSection *, LpStringHash, LpStringEqual> LpSectionIndex;
+
+/*
+ * Writes snapshots of the config to the disk in a background thread. A new snapshot replaces the pending one, so
+ * a burst of changes is written only once.
+ */
+typedef struct _LpConfigWriter{
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::string pending;
+	bool has_pending = false;
+	bool writing = false;
+	bool stopped = false;
+	std::atomic<bool> failed{false};
+	std::string filename;
+	std::string tmpfilename;
+	bctbx_vfs_t *vfs = NULL;
+} LpConfigWriter;
+
 struct _LpConfig{
 	belle_sip_object_t base;
 	bctbx_vfs_file_t* pFile;
@@ -102,6 +155,8 @@ struct _LpConfig{
 	char *tmpfilename;
 	char *factory_filename;
 	bctbx_list_t *sections;
+	LpSectionIndex *sections_index;
+	LpConfigWriter *writer;
 	bool_t modified;
 	bool_t readonly;
 	bctbx_vfs_t* g_bctbx_vfs;
@@ -122,13 +177,46 @@ char* lp_realpath(const char* file, char* name) {
 #endif
 }
 
+static void lp_item_parse_value(LpItem *item){
+	const char *str=item->value;
+	int ret=0;
+
+	if (strstr(str,"0x")==str){
+		sscanf(str,"%x",&ret);
+	}else
+		sscanf(str,"%i",&ret);
+	item->int_value=ret;
+
+	ret=0;
+	sscanf(str,"%i",&ret);
+	item->bool_value=ret!=0;
+
+#ifdef _WIN32
+	item->int64_value=(int64_t)_atoi64(str);
+#else
+	item->int64_value=atoll(str);
+#endif
+
+	item->float_valid=sscanf(str,"%f",&item->float_value)==1;
+}
+
 LpItem * lp_item_new(const char *key, const char *value){
 	LpItem *item=lp_new0(LpItem,1);
 	item->key=ortp_strdup(key);
 	item->value=ortp_strdup(value);
+	lp_item_parse_value(item);
 	return item;
 }
 
+void lp_item_set_value(LpItem *item, const char *value){
+	if (item->value != value) {
+		char *prev_value=item->value;
+		item->value=ortp_strdup(value);
+		ortp_free(prev_value);
+		lp_item_parse_value(item);
+	}
+}
+
 LpItem * lp_comment_new(const char *comment){
 	LpItem *item=lp_new0(LpItem,1);
 	char* pos = NULL;
@@ -155,6 +243,7 @@ LpSectionParam *lp_section_param_new(const char *key, const char *value){
 LpSection *lp_section_new(const char *name){
 	LpSection *sec=lp_new0(LpSection,1);
 	sec->name=ortp_strdup(name);
+	sec->items_index=new LpItemIndex();
 	return sec;
 }
 
@@ -173,32 +262,89 @@ void lp_section_param_destroy(void *section_param){
 }
 
 void lp_section_destroy(LpSection *sec){
+	delete sec->items_index;
+	delete sec->text;
 	ortp_free(sec->name);
 	bctbx_list_for_each(sec->items,lp_item_destroy);
 	bctbx_list_for_each(sec->params,lp_section_param_destroy);
 	bctbx_list_free(sec->items);
+	bctbx_list_free(sec->params);
 	free(sec);
 }
 
+static void lp_section_set_modified(LpSection *sec){
+	delete sec->text;
+	sec->text = NULL;
+}
+
+static void lp_section_set_item_value(LpSection *sec, LpItem *item, const char *value){
+	lp_section_set_modified(sec);
+	lp_item_set_value(item, value);
+}
+
 void lp_section_add_item(LpSection *sec,LpItem *item){
+	lp_section_set_modified(sec);
 	sec->items=bctbx_list_append(sec->items,(void *)item);
+	if (!item->is_comment)
+		sec->items_index->emplace(item->key, item);
+}
+
+static void linphone_config_clear_sections(LpConfig *lpconfig){
+	bctbx_list_for_each(lpconfig->sections,(void (*)(void*))lp_section_destroy);
+	bctbx_list_free(lpconfig->sections);
+	lpconfig->sections = NULL;
+	delete lpconfig->sections_index;
+	lpconfig->sections_index = NULL;
 }
 
 void linphone_config_add_section(LpConfig *lpconfig, LpSection *section){
 	lpconfig->sections=bctbx_list_append(lpconfig->sections,(void *)section);
+	if (!lpconfig->sections_index)
+		lpconfig->sections_index = new LpSectionIndex();
+	lpconfig->sections_index->emplace(section->name, section);
 }
 
 void linphone_config_add_section_param(LpSection *section, LpSectionParam *param){
+	lp_section_set_modified(section);
 	section->params = bctbx_list_append(section->params, (void *)param);
 }
 
 void linphone_config_remove_section(LpConfig *lpconfig, LpSection *section){
+	bctbx_list_t *elem;
 	lpconfig->sections=bctbx_list_remove(lpconfig->sections,(void *)section);
+	auto it = lpconfig->sections_index->find(section->name);
+	if (it != lpconfig->sections_index->end() && it->second == section) {
+		lpconfig->sections_index->erase(it);
+		/* Index the next section with the same name, if any. */
+		for (elem = lpconfig->sections; elem != NULL; elem = bctbx_list_next(elem)) {
+			LpSection *other = (LpSection *)elem->data;
+			if (strcmp(other->name, section->name) == 0) {
+				lpconfig->sections_index->emplace(other->name, other);
+				break;
+			}
+		}
+	}
 	lp_section_destroy(section);
 }
 
 void lp_section_remove_item(LpSection *sec, LpItem *item){
+	bctbx_list_t *elem;
+	lp_section_set_modified(sec);
 	sec->items=bctbx_list_remove(sec->items,(void *)item);
+	if (!item->is_comment) {
+		auto it = sec->items_index->find(item->key);
+		if (it != sec->items_index->end() && it->second == item) {
+			sec->items_index->erase(it);
+			/* Index the next item with the same key, if any. */
+			for (elem = sec->items; elem != NULL; elem = bctbx_list_next(elem)) {
+				LpItem *other = (LpItem *)elem->data;
+				if (!other->is_comment && strcmp(other->key, item->key) == 0) {
+					sec->items_index->emplace(other->key, other);
+					break;
+				}
+			}
+		}
+	}
 	lp_item_destroy(item);
 }
 
@@ -219,17 +365,9 @@ static int is_a_comment(const char *str){
 }
 
 LpSection *linphone_config_find_section(const LpConfig *lpconfig, const char *name){
-	LpSection *sec;
-	bctbx_list_t *elem = lpconfig->sections;
-	/*printf("Looking for section %s\n",name);*/
-	for (;elem!=NULL;elem=bctbx_list_next(elem)){
-		sec=(LpSection*)elem->data;
-		if (strcmp(sec->name,name)==0){
-			/*printf("Section %s found\n",name);*/
-			return sec;
-		}
-	}
-	return NULL;
+	if (!lpconfig->sections_index) return NULL;
+	auto it = lpconfig->sections_index->find(name);
+	return it != lpconfig->sections_index->end() ? it->second : NULL;
 }
 
 LpSectionParam *lp_section_find_param(const LpSection *sec, const char *key){
@@ -259,17 +397,15 @@ LpItem *lp_section_find_comment(const LpSection *sec, const char *comment){
 }
 
 LpItem *lp_section_find_item(const LpSection *sec, const char *name){
-	bctbx_list_t *elem;
-	LpItem *item;
-	/*printf("Looking for item %s\n",name);*/
-	for (elem=sec->items;elem!=NULL;elem=bctbx_list_next(elem)){
-		item=(LpItem*)elem->data;
-		if (!item->is_comment && strcmp(item->key,name)==0) {
-			/*printf("Item %s found\n",name);*/
-			return item;
-		}
-	}
-	return NULL;
+	auto it = sec->items_index->find(name);
+	return it != sec->items_index->end() ? it->second : NULL;
+}
+
+static LpItem *linphone_config_find_item(const LpConfig *lpconfig, const char *section, const char *key){
+	LpSection *sec = linphone_config_find_section(lpconfig, section);
+	if (sec == NULL) return NULL;
+	LpItem *item = lp_section_find_item(sec, key);
+	return (item != NULL && item->value != NULL) ? item : NULL;
 }
 
 bctbx_list_t *lp_section_get_items(const LpSection *sec){
@@ -376,8 +512,7 @@ static LpSection* linphone_config_parse_line(LpConfig* lpconfig, char* line, LpS
 							if (item==NULL){
 								lp_section_add_item(cur,lp_item_new(key,pos1));
 							}else{
-								ortp_free(item->value);
-								item->value=ortp_strdup(pos1);
+								lp_section_set_item_value(cur, item, pos1);
 							}
 							/*ms_message("Found %s=%s",key,pos1);*/
 						}else{
@@ -607,21 +742,15 @@ LinphoneStatus linphone_config_load_from_xml_string(LpConfig *lpc, const char *b
 		return 0;
 }
 
-void lp_item_set_value(LpItem *item, const char *value){
-	if (item->value != value) {
-		char *prev_value=item->value;
-		item->value=ortp_strdup(value);
-		ortp_free(prev_value);
-	}
-}
 
+static void linphone_config_stop_writer(LpConfig *lpconfig);
 
 static void _linphone_config_uninit(LpConfig *lpconfig){
+	linphone_config_stop_writer(lpconfig);
 	if (lpconfig->filename!=NULL) ortp_free(lpconfig->filename);
 	if (lpconfig->tmpfilename) ortp_free(lpconfig->tmpfilename);
 	if (lpconfig->factory_filename) bctbx_free(lpconfig->factory_filename);
-	bctbx_list_for_each(lpconfig->sections,(void (*)(void*))lp_section_destroy);
-	bctbx_list_free(lpconfig->sections);
+	linphone_config_clear_sections(lpconfig);
 }
 
 LpConfig *linphone_config_ref(LpConfig *lpconfig){
@@ -703,47 +832,29 @@ bool_t linphone_config_get_range(const LpConfig *lpconfig, const char *section,
 }
 
 int linphone_config_get_int(const LpConfig *lpconfig,const char *section, const char *key, int default_value){
-	const char *str=linphone_config_get_string(lpconfig,section,key,NULL);
-	if (str!=NULL) {
-		int ret=0;
-
-		if (strstr(str,"0x")==str){
-			sscanf(str,"%x",&ret);
-		}else
-			sscanf(str,"%i",&ret);
-		return ret;
-	}
-	else return default_value;
+	const LpItem *item=linphone_config_find_item(lpconfig,section,key);
+	if (item==NULL) return default_value;
+	return item->int_value;
 }
 
 bool_t linphone_config_get_bool(const LpConfig *lpconfig, const char *section, const char *key, bool_t default_value) {
-	const char *str = linphone_config_get_string(lpconfig, section, key, NULL);
-	if (str != NULL) {
-		int ret = 0;
-		sscanf(str, "%i", &ret);
-		return ret != 0;
-	}
-	return default_value;
+	const LpItem *item = linphone_config_find_item(lpconfig, section, key);
+	if (item == NULL) return default_value;
+	return item->bool_value;
 }
 
 int64_t linphone_config_get_int64(const LpConfig *lpconfig,const char *section, const char *key, int64_t default_value){
-	const char *str=linphone_config_get_string(lpconfig,section,key,NULL);
-	if (str!=NULL) {
-#ifdef _WIN32
-		return (int64_t)_atoi64(str);
-#else
-		return atoll(str);
-#endif
-	}
-	else return default_value;
+	const LpItem *item=linphone_config_find_item(lpconfig,section,key);
+	if (item==NULL) return default_value;
+	return item->int64_value;
 }
 
 float linphone_config_get_float(const LpConfig *lpconfig,const char *section, const char *key, float default_value){
-	const char *str=linphone_config_get_string(lpconfig,section,key,NULL);
-	float ret=default_value;
-	if (str==NULL) return default_value;
-	sscanf(str,"%f",&ret);
-	return ret;
+	const LpItem *item=linphone_config_find_item(lpconfig,section,key);
+	if (item==NULL) return default_value;
+	/* Like sscanf, keep the default value when the string isn't a float. */
+	if (!item->float_valid) return default_value;
+	return item->float_value;
 }
 
 bool_t linphone_config_get_overwrite_flag_for_entry(const LpConfig *lpconfig, const char *section, const char *key) {
@@ -794,7 +905,7 @@ void linphone_config_set_string(LpConfig *lpconfig,const char *section, const ch
 		if (item!=NULL){
 			if ((value != NULL) && (value[0] != '\0')) {
 				if (strcmp(value, item->value) == 0) return;
-				lp_item_set_value(item, value);
+				lp_section_set_item_value(sec, item, value);
 			} else {
 				lp_section_remove_item(sec, item);
 			}
@@ -901,83 +1012,175 @@ void linphone_config_set_skip_flag_for_section(LpConfig *lpconfig, const char *s
 	}
 }
 
-void lp_item_write(LpItem *item, LpConfig *lpconfig){
-	int ret =-1 ;
+static void lp_item_serialize(const LpItem *item, std::string &text){
 	if (item->is_comment){
-		ret = (int)bctbx_file_fprintf(lpconfig->pFile, 0, "%s\n",item->value);
-
+		text.append(item->value).append("\n");
 	}
 	else if (item->value && item->value[0] != '\0' ){
-		ret = (int)bctbx_file_fprintf(lpconfig->pFile, 0, "%s=%s\n",item->key,item->value);
+		text.append(item->key).append("=").append(item->value).append("\n");
 	}
-
 	else {
 		ms_warning("Not writing item %s to file, it is empty", item->key);
 	}
-	if (ret < 0){
-		ms_error("lp_item_write : not writing item to file" );
-	}
 }
 
-void lp_section_param_write(LpSectionParam *param, LpConfig *lpconfig){
+static void lp_section_param_serialize(const LpSectionParam *param, std::string &text){
 	if( param->value && param->value[0] != '\0') {
-		bctbx_file_fprintf(lpconfig->pFile, 0, " %s=%s", param->key, param->value);
-
+		text.append(" ").append(param->key).append("=").append(param->value);
 	} else {
 		ms_warning("Not writing param %s to file, it is empty", param->key);
 	}
 }
 
-void lp_section_write(LpSection *sec,LpConfig *lpconfig){
-
-	if (bctbx_file_fprintf(lpconfig->pFile, 0, "[%s",sec->name) < 0) ms_error("lp_section_write : write error on %s", sec->name);
-	bctbx_list_for_each2(sec->params, (void (*)(void*, void*))lp_section_param_write, (void *)lpconfig);
-
-	if (bctbx_file_fprintf(lpconfig->pFile, 0, "]\n")< 0) ms_error("lp_section_write : write error ");
-	bctbx_list_for_each2(sec->items, (void (*)(void*, void*))lp_item_write, (void *)lpconfig);
-
-	if (bctbx_file_fprintf(lpconfig->pFile, 0, "\n")< 0) ms_error("lp_section_write : write error");
-
+static const std::string &lp_section_serialize(LpSection *sec){
+	const bctbx_list_t *elem;
+	if (sec->text) return *sec->text;
+
+	sec->text = new std::string("[");
+	sec->text->append(sec->name);
+	for (elem = sec->params; elem != NULL; elem = bctbx_list_next(elem))
+		lp_section_param_serialize((const LpSectionParam *)elem->data, *sec->text);
+	sec->text->append("]\n");
+	for (elem = sec->items; elem != NULL; elem = bctbx_list_next(elem))
+		lp_item_serialize((const LpItem *)elem->data, *sec->text);
+	sec->text->append("\n");
+	return *sec->text;
+}
+
+/* Only the sections modified since the previous snapshot are serialized again. */
+static std::string linphone_config_snapshot(LpConfig *lpconfig){
+	std::string text;
+	const bctbx_list_t *elem;
+	for (elem = lpconfig->sections; elem != NULL; elem = bctbx_list_next(elem))
+		text.append(lp_section_serialize((LpSection *)elem->data));
+	return text;
 }
 
-LinphoneStatus linphone_config_sync(LpConfig *lpconfig){
+/* Writes the content in the temporary file then renames it, so that the config file is never partially written. */
+static int linphone_config_write_file(bctbx_vfs_t *vfs, const char *filename, const char *tmpfilename, const std::string &content){
 	bctbx_vfs_file_t *pFile = NULL;
-	if (lpconfig->filename==NULL) return -1;
-	if (lpconfig->readonly) return 0;
 
 #ifndef _WIN32
 	/* don't create group/world-accessible files */
 	(void) umask(S_IRWXG | S_IRWXO);
 #endif
-	pFile  = bctbx_file_open(lpconfig->g_bctbx_vfs,lpconfig->tmpfilename, "w");
-	lpconfig->pFile = pFile;
+	pFile  = bctbx_file_open(vfs, tmpfilename, "w");
 	if (pFile == NULL){
-		ms_warning("Could not write %s ! Maybe it is read-only. Configuration will not be saved.",lpconfig->filename);
-		lpconfig->readonly = TRUE;
+		ms_warning("Could not write %s ! Maybe it is read-only. Configuration will not be saved.",filename);
 		return -1;
 	}
 
-	bctbx_list_for_each2(lpconfig->sections,(void (*)(void *,void*))lp_section_write,(void *)lpconfig);
+	if (!content.empty() && bctbx_file_write(pFile, content.c_str(), content.size(), 0) < 0)
+		ms_error("linphone_config_write_file : write error on %s", tmpfilename);
 	bctbx_file_close(pFile);
 
 #ifdef RENAME_REQUIRES_NONEXISTENT_NEW_PATH
 	/* On windows, rename() does not accept that the newpath is an existing file, while it is accepted on Unix.
 	 * As a result, we are forced to first delete the linphonerc file, and then rename.*/
-	if (remove(lpconfig->filename)!=0){
-		ms_error("Cannot remove %s: %s",lpconfig->filename, strerror(errno));
+	if (remove(filename)!=0){
+		ms_error("Cannot remove %s: %s",filename, strerror(errno));
 	}
 #endif
-	if (rename(lpconfig->tmpfilename,lpconfig->filename)!=0){
-		ms_error("Cannot rename %s into %s: %s",lpconfig->tmpfilename,lpconfig->filename,strerror(errno));
+	if (rename(tmpfilename,filename)!=0){
+		ms_error("Cannot rename %s into %s: %s",tmpfilename,filename,strerror(errno));
+	}
+	return 0;
+}
+
+static void linphone_config_writer_run(LpConfigWriter *writer){
+	std::unique_lock<std::mutex> lock(writer->mutex);
+	while (true) {
+		writer->condition.wait(lock, [writer] { return writer->has_pending || writer->stopped; });
+		if (!writer->has_pending) break;
+
+		std::string content;
+		content.swap(writer->pending);
+		writer->has_pending = false;
+		writer->writing = true;
+		lock.unlock();
+
+		if (linphone_config_write_file(writer->vfs, writer->filename.c_str(), writer->tmpfilename.c_str(), content) != 0)
+			writer->failed = true;
+
+		lock.lock();
+		writer->writing = false;
+		writer->condition.notify_all();
 	}
+}
+
+static void linphone_config_flush_writer(LpConfig *lpconfig){
+	LpConfigWriter *writer = lpconfig->writer;
+	if (!writer) return;
+
+	std::unique_lock<std::mutex> lock(writer->mutex);
+	writer->condition.wait(lock, [writer] { return !writer->has_pending && !writer->writing; });
+	lock.unlock();
+	if (writer->failed) lpconfig->readonly = TRUE;
+}
+
+static void linphone_config_stop_writer(LpConfig *lpconfig){
+	LpConfigWriter *writer = lpconfig->writer;
+	if (!writer) return;
+
+	{
+		std::lock_guard<std::mutex> lock(writer->mutex);
+		writer->stopped = true;
+	}
+	writer->condition.notify_all();
+	// The pending snapshot is written before the thread exits.
+	writer->thread.join();
+	delete writer;
+	lpconfig->writer = NULL;
+}
+
+LinphoneStatus linphone_config_sync(LpConfig *lpconfig){
+	if (lpconfig->filename==NULL) return -1;
+	if (lpconfig->readonly) return 0;
+
+	// A snapshot written by the background thread must not overwrite this one.
+	linphone_config_flush_writer(lpconfig);
+	if (linphone_config_write_file(lpconfig->g_bctbx_vfs, lpconfig->filename, lpconfig->tmpfilename, linphone_config_snapshot(lpconfig)) != 0){
+		lpconfig->readonly = TRUE;
+		return -1;
+	}
+	lpconfig->modified = FALSE;
+	return 0;
+}
+
+LinphoneStatus _linphone_config_sync_in_background(LpConfig *lpconfig){
+	LpConfigWriter *writer;
+	if (lpconfig->filename==NULL) return -1;
+	if (lpconfig->writer && lpconfig->writer->failed) lpconfig->readonly = TRUE;
+	if (lpconfig->readonly) return 0;
+
+	if (!lpconfig->writer) {
+		writer = new LpConfigWriter();
+		writer->filename = lpconfig->filename;
+		writer->tmpfilename = lpconfig->tmpfilename;
+		writer->vfs = lpconfig->g_bctbx_vfs;
+		writer->thread = std::thread(linphone_config_writer_run, writer);
+		lpconfig->writer = writer;
+	}
+	writer = lpconfig->writer;
+
+	std::string content = linphone_config_snapshot(lpconfig);
+	{
+		std::lock_guard<std::mutex> lock(writer->mutex);
+		writer->pending.swap(content);
+		writer->has_pending = true;
+	}
+	writer->condition.notify_one();
 	lpconfig->modified = FALSE;
 	return 0;
 }
 
+void _linphone_config_flush(LpConfig *lpconfig){
+	linphone_config_flush_writer(lpconfig);
+}
+
 void linphone_config_reload(LinphoneConfig *lpconfig) {
-	bctbx_list_for_each(lpconfig->sections, (void (*)(void*)) lp_section_destroy);
-	bctbx_list_free(lpconfig->sections);
-	lpconfig->sections = NULL;
+	linphone_config_flush_writer(lpconfig);
+	linphone_config_clear_sections(lpconfig);
 	linphone_config_read_file(lpconfig, lpconfig->filename);
 }
 
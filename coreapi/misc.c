@@ -178,11 +178,22 @@ int parse_hostname_to_addr(const char *server, struct sockaddr_storage *ss, sock
 	return 0;
 }
 
-/* this functions runs a simple stun test and return the number of milliseconds to complete the tests, or -1 if the test were failed.*/
+/* this functions runs a simple stun test and return the number of milliseconds to complete the tests, or -1 if the test were failed.
+ * The core is iterated until the discovery is done.*/
 int linphone_run_stun_tests(LinphoneCore *lc, int audioPort, int videoPort, int textPort,
 	char *audioCandidateAddr, int *audioCandidatePort, char *videoCandidateAddr, int *videoCandidatePort, char *textCandidateAddr, int *textCandidatePort) {
 	LinphonePrivate::StunClient *client = new LinphonePrivate::StunClient(L_GET_CPP_PTR_FROM_C_OBJECT(lc));
-	int ret = client->run(audioPort, videoPort, textPort);
+	int ret = -1;
+	bool done = false;
+	if (client->start(audioPort, videoPort, textPort, [&ret, &done](int pingTime) {
+		ret = pingTime;
+		done = true;
+	})) {
+		while (!done) {
+			linphone_core_iterate(lc);
+			ms_usleep(10000);
+		}
+	}
 	strncpy(audioCandidateAddr, client->getAudioCandidate().address.c_str(), LINPHONE_IPADDR_SIZE);
 	*audioCandidatePort = client->getAudioCandidate().port;
 	strncpy(videoCandidateAddr, client->getVideoCandidate().address.c_str(), LINPHONE_IPADDR_SIZE);
@@ -205,6 +205,8 @@ void _linphone_friend_list_update_subscriptions(LinphoneFriendList *list, Linpho
 void linphone_core_friends_storage_init(LinphoneCore *lc);
 void linphone_core_friends_storage_close(LinphoneCore *lc);
 void linphone_core_store_friend_in_db(LinphoneCore *lc, LinphoneFriend *lf);
+void linphone_core_begin_friends_db_transaction(LinphoneCore *lc);
+void linphone_core_end_friends_db_transaction(LinphoneCore *lc);
 void linphone_core_remove_friend_from_db(LinphoneCore *lc, LinphoneFriend *lf);
 void linphone_core_store_friends_list_in_db(LinphoneCore *lc, LinphoneFriendList *list);
 void linphone_core_remove_friends_list_from_db(LinphoneCore *lc, LinphoneFriendList *list);
@@ -214,6 +216,12 @@ LINPHONE_PUBLIC LinphoneFriendListStatus linphone_friend_list_import_friend(Linp
 LinphoneFriendListCbs * linphone_friend_list_cbs_new(void);
 void linphone_friend_list_set_current_callbacks(LinphoneFriendList *friend_list, LinphoneFriendListCbs *cbs);
 void linphone_friend_add_addresses_and_numbers_into_maps(LinphoneFriend *lf, LinphoneFriendList *list);
+void linphone_friend_list_add_phone_number_to_map(LinphoneFriendList *list, LinphoneFriend *lf, const char *phone_number);
+void linphone_friend_list_remove_phone_number_from_map(LinphoneFriendList *list, LinphoneFriend *lf, const char *phone_number);
+void linphone_friend_list_invalidate_phone_number_map(LinphoneFriendList *list);
+void linphone_core_update_friend_in_search_index(LinphoneCore *lc, const LinphoneFriend *lf);
+void linphone_core_remove_friend_from_search_index(LinphoneCore *lc, const LinphoneFriend *lf);
+void linphone_core_invalidate_friend_search_index(LinphoneCore *lc);
 
 int linphone_parse_host_port(const char *input, char *host, size_t hostlen, int *port);
 int parse_hostname_to_addr(const char *server, struct sockaddr_storage *ss, socklen_t *socklen, int default_port);
@@ -377,6 +385,7 @@ void _linphone_chat_message_notify_ephemeral_message_deleted(LinphoneChatMessage
 void _linphone_chat_message_clear_callbacks (LinphoneChatMessage *msg);
 
 void _linphone_magic_search_notify_search_results_received(LinphoneMagicSearch* magic_search);
+void _linphone_magic_search_notify_partial_search_results_received(LinphoneMagicSearch* magic_search);
 
 
 const LinphoneParticipantImdnState *_linphone_participant_imdn_state_from_cpp_obj (const LinphonePrivate::ParticipantImdnState &state);
@@ -670,6 +679,10 @@ LinphoneVideoDefinition * linphone_factory_find_supported_video_definition_by_na
 const char* _linphone_config_load_from_xml_string(LpConfig *lpc, const char *buffer);
 LinphoneNatPolicy * linphone_config_create_nat_policy_from_section(const LinphoneConfig *config, const char* section);
 void _linphone_config_apply_factory_config (LpConfig *config);
+/* Writes a snapshot of the config in a background thread, a newer snapshot replaces a pending one. */
+LinphoneStatus _linphone_config_sync_in_background(LpConfig *lpconfig);
+/* Waits until all the snapshots are written. */
+void _linphone_config_flush(LpConfig *lpconfig);
 
 SalCustomHeader *linphone_info_message_get_headers (const LinphoneInfoMessage *im);
 void linphone_info_message_set_headers (LinphoneInfoMessage *im, const SalCustomHeader *headers);
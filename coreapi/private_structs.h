@@ -135,6 +135,7 @@ struct _LinphoneFriendListCbs {
 	LinphoneFriendListCbsContactUpdatedCb contact_updated_cb;
 	LinphoneFriendListCbsSyncStateChangedCb sync_state_changed_cb;
 	LinphoneFriendListCbsPresenceReceivedCb presence_received_cb;
+	LinphoneFriendListCbsImportProgressCb import_progress_cb;
 };
 
 BELLE_SIP_DECLARE_VPTR_NO_EXPORT(LinphoneFriendListCbs);
@@ -150,6 +151,8 @@ struct _LinphoneFriendList {
 	MSList *friends;
 	bctbx_map_t *friends_map;
 	bctbx_map_t *friends_map_uri;
+	bctbx_map_t *friends_map_phone_number; /* built on first lookup by phone number */
+	char *friends_map_phone_number_key; /* normalization parameters of the accounts used to build it */
 	unsigned char *content_digest;
 	int expected_notification_version;
 	unsigned int storage_id;
@@ -816,6 +819,9 @@ namespace LinphonePrivate {
 	bctbx_mutex_t zrtp_cache_db_mutex; \
 	sqlite3 *logs_db; \
 	sqlite3 *friends_db; \
+	sqlite3_stmt *friends_insert_stmt; \
+	sqlite3_stmt *friends_update_stmt; \
+	int friends_db_transaction_depth; \
 	bool_t debug_storage; \
 	void *system_context; \
 	bool_t is_unreffing; \
@@ -74,6 +74,7 @@ struct _LinphoneVcard {
 	char *url;
 	unsigned char md5[VCARD_MD5_HASH_SIZE];
 	bctbx_list_t *sip_addresses_cache;
+	char *vcard4_string; // Serialized vCard, kept until the next modification.
 };
 
 extern "C" {
@@ -82,9 +83,17 @@ static void _linphone_vcard_uninit(LinphoneVcard *vCard) {
 	if (vCard->etag) ms_free(vCard->etag);
 	if (vCard->url) ms_free(vCard->url);
 	linphone_vcard_clean_cache(vCard);
+	if (vCard->vcard4_string) ms_free(vCard->vcard4_string);
 	vCard->belCard.~shared_ptr<belcard::BelCard>();
 }
 
+static void linphone_vcard_set_modified(LinphoneVcard *vCard) {
+	if (vCard->vcard4_string) {
+		ms_free(vCard->vcard4_string);
+		vCard->vcard4_string = NULL;
+	}
+}
+
 BELLE_SIP_DECLARE_VPTR_NO_EXPORT(LinphoneVcard);
 BELLE_SIP_DECLARE_NO_IMPLEMENTED_INTERFACES(LinphoneVcard);
 BELLE_SIP_INSTANCIATE_VPTR(LinphoneVcard, belle_sip_object_t,
@@ -184,15 +193,20 @@ LinphoneVcard* linphone_vcard_context_get_vcard_from_buffer(LinphoneVcardContext
 const char * linphone_vcard_as_vcard4_string(LinphoneVcard *vCard) {
 	if (!vCard) return NULL;
 
-	return vCard->belCard->toFoldedString().c_str();
+	if (!vCard->vcard4_string)
+		vCard->vcard4_string = ms_strdup(vCard->belCard->toFoldedString().c_str());
+	return vCard->vcard4_string;
 }
 
 void *linphone_vcard_get_belcard(LinphoneVcard *vcard) {
+	// The caller may modify the belcard.
+	linphone_vcard_set_modified(vcard);
 	return &vcard->belCard;
 }
 
 void linphone_vcard_set_full_name(LinphoneVcard *vCard, const char *name) {
 	if (!vCard || !name) return;
+	linphone_vcard_set_modified(vCard);
 
 	if (vCard->belCard->getFullName()) {
 		vCard->belCard->getFullName()->setValue(name);
@@ -225,6 +239,7 @@ bool_t linphone_vcard_get_skip_validation(const LinphoneVcard *vCard) {
 
 void linphone_vcard_set_family_name(LinphoneVcard *vCard, const char *name) {
 	if (!vCard || !name) return;
+	linphone_vcard_set_modified(vCard);
 
 	if (vCard->belCard->getName()) {
 		vCard->belCard->getName()->setFamilyName(name);
@@ -244,6 +259,7 @@ const char* linphone_vcard_get_family_name(const LinphoneVcard *vCard) {
 
 void linphone_vcard_set_given_name(LinphoneVcard *vCard, const char *name) {
 	if (!vCard || !name) return;
+	linphone_vcard_set_modified(vCard);
 
 	if (vCard->belCard->getName()) {
 		vCard->belCard->getName()->setGivenName(name);
@@ -263,6 +279,7 @@ const char* linphone_vcard_get_given_name(const LinphoneVcard *vCard) {
 
 void linphone_vcard_add_sip_address(LinphoneVcard *vCard, const char *sip_address) {
 	if (!vCard || !sip_address) return;
+	linphone_vcard_set_modified(vCard);
 
 	shared_ptr<belcard::BelCardImpp> impp = belcard::BelCardGeneric::create<belcard::BelCardImpp>();
 	impp->setValue(sip_address);
@@ -273,6 +290,7 @@ void linphone_vcard_add_sip_address(LinphoneVcard *vCard, const char *sip_addres
 
 void linphone_vcard_remove_sip_address(LinphoneVcard *vCard, const char *sip_address) {
 	if (!vCard) return;
+	linphone_vcard_set_modified(vCard);
 
 	for (auto &impp : vCard->belCard->getImpp()) {
 		const char *value = impp->getValue().c_str();
@@ -285,6 +303,7 @@ void linphone_vcard_remove_sip_address(LinphoneVcard *vCard, const char *sip_add
 
 void linphone_vcard_edit_main_sip_address(LinphoneVcard *vCard, const char *sip_address) {
 	if (!vCard || !sip_address) return;
+	linphone_vcard_set_modified(vCard);
 
 	if (vCard->belCard->getImpp().size() > 0) {
 		const shared_ptr<belcard::BelCardImpp> impp = vCard->belCard->getImpp().front();
@@ -316,6 +335,7 @@ const bctbx_list_t* linphone_vcard_get_sip_addresses(LinphoneVcard *vCard) {
 
 void linphone_vcard_add_phone_number(LinphoneVcard *vCard, const char *phone) {
 	if (!vCard || !phone) return;
+	linphone_vcard_set_modified(vCard);
 
 	shared_ptr<belcard::BelCardPhoneNumber> phone_number = belcard::BelCardGeneric::create<belcard::BelCardPhoneNumber>();
 	phone_number->setValue(phone);
@@ -324,6 +344,7 @@ void linphone_vcard_add_phone_number(LinphoneVcard *vCard, const char *phone) {
 
 void linphone_vcard_remove_phone_number(LinphoneVcard *vCard, const char *phone) {
 	if (!vCard) return;
+	linphone_vcard_set_modified(vCard);
 
 	shared_ptr<belcard::BelCardPhoneNumber> tel;
 	for (auto &phoneNumber : vCard->belCard->getPhoneNumbers()) {
@@ -348,6 +369,7 @@ bctbx_list_t* linphone_vcard_get_phone_numbers(const LinphoneVcard *vCard) {
 
 void linphone_vcard_set_organization(LinphoneVcard *vCard, const char *organization) {
 	if (!vCard) return;
+	linphone_vcard_set_modified(vCard);
 
 	if (!organization) {
 		linphone_vcard_remove_organization(vCard);
@@ -372,6 +394,7 @@ const char* linphone_vcard_get_organization(const LinphoneVcard *vCard) {
 
 void linphone_vcard_remove_organization(LinphoneVcard *vCard) {
 	if (!vCard) return;
+	linphone_vcard_set_modified(vCard);
 
 	if (vCard->belCard->getOrganizations().size() > 0) {
 		const shared_ptr<belcard::BelCardOrganization> org = vCard->belCard->getOrganizations().front();
@@ -393,6 +416,7 @@ bool_t linphone_vcard_generate_unique_id(LinphoneVcard *vCard) {
 
 void linphone_vcard_set_uid(LinphoneVcard *vCard, const char *uid) {
 	if (!vCard || !uid) return;
+	linphone_vcard_set_modified(vCard);
 
 	shared_ptr<belcard::BelCardUniqueId> uniqueId = belcard::BelCardGeneric::create<belcard::BelCardUniqueId>();
 	uniqueId->setValue(uid);
@@ -507,6 +507,13 @@ typedef void (*LinphoneConferenceCbsParticipantDeviceRemovedCb) (LinphoneConfere
  */
 typedef void (*LinphoneMagicSearchCbsSearchResultsReceivedCb)(LinphoneMagicSearch* magic_search);
 
+/**
+ * Callback used to notify that a source of an asynchronous search ended before the others.
+ * The results ranked so far are available with linphone_magic_search_get_last_search().
+ * @param magic_search #LinphoneMagicSearch object @notnil
+ */
+typedef void (*LinphoneMagicSearchCbsPartialSearchResultsReceivedCb)(LinphoneMagicSearch* magic_search);
+
 /**
 * @}
 **/	
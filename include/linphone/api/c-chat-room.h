@@ -289,6 +289,16 @@ LINPHONE_PUBLIC bctbx_list_t *linphone_chat_room_get_history_events (LinphoneCha
  */
 LINPHONE_PUBLIC bctbx_list_t *linphone_chat_room_get_history_range_events (LinphoneChatRoom *chat_room, int begin, int end);
 
+/**
+ * Gets the events that are older than the given one, sorted from oldest to most recent.
+ * Unlike #linphone_chat_room_get_history_range_events(), the cost of this call does not grow with the depth of the page in the history.
+ * @param chat_room The #LinphoneChatRoom object corresponding to the conversation for which events should be retrieved @notnil
+ * @param event_log The oldest #LinphoneEventLog already retrieved, or NULL to get the most recent events. @maybenil
+ * @param nb_events Number of events to retrieve.
+ * @return The list of the found events. \bctbx_list{LinphoneEventLog} @tobefreed
+ */
+LINPHONE_PUBLIC bctbx_list_t *linphone_chat_room_get_history_range_events_before (LinphoneChatRoom *chat_room, const LinphoneEventLog *event_log, int nb_events);
+
 /**
  * Gets the number of events in a chat room.
  * @param chat_room The #LinphoneChatRoom object corresponding to the conversation for which size has to be computed @notnil
@@ -77,6 +77,20 @@ LINPHONE_PUBLIC LinphoneMagicSearchCbsSearchResultsReceivedCb linphone_magic_sea
  */
 LINPHONE_PUBLIC void linphone_magic_search_cbs_set_search_results_received (LinphoneMagicSearchCbs *cbs, LinphoneMagicSearchCbsSearchResultsReceivedCb cb);
 
+/**
+ * Get the partial search results received callback.
+ * @param cbs #LinphoneMagicSearchCbs object. @notnil
+ * @return The current partial search results received callback.
+ */
+LINPHONE_PUBLIC LinphoneMagicSearchCbsPartialSearchResultsReceivedCb linphone_magic_search_cbs_get_partial_search_results_received (const LinphoneMagicSearchCbs *cbs);
+
+/**
+ * Set the partial search results received callback, called each time a source of an asynchronous search ends.
+ * @param cbs #LinphoneMagicSearchCbs object. @notnil
+ * @param cb The partial search results received callback to be used.
+ */
+LINPHONE_PUBLIC void linphone_magic_search_cbs_set_partial_search_results_received (LinphoneMagicSearchCbs *cbs, LinphoneMagicSearchCbsPartialSearchResultsReceivedCb cb);
+
 /**
  * @}
  */
@@ -654,6 +654,14 @@ typedef void (*LinphoneFriendListCbsSyncStateChangedCb)(LinphoneFriendList *frie
 **/
 typedef void (*LinphoneFriendListCbsPresenceReceivedCb)(LinphoneFriendList *friend_list, const bctbx_list_t *friends);
 
+/**
+ * Callback used to notify the progress of a vCard import in a friend list.
+ * @param friend_list The #LinphoneFriendList object in which the friends are imported @notnil
+ * @param imported_count The number of vCards processed so far
+ * @param total_count The number of vCards to import
+**/
+typedef void (*LinphoneFriendListCbsImportProgressCb)(LinphoneFriendList *friend_list, int imported_count, int total_count);
+
 /**
  * @}
 **/
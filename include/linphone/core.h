@@ -1120,6 +1120,35 @@ LINPHONE_PUBLIC size_t linphone_core_get_log_collection_max_file_size(void);
  */
 LINPHONE_PUBLIC void linphone_core_set_log_collection_max_file_size(size_t size);
 
+/**
+ * Enable or disable the buffering of the log collection.
+ * When enabled, the logging threads format their lines into a per-thread buffer and a dedicated thread writes
+ * them to the log collection files by batches, so that no logging thread waits for the disk.
+ * If a thread logs faster than the lines are written, its new lines are dropped until its buffer has room again,
+ * and the number of dropped lines is written in the collected logs.
+ * @param enable TRUE to buffer the log collection, FALSE to write each line when it is logged.
+ */
+LINPHONE_PUBLIC void linphone_core_enable_log_collection_buffering(bool_t enable);
+
+/**
+ * Tells whether the log collection is buffered.
+ * @return TRUE if the log collection is buffered, FALSE otherwise.
+ */
+LINPHONE_PUBLIC bool_t linphone_core_log_collection_buffering_enabled(void);
+
+/**
+ * Get the size in bytes of the buffer of each logging thread, when the log collection is buffered.
+ * @return The size in bytes of the buffer of each logging thread.
+ */
+LINPHONE_PUBLIC size_t linphone_core_get_log_collection_buffer_size(void);
+
+/**
+ * Set the size in bytes of the buffer of each logging thread, when the log collection is buffered.
+ * It applies to the threads that did not log yet.
+ * @param size The size in bytes of the buffer of each logging thread.
+ */
+LINPHONE_PUBLIC void linphone_core_set_log_collection_buffer_size(size_t size);
+
 /**
  * Set the url of the server where to upload the collected log files.
  * @param core #LinphoneCore object @notnil
@@ -3090,11 +3119,24 @@ LINPHONE_PUBLIC void linphone_core_set_rtp_no_xmit_on_audio_mute(LinphoneCore *c
 
 /**
  * Get the list of call logs (past calls).
+ * When the call logs are stored in a database, only the most recent ones are kept in memory, up to the
+ * [misc] history_cache_size config entry. Use linphone_core_get_call_history_page() to browse the older ones.
  * @param core #LinphoneCore object @notnil
  * @return A list of #LinphoneCallLog. \bctbx_list{LinphoneCallLog} @maybenil
 **/
 LINPHONE_PUBLIC const bctbx_list_t * linphone_core_get_call_logs(LinphoneCore *core);
 
+/**
+ * Get a page of the call logs, from the most recent to the oldest.
+ * The logs are read from the database on demand, so the whole history doesn't need to be loaded in memory.
+ * At the contrary of linphone_core_get_call_logs, it is your responsibility to unref the logs and free this list once you are done using it.
+ * @param core #LinphoneCore object. @notnil
+ * @param last The last #LinphoneCallLog of the previous page, or NULL to get the first page. @maybenil
+ * @param count The maximum number of call logs to return.
+ * @return A list of #LinphoneCallLog. \bctbx_list{LinphoneCallLog} @tobefreed @maybenil
+**/
+LINPHONE_PUBLIC bctbx_list_t *linphone_core_get_call_history_page(LinphoneCore *core, const LinphoneCallLog *last, int count);
+
 /**
  * Get the list of call logs (past calls).
  * At the contrary of linphone_core_get_call_logs, it is your responsibility to unref the logs and free this list once you are done using it.
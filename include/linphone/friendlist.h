@@ -352,6 +352,20 @@ LINPHONE_PUBLIC LinphoneFriendListCbsPresenceReceivedCb linphone_friend_list_cbs
 **/
 LINPHONE_PUBLIC void linphone_friend_list_cbs_set_presence_received(LinphoneFriendListCbs *cbs, LinphoneFriendListCbsPresenceReceivedCb cb);
 
+/**
+ * Get the import progress callback.
+ * @param cbs #LinphoneFriendListCbs object. @notnil
+ * @return The current import progress callback.
+**/
+LINPHONE_PUBLIC LinphoneFriendListCbsImportProgressCb linphone_friend_list_cbs_get_import_progress(const LinphoneFriendListCbs *cbs);
+
+/**
+ * Set the import progress callback, called periodically while vCards are imported in the list.
+ * @param cbs #LinphoneFriendListCbs object. @notnil
+ * @param cb The import progress callback to be used.
+**/
+LINPHONE_PUBLIC void linphone_friend_list_cbs_set_import_progress(LinphoneFriendListCbs *cbs, LinphoneFriendListCbsImportProgressCb cb);
+
 /**
  * Starts a CardDAV synchronization using value set using linphone_friend_list_set_uri.
  * @param friend_list #LinphoneFriendList object. @notnil
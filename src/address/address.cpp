@@ -21,7 +21,6 @@
 
 #include "address.h"
 #include "c-wrapper/c-wrapper.h"
-#include "containers/lru-cache.h"
 #include "logger/logger.h"
 
 // TODO: delete after Addres is not derived anymore from ClonableObject
@@ -59,18 +58,20 @@ namespace {
 	private:
 		SalAddress *mSalAddress;
 	};
-	LruCache<string, SalAddressWrap> addressesCache;
+	ShardedLruCache<string, SalAddressWrap> addressesCache(Address::DefaultSipAddressesCacheSize);
 }
 
 static SalAddress *getSalAddressFromCache (const string &uri) {
-	SalAddressWrap *wrap = addressesCache[uri];
-	if (wrap)
-		return sal_address_clone(wrap->get());
+	// The cached address is cloned under the lock of its shard, its reference count is not atomic.
+	SalAddress *address = nullptr;
+	if (addressesCache.find(uri, [&address](SalAddressWrap &wrap) { address = sal_address_clone(wrap.get()); }))
+		return address;
 
-	SalAddress *address = sal_address_new(L_STRING_TO_C(uri));
+	address = sal_address_new(L_STRING_TO_C(uri));
 	if (address) {
+		SalAddress *clone = sal_address_clone(address);
 		addressesCache.insert(uri, SalAddressWrap(address));
-		return sal_address_clone(address);
+		return clone;
 	}
 
 	return nullptr;
@@ -132,6 +133,15 @@ void Address::clearSipAddressesCache () {
 	addressesCache.clear();
 }
 
+void Address::setSipAddressesCacheSize (int size) {
+	if (size != addressesCache.getCapacity())
+		addressesCache.setCapacity(size);
+}
+
+LruCacheStats Address::getSipAddressesCacheStats () {
+	return addressesCache.getStats();
+}
+
 bool Address::isValid () const {
 	return !!internalAddress;
 }
@@ -27,6 +27,7 @@
 #include "enums.h"
 #include "object/clonable-object.h"
 #include "c-wrapper/internal/c-sal.h"
+#include "containers/sharded-lru-cache.h"
 
 // =============================================================================
 
@@ -121,6 +122,11 @@ public:
 	// This method is necessary when creating static variables of type address as they canot be freed before the leak detector runs
 	void removeFromLeakDetector() const;
 	static void clearSipAddressesCache ();
+	// Maximum number of parsed addresses kept by the process, the cache is cleared when the size changes.
+	static void setSipAddressesCacheSize (int size);
+	static LruCacheStats getSipAddressesCacheStats ();
+
+	static constexpr int DefaultSipAddressesCacheSize = 1000;
 
 private:
 	struct AddressCache {
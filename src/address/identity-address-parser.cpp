@@ -17,8 +17,8 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <mutex>
 #include <set>
-#include <unordered_map>
 
 #include <belr/abnf.h>
 #include <belr/grammarbuilder.h>
@@ -45,7 +45,8 @@ namespace {
 class IdentityAddressParserPrivate : public ObjectPrivate {
 public:
 	shared_ptr<belr::Parser<shared_ptr<IdentityAddress> >> parser;
-    unordered_map<string, shared_ptr<IdentityAddress >> cache;
+	mutex parserMutex;
+	ShardedLruCache<string, shared_ptr<IdentityAddress>> cache{IdentityAddressParser::DefaultCacheSize};
 };
 
 IdentityAddressParser::IdentityAddressParser () : Singleton(*new IdentityAddressParserPrivate) {
@@ -68,21 +69,35 @@ IdentityAddressParser::IdentityAddressParser () : Singleton(*new IdentityAddress
 shared_ptr<IdentityAddress> IdentityAddressParser::parseAddress (const string &input) {
 	L_D();
 
-    auto it = d->cache.find(input);
-    if (it == d->cache.end()) {
-        size_t parsedSize;
-        shared_ptr<IdentityAddress> identityAddress = d->parser->parseInput("Address", input, &parsedSize);
-        if (!identityAddress) {
-            lDebug() << "Unable to parse identity address from " << input;
-            return nullptr;
-        }
-        // Remove identity address from leak detector as the IdentityAddressParser is a used as static variable
-        identityAddress->removeFromLeakDetector();
-        d->cache[input] = identityAddress;
-        return identityAddress;
-    } else {
-        return it->second;
-    }
+	shared_ptr<IdentityAddress> identityAddress;
+	if (d->cache.find(input, [&identityAddress](const shared_ptr<IdentityAddress> &cached) { identityAddress = cached; }))
+		return identityAddress;
+
+	size_t parsedSize;
+	// The grammar parser keeps a parsing context, it cannot be shared by several threads.
+	{
+		lock_guard<mutex> lock(d->parserMutex);
+		identityAddress = d->parser->parseInput("Address", input, &parsedSize);
+	}
+	if (!identityAddress) {
+		lDebug() << "Unable to parse identity address from " << input;
+		return nullptr;
+	}
+	// Remove identity address from leak detector as the IdentityAddressParser is a used as static variable
+	identityAddress->removeFromLeakDetector();
+	d->cache.insert(input, shared_ptr<IdentityAddress>(identityAddress));
+	return identityAddress;
+}
+
+void IdentityAddressParser::setCacheSize (int size) {
+	L_D();
+	if (size != d->cache.getCapacity())
+		d->cache.setCapacity(size);
+}
+
+LruCacheStats IdentityAddressParser::getCacheStats () const {
+	L_D();
+	return d->cache.getStats();
 }
 
 LINPHONE_END_NAMESPACE
@@ -20,6 +20,7 @@
 #ifndef _L_IDENTITY_ADDRESS_PARSER_H_
 #define _L_IDENTITY_ADDRESS_PARSER_H_
 
+#include "containers/sharded-lru-cache.h"
 #include "identity-address.h"
 #include "object/singleton.h"
 
@@ -33,8 +34,15 @@ class IdentityAddressParser : public Singleton<IdentityAddressParser> {
 	friend class Singleton<IdentityAddressParser>;
 
 public:
+	// Can be called from any thread.
 	std::shared_ptr<IdentityAddress> parseAddress (const std::string &input);
 
+	// Maximum number of parsed addresses kept, the cache is cleared when the size changes.
+	void setCacheSize (int size);
+	LruCacheStats getCacheStats () const;
+
+	static constexpr int DefaultCacheSize = 10000;
+
 private:
 	IdentityAddressParser ();
 
@@ -313,6 +313,13 @@ bctbx_list_t *linphone_chat_room_get_history_range_events (LinphoneChatRoom *cr,
 	return L_GET_RESOLVED_C_LIST_FROM_CPP_LIST(L_GET_CPP_PTR_FROM_C_OBJECT(cr)->getHistoryRange(begin, end));
 }
 
+bctbx_list_t *linphone_chat_room_get_history_range_events_before (LinphoneChatRoom *cr, const LinphoneEventLog *event_log, int nb_events) {
+	shared_ptr<const LinphonePrivate::EventLog> lastEvent;
+	if (event_log)
+		lastEvent = L_GET_CPP_PTR_FROM_C_OBJECT(event_log);
+	return L_GET_RESOLVED_C_LIST_FROM_CPP_LIST(L_GET_CPP_PTR_FROM_C_OBJECT(cr)->getHistoryRangeBefore(lastEvent, nb_events));
+}
+
 int linphone_chat_room_get_history_events_size(LinphoneChatRoom *cr) {
 	return L_GET_CPP_PTR_FROM_C_OBJECT(cr)->getHistorySize();
 }
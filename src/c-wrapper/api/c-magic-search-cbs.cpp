@@ -27,6 +27,7 @@ struct _LinphoneMagicSearchCbs {
 	belle_sip_object_t base;
 	void *userData;
 	LinphoneMagicSearchCbsSearchResultsReceivedCb search_results_received;
+	LinphoneMagicSearchCbsPartialSearchResultsReceivedCb partial_search_results_received;
 };
 
 BELLE_SIP_DECLARE_VPTR_NO_EXPORT(LinphoneMagicSearchCbs);
@@ -74,3 +75,15 @@ void linphone_magic_search_cbs_set_search_results_received (
 ) {
 	cbs->search_results_received = cb;
 }
+
+LinphoneMagicSearchCbsPartialSearchResultsReceivedCb linphone_magic_search_cbs_get_partial_search_results_received(
+	const LinphoneMagicSearchCbs *cbs
+) {
+	return cbs->partial_search_results_received;
+}
+void linphone_magic_search_cbs_set_partial_search_results_received (
+	LinphoneMagicSearchCbs *cbs,
+	LinphoneMagicSearchCbsPartialSearchResultsReceivedCb cb
+) {
+	cbs->partial_search_results_received = cb;
+}
@@ -94,6 +94,10 @@ void _linphone_magic_search_notify_search_results_received(LinphoneMagicSearch *
 	NOTIFY_IF_EXIST(SearchResultsReceived, search_results_received, magic_search)
 }
 
+void _linphone_magic_search_notify_partial_search_results_received(LinphoneMagicSearch *magic_search) {
+	NOTIFY_IF_EXIST(PartialSearchResultsReceived, partial_search_results_received, magic_search)
+}
+
 // =============================================================================
 // Getter and setters
 // =============================================================================
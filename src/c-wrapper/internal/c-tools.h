@@ -312,6 +312,15 @@ public:
 			belle_sip_object_unref(value);
 	}
 
+	// True if a C object has already been built on top of the cpp object.
+	template<
+		typename CppType,
+		typename = typename std::enable_if<std::is_base_of<BaseObject, CppType>::value, CppType>::type
+	>
+	static inline bool hasCBackPtr (const CppType *cppObject) {
+		return !!cppObject->getCBackPtr();
+	}
+
 	template<
 		typename CppType,
 		typename = typename std::enable_if<std::is_base_of<ClonableObject, CppType>::value, CppType>::type
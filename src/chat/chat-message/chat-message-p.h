@@ -261,6 +261,8 @@ private:
 	// Do not expose.
 
 	std::weak_ptr<AbstractChatRoom> chatRoom;
+	// Tells the chat room that this message is alive, it must not be released while it is.
+	std::shared_ptr<bool> chatRoomToken;
 	ConferenceId conferenceId;
 	ConferenceAddress fromAddress;
 	IdentityAddress authenticatedFromAddress;
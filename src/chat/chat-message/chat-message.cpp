@@ -627,6 +627,8 @@ std::string ChatMessagePrivate::createFakeFileTransferFromUrl(const std::string
 
 void ChatMessagePrivate::setChatRoom (const shared_ptr<AbstractChatRoom> &cr) {
 	chatRoom = cr;
+	shared_ptr<ChatRoom> room = dynamic_pointer_cast<ChatRoom>(cr);
+	chatRoomToken = room ? room->getPrivate()->getChatMessagesToken() : nullptr;
 	const ConferenceId &conferenceId(cr->getConferenceId());
 	if (direction == ChatMessage::Direction::Outgoing) {
 		fromAddress = conferenceId.getLocalAddress();
@@ -109,6 +109,7 @@ public:
 	virtual int getMessageHistorySize () const = 0;
 	virtual std::list<std::shared_ptr<EventLog>> getHistory (int nLast) const = 0;
 	virtual std::list<std::shared_ptr<EventLog>> getHistoryRange (int begin, int end) const = 0;
+	virtual std::list<std::shared_ptr<EventLog>> getHistoryRangeBefore (const std::shared_ptr<const EventLog> &lastEvent, int nLast) const = 0;
 	virtual int getHistorySize () const = 0;
 
 	virtual void deleteFromDb () = 0;
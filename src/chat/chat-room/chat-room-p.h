@@ -98,6 +98,10 @@ public:
 
 	Imdn *getImdnHandler () const { return imdnHandler.get(); }
 
+	// Held by every chat message of this chat room, see ChatMessagePrivate::setChatRoom().
+	const std::shared_ptr<bool> &getChatMessagesToken () const { return chatMessagesToken; }
+	bool hasChatMessagesInUse () const { return chatMessagesToken.use_count() > 1; }
+
 	LinphoneChatRoom *getCChatRoom () const;
 
 	std::list<IdentityAddress> remoteIsComposing;
@@ -118,6 +122,8 @@ private:
 	std::unique_ptr<Imdn> imdnHandler;
 	std::unique_ptr<IsComposing> isComposingHandler;
 
+	std::shared_ptr<bool> chatMessagesToken = std::make_shared<bool>(true);
+
 	bool isComposing = false;
 	bool isEmpty = true;
 	
@@ -524,6 +524,15 @@ list<shared_ptr<EventLog>> ChatRoom::getHistoryRange (int begin, int end) const
 	);
 }
 
+list<shared_ptr<EventLog>> ChatRoom::getHistoryRangeBefore (const shared_ptr<const EventLog> &lastEvent, int nLast) const {
+	return getCore()->getPrivate()->mainDb->getHistoryBefore(
+		getConferenceId(),
+		lastEvent,
+		nLast,
+		MainDb::FilterMask({ MainDb::Filter::ConferenceChatMessageFilter, MainDb::Filter::ConferenceInfoNoDeviceFilter })
+	);
+}
+
 int ChatRoom::getHistorySize () const {
 	return getCore()->getPrivate()->mainDb->getHistorySize(getConferenceId());
 }
@@ -177,6 +177,7 @@ void ClientGroupChatRoomPrivate::confirmJoining (SalCallOp *op) {
 				q->getConference()->participants.push_back(participant);
 			}
 		}
+		q->getCore()->getPrivate()->updateChatRoomIndex(q->getSharedFromThis());
 	}
 
 	acceptSession(session);
@@ -593,6 +594,18 @@ list<shared_ptr<EventLog>> ClientGroupChatRoom::getHistoryRange (int begin, int
 	);
 }
 
+list<shared_ptr<EventLog>> ClientGroupChatRoom::getHistoryRangeBefore (const shared_ptr<const EventLog> &lastEvent, int nLast) const {
+	L_D();
+	return getCore()->getPrivate()->mainDb->getHistoryBefore(
+		getConferenceId(),
+		lastEvent,
+		nLast,
+		(d->capabilities & Capabilities::OneToOne) ?
+			MainDb::Filter::ConferenceChatMessageSecurityFilter :
+			MainDb::FilterMask({MainDb::Filter::ConferenceChatMessageFilter, MainDb::Filter::ConferenceInfoNoDeviceFilter})
+	);
+}
+
 int ClientGroupChatRoom::getHistorySize () const {
 	L_D();
 	return getCore()->getPrivate()->mainDb->getHistorySize(
@@ -967,6 +980,9 @@ void ClientGroupChatRoom::onConferenceTerminated (const IdentityAddress &addr) {
 void ClientGroupChatRoom::onFirstNotifyReceived (const IdentityAddress &addr) {
 	L_D();
 
+	// The full state may have replaced the participants.
+	getCore()->getPrivate()->updateChatRoomIndex(getSharedFromThis());
+
 	if (getState() != ConferenceInterface::State::Created) {
 		lWarning() << "First notify received in ClientGroupChatRoom that is not in the Created state ["
 			<< getState() << "], ignoring it!";
@@ -1017,6 +1033,8 @@ void ClientGroupChatRoom::onParticipantAdded (const shared_ptr<ConferencePartici
 	if (event->getFullState())
 		return;
 
+	getCore()->getPrivate()->updateChatRoomIndex(getSharedFromThis());
+
 	d->addEvent(event);
 
 	LinphoneChatRoom *cr = d->getCChatRoom();
@@ -1026,6 +1044,7 @@ void ClientGroupChatRoom::onParticipantAdded (const shared_ptr<ConferencePartici
 void ClientGroupChatRoom::onParticipantRemoved (const shared_ptr<ConferenceParticipantEvent> &event, const std::shared_ptr<Participant> &participant) {
 	L_D();
 
+	getCore()->getPrivate()->updateChatRoomIndex(getSharedFromThis());
 	d->addEvent(event);
 
 	LinphoneChatRoom *cr = d->getCChatRoom();
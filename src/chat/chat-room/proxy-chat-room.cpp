@@ -135,6 +135,11 @@ list<shared_ptr<EventLog>> ProxyChatRoom::getHistoryRange (int begin, int end) c
 	return d->chatRoom->getHistoryRange(begin, end);
 }
 
+list<shared_ptr<EventLog>> ProxyChatRoom::getHistoryRangeBefore (const shared_ptr<const EventLog> &lastEvent, int nLast) const {
+	L_D();
+	return d->chatRoom->getHistoryRangeBefore(lastEvent, nLast);
+}
+
 int ProxyChatRoom::getHistorySize () const {
 	L_D();
 	return d->chatRoom->getHistorySize();
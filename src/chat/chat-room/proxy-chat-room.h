@@ -52,6 +52,7 @@ public:
 	int getMessageHistorySize () const override;
 	std::list<std::shared_ptr<EventLog>> getHistory (int nLast) const override;
 	std::list<std::shared_ptr<EventLog>> getHistoryRange (int begin, int end) const override;
+	std::list<std::shared_ptr<EventLog>> getHistoryRangeBefore (const std::shared_ptr<const EventLog> &lastEvent, int nLast) const override;
 	int getHistorySize () const override;
 
 	void deleteFromDb () override;
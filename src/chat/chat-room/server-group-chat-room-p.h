@@ -21,8 +21,7 @@
 #define _L_SERVER_GROUP_CHAT_ROOM_P_H_
 
 #include <chrono>
-#include <queue>
-#include <unordered_map>
+#include <deque>
 #include <map>
 
 #include "chat-room-p.h"
@@ -88,7 +87,8 @@ public:
 	void confirmJoining (SalCallOp *op);
 	void confirmRecreation (SalCallOp *op);
 	void declineSession (const std::shared_ptr<CallSession> &session, LinphoneReason reason);
-	void dispatchQueuedMessages ();
+	// Send the messages queued for a device which just became present.
+	void dispatchQueuedMessages (const std::shared_ptr<ParticipantDevice> &device);
 
 	void subscriptionStateChanged (LinphoneEvent *event, LinphoneSubscriptionState state);
 
@@ -120,7 +120,7 @@ private:
 		Message (const std::string &from, const ContentType &contentType, const std::string &text, const SalCustomHeader *salCustomHeaders)
 			: fromAddr(from)
 		{
-			content.setContentType(contentType);
+			content.setContentType(contentType.isValid() ? contentType : ContentType::PlainText);
 			if (!text.empty())
 				content.setBodyFromUtf8(text);
 			if (salCustomHeaders)
@@ -130,15 +130,27 @@ private:
 		~Message () {
 			if (customHeaders)
 				sal_custom_header_free(customHeaders);
+			if (forwardHeaders)
+				sal_custom_header_free(forwardHeaders);
+			if (nonUrgentForwardHeaders)
+				sal_custom_header_free(nonUrgentForwardHeaders);
 		}
 
 		IdentityAddress fromAddr;
 		Content content;
 		std::chrono::system_clock::time_point timestamp = std::chrono::system_clock::now();
 		SalCustomHeader *customHeaders = nullptr;
+		// Headers of the forwarded requests, built on first use and shared by all of them.
+		SalCustomHeader *forwardHeaders = nullptr;
+		SalCustomHeader *nonUrgentForwardHeaders = nullptr;
+		// Devices for which the message is still queued.
+		std::vector<std::weak_ptr<ParticipantDevice>> devices;
+		size_t pendingDeviceCount = 0;
 	};
 
-	static void copyMessageHeaders (const std::shared_ptr<Message> &fromMessage, const std::shared_ptr<ChatMessage> &toMessage);
+	using MessageQueue = std::deque<std::shared_ptr<Message>>;
+
+	static SalCustomHeader *getForwardHeaders (const std::shared_ptr<Message> &message, bool nonUrgent);
 	static bool allDevicesLeft(const std::shared_ptr<Participant> &participant);
 	void addParticipantDevice (const std::shared_ptr<Participant> &participant, const std::shared_ptr<ParticipantDeviceIdentity> &deviceInfo);
 	void designateAdmin ();
@@ -149,7 +161,9 @@ private:
 	void byeDevice (const std::shared_ptr<ParticipantDevice> &device);
 	bool isAdminLeft () const;
 	void queueMessage (const std::shared_ptr<Message> &message);
-	void queueMessage (const std::shared_ptr<Message> &msg, const IdentityAddress &deviceAddress);
+	void loadQueuedMessages ();
+	void removeQueuedMessages (const std::shared_ptr<ParticipantDevice> &device);
+	void removeExpiredQueuedMessages ();
 	void removeParticipantDevice (const std::shared_ptr<Participant> &participant, const IdentityAddress &deviceAddress);
 
 	void onParticipantDeviceLeft (const std::shared_ptr<ParticipantDevice> &device);
@@ -182,7 +196,11 @@ private:
 	std::shared_ptr<ParticipantDevice> mInitiatorDevice; /*pointer to the ParticipantDevice that is creating the chat room*/
 	bool joiningPendingAfterCreation = false;
 	bool needsUnref = false;
-	std::unordered_map<std::string, std::queue<std::shared_ptr<Message>>> queuedMessages;
+	// Queues are keyed by the device objects themselves, their addresses are only used for the database.
+	std::map<std::weak_ptr<ParticipantDevice>, MessageQueue, std::owner_less<std::weak_ptr<ParticipantDevice>>> queuedMessages;
+	// All the queued messages, by reception time, to expire them without scanning the device queues.
+	MessageQueue queuedMessagesByTime;
+	bool queuedMessagesLoaded = false;
 	Utils::Version protocolVersion;
 	L_DECLARE_PUBLIC(ServerGroupChatRoom);
 };
@@ -18,6 +18,7 @@
  */
 
 #include <algorithm>
+#include <sstream>
 
 #include "address/address.h"
 #include "address/identity-address.h"
@@ -35,6 +36,7 @@
 #include "core/core-p.h"
 #include "event-log/events.h"
 #include "logger/logger.h"
+#include "sal/message-op.h"
 #include "sal/refer-op.h"
 #include "server-group-chat-room-p.h"
 #include "sip-tools/sip-headers.h"
@@ -89,8 +91,9 @@ shared_ptr<Participant> ServerGroupChatRoomPrivate::addParticipant (const Identi
 	 * previously OR a totally new participant. */
 	if (q->findParticipant(addr) == nullptr){
 		q->getConference()->participants.push_back(participant);
+		q->getCore()->getPrivate()->updateChatRoomIndex(q->getSharedFromThis());
 		shared_ptr<ConferenceParticipantEvent> event = q->getConference()->notifyParticipantAdded(time(nullptr), false, participant);
-		q->getCore()->getPrivate()->mainDb->addEvent(event);
+		q->getCore()->getPrivate()->mainDb->queueEvent(event);
 	}
 	return participant;
 }
@@ -125,10 +128,10 @@ void ServerGroupChatRoomPrivate::setParticipantDeviceState (const shared_ptr<Par
 		switch (state){
 			case ParticipantDevice::State::ScheduledForLeaving:
 			case ParticipantDevice::State::Leaving:
-				queuedMessages.erase(address);
+				removeQueuedMessages(device);
 			break;
 			case ParticipantDevice::State::Left:
-				queuedMessages.erase(address);
+				removeQueuedMessages(device);
 				onParticipantDeviceLeft(device);
 			break;
 			default:
@@ -252,10 +255,10 @@ void ServerGroupChatRoomPrivate::confirmJoining (SalCallOp *op) {
 
 		/*Since the initiator of the chatroom has not yet subscribed at this stage, this won't generate NOTIFY, the events will be queued. */
 		shared_ptr<ConferenceParticipantDeviceEvent> deviceEvent = q->getConference()->notifyParticipantDeviceAdded(time(nullptr), false, participant, device);
-		q->getCore()->getPrivate()->mainDb->addEvent(deviceEvent);
+		q->getCore()->getPrivate()->mainDb->queueEvent(deviceEvent);
 		if (!(capabilities & ServerGroupChatRoom::Capabilities::OneToOne)) {
 			shared_ptr<ConferenceParticipantEvent> adminEvent = q->getConference()->notifyParticipantSetAdmin(time(nullptr), false, participant, true);
-			q->getCore()->getPrivate()->mainDb->addEvent(adminEvent);
+			q->getCore()->getPrivate()->mainDb->queueEvent(adminEvent);
 		}
 	} else {
 		// INVITE coming from an invited participant
@@ -344,38 +347,27 @@ void ServerGroupChatRoomPrivate::declineSession (const shared_ptr<CallSession> &
 	session->decline(reason);
 }
 
-void ServerGroupChatRoomPrivate::dispatchQueuedMessages () {
+void ServerGroupChatRoomPrivate::dispatchQueuedMessages (const shared_ptr<ParticipantDevice> &device) {
 	L_Q();
-	for (const auto &participant : q->getParticipants()) {
-		/*
-		 * Dispatch messages for each device in Present state. In a one to one chatroom, if a device
-		 * is found is Left state, it must be invited first.
-		 */
 
-		for (const auto &device : participant->getDevices()) {
+	if (device->getState() != ParticipantDevice::State::Present)
+		return;
 
-			string uri(device->getAddress().asString());
-			auto & msgQueue = queuedMessages[uri];
+	loadQueuedMessages();
+	auto it = queuedMessages.find(device);
+	if (it == queuedMessages.end())
+		return;
 
-			if (!msgQueue.empty()){
-				if ( (capabilities & ServerGroupChatRoom::Capabilities::OneToOne) && device->getState() == ParticipantDevice::State::Left){
-					// Happens only with protocol < 1.1
-					lInfo() << "There is a message to transmit to a participant in left state in a one to one chatroom, so inviting first.";
-					inviteDevice(device);
-					continue;
-				}
-				if (device->getState() != ParticipantDevice::State::Present)
-					continue;
-				size_t nbMessages = msgQueue.size();
-				lInfo() << q << ": Dispatching " << nbMessages << " queued message(s) for '" << uri << "'";
-				while (!msgQueue.empty()) {
-					shared_ptr<Message> msg = msgQueue.front();
-					sendMessage(msg, device->getAddress());
-					msgQueue.pop();
-				}
-			}
-		}
+	// Take the queue first, sending may change the state of the device.
+	MessageQueue msgQueue = move(it->second);
+	queuedMessages.erase(it);
+
+	lInfo() << q << ": Dispatching " << msgQueue.size() << " queued message(s) for '" << device->getAddress() << "'";
+	for (const auto &msg : msgQueue) {
+		msg->pendingDeviceCount--;
+		sendMessage(msg, device->getAddress());
 	}
+	q->getCore()->getPrivate()->mainDb->deleteServerQueuedMessages(q->getConferenceId(), device->getAddress().asString());
 }
 
 void ServerGroupChatRoomPrivate::removeParticipant (const shared_ptr<Participant> &participant) {
@@ -394,12 +386,11 @@ void ServerGroupChatRoomPrivate::removeParticipant (const shared_ptr<Participant
 		if (participant->getAddress() == p->getAddress()) {
 			lInfo() << q <<" 'participant ' "<< p->getAddress() <<" no more authorized'";
 			q->getConference()->removeParticipant(p);
+			q->getCore()->getPrivate()->updateChatRoomIndex(q->getSharedFromThis());
 			break;
 		}
 	}
 
-	queuedMessages.erase(participant->getAddress().asString());
-
 	shared_ptr<ConferenceParticipantEvent> event = q->getConference()->notifyParticipantRemoved(time(nullptr), false, participant);
 	q->getCore()->getPrivate()->mainDb->addConferenceParticipantEventToDb(event);
 
@@ -563,7 +554,6 @@ LinphoneReason ServerGroupChatRoomPrivate::onSipMessageReceived (SalOp *op, cons
 	);
 
 	queueMessage(msg);
-	dispatchQueuedMessages();
 	return LinphoneReasonNone;
 }
 
@@ -714,17 +704,28 @@ void ServerGroupChatRoomPrivate::setParticipantDevices(const IdentityAddress &pa
 
 // -----------------------------------------------------------------------------
 
-void ServerGroupChatRoomPrivate::copyMessageHeaders (const shared_ptr<Message> &fromMessage, const shared_ptr<ChatMessage> &toMessage) {
-	string headersToCopy[] = {
-		"Content-Encoding",
-		"Expires",
-		"Priority"
-	};
+// Headers of the received MESSAGE forwarded to the devices, they are also stored with the queued messages.
+static const string headersToCopy[] = {
+	"Content-Encoding",
+	"Expires",
+	"Priority"
+};
+
+SalCustomHeader *ServerGroupChatRoomPrivate::getForwardHeaders (const shared_ptr<Message> &message, bool nonUrgent) {
+	SalCustomHeader *&headers = nonUrgent ? message->nonUrgentForwardHeaders : message->forwardHeaders;
+	if (headers)
+		return headers;
+
 	for (const auto &headerName : headersToCopy) {
-		const char *headerValue = sal_custom_header_find(fromMessage->customHeaders, headerName.c_str());
+		const char *headerValue = sal_custom_header_find(message->customHeaders, headerName.c_str());
 		if (headerValue)
-			toMessage->getPrivate()->addSalCustomHeader(headerName, headerValue);
+			headers = sal_custom_header_append(headers, headerName.c_str(), headerValue);
 	}
+	// Special custom header to identify MESSAGE that belong to server group chatroom
+	headers = sal_custom_header_append(headers, "Session-mode", "true");
+	if (nonUrgent)
+		headers = sal_custom_header_append(headers, PriorityHeader::HeaderName, PriorityHeader::NonUrgent);
+	return headers;
 }
 
 /*
@@ -807,7 +808,7 @@ void ServerGroupChatRoomPrivate::addParticipantDevice (const shared_ptr<Particip
 		device->setCapabilityDescriptor(deviceInfo->getCapabilityDescriptor());
 		updateProtocolVersionFromDevice(device);
 		shared_ptr<ConferenceParticipantDeviceEvent> event = q->getConference()->notifyParticipantDeviceAdded(time(nullptr), false, participant, device);
-		q->getCore()->getPrivate()->mainDb->addEvent(event);
+		q->getCore()->getPrivate()->mainDb->queueEvent(event);
 
 		if (protocolVersion < Utils::Version(1, 1) && (capabilities & ServerGroupChatRoom::Capabilities::OneToOne) && allDevLeft){
 			/* If all other devices have left, let this new device to left state too, it will be invited to join if a message is sent to it. */
@@ -829,24 +830,30 @@ void ServerGroupChatRoomPrivate::designateAdmin () {
 	}
 }
 
-void ServerGroupChatRoomPrivate::sendMessage(const shared_ptr<Message> &message, const IdentityAddress &deviceAddr) {
+void ServerGroupChatRoomPrivate::sendMessage (const shared_ptr<Message> &message, const IdentityAddress &deviceAddr) {
 	L_Q();
 
-	shared_ptr<ChatMessage> msg = q->createChatMessage();
-	copyMessageHeaders(message, msg);
-	// Special custom header to identify MESSAGE that belong to server group chatroom
-	msg->getPrivate()->addSalCustomHeader("Session-mode", "true");
-	msg->setInternalContent(message->content);
-	msg->getPrivate()->forceFromAddress(q->getConferenceAddress());
-	msg->getPrivate()->forceToAddress(deviceAddr);
-	msg->getPrivate()->setApplyModifiers(false);
-	if (message->fromAddr.getUsername() == msg->getToAddress().getUsername() &&
-		message->fromAddr.getDomain() == msg->getToAddress().getDomain()) {
-		// If FROM and TO are the same user (with a different device for example, gruu is not checked), set the
-		// Non-Urgent header to disable push notification for this message.
-		msg->getPrivate()->addSalCustomHeader(PriorityHeader::HeaderName, PriorityHeader::NonUrgent);
-	}
-	msg->send();
+	// Same request as a ChatMessage sent without modifiers, but no ChatMessage is created per device: the content and
+	// the headers are shared by the requests to all the devices, only the addresses are specific.
+	LinphoneCore *lc = q->getCore()->getCCore();
+	Address localAddr(q->getConferenceAddress().asAddress());
+	Address peerAddr(deviceAddr.asAddress());
+
+	// If FROM and TO are the same user (with a different device for example, gruu is not checked), set the
+	// Non-Urgent header to disable push notification for this message.
+	const bool nonUrgent = message->fromAddr.getUsername() == deviceAddr.getUsername() &&
+		message->fromAddr.getDomain() == deviceAddr.getDomain();
+
+	SalMessageOp *op = new SalMessageOp(lc->sal.get());
+	linphone_configure_op_2(
+		lc, op, L_GET_C_BACK_PTR(&localAddr), L_GET_C_BACK_PTR(&peerAddr), getForwardHeaders(message, nonUrgent),
+		!!linphone_config_get_int(lc->config, "sip", "chat_msg_with_contact", 0)
+	);
+	op->setFrom(localAddr.asString().c_str());
+	op->setTo(peerAddr.asString().c_str());
+	op->sendMessage(message->content);
+	// The transaction keeps the op alive until the response, the delivery status is ignored without user pointer.
+	op->unref();
 }
 
 void ServerGroupChatRoomPrivate::finalizeCreation () {
@@ -1007,29 +1014,157 @@ bool ServerGroupChatRoomPrivate::isAdminLeft () const {
 
 void ServerGroupChatRoomPrivate::queueMessage (const shared_ptr<Message> &msg) {
 	L_Q();
+
+	loadQueuedMessages();
+	removeExpiredQueuedMessages();
+
+	MainDb::ServerQueuedMessage storedMessage;
 	for (const auto &participant : q->getParticipants()) {
 		for (const auto &device : participant->getDevices()) {
 			// Queue the message for all devices except the one that sent it
-			if (msg->fromAddr != device->getAddress()){
-				queueMessage(msg, device->getAddress());
+			if (msg->fromAddr == device->getAddress())
+				continue;
+
+			if (device->getState() == ParticipantDevice::State::Present) {
+				// Messages may have been queued before a restart, keep the order.
+				dispatchQueuedMessages(device);
+				sendMessage(msg, device->getAddress());
+				continue;
+			}
+
+			queuedMessages[device].push_back(msg);
+			msg->devices.push_back(device);
+			storedMessage.deviceAddresses.push_back(device->getAddress().asString());
+
+			if ((capabilities & ServerGroupChatRoom::Capabilities::OneToOne) && device->getState() == ParticipantDevice::State::Left) {
+				// Happens only with protocol < 1.1
+				lInfo() << "There is a message to transmit to a participant in left state in a one to one chatroom, so inviting first.";
+				inviteDevice(device);
 			}
 		}
 	}
+
+	if (msg->devices.empty())
+		return;
+
+	msg->pendingDeviceCount = msg->devices.size();
+	queuedMessagesByTime.push_back(msg);
+
+	storedMessage.fromAddress = msg->fromAddr.asString();
+	storedMessage.contentType = msg->content.getContentType().getValueWithParams();
+	storedMessage.body = msg->content.getBodyAsUtf8String();
+	storedMessage.time = chrono::system_clock::to_time_t(msg->timestamp);
+	for (const auto &headerName : headersToCopy) {
+		const char *headerValue = sal_custom_header_find(msg->customHeaders, headerName.c_str());
+		if (headerValue)
+			storedMessage.headers += headerName + ": " + headerValue + "\n";
+	}
+	q->getCore()->getPrivate()->mainDb->insertServerQueuedMessage(q->getConferenceId(), storedMessage);
+}
+
+void ServerGroupChatRoomPrivate::loadQueuedMessages () {
+	L_Q();
+
+	if (queuedMessagesLoaded)
+		return;
+	queuedMessagesLoaded = true;
+
+	list<MainDb::ServerQueuedMessage> storedMessages = q->getCore()->getPrivate()->mainDb->getServerQueuedMessages(q->getConferenceId());
+	if (storedMessages.empty())
+		return;
+
+	map<string, shared_ptr<ParticipantDevice>> devicesByAddress;
+	for (const auto &participant : q->getParticipants()) {
+		for (const auto &device : participant->getDevices())
+			devicesByAddress[device->getAddress().asString()] = device;
+	}
+
+	for (const auto &storedMessage : storedMessages) {
+		SalCustomHeader *headers = nullptr;
+		istringstream headerLines(storedMessage.headers);
+		string line;
+		while (getline(headerLines, line)) {
+			const size_t separator = line.find(": ");
+			if (separator != string::npos)
+				headers = sal_custom_header_append(headers, line.substr(0, separator).c_str(), line.substr(separator + 2).c_str());
+		}
+
+		shared_ptr<Message> msg = make_shared<Message>(
+			storedMessage.fromAddress,
+			ContentType(storedMessage.contentType),
+			storedMessage.body,
+			headers
+		);
+		if (headers)
+			sal_custom_header_free(headers);
+		msg->timestamp = chrono::system_clock::from_time_t(storedMessage.time);
+
+		// Devices removed while the server was stopped are ignored.
+		for (const auto &deviceAddress : storedMessage.deviceAddresses) {
+			auto it = devicesByAddress.find(deviceAddress);
+			if (it == devicesByAddress.end())
+				continue;
+			queuedMessages[it->second].push_back(msg);
+			msg->devices.push_back(it->second);
+		}
+
+		msg->pendingDeviceCount = msg->devices.size();
+		if (msg->pendingDeviceCount > 0)
+			queuedMessagesByTime.push_back(msg);
+	}
+
+	lInfo() << q << ": " << queuedMessagesByTime.size() << " queued message(s) loaded";
+}
+
+void ServerGroupChatRoomPrivate::removeQueuedMessages (const shared_ptr<ParticipantDevice> &device) {
+	L_Q();
+
+	auto it = queuedMessages.find(device);
+	if (it != queuedMessages.end()) {
+		for (const auto &msg : it->second)
+			msg->pendingDeviceCount--;
+		queuedMessages.erase(it);
+	} else if (queuedMessagesLoaded)
+		return;
+
+	q->getCore()->getPrivate()->mainDb->deleteServerQueuedMessages(q->getConferenceId(), device->getAddress().asString());
 }
 
-void ServerGroupChatRoomPrivate::queueMessage (const shared_ptr<Message> &msg, const IdentityAddress &deviceAddress) {
-	chrono::system_clock::time_point timestamp = chrono::system_clock::now();
-	string uri(deviceAddress.asString());
+void ServerGroupChatRoomPrivate::removeExpiredQueuedMessages () {
+	L_Q();
+
 	// Remove queued messages older than one week
-	while (!queuedMessages[uri].empty()) {
-		shared_ptr<Message> m = queuedMessages[uri].front();
-		chrono::hours age = chrono::duration_cast<chrono::hours>(timestamp - m->timestamp);
-		chrono::hours oneWeek(168);
-		if (age < oneWeek)
-			break;
-		queuedMessages[uri].pop();
+	const chrono::system_clock::time_point expiryTime = chrono::system_clock::now() - chrono::hours(168);
+	bool expired = false;
+	while (!queuedMessagesByTime.empty()) {
+		shared_ptr<Message> msg = queuedMessagesByTime.front();
+		// Messages delivered to all their devices are only waiting to reach the front.
+		if (msg->pendingDeviceCount > 0) {
+			if (msg->timestamp >= expiryTime)
+				break;
+
+			// Device queues are ordered by time too, the message is normally at their front.
+			for (const auto &device : msg->devices) {
+				auto it = queuedMessages.find(device);
+				if (it == queuedMessages.end())
+					continue;
+				MessageQueue &msgQueue = it->second;
+				auto msgIt = find(msgQueue.begin(), msgQueue.end(), msg);
+				if (msgIt != msgQueue.end())
+					msgQueue.erase(msgIt);
+				if (msgQueue.empty())
+					queuedMessages.erase(it);
+			}
+			expired = true;
+		}
+		queuedMessagesByTime.pop_front();
 	}
-	queuedMessages[uri].push(msg);
+
+	if (expired)
+		q->getCore()->getPrivate()->mainDb->deleteServerQueuedMessagesBefore(
+			q->getConferenceId(),
+			chrono::system_clock::to_time_t(expiryTime)
+		);
 }
 
 /* The removal of participant device is done only when such device disapears from registration database, ie when a device unregisters explicitely
@@ -1046,7 +1181,7 @@ void ServerGroupChatRoomPrivate::removeParticipantDevice (const shared_ptr<Parti
 	}
 	// Notify to everyone the retirement of this device.
 	auto deviceEvent = q->getConference()->notifyParticipantDeviceRemoved(time(nullptr), false, participant, participantDevice);
-	q->getCore()->getPrivate()->mainDb->addEvent(deviceEvent);
+	q->getCore()->getPrivate()->mainDb->queueEvent(deviceEvent);
 	// First set it as left, so that it may eventually trigger the destruction of the chatroom if no device are present for any participant.
 	setParticipantDeviceState(participantDevice, ParticipantDevice::State::Left);
 	participantCopy->removeDevice(deviceAddress);
@@ -1469,7 +1604,7 @@ void ServerGroupChatRoom::onFirstNotifyReceived (const IdentityAddress &addr) {
 		for (const auto &device : participant->getDevices()) {
 			if (device->getAddress() == addr) {
 				d->setParticipantDeviceState(device, ParticipantDevice::State::Present);
-				d->dispatchQueuedMessages();
+				d->dispatchQueuedMessages(device);
 				return;
 			}
 		}
@@ -1489,7 +1624,7 @@ void ServerGroupChatRoom::setParticipantAdminStatus (const shared_ptr<Participan
 		participant->setAdmin(isAdmin);
 		if (!(d->capabilities & ServerGroupChatRoom::Capabilities::OneToOne)) {
 			shared_ptr<ConferenceParticipantEvent> event = getConference()->notifyParticipantSetAdmin(time(nullptr), false, participant, participant->isAdmin());
-			getCore()->getPrivate()->mainDb->addEvent(event);
+			getCore()->getPrivate()->mainDb->queueEvent(event);
 		}
 	}
 }
@@ -1498,7 +1633,7 @@ void ServerGroupChatRoom::setSubject (const string &subject) {
 	if (subject != getSubject()) {
 		getConference()->setSubject(subject);
 		shared_ptr<ConferenceSubjectEvent> event = getConference()->notifySubjectChanged(time(nullptr), false, getSubject());
-		getCore()->getPrivate()->mainDb->addEvent(event);
+		getCore()->getPrivate()->mainDb->queueEvent(event);
 	}
 }
 
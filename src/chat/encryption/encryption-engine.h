@@ -69,6 +69,10 @@ public:
 		FileTransferContent *fileTransferContent
 	) {}
 
+	// If true, downloadingFile() and uploadingFile() may be given the input buffer as output buffer, so that file
+	// transfer chunks are decrypted or encrypted in place.
+	virtual bool canTransformFileInPlace () const { return false; }
+
 	virtual int downloadingFile (
 		const std::shared_ptr<ChatMessage> &message,
 		size_t offset,
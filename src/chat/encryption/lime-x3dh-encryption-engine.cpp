@@ -531,6 +531,11 @@ void LimeX3dhEncryptionEngine::generateFileTransferKey (
 	bctbx_clean(keyBuffer, FILE_TRANSFER_KEY_SIZE);
 }
 
+bool LimeX3dhEncryptionEngine::canTransformFileInPlace () const {
+	// AES-GCM is a stream mode, each byte of output only depends on the byte of input at the same position.
+	return true;
+}
+
 int LimeX3dhEncryptionEngine::downloadingFile (
 	const shared_ptr<ChatMessage> &message,
 	size_t offset,
@@ -849,9 +854,9 @@ void LimeX3dhEncryptionEngine::addSecurityEventInChatrooms (
 	const IdentityAddress &peerDeviceAddr,
 	ConferenceSecurityEvent::SecurityEventType securityEventType
 ) {
-	const list<shared_ptr<AbstractChatRoom>> chatRooms = getCore()->getChatRooms();
+	const list<shared_ptr<AbstractChatRoom>> chatRooms = getCore()->getChatRooms(LinphoneChatRoomCapabilitiesEncrypted);
 	for (const auto &chatRoom : chatRooms) {
-		if (chatRoom->findParticipant(peerDeviceAddr) && (chatRoom->getCapabilities() & ChatRoom::Capabilities::Encrypted) ) {
+		if (chatRoom->findParticipant(peerDeviceAddr)) {
 			shared_ptr<ConferenceSecurityEvent> securityEvent = make_shared<ConferenceSecurityEvent>(
 				time(nullptr),
 				chatRoom->getConferenceId(),
@@ -99,6 +99,8 @@ public:
 		FileTransferContent *fileTransferContent
 	) override;
 
+	bool canTransformFileInPlace () const override;
+
 	int downloadingFile (
 		const std::shared_ptr<ChatMessage> &message,
 		size_t offset,
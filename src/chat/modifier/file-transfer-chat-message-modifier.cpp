@@ -17,6 +17,8 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <fstream>
+
 #include "linphone/api/c-content.h"
 
 #include "address/address.h"
@@ -38,6 +40,17 @@ using namespace std;
 
 LINPHONE_BEGIN_NAMESPACE
 
+// Written next to a file being downloaded, a partial file is only resumed if its marker matches the content.
+static string getDownloadResumeMarkerPath (const string &filePath) {
+	return filePath + ".resume";
+}
+
+static void removeDownloadResumeMarker (const string &filePath) {
+	const string markerPath = getDownloadResumeMarkerPath(filePath);
+	if (bctbx_file_exist(markerPath.c_str()) == 0)
+		unlink(markerPath.c_str());
+}
+
 FileTransferChatMessageModifier::FileTransferChatMessageModifier (belle_http_provider_t *prov) : provider(prov) {
 	bgTask.setName("File transfer upload");
 }
@@ -56,6 +69,7 @@ FileTransferChatMessageModifier::~FileTransferChatMessageModifier () {
 		cancelFileTransfer(); //to avoid body handler to still refference zombie FileTransferChatMessageModifier
 	else
 		releaseHttpRequest();
+	cancelUploadRetry();
 }
 
 ChatMessageModifier::Result FileTransferChatMessageModifier::encode (const shared_ptr<ChatMessage> &message, int &errorCode) {
@@ -63,6 +77,7 @@ ChatMessageModifier::Result FileTransferChatMessageModifier::encode (const share
 
 	currentFileContentToTransfer = nullptr;
 	currentFileTransferContent = nullptr;
+	uploadRetryCount = 0;
 	// For each FileContent, upload it and create a FileTransferContent
 	for (Content *content : message->getContents()) {
 		if (content->isFile()) {
@@ -110,6 +125,12 @@ void FileTransferChatMessageModifier::fileTransferOnProgress (
 	if (!message)
 		return;
 
+	// The body handler of a resumed download only knows about the missing bytes.
+	if (downloadResumeFile) {
+		offset += downloadResumeOffset;
+		total += downloadResumeOffset;
+	}
+
 	size_t percentage = offset * 100 / total;
 	if (percentage <= lastNotifiedPercentage) {
 		return;
@@ -201,16 +222,16 @@ int FileTransferChatMessageModifier::onSendBody (
 	EncryptionEngine *imee = message->getCore()->getEncryptionEngine();
 	if (imee) {
 		size_t max_size = *size;
-		uint8_t *encrypted_buffer = (uint8_t *)ms_malloc0(max_size);
+		uint8_t *encrypted_buffer = getCryptoBuffer(imee, buffer, max_size);
 		retval = imee->uploadingFile(L_GET_CPP_PTR_FROM_C_OBJECT(msg), offset, buffer, size, encrypted_buffer, currentFileTransferContent);
 		if (retval == 0) {
 			if (*size > max_size) {
 				lError() << "IM encryption engine process upload file callback returned a size bigger than the size of the buffer, so it will be truncated !";
 				*size = max_size;
 			}
-			memcpy(buffer, encrypted_buffer, *size);
+			if (encrypted_buffer != buffer)
+				memcpy(buffer, encrypted_buffer, *size);
 		}
-		ms_free(encrypted_buffer);
 	}
 
 	return retval <= 0 && *size != 0 ? BELLE_SIP_CONTINUE : BELLE_SIP_STOP;
@@ -230,6 +251,21 @@ void FileTransferChatMessageModifier::onSendEnd (belle_sip_user_body_handler_t *
 	if (imee) {
 		imee->uploadingFile(message, 0, nullptr, 0, nullptr, currentFileTransferContent);
 	}
+	releaseCryptoBuffer();
+}
+
+uint8_t *FileTransferChatMessageModifier::getCryptoBuffer (EncryptionEngine *imee, uint8_t *buffer, size_t size) {
+	if (imee->canTransformFileInPlace())
+		return buffer;
+
+	// Reused for all the chunks of the transfer.
+	if (cryptoBuffer.size() < size)
+		cryptoBuffer.resize(size);
+	return cryptoBuffer.data();
+}
+
+void FileTransferChatMessageModifier::releaseCryptoBuffer () {
+	vector<uint8_t>().swap(cryptoBuffer);
 }
 
 static void _chat_message_process_response_from_post_file (void *data, const belle_http_response_event_t *event) {
@@ -282,24 +318,29 @@ belle_sip_body_handler_t *FileTransferChatMessageModifier::prepare_upload_body_h
 		currentFileTransferContent->setFileSize(belle_sip_file_body_handler_get_file_size((belle_sip_file_body_handler_t *)first_part_bh));
 	} else if (!currentFileContentToTransfer->isEmpty()) {
 		size_t buf_size = currentFileContentToTransfer->getSize();
+		// Owned by the body handler, the body is encrypted directly into it when the engine allows it.
 		uint8_t *buf = (uint8_t *)ms_malloc(buf_size);
 		memcpy(buf, currentFileContentToTransfer->getBody().data(), buf_size);
 
 		EncryptionEngine *imee = message->getCore()->getEncryptionEngine();
 		if (imee) {
 			size_t max_size = buf_size;
-			uint8_t *encrypted_buffer = (uint8_t *)ms_malloc0(max_size);
+			uint8_t *encrypted_buffer = imee->canTransformFileInPlace() ? buf : (uint8_t *)ms_malloc0(buf_size);
 			int retval = imee->uploadingFile(message, 0, buf, &max_size, encrypted_buffer, currentFileTransferContent);
 			if (retval == 0) {
 				if (max_size > buf_size) {
 					lError() << "IM encryption engine process upload file callback returned a size bigger than the size of the buffer, so it will be truncated !";
 					max_size = buf_size;
 				}
-				memcpy(buf, encrypted_buffer, buf_size);
+				if (encrypted_buffer != buf)
+					memcpy(buf, encrypted_buffer, buf_size);
+				else if (max_size < buf_size)
+					memset(buf + max_size, 0, buf_size - max_size);
 				// Call it once more to compute the authentication tag
 				imee->uploadingFile(message, 0, nullptr, 0, nullptr, currentFileTransferContent);
 			}
-			ms_free(encrypted_buffer);
+			if (encrypted_buffer != buf)
+				ms_free(encrypted_buffer);
 		}
 
 		first_part_bh = (belle_sip_body_handler_t *)belle_sip_memory_body_handler_new_from_buffer(
@@ -431,10 +472,58 @@ void FileTransferChatMessageModifier::processIoErrorUpload (const belle_sip_io_e
 	lError() << "I/O Error during file upload of message [" << message << "]";
 	if (!message)
 		return;
+	if (scheduleUploadRetry(message))
+		return;
 	message->getPrivate()->setState(ChatMessage::State::NotDelivered);
 	releaseHttpRequest();
 }
 
+bool FileTransferChatMessageModifier::scheduleUploadRetry (const shared_ptr<ChatMessage> &message) {
+	int maxRetries = linphone_config_get_int(linphone_core_get_config(message->getCore()->getCCore()), "misc", "file_transfer_upload_max_retries", 2);
+	if (uploadRetryCount >= maxRetries || !currentFileContentToTransfer)
+		return false;
+	uploadRetryCount++;
+
+	// The file sharing server cannot resume an upload: restore the file content, a new file key will be generated
+	// when the server accepts the upload again.
+	if (currentFileTransferContent) {
+		message->getPrivate()->replaceContent(currentFileTransferContent, currentFileContentToTransfer);
+		delete currentFileTransferContent;
+		currentFileTransferContent = nullptr;
+	}
+	releaseCryptoBuffer();
+
+	// Save currentFileContentToTransfer pointer as it will be set to NULL in releaseHttpRequest
+	FileContent *fileContent = currentFileContentToTransfer;
+	releaseHttpRequest();
+	currentFileContentToTransfer = fileContent;
+	fileUploadEndBackgroundTask();
+
+	unsigned int delay = 1000u << (uploadRetryCount - 1);
+	lWarning() << "Upload of message [" << message << "] will be retried in " << delay << "ms (" << uploadRetryCount << "/" << maxRetries << ")";
+	cancelUploadRetry();
+	uploadRetryPending = true;
+	uploadRetryTimer = message->getCore()->createTimer([this]() {
+		uploadRetryPending = false;
+		shared_ptr<ChatMessage> message = chatMessage.lock();
+		if (message && uploadFile(nullptr) != 0) {
+			lError() << "Unable to retry upload of message [" << message << "]";
+			message->getPrivate()->setState(ChatMessage::State::NotDelivered);
+		}
+		return false;
+	}, delay, "File transfer upload retry");
+	return true;
+}
+
+void FileTransferChatMessageModifier::cancelUploadRetry () {
+	uploadRetryPending = false;
+	if (uploadRetryTimer) {
+		belle_sip_source_cancel(uploadRetryTimer);
+		belle_sip_object_unref(uploadRetryTimer);
+		uploadRetryTimer = nullptr;
+	}
+}
+
 static void _chat_message_process_auth_requested_upload (void *data, belle_sip_auth_event *event) {
 	FileTransferChatMessageModifier *d = (FileTransferChatMessageModifier *)data;
 	d->processAuthRequestedUpload(event);
@@ -533,6 +622,13 @@ int FileTransferChatMessageModifier::startHttpTransfer (const string &url, const
 		lWarning() << "Could not create http request for uri " << url;
 		goto error;
 	}
+	if (downloadResumeOffset > 0) {
+		string range = "bytes=" + to_string(downloadResumeOffset) + "-";
+		belle_sip_message_add_header(BELLE_SIP_MESSAGE(httpRequest), belle_http_header_create("Range", range.c_str()));
+		// If the remote file changed since the partial download, the server answers 200 with the whole file.
+		if (!downloadResumeValidator.empty())
+			belle_sip_message_add_header(BELLE_SIP_MESSAGE(httpRequest), belle_http_header_create("If-Range", downloadResumeValidator.c_str()));
+	}
 	if (bh) belle_sip_message_set_body_handler(BELLE_SIP_MESSAGE(httpRequest), BELLE_SIP_BODY_HANDLER(bh));
 	// keep a reference to the http request to be able to cancel it during upload
 	belle_sip_object_ref(httpRequest);
@@ -612,16 +708,20 @@ void FileTransferChatMessageModifier::onRecvBody (belle_sip_user_body_handler_t
 	int retval = -1;
 	EncryptionEngine *imee = message->getCore()->getEncryptionEngine();
 	if (imee) {
-		uint8_t *decrypted_buffer = (uint8_t *)ms_malloc0(size);
+		uint8_t *decrypted_buffer = getCryptoBuffer(imee, buffer, size);
 		retval = imee->downloadingFile(message, offset, buffer, size, decrypted_buffer, currentFileTransferContent);
-		if (retval == 0) {
+		if (retval == 0 && decrypted_buffer != buffer) {
 			memcpy(buffer, decrypted_buffer, size);
 		}
-		ms_free(decrypted_buffer);
 	}
 
 	if (retval == 0 || retval == -1) {
-		if (currentFileContentToTransfer->getFilePath().empty()) {
+		if (downloadResumeFile) {
+			if (bctbx_file_write(downloadResumeFile, buffer, size, off_t(downloadResumeOffset + offset)) != ssize_t(size)) {
+				lError() << "Unable to write resumed download of message [" << message << "] to " << currentFileContentToTransfer->getFilePath();
+				message->getPrivate()->setState(ChatMessage::State::FileTransferError);
+			}
+		} else if (currentFileContentToTransfer->getFilePath().empty()) {
 			LinphoneChatMessage *msg = L_GET_C_BACK_PTR(message);
 			LinphoneChatMessageCbs *cbs = linphone_chat_message_get_callbacks(msg);
 			LinphoneContent *content = L_GET_C_BACK_PTR((Content *)currentFileContentToTransfer);
@@ -659,6 +759,8 @@ void FileTransferChatMessageModifier::onRecvEnd (belle_sip_user_body_handler_t *
 	if (imee) {
 		retval = imee->downloadingFile(message, 0, nullptr, 0, nullptr, currentFileTransferContent);
 	}
+	releaseCryptoBuffer();
+	closeDownloadResumeFile();
 
 	if (retval == 0 || retval == -1) {
 		if (currentFileContentToTransfer->getFilePath().empty()) {
@@ -678,6 +780,9 @@ void FileTransferChatMessageModifier::onRecvEnd (belle_sip_user_body_handler_t *
 		}
 
 		if (message->getState() != ChatMessage::State::FileTransferError) {
+			if (!currentFileContentToTransfer->getFilePath().empty())
+				removeDownloadResumeMarker(currentFileContentToTransfer->getFilePath());
+
 			// Remove the FileTransferContent from the message and store the FileContent
 			FileContent *fileContent = currentFileContentToTransfer;
 			message->getPrivate()->addContent(fileContent);
@@ -739,19 +844,33 @@ void FileTransferChatMessageModifier::processResponseHeadersFromGetFile (const b
 
 		if (code >= 400 && code < 500) {
 			lWarning() << "File transfer failed with code " << code;
+			if (code == 416 && downloadResumeOffset > 0) {
+				// The partial file does not match the remote one, the next download will start from the beginning.
+				lWarning() << "Deleting partial file " << currentFileContentToTransfer->getFilePath();
+				unlink(currentFileContentToTransfer->getFilePath().c_str());
+				removeDownloadResumeMarker(currentFileContentToTransfer->getFilePath());
+			}
 			message->getPrivate()->setState(ChatMessage::State::FileTransferError);
 			releaseHttpRequest();
 			currentFileTransferContent = nullptr;
 			return;
 		}
 
+		if (downloadResumeOffset > 0 && code != 206) {
+			lInfo() << "Server did not accept to resume the download, restarting from the beginning";
+			unlink(currentFileContentToTransfer->getFilePath().c_str());
+			downloadResumeOffset = 0;
+		}
+		if (downloadResumeOffset == 0 && currentFileContentToTransfer && currentFileTransferContent && canResumeDownload(message, currentFileTransferContent))
+			writeDownloadResumeMarker(event->response);
+
 		// we are receiving a response, set a specific body handler to acquire the response.
 		// if not done, belle-sip will create a memory body handler, the default
 		belle_sip_message_t *response = BELLE_SIP_MESSAGE(event->response);
 
 		if (currentFileContentToTransfer) {
 			belle_sip_header_content_length_t *content_length_hdr = BELLE_SIP_HEADER_CONTENT_LENGTH(belle_sip_message_get_header(response, "Content-Length"));
-			currentFileContentToTransfer->setFileSize(belle_sip_header_content_length_get_content_length(content_length_hdr));
+			currentFileContentToTransfer->setFileSize(downloadResumeOffset + belle_sip_header_content_length_get_content_length(content_length_hdr));
 			lInfo() << "Extracted content length " << currentFileContentToTransfer->getFileSize() << " from header";
 		} else {
 			lWarning() << "No file transfer information for message [" << message << "]: creating...";
@@ -761,13 +880,23 @@ void FileTransferChatMessageModifier::processResponseHeadersFromGetFile (const b
 
 		size_t body_size = 0;
 		if (currentFileContentToTransfer)
-			body_size = currentFileContentToTransfer->getFileSize();
+			body_size = currentFileContentToTransfer->getFileSize() - downloadResumeOffset;
+
+		if (downloadResumeOffset > 0) {
+			downloadResumeFile = bctbx_file_open(bctbx_vfs_get_standard(), currentFileContentToTransfer->getFilePath().c_str(), "r+");
+			if (!downloadResumeFile) {
+				lError() << "Unable to open partial file " << currentFileContentToTransfer->getFilePath() << " to resume the download";
+				onDownloadFailed();
+				return;
+			}
+			lInfo() << "Resuming download of message [" << message << "] at byte " << downloadResumeOffset;
+		}
 
 		/* Reception buffering : The decryption engine must get data chunks which size is 0 mod 16
 		 * In order to achieve this, we bufferize the input at body handler level as the callbacks
 		 * cannot modify the size or the offset given by the body handler */
 		belle_sip_body_handler_t *body_handler = NULL;
-		if (!currentFileContentToTransfer->getFilePath().empty()) {
+		if (!currentFileContentToTransfer->getFilePath().empty() && !downloadResumeFile) {
 			/* the buffering is done by file body handler, use a regular user body handler*/
 			belle_sip_user_body_handler_t *bh = belle_sip_user_body_handler_new(
 				body_size, _chat_message_file_transfer_on_progress,
@@ -850,7 +979,7 @@ void FileTransferChatMessageModifier::processResponseFromGetFile (const belle_ht
 		if (code >= 400 && code < 500) {
 			lWarning() << "File transfer failed with code " << code;
 			onDownloadFailed();
-		} else if (code != 200) {
+		} else if (code != 200 && code != 206) {
 			lWarning() << "Unhandled HTTP code response " << code << " for file transfer";
 		}
 	}
@@ -898,6 +1027,7 @@ bool FileTransferChatMessageModifier::downloadFile (
 	}
 
 	lastNotifiedPercentage = 0;
+	downloadResumeOffset = getDownloadResumeOffset(message, fileTransferContent);
 	lInfo() << "Downloading file transfer content [" << fileTransferContent << "], removing it to keep only the file content [" << fileContent << "]";
 
 	belle_http_request_listener_callbacks_t cbs = { 0 };
@@ -915,16 +1045,71 @@ bool FileTransferChatMessageModifier::downloadFile (
 		url.insert(0,proxy);
 	}
 	int err = startHttpTransfer(url, "GET", nullptr, &cbs);
-	if (err == -1)
+	if (err == -1) {
+		downloadResumeOffset = 0;
+		downloadResumeValidator.clear();
 		return false;
+	}
 	// start the download, status is In Progress
 	message->getPrivate()->setState(ChatMessage::State::FileTransferInProgress);
 	return true;
 }
 
+bool FileTransferChatMessageModifier::canResumeDownload (const shared_ptr<ChatMessage> &message, const FileTransferContent *fileTransferContent) const {
+	// The authentication tag of an encrypted file is computed over the whole file, it cannot be resumed.
+	if (currentFileContentToTransfer->getFilePath().empty() || fileTransferContent->getFileKeySize() > 0)
+		return false;
+	return !!linphone_config_get_bool(linphone_core_get_config(message->getCore()->getCCore()), "misc", "file_transfer_resume_download", TRUE);
+}
+
+void FileTransferChatMessageModifier::writeDownloadResumeMarker (belle_http_response_t *response) {
+	// Only strong validators can be sent in If-Range, a weak ETag is replaced by the modification date.
+	string validator;
+	belle_sip_header_t *etag = belle_sip_message_get_header(BELLE_SIP_MESSAGE(response), "ETag");
+	if (etag && strncmp(belle_sip_header_get_unparsed_value(etag), "W/", 2) != 0)
+		validator = belle_sip_header_get_unparsed_value(etag);
+	else {
+		belle_sip_header_t *lastModified = belle_sip_message_get_header(BELLE_SIP_MESSAGE(response), "Last-Modified");
+		if (lastModified)
+			validator = belle_sip_header_get_unparsed_value(lastModified);
+	}
+
+	const string markerPath = getDownloadResumeMarkerPath(currentFileContentToTransfer->getFilePath());
+	ofstream marker(markerPath, ios::trunc);
+	marker << currentFileTransferContent->getFileUrl() << "\n" << validator << "\n";
+	if (!marker)
+		lWarning() << "Unable to write " << markerPath << ", an interrupted download will start again from the beginning";
+}
+
+size_t FileTransferChatMessageModifier::getDownloadResumeOffset (const shared_ptr<ChatMessage> &message, const FileTransferContent *fileTransferContent) {
+	const string &filePath = currentFileContentToTransfer->getFilePath();
+	if (!canResumeDownload(message, fileTransferContent) || bctbx_file_exist(filePath.c_str()) != 0)
+		return 0;
+
+	// An existing file is resumed only if the modifier started its download: it may be unrelated to the content.
+	ifstream marker(getDownloadResumeMarkerPath(filePath));
+	string url;
+	if (!marker || !getline(marker, url) || url != fileTransferContent->getFileUrl()) {
+		lInfo() << "No partial download of " << fileTransferContent->getFileUrl() << " found in " << filePath;
+		return 0;
+	}
+	getline(marker, downloadResumeValidator);
+
+	bctbx_vfs_file_t *file = bctbx_file_open(bctbx_vfs_get_standard(), filePath.c_str(), "r");
+	if (!file)
+		return 0;
+	ssize_t size = bctbx_file_size(file);
+	bctbx_file_close(file);
+
+	if (size <= 0 || size_t(size) >= fileTransferContent->getFileSize())
+		return 0;
+	return size_t(size);
+}
+
 // ----------------------------------------------------------
 
 void FileTransferChatMessageModifier::cancelFileTransfer () {
+	cancelUploadRetry();
 	if (!httpRequest) {
 		lInfo() << "No existing file transfer - nothing to cancel";
 		return;
@@ -938,11 +1123,13 @@ void FileTransferChatMessageModifier::cancelFileTransfer () {
 
 				shared_ptr<ChatMessage> message = chatMessage.lock();
 				if (message && message->getDirection() == ChatMessage::Direction::Incoming) {
+					closeDownloadResumeFile();
 					lWarning() << "Deleting incomplete file " << filePath;
 					int result = unlink(filePath.c_str());
 					if (result != 0) {
 						lError() << "Couldn't delete file " << filePath << ", errno is " << result;
 					}
+					removeDownloadResumeMarker(filePath);
 				} else {
 					lWarning() << "http request still running for ORPHAN msg: this is a memory leak";
 				}
@@ -960,7 +1147,7 @@ void FileTransferChatMessageModifier::cancelFileTransfer () {
 }
 
 bool FileTransferChatMessageModifier::isFileTransferInProgressAndValid () const {
-	return httpRequest && !belle_http_request_is_cancelled(httpRequest);
+	return (httpRequest && !belle_http_request_is_cancelled(httpRequest)) || uploadRetryPending;
 }
 
 void FileTransferChatMessageModifier::releaseHttpRequest () {
@@ -972,9 +1159,19 @@ void FileTransferChatMessageModifier::releaseHttpRequest () {
 			httpListener = nullptr;
 		}
 	}
+	closeDownloadResumeFile();
+	downloadResumeOffset = 0;
+	downloadResumeValidator.clear();
 	currentFileContentToTransfer = nullptr;
 }
 
+void FileTransferChatMessageModifier::closeDownloadResumeFile () {
+	if (downloadResumeFile) {
+		bctbx_file_close(downloadResumeFile);
+		downloadResumeFile = nullptr;
+	}
+}
+
 /* -------------------------------------------------------------------------------------- */
 
 string FileTransferChatMessageModifier::createFakeFileTransferFromUrl (const string &url) {
@@ -20,7 +20,10 @@
 #ifndef _L_FILE_TRANSFER_CHAT_MESSAGE_MODIFIER_H_
 #define _L_FILE_TRANSFER_CHAT_MESSAGE_MODIFIER_H_
 
+#include <vector>
+
 #include <belle-sip/belle-sip.h>
+#include <bctoolbox/vfs.h>
 
 #include "chat-message-modifier.h"
 #include "utils/background-task.h"
@@ -31,6 +34,7 @@ LINPHONE_BEGIN_NAMESPACE
 
 class ChatRoom;
 class Core;
+class EncryptionEngine;
 class FileContent;
 class FileTransferContent;
 
@@ -83,7 +87,19 @@ private:
 
 	void onDownloadFailed ();
 	void releaseHttpRequest ();
+	bool canResumeDownload (const std::shared_ptr<ChatMessage> &message, const FileTransferContent *fileTransferContent) const;
+	// Records next to the file the URL and the validator of the remote file whose download starts.
+	void writeDownloadResumeMarker (belle_http_response_t *response);
+	// Size of the partial file left by a previous download of the content, 0 if the download must start from the beginning.
+	size_t getDownloadResumeOffset (const std::shared_ptr<ChatMessage> &message, const FileTransferContent *fileTransferContent);
+	void closeDownloadResumeFile ();
+	// Restart the upload from the first empty POST after a delay, false if the retries are exhausted.
+	bool scheduleUploadRetry (const std::shared_ptr<ChatMessage> &message);
+	void cancelUploadRetry ();
 	belle_sip_body_handler_t *prepare_upload_body_handler(std::shared_ptr<ChatMessage> message);
+	// Output buffer of the encryption engine for a chunk: the chunk itself if the engine can transform it in place.
+	uint8_t *getCryptoBuffer (EncryptionEngine *imee, uint8_t *buffer, size_t size);
+	void releaseCryptoBuffer ();
 
 	std::weak_ptr<ChatMessage> chatMessage;
 	FileContent* currentFileContentToTransfer = nullptr;
@@ -95,6 +111,18 @@ private:
 
 	size_t lastNotifiedPercentage = 0;
 
+	// A resumed download appends to the partial file itself, the file body handler would truncate it.
+	size_t downloadResumeOffset = 0;
+	// ETag or Last-Modified of the partially downloaded file, sent in If-Range.
+	std::string downloadResumeValidator;
+	bctbx_vfs_file_t *downloadResumeFile = nullptr;
+
+	int uploadRetryCount = 0;
+	bool uploadRetryPending = false;
+	belle_sip_source_t *uploadRetryTimer = nullptr;
+
+	std::vector<uint8_t> cryptoBuffer;
+
 	BackgroundTask bgTask;
 };
 
@@ -0,0 +1,595 @@
+/*
+ * Copyright (c) 2010-2021 Belledonne Communications SARL.
+ *
+ * This file is part of Liblinphone.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <sstream>
+
+#include <libxml/parser.h>
+
+#include "conference-info-parser.h"
+#include "remote-conference-event-handler.h"
+#include "xml/conference-info.h"
+#include "xml/conference-info-linphone-extension.h"
+
+#include <xsd/cxx/xml/string.hxx>
+
+// =============================================================================
+
+using namespace std;
+
+LINPHONE_BEGIN_NAMESPACE
+
+namespace {
+	constexpr char ConferenceInfoNamespace[] = "urn:ietf:params:xml:ns:conference-info";
+	constexpr char LinphoneExtensionNamespace[] = "linphone:xml:ns:conference-info-linphone-extension";
+
+	enum class Element {
+		Other,
+		ConferenceInfo,
+		ConferenceDescription,
+		Subject,
+		FreeText,
+		Keywords,
+		AvailableMedia,
+		AvailableMediaEntry,
+		Ephemeral,
+		EphemeralMode,
+		EphemeralLifetime,
+		Users,
+		User,
+		Roles,
+		RoleEntry,
+		Endpoint,
+		EndpointDisplayText,
+		EndpointMedia,
+		MediaType,
+		MediaSrcId,
+		MediaStatus
+	};
+
+	bool isTextElement (Element element) {
+		switch (element) {
+			case Element::Subject:
+			case Element::FreeText:
+			case Element::Keywords:
+			case Element::EphemeralMode:
+			case Element::EphemeralLifetime:
+			case Element::RoleEntry:
+			case Element::EndpointDisplayText:
+			case Element::MediaType:
+			case Element::MediaSrcId:
+			case Element::MediaStatus:
+				return true;
+			default:
+				return false;
+		}
+	}
+
+	ConferenceInfoParser::State toState (const string &value) {
+		if (value == "deleted")
+			return ConferenceInfoParser::State::Deleted;
+		if (value == "partial")
+			return ConferenceInfoParser::State::Partial;
+		return ConferenceInfoParser::State::Full;
+	}
+
+	ConferenceInfoParser::State toState (Xsd::ConferenceInfo::StateType state) {
+		switch (state) {
+			case Xsd::ConferenceInfo::StateType::deleted:
+				return ConferenceInfoParser::State::Deleted;
+			case Xsd::ConferenceInfo::StateType::partial:
+				return ConferenceInfoParser::State::Partial;
+			case Xsd::ConferenceInfo::StateType::full:
+				break;
+		}
+		return ConferenceInfoParser::State::Full;
+	}
+
+	LinphoneMediaDirection toMediaDirection (const string &status) {
+		if (status == "inactive")
+			return LinphoneMediaDirectionInactive;
+		if (status == "sendonly")
+			return LinphoneMediaDirectionSendOnly;
+		if (status == "recvonly")
+			return LinphoneMediaDirectionRecvOnly;
+		return LinphoneMediaDirectionSendRecv;
+	}
+
+	vector<string> splitKeywords (const string &value) {
+		vector<string> keywords;
+		istringstream stream(value);
+		string keyword;
+		while (stream >> keyword)
+			keywords.push_back(keyword);
+		return keywords;
+	}
+}
+
+// -----------------------------------------------------------------------------
+
+class ConferenceInfoParser::Context {
+public:
+	explicit Context (Listener &listener) : mListener(listener) {}
+
+	bool parse (const string &xmlBody) {
+		xmlSAXHandler handler;
+		memset(&handler, 0, sizeof(handler));
+		handler.initialized = XML_SAX2_MAGIC;
+		handler.startElementNs = onStartElement;
+		handler.endElementNs = onEndElement;
+		handler.characters = onCharacters;
+		handler.cdataBlock = onCharacters;
+		handler.warning = onWarning;
+		handler.error = onError;
+		handler.fatalError = onError;
+
+		mParserContext = xmlCreatePushParserCtxt(&handler, this, nullptr, 0, nullptr);
+		if (!mParserContext)
+			return false;
+		xmlCtxtUseOptions(mParserContext, XML_PARSE_NONET);
+
+		xmlParseChunk(mParserContext, xmlBody.c_str(), int(xmlBody.size()), 1);
+		const bool wellFormed = mParserContext->wellFormed && !mInvalid;
+		xmlFreeParserCtxt(mParserContext);
+		mParserContext = nullptr;
+
+		if (!wellFormed || !mRootFound)
+			return false;
+
+		// The listener only gets the events of a well-formed document.
+		for (const auto &event : mEvents) {
+			if (!event())
+				break;
+		}
+		return true;
+	}
+
+private:
+	static void onStartElement (
+		void *ctx,
+		const xmlChar *localName,
+		const xmlChar *,
+		const xmlChar *uri,
+		int,
+		const xmlChar **,
+		int attributeCount,
+		int,
+		const xmlChar **attributes
+	) {
+		static_cast<Context *>(ctx)->startElement(
+			reinterpret_cast<const char *>(localName),
+			reinterpret_cast<const char *>(uri),
+			attributeCount,
+			reinterpret_cast<const char **>(attributes)
+		);
+	}
+
+	static void onEndElement (void *ctx, const xmlChar *, const xmlChar *, const xmlChar *) {
+		static_cast<Context *>(ctx)->endElement();
+	}
+
+	static void onCharacters (void *ctx, const xmlChar *ch, int len) {
+		Context *context = static_cast<Context *>(ctx);
+		if (context->mSkipDepth == 0 && !context->mElements.empty() && isTextElement(context->mElements.back()))
+			context->mText.append(reinterpret_cast<const char *>(ch), size_t(len));
+	}
+
+	static void onWarning (void *, const char *, ...) {}
+
+	// Errors are reported by the well-formed flag of the parser context.
+	static void onError (void *, const char *, ...) {}
+
+	// Attributes are given by groups of 5: local name, prefix, uri, value begin and value end.
+	static bool getAttribute (int attributeCount, const char **attributes, const char *name, string &value) {
+		for (int i = 0; i < attributeCount; ++i) {
+			const char **attribute = attributes + 5 * i;
+			if (attribute[2] == nullptr && strcmp(attribute[0], name) == 0) {
+				value.assign(attribute[3], size_t(attribute[4] - attribute[3]));
+				return true;
+			}
+		}
+		return false;
+	}
+
+	Element getChildElement (Element parent, const char *localName, const char *uri) const {
+		if (!uri)
+			return Element::Other;
+
+		if (strcmp(uri, LinphoneExtensionNamespace) == 0) {
+			if (parent == Element::ConferenceDescription && strcmp(localName, "ephemeral") == 0)
+				return Element::Ephemeral;
+			if (parent == Element::Ephemeral) {
+				if (strcmp(localName, "mode") == 0)
+					return Element::EphemeralMode;
+				if (strcmp(localName, "lifetime") == 0)
+					return Element::EphemeralLifetime;
+			}
+			return Element::Other;
+		}
+
+		if (strcmp(uri, ConferenceInfoNamespace) != 0)
+			return Element::Other;
+
+		switch (parent) {
+			case Element::ConferenceInfo:
+				if (strcmp(localName, "conference-description") == 0)
+					return Element::ConferenceDescription;
+				if (strcmp(localName, "users") == 0)
+					return Element::Users;
+				break;
+			case Element::ConferenceDescription:
+				if (strcmp(localName, "subject") == 0)
+					return Element::Subject;
+				if (strcmp(localName, "free-text") == 0)
+					return Element::FreeText;
+				if (strcmp(localName, "keywords") == 0)
+					return Element::Keywords;
+				if (strcmp(localName, "available-media") == 0)
+					return Element::AvailableMedia;
+				break;
+			case Element::AvailableMedia:
+				if (strcmp(localName, "entry") == 0)
+					return Element::AvailableMediaEntry;
+				break;
+			case Element::AvailableMediaEntry:
+				if (strcmp(localName, "type") == 0)
+					return Element::MediaType;
+				if (strcmp(localName, "status") == 0)
+					return Element::MediaStatus;
+				break;
+			case Element::Users:
+				if (strcmp(localName, "user") == 0)
+					return Element::User;
+				break;
+			case Element::User:
+				if (strcmp(localName, "roles") == 0)
+					return Element::Roles;
+				if (strcmp(localName, "endpoint") == 0)
+					return Element::Endpoint;
+				break;
+			case Element::Roles:
+				if (strcmp(localName, "entry") == 0)
+					return Element::RoleEntry;
+				break;
+			case Element::Endpoint:
+				if (strcmp(localName, "display-text") == 0)
+					return Element::EndpointDisplayText;
+				if (strcmp(localName, "media") == 0)
+					return Element::EndpointMedia;
+				break;
+			case Element::EndpointMedia:
+				if (strcmp(localName, "type") == 0)
+					return Element::MediaType;
+				if (strcmp(localName, "src-id") == 0)
+					return Element::MediaSrcId;
+				if (strcmp(localName, "status") == 0)
+					return Element::MediaStatus;
+				break;
+			default:
+				break;
+		}
+		return Element::Other;
+	}
+
+	void startElement (const char *localName, const char *uri, int attributeCount, const char **attributes) {
+		++mDepth;
+		if (mSkipDepth > 0)
+			return;
+
+		Element element;
+		if (mElements.empty()) {
+			if (!uri || strcmp(uri, ConferenceInfoNamespace) != 0 || strcmp(localName, "conference-info") != 0) {
+				stop();
+				return;
+			}
+			element = Element::ConferenceInfo;
+		} else {
+			element = getChildElement(mElements.back(), localName, uri);
+			if (element == Element::Other) {
+				// Nothing is read in this subtree.
+				mSkipDepth = mDepth;
+				return;
+			}
+		}
+
+		mElements.push_back(element);
+		mText.clear();
+
+		string value;
+		switch (element) {
+			case Element::ConferenceInfo: {
+				mRootFound = true;
+				ConferenceInfo conferenceInfo;
+				if (!getAttribute(attributeCount, attributes, "entity", conferenceInfo.entity)) {
+					stop();
+					return;
+				}
+				if (getAttribute(attributeCount, attributes, "state", value))
+					conferenceInfo.state = toState(value);
+				if (getAttribute(attributeCount, attributes, "version", value)) {
+					conferenceInfo.hasVersion = true;
+					conferenceInfo.version = (unsigned int)strtoul(value.c_str(), nullptr, 10);
+				}
+				mEvents.push_back([this, conferenceInfo]() {
+					return mListener.onConferenceInfo(conferenceInfo);
+				});
+			} break;
+			case Element::ConferenceDescription:
+				mDescription = ConferenceDescription();
+				break;
+			case Element::AvailableMedia:
+				mDescription.hasAvailableMedia = true;
+				break;
+			case Element::Ephemeral:
+				mDescription.hasEphemeral = true;
+				mDescription.ephemeralMode.clear();
+				mDescription.ephemeralLifetime.clear();
+				break;
+			case Element::AvailableMediaEntry:
+			case Element::EndpointMedia:
+				mMedia = Media();
+				break;
+			case Element::Users:
+				mEvents.push_back([this]() {
+					mListener.onUsers();
+					return true;
+				});
+				break;
+			case Element::User:
+				mUser = User();
+				mUserHasEntity = getAttribute(attributeCount, attributes, "entity", mUser.entity);
+				if (getAttribute(attributeCount, attributes, "state", value))
+					mUser.state = toState(value);
+				mUserNotified = false;
+				break;
+			case Element::Roles:
+				mUser.hasRoles = true;
+				break;
+			case Element::Endpoint:
+				notifyUser();
+				mEndpoint = Endpoint();
+				mEndpointHasEntity = getAttribute(attributeCount, attributes, "entity", mEndpoint.entity);
+				if (getAttribute(attributeCount, attributes, "state", value))
+					mEndpoint.state = toState(value);
+				break;
+			default:
+				break;
+		}
+	}
+
+	void endElement () {
+		const int depth = mDepth--;
+		if (mSkipDepth > 0) {
+			if (mSkipDepth == depth)
+				mSkipDepth = 0;
+			return;
+		}
+		if (mElements.empty())
+			return;
+
+		const Element element = mElements.back();
+		mElements.pop_back();
+
+		switch (element) {
+			case Element::Subject:
+				mDescription.subject = move(mText);
+				break;
+			case Element::FreeText:
+				mDescription.hasFreeText = true;
+				mDescription.freeText = move(mText);
+				break;
+			case Element::Keywords:
+				mDescription.keywords = splitKeywords(mText);
+				break;
+			case Element::EphemeralMode:
+				mDescription.ephemeralMode = move(mText);
+				break;
+			case Element::EphemeralLifetime:
+				mDescription.ephemeralLifetime = move(mText);
+				break;
+			case Element::ConferenceDescription:
+				mEvents.push_back([this, description = move(mDescription)]() {
+					mListener.onConferenceDescription(description);
+					return true;
+				});
+				break;
+			case Element::MediaType:
+				mMedia.type = move(mText);
+				break;
+			case Element::MediaSrcId:
+				mMedia.srcId = move(mText);
+				break;
+			case Element::MediaStatus:
+				mMedia.direction = toMediaDirection(mText);
+				break;
+			case Element::AvailableMediaEntry:
+				mDescription.availableMedia.push_back(move(mMedia));
+				break;
+			case Element::EndpointMedia:
+				mEndpoint.media.push_back(move(mMedia));
+				break;
+			case Element::RoleEntry:
+				mUser.roles.push_back(move(mText));
+				break;
+			case Element::EndpointDisplayText:
+				mEndpoint.displayText = move(mText);
+				break;
+			case Element::Endpoint:
+				if (mUserHasEntity && mEndpointHasEntity) {
+					mEvents.push_back([this, user = mUser, endpoint = move(mEndpoint)]() {
+						mListener.onEndpoint(user, endpoint);
+						return true;
+					});
+				}
+				break;
+			case Element::User:
+				notifyUser();
+				break;
+			default:
+				break;
+		}
+		mText.clear();
+	}
+
+	void notifyUser () {
+		if (mUserNotified)
+			return;
+		mUserNotified = true;
+		if (mUserHasEntity) {
+			mEvents.push_back([this, user = mUser]() {
+				mListener.onUser(user);
+				return true;
+			});
+		}
+	}
+
+	void stop () {
+		mInvalid = true;
+		xmlStopParser(mParserContext);
+	}
+
+	Listener &mListener;
+	xmlParserCtxtPtr mParserContext = nullptr;
+
+	int mDepth = 0;
+	// Depth of the element whose subtree is ignored, 0 if none.
+	int mSkipDepth = 0;
+	vector<Element> mElements;
+	string mText;
+
+	bool mRootFound = false;
+	bool mInvalid = false;
+
+	// Events of the document, given to the listener once it is known to be well formed.
+	vector<function<bool ()>> mEvents;
+
+	ConferenceDescription mDescription;
+	Media mMedia;
+	User mUser;
+	bool mUserHasEntity = false;
+	bool mUserNotified = false;
+	Endpoint mEndpoint;
+	bool mEndpointHasEntity = false;
+};
+
+// -----------------------------------------------------------------------------
+
+bool ConferenceInfoParser::parse (const string &xmlBody, Listener &listener) {
+	Context context(listener);
+	return context.parse(xmlBody);
+}
+
+void ConferenceInfoParser::walk (const Xsd::ConferenceInfo::ConferenceType &confInfo, Listener &listener) {
+	using namespace Xsd::ConferenceInfo;
+
+	ConferenceInfo conferenceInfo;
+	conferenceInfo.entity = confInfo.getEntity();
+	conferenceInfo.state = toState(confInfo.getState());
+	if (confInfo.getVersion().present()) {
+		conferenceInfo.hasVersion = true;
+		conferenceInfo.version = confInfo.getVersion().get();
+	}
+	if (!listener.onConferenceInfo(conferenceInfo))
+		return;
+
+	const auto &confDescription = confInfo.getConferenceDescription();
+	if (confDescription.present()) {
+		ConferenceDescription description;
+		if (confDescription->getSubject().present())
+			description.subject = confDescription->getSubject().get();
+		if (confDescription->getFreeText().present()) {
+			description.hasFreeText = true;
+			description.freeText = confDescription->getFreeText().get();
+		}
+		if (confDescription->getKeywords().present()) {
+			const KeywordsType &keywords = confDescription->getKeywords().get();
+			description.keywords.assign(keywords.begin(), keywords.end());
+		}
+
+		const auto &availableMedia = confDescription->getAvailableMedia();
+		if (availableMedia.present()) {
+			description.hasAvailableMedia = true;
+			for (const auto &mediaEntry : availableMedia->getEntry()) {
+				Media media;
+				media.type = mediaEntry.getType();
+				if (mediaEntry.getStatus().present())
+					media.direction = RemoteConferenceEventHandler::mediaStatusToMediaDirection(mediaEntry.getStatus().get());
+				description.availableMedia.push_back(move(media));
+			}
+		}
+
+		for (const auto &anyElement : confDescription->getAny()) {
+			const string nodeName = xsd::cxx::xml::transcode<char>(anyElement.getNodeName());
+			if (nodeName != "linphone-cie:ephemeral")
+				continue;
+			Xsd::ConferenceInfoLinphoneExtension::Ephemeral ephemeral{anyElement};
+			description.hasEphemeral = true;
+			description.ephemeralMode = ephemeral.getMode();
+			description.ephemeralLifetime = ephemeral.getLifetime();
+		}
+
+		listener.onConferenceDescription(description);
+	}
+
+	const auto &users = confInfo.getUsers();
+	if (!users.present())
+		return;
+
+	listener.onUsers();
+	for (const auto &xmlUser : users->getUser()) {
+		if (!xmlUser.getEntity().present())
+			continue;
+
+		User user;
+		user.entity = xmlUser.getEntity().get();
+		user.state = toState(xmlUser.getState());
+		if (xmlUser.getRoles().present()) {
+			user.hasRoles = true;
+			const auto &entries = xmlUser.getRoles()->getEntry();
+			user.roles.assign(entries.begin(), entries.end());
+		}
+		listener.onUser(user);
+
+		for (const auto &xmlEndpoint : xmlUser.getEndpoint()) {
+			if (!xmlEndpoint.getEntity().present())
+				continue;
+
+			Endpoint endpoint;
+			endpoint.entity = xmlEndpoint.getEntity().get();
+			endpoint.state = toState(xmlEndpoint.getState());
+			if (xmlEndpoint.getDisplayText().present())
+				endpoint.displayText = xmlEndpoint.getDisplayText().get();
+			for (const auto &xmlMedia : xmlEndpoint.getMedia()) {
+				Media media;
+				if (xmlMedia.getType().present())
+					media.type = xmlMedia.getType().get();
+				if (xmlMedia.getSrcId().present())
+					media.srcId = xmlMedia.getSrcId().get();
+				if (xmlMedia.getStatus().present())
+					media.direction = RemoteConferenceEventHandler::mediaStatusToMediaDirection(xmlMedia.getStatus().get());
+				endpoint.media.push_back(move(media));
+			}
+			listener.onEndpoint(user, endpoint);
+		}
+	}
+}
+
+LINPHONE_END_NAMESPACE
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2010-2021 Belledonne Communications SARL.
+ *
+ * This file is part of Liblinphone.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _L_CONFERENCE_INFO_PARSER_H_
+#define _L_CONFERENCE_INFO_PARSER_H_
+
+#include <string>
+#include <vector>
+
+#include "linphone/types.h"
+#include "linphone/utils/general.h"
+
+// =============================================================================
+
+LINPHONE_BEGIN_NAMESPACE
+
+namespace Xsd {
+	namespace ConferenceInfo {
+		class ConferenceType;
+	}
+}
+
+/*
+ * Streaming parser of conference-info documents (RFC 4575) and of the linphone extension.
+ * The body is walked once by the libxml2 SAX2 parser, without building a tree: the parts of the document used by
+ * RemoteConferenceEventHandler are kept as they are complete, one user and one endpoint at a time, and given to a
+ * listener once the whole document is known to be well formed. Elements outside of conference-description and users
+ * are skipped.
+ */
+class LINPHONE_PUBLIC ConferenceInfoParser {
+public:
+	enum class State {
+		Full,
+		Partial,
+		Deleted
+	};
+
+	struct Media {
+		std::string type;
+		std::string srcId;
+		LinphoneMediaDirection direction = LinphoneMediaDirectionSendRecv;
+	};
+
+	struct ConferenceInfo {
+		std::string entity;
+		State state = State::Full;
+		bool hasVersion = false;
+		unsigned int version = 0;
+	};
+
+	struct ConferenceDescription {
+		std::string subject;
+		bool hasFreeText = false;
+		std::string freeText;
+		std::vector<std::string> keywords;
+		bool hasAvailableMedia = false;
+		std::vector<Media> availableMedia;
+		bool hasEphemeral = false;
+		std::string ephemeralMode;
+		std::string ephemeralLifetime;
+	};
+
+	struct User {
+		std::string entity;
+		State state = State::Full;
+		bool hasRoles = false;
+		std::vector<std::string> roles;
+	};
+
+	struct Endpoint {
+		std::string entity;
+		State state = State::Full;
+		std::string displayText;
+		std::vector<Media> media;
+	};
+
+	class Listener {
+	public:
+		virtual ~Listener () = default;
+
+		// Called with the attributes of the root element, return false to ignore the rest of the document.
+		virtual bool onConferenceInfo (const ConferenceInfo &conferenceInfo) = 0;
+		// Not called if the document has no conference-description.
+		virtual void onConferenceDescription (const ConferenceDescription &description) = 0;
+		// Called before the first user, not called if the document has no users element.
+		virtual void onUsers () = 0;
+		// Called once the roles of the user are known, before its endpoints. Users without entity are skipped.
+		virtual void onUser (const User &user) = 0;
+		// Endpoints without entity are skipped.
+		virtual void onEndpoint (const User &user, const Endpoint &endpoint) = 0;
+	};
+
+	// Returns false if the body is not a well-formed conference-info document, the listener then gets no event.
+	static bool parse (const std::string &xmlBody, Listener &listener);
+
+	// Gives the same events from a document parsed with the XSD bindings.
+	static void walk (const Xsd::ConferenceInfo::ConferenceType &confInfo, Listener &listener);
+
+private:
+	class Context;
+};
+
+LINPHONE_END_NAMESPACE
+
+#endif // ifndef _L_CONFERENCE_INFO_PARSER_H_
@@ -56,6 +56,7 @@ void LocalAudioVideoConferenceEventHandler::onStateChanged (LinphonePrivate::Con
 			break;
 		case ConferenceInterface::State::Terminated:
 			getMediaConference()->resetLastNotify();
+			invalidateFullState();
 			getMediaConference()->onConferenceTerminated(getMediaConference()->getConferenceAddress());
 			break;
 		case ConferenceInterface::State::Deleted:
@@ -17,6 +17,8 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <climits>
 #include <ctime>
 
 #include "linphone/api/c-content.h"
@@ -52,9 +54,28 @@ using namespace Xsd::ConferenceInfoLinphoneExtension;
 
 // =============================================================================
 
+namespace {
+	constexpr int DefaultNotifyBatchSize = 50;
+
+	// Approximate sizes of the serialized bodies, used to choose between a full state and the missed events.
+	constexpr size_t EstimatedFullStateBaseSize = 1024;
+	constexpr size_t EstimatedUserSize = 256;
+	constexpr size_t EstimatedEndpointSize = 768;
+	constexpr size_t EstimatedNotifyPartSize = 1024;
+}
+
 LocalConferenceEventHandler::LocalConferenceEventHandler (Conference *conference, ConferenceListener *listener): conf(conference), confListener(listener) {
 }
 
+LocalConferenceEventHandler::~LocalConferenceEventHandler () {
+	if (pendingNotifiesTimer) {
+		if (!pendingNotifies.empty())
+			lWarning() << "Dropping " << pendingNotifies.size() << " pending NOTIFYs of conference event handler [" << this << "]";
+		conf->getCore()->destroyTimer(pendingNotifiesTimer);
+		pendingNotifiesTimer = nullptr;
+	}
+}
+
 // -----------------------------------------------------------------------------
 
 void LocalConferenceEventHandler::notifyFullState (const string &notify, const shared_ptr<ParticipantDevice> &device) {
@@ -62,18 +83,28 @@ void LocalConferenceEventHandler::notifyFullState (const string &notify, const s
 }
 
 void LocalConferenceEventHandler::notifyAllExcept (const string &notify, const shared_ptr<Participant> &exceptParticipant) {
+	shared_ptr<Content> content = createNotifyContent(notify, (notify.find(MultipartBoundary) != std::string::npos));
+	if (!content)
+		return;
 	for (const auto &participant : conf->getParticipants()) {
 		if (participant != exceptParticipant)
-			notifyParticipant(notify, participant);
+			notifyParticipant(content, participant);
 	}
 }
 
 void LocalConferenceEventHandler::notifyAll (const string &notify) {
+	shared_ptr<Content> content = createNotifyContent(notify, (notify.find(MultipartBoundary) != std::string::npos));
+	if (!content)
+		return;
 	for (const auto &participant : conf->getParticipants())
-		notifyParticipant(notify, participant);
+		notifyParticipant(content, participant);
 }
 
 string LocalConferenceEventHandler::createNotifyFullState (LinphoneEvent * lev) {
+	std::list<std::shared_ptr<Participant>> participants = getFullStateParticipants();
+	if (isFullStateSnapshotValid(participants))
+		return fullStateSnapshot.body;
+
 	vector<string> acceptedContents = vector<string>();
 	if (lev) {
 		const auto message = (belle_sip_message_t*)lev->op->getRecvCustomHeaders();
@@ -132,16 +163,6 @@ string LocalConferenceEventHandler::createNotifyFullState (LinphoneEvent * lev)
 	UsersType users;
 	confInfo.setUsers(users);
 
-	std::list<std::shared_ptr<Participant>> participants(conf->getParticipants());
-
-	// Add local participant only if it is enabled
-	if (confParams.localParticipantEnabled() && conf->isIn()) {
-		std::shared_ptr<Participant> me = conf->getMe();
-		if (me) {
-			participants.push_front(me);
-		}
-	}
-
 	for (const auto &participant : participants) {
 		UserType user = UserType();
 		UserRolesType roles;
@@ -182,8 +203,88 @@ string LocalConferenceEventHandler::createNotifyFullState (LinphoneEvent * lev)
 		confInfo.getUsers()->getUser().push_back(user);
 	}
 
-	const auto conferenceInfoNotify = createNotify(confInfo, true);
-	return conferenceInfoNotify;
+	fullStateSnapshot.version = conf->getLastNotify();
+	fullStateSnapshot.key = getFullStateKey(participants);
+	fullStateSnapshot.body = createNotify(confInfo, true);
+	fullStateSnapshot.content = nullptr;
+	return fullStateSnapshot.body;
+}
+
+list<shared_ptr<Participant>> LocalConferenceEventHandler::getFullStateParticipants () const {
+	list<shared_ptr<Participant>> participants(conf->getParticipants());
+
+	// Add local participant only if it is enabled
+	if (conf->getCurrentParams().localParticipantEnabled() && conf->isIn()) {
+		shared_ptr<Participant> me = conf->getMe();
+		if (me)
+			participants.push_front(me);
+	}
+	return participants;
+}
+
+size_t LocalConferenceEventHandler::getUsersAndDevicesCount (const list<shared_ptr<Participant>> &participants) const {
+	size_t count = participants.size();
+	for (const auto &participant : participants)
+		count += participant->getDevices().size();
+	return count;
+}
+
+string LocalConferenceEventHandler::getFullStateKey (const list<shared_ptr<Participant>> &participants) const {
+	// Devices joining, display names, capabilities and media directions may change without a new version.
+	ostringstream key;
+	key << conf->getConferenceAddress().asString() << '\n';
+	for (const auto &participant : participants) {
+		key << participant->getAddress().asString() << ' ' << participant->isAdmin() << '\n';
+		for (const auto &device : participant->getDevices()) {
+			key << ' ' << device->getAddress().asString() << ' ' << device->getSsrc()
+				<< ' ' << int(device->getAudioDirection()) << int(device->getVideoDirection()) << int(device->getTextDirection())
+				<< ' ' << device->getCapabilityDescriptor() << ' ' << device->getName() << '\n';
+		}
+	}
+	return key.str();
+}
+
+bool LocalConferenceEventHandler::isFullStateSnapshotValid (const list<shared_ptr<Participant>> &participants) const {
+	return !fullStateSnapshot.body.empty()
+		&& fullStateSnapshot.version == conf->getLastNotify()
+		&& fullStateSnapshot.key == getFullStateKey(participants);
+}
+
+void LocalConferenceEventHandler::invalidateFullState () {
+	fullStateSnapshot = FullStateSnapshot();
+}
+
+shared_ptr<Content> LocalConferenceEventHandler::getFullStateContent (LinphoneEvent *lev) {
+	const string &notify = createNotifyFullState(lev);
+	if (!fullStateSnapshot.content)
+		fullStateSnapshot.content = createNotifyContent(notify, (notify.find(MultipartBoundary) != std::string::npos));
+	return fullStateSnapshot.content;
+}
+
+bool LocalConferenceEventHandler::isFullStateSmallerThanDelta (unsigned int lastNotifyId) {
+	// Events may still be waiting in the write-behind queue.
+	const auto &mainDb = conf->getCore()->getPrivate()->mainDb;
+	mainDb->flushQueuedEvents();
+	const int eventCount = mainDb->getConferenceNotifiedEventCount(
+		ConferenceId(conf->getConferenceAddress(), conf->getConferenceAddress()),
+		lastNotifyId
+	);
+	if (eventCount <= 0)
+		return false;
+
+	const list<shared_ptr<Participant>> participants = getFullStateParticipants();
+	size_t fullStateSize;
+	if (isFullStateSnapshotValid(participants))
+		fullStateSize = fullStateSnapshot.body.size();
+	else {
+		fullStateSize = EstimatedFullStateBaseSize + participants.size() * EstimatedUserSize
+			+ (getUsersAndDevicesCount(participants) - participants.size()) * EstimatedEndpointSize;
+	}
+	const size_t deltaSize = size_t(eventCount) * EstimatedNotifyPartSize;
+
+	lInfo() << "Conference [" << conf->getConferenceAddress() << "] missed " << eventCount << " events since notify ["
+		<< lastNotifyId << "], estimated delta size " << deltaSize << " bytes, full state size " << fullStateSize << " bytes";
+	return fullStateSize < deltaSize;
 }
 
 void LocalConferenceEventHandler::addAvailableMediaCapabilities(const LinphoneMediaDirection audioDirection, const LinphoneMediaDirection videoDirection, const LinphoneMediaDirection textDirection, ConferenceDescriptionType & confDescr) {
@@ -233,6 +334,8 @@ void LocalConferenceEventHandler::addMediaCapabilities(const std::shared_ptr<Par
 }
 
 string LocalConferenceEventHandler::createNotifyMultipart (int notifyId) {
+	// Events may still be waiting in the write-behind queue.
+	conf->getCore()->getPrivate()->mainDb->flushQueuedEvents();
 	list<shared_ptr<EventLog>> events = conf->getCore()->getPrivate()->mainDb->getConferenceNotifiedEvents(
 		ConferenceId(conf->getConferenceAddress(), conf->getConferenceAddress()),
 		static_cast<unsigned int>(notifyId)
@@ -707,14 +810,14 @@ string LocalConferenceEventHandler::createNotifyAvailableMediaChanged (const std
 }
 
 
-void LocalConferenceEventHandler::notifyParticipant (const string &notify, const shared_ptr<Participant> &participant) {
+void LocalConferenceEventHandler::notifyParticipant (const shared_ptr<Content> &content, const shared_ptr<Participant> &participant) {
 	for (const auto &device : participant->getDevices()){
 		/* Only notify to device that are present in the conference. */
 		switch(device->getState()){
 			case ParticipantDevice::State::Present:
 			case ParticipantDevice::State::Joining:
 			case ParticipantDevice::State::ScheduledForJoining:
-				notifyParticipantDevice(notify, device, (notify.find(MultipartBoundary) != std::string::npos));
+				notifyParticipantDevice(content, device);
 				break;
 			case ParticipantDevice::State::Leaving:
 			case ParticipantDevice::State::Left:
@@ -724,17 +827,12 @@ void LocalConferenceEventHandler::notifyParticipant (const string &notify, const
 	}
 }
 
-void LocalConferenceEventHandler::notifyParticipantDevice (const string &notify, const shared_ptr<ParticipantDevice> &device, bool multipart) {
-	if (!device->isSubscribedToConferenceEventPackage() || notify.empty())
-		return;
-
-	LinphoneEvent *ev = device->getConferenceSubscribeEvent();
-	LinphoneEventCbs *cbs = linphone_event_get_callbacks(ev);
-	linphone_event_cbs_set_user_data(cbs, this);
-	linphone_event_cbs_set_notify_response(cbs, notifyResponseCb);
+shared_ptr<Content> LocalConferenceEventHandler::createNotifyContent (const string &notify, bool multipart) const {
+	if (notify.empty())
+		return nullptr;
 
-	Content content;
-	content.setBodyFromUtf8(notify);
+	shared_ptr<Content> content = make_shared<Content>();
+	content->setBodyFromUtf8(notify);
 	ContentType contentType;
 	if (multipart) {
 		contentType = ContentType(ContentType::Multipart);
@@ -742,11 +840,75 @@ void LocalConferenceEventHandler::notifyParticipantDevice (const string &notify,
 	} else
 		contentType = ContentType(ContentType::ConferenceInfo);
 
-	content.setContentType(contentType);
+	content->setContentType(contentType);
 	if (linphone_core_content_encoding_supported(conf->getCore()->getCCore(), "deflate"))
-		content.setContentEncoding("deflate");
-	LinphoneContent *cContent = L_GET_C_BACK_PTR(&content);
-	linphone_event_notify(ev, cContent);
+		content->setContentEncoding("deflate");
+	return content;
+}
+
+void LocalConferenceEventHandler::notifyParticipantDevice (const string &notify, const shared_ptr<ParticipantDevice> &device, bool multipart) {
+	if (!device->isSubscribedToConferenceEventPackage() || notify.empty())
+		return;
+
+	notifyParticipantDevice(createNotifyContent(notify, multipart), device);
+}
+
+void LocalConferenceEventHandler::notifyParticipantDevice (const shared_ptr<Content> &content, const shared_ptr<ParticipantDevice> &device, bool fullState) {
+	if (!content || !device->isSubscribedToConferenceEventPackage())
+		return;
+
+	if (fullState) {
+		// The full state already contains the changes of the NOTIFYs still queued for this device.
+		size_t previousSize = pendingNotifies.size();
+		pendingNotifies.erase(remove_if(pendingNotifies.begin(), pendingNotifies.end(), [&device](const pair<weak_ptr<ParticipantDevice>, shared_ptr<Content>> &pendingNotify) {
+			return pendingNotify.first.lock() == device;
+		}), pendingNotifies.end());
+		if (pendingNotifies.size() != previousSize)
+			lInfo() << "Dropping " << (previousSize - pendingNotifies.size()) << " pending NOTIFYs of conference [" << conf->getConferenceAddress()
+				<< "] for device [" << device->getAddress() << "] as a full state is sent";
+	}
+
+	pendingNotifies.emplace_back(device, content);
+	if (!pendingNotifiesTimer)
+		sendPendingNotifies();
+}
+
+void LocalConferenceEventHandler::sendPendingNotifies () {
+	int batchSize = linphone_config_get_int(linphone_core_get_config(conf->getCore()->getCCore()), "misc", "conference_notify_batch_size", DefaultNotifyBatchSize);
+	if (batchSize <= 0)
+		batchSize = INT_MAX;
+
+	for (int sent = 0; sent < batchSize && !pendingNotifies.empty(); ) {
+		shared_ptr<ParticipantDevice> device = pendingNotifies.front().first.lock();
+		shared_ptr<Content> content = move(pendingNotifies.front().second);
+		pendingNotifies.pop_front();
+
+		// The device may have left or unsubscribed since the NOTIFY was queued.
+		if (!device || !device->isSubscribedToConferenceEventPackage())
+			continue;
+
+		LinphoneEvent *ev = device->getConferenceSubscribeEvent();
+		LinphoneEventCbs *cbs = linphone_event_get_callbacks(ev);
+		linphone_event_cbs_set_user_data(cbs, this);
+		linphone_event_cbs_set_notify_response(cbs, notifyResponseCb);
+
+		LinphoneContent *cContent = L_GET_C_BACK_PTR(content.get());
+		linphone_event_notify(ev, cContent);
+		sent++;
+	}
+
+	if (pendingNotifies.empty()) {
+		if (pendingNotifiesTimer) {
+			conf->getCore()->destroyTimer(pendingNotifiesTimer);
+			pendingNotifiesTimer = nullptr;
+		}
+	} else if (!pendingNotifiesTimer) {
+		lInfo() << pendingNotifies.size() << " NOTIFYs of conference [" << conf->getConferenceAddress() << "] postponed to the next iterations";
+		pendingNotifiesTimer = conf->getCore()->createTimer([this]() {
+			sendPendingNotifies();
+			return pendingNotifiesTimer != nullptr;
+		}, 0, "Conference pending NOTIFYs");
+	}
 }
 
 // -----------------------------------------------------------------------------
@@ -784,14 +946,20 @@ void LocalConferenceEventHandler::subscribeReceived (LinphoneEvent *lev) {
 		device->setConferenceSubscribeEvent(lev);
 		if (evLastNotify == 0 || (device->getState() == ParticipantDevice::State::Joining)) {
 			lInfo() << "Sending initial notify of conference [" << conf->getConferenceAddress() << "] to: " << device->getAddress();
-			notifyFullState(createNotifyFullState(lev), device);
+			notifyParticipantDevice(getFullStateContent(lev), device, true);
 
 			// Notify everybody that a participant device has been added and its capabilities after receiving the SUBSCRIBE
 			notifyAllExcept(createNotifyParticipantDeviceAdded(participant->getAddress().asAddress(), device->getAddress().asAddress()), participant);
 		} else if (evLastNotify < lastNotify) {
-			lInfo() << "Sending all missed notify [" << evLastNotify << "-" << lastNotify <<
-				"] for conference [" << conf->getConferenceAddress() << "] to: " << participant->getAddress();
-			notifyParticipantDevice(createNotifyMultipart(static_cast<int>(evLastNotify)), device, true);
+			if (isFullStateSmallerThanDelta(evLastNotify)) {
+				lInfo() << "Sending full state instead of missed notify [" << evLastNotify << "-" << lastNotify <<
+					"] for conference [" << conf->getConferenceAddress() << "] to: " << participant->getAddress();
+				notifyParticipantDevice(getFullStateContent(lev), device, true);
+			} else {
+				lInfo() << "Sending all missed notify [" << evLastNotify << "-" << lastNotify <<
+					"] for conference [" << conf->getConferenceAddress() << "] to: " << participant->getAddress();
+				notifyParticipantDevice(createNotifyMultipart(static_cast<int>(evLastNotify)), device, true);
+			}
 		} else if (evLastNotify > lastNotify) {
 			lError() << "Last notify received by client [" << evLastNotify << "] for conference [" <<
 				conf->getConferenceAddress() <<
@@ -826,8 +994,11 @@ string LocalConferenceEventHandler::getNotifyForId (int notifyId, LinphoneEvent
 	unsigned int lastNotify = conf->getLastNotify();
 	if (notifyId == 0)
 		return createNotifyFullState(lev);
-	else if (notifyId < static_cast<int>(lastNotify))
+	else if (notifyId < static_cast<int>(lastNotify)) {
+		if (isFullStateSmallerThanDelta(static_cast<unsigned int>(notifyId)))
+			return createNotifyFullState(lev);
 		return createNotifyMultipart(notifyId);
+	}
 
 	return Utils::getEmptyConstRefObject<string>();
 }
@@ -836,6 +1007,7 @@ void LocalConferenceEventHandler::onFullStateReceived () {
 }
 
 void LocalConferenceEventHandler::onParticipantAdded (const std::shared_ptr<ConferenceParticipantEvent> &event, const std::shared_ptr<Participant> &participant) {
+	invalidateFullState();
 	// Do not send notify if conference pointer is null. It may mean that the confernece has been terminated
 	if (conf) {
 		notifyAllExcept(createNotifyParticipantAdded(participant->getAddress().asAddress()), participant);
@@ -845,6 +1017,7 @@ void LocalConferenceEventHandler::onParticipantAdded (const std::shared_ptr<Conf
 }
 
 void LocalConferenceEventHandler::onParticipantRemoved (const std::shared_ptr<ConferenceParticipantEvent> &event, const std::shared_ptr<Participant> &participant) {
+	invalidateFullState();
 	// Do not send notify if conference pointer is null. It may mean that the confernece has been terminated
 	if (conf) {
 		notifyAllExcept(createNotifyParticipantRemoved(participant->getAddress().asAddress()), participant);
@@ -854,6 +1027,7 @@ void LocalConferenceEventHandler::onParticipantRemoved (const std::shared_ptr<Co
 }
 
 void LocalConferenceEventHandler::onParticipantSetAdmin (const std::shared_ptr<ConferenceParticipantEvent> &event, const std::shared_ptr<Participant> &participant) {
+	invalidateFullState();
 	const bool isAdmin = (event->getType() == EventLog::Type::ConferenceParticipantSetAdmin);
 	// Do not send notify if conference pointer is null. It may mean that the confernece has been terminated
 	if (conf) {
@@ -864,6 +1038,7 @@ void LocalConferenceEventHandler::onParticipantSetAdmin (const std::shared_ptr<C
 }
 
 void LocalConferenceEventHandler::onSubjectChanged (const std::shared_ptr<ConferenceSubjectEvent> &event) {
+	invalidateFullState();
 	// Do not send notify if conference pointer is null. It may mean that the confernece has been terminated
 	if (conf) {
 		notifyAll(createNotifySubjectChanged(event->getSubject()));
@@ -873,6 +1048,7 @@ void LocalConferenceEventHandler::onSubjectChanged (const std::shared_ptr<Confer
 }
 
 void LocalConferenceEventHandler::onAvailableMediaChanged (const std::shared_ptr<ConferenceAvailableMediaEvent> &event) {
+	invalidateFullState();
 	// Do not send notify if conference pointer is null. It may mean that the confernece has been terminated
 	if (conf) {
 		notifyAll(createNotifyAvailableMediaChanged(event->getAvailableMediaType()));
@@ -882,6 +1058,7 @@ void LocalConferenceEventHandler::onAvailableMediaChanged (const std::shared_ptr
 }
 
 void LocalConferenceEventHandler::onParticipantDeviceAdded (const std::shared_ptr<ConferenceParticipantDeviceEvent> &event, const std::shared_ptr<ParticipantDevice> &device) {
+	invalidateFullState();
 	// Do not send notify if conference pointer is null. It may mean that the confernece has been terminated
 	if (conf) {
 		Participant *participant = device->getParticipant();
@@ -892,6 +1069,7 @@ void LocalConferenceEventHandler::onParticipantDeviceAdded (const std::shared_pt
 }
 
 void LocalConferenceEventHandler::onParticipantDeviceRemoved (const std::shared_ptr<ConferenceParticipantDeviceEvent> &event, const std::shared_ptr<ParticipantDevice> &device) {
+	invalidateFullState();
 	// Do not send notify if conference pointer is null. It may mean that the confernece has been terminated
 	if (conf) {
 		Participant *participant = device->getParticipant();
@@ -902,6 +1080,7 @@ void LocalConferenceEventHandler::onParticipantDeviceRemoved (const std::shared_
 }
 
 void LocalConferenceEventHandler::onParticipantDeviceMediaChanged (const std::shared_ptr<ConferenceParticipantDeviceEvent> &event, const std::shared_ptr<ParticipantDevice> &device) {
+	invalidateFullState();
 	// Do not send notify if conference pointer is null. It may mean that the confernece has been terminated
 	if (conf) {
 		Participant *participant = device->getParticipant();
@@ -912,6 +1091,7 @@ void LocalConferenceEventHandler::onParticipantDeviceMediaChanged (const std::sh
 }
 
 void LocalConferenceEventHandler::onEphemeralModeChanged (const std::shared_ptr<ConferenceEphemeralMessageEvent> &event) {
+	invalidateFullState();
 	// Do not send notify if conference pointer is null. It may mean that the confernece has been terminated
 	if (conf) {
 		notifyAll(createNotifyEphemeralMode(event->getType()));
@@ -921,6 +1101,7 @@ void LocalConferenceEventHandler::onEphemeralModeChanged (const std::shared_ptr<
 }
 
 void LocalConferenceEventHandler::onEphemeralLifetimeChanged (const std::shared_ptr<ConferenceEphemeralMessageEvent> &event) {
+	invalidateFullState();
 	// Do not send notify if conference pointer is null. It may mean that the confernece has been terminated
 	if (conf) {
 		notifyAll(createNotifyEphemeralLifetime(event->getEphemeralMessageLifetime()));
@@ -930,6 +1111,7 @@ void LocalConferenceEventHandler::onEphemeralLifetimeChanged (const std::shared_
 }
 
 void LocalConferenceEventHandler::onStateChanged (LinphonePrivate::ConferenceInterface::State state) {
+	invalidateFullState();
 }
 
 shared_ptr<Participant> LocalConferenceEventHandler::getConferenceParticipant (const Address & address) const {
@@ -20,6 +20,8 @@
 #ifndef _L_LOCAL_CONFERENCE_EVENT_HANDLER_H_
 #define _L_LOCAL_CONFERENCE_EVENT_HANDLER_H_
 
+#include <deque>
+#include <list>
 #include <string>
 
 #include "linphone/types.h"
@@ -42,6 +44,7 @@ class ConferenceId;
 class ConferenceParticipantDeviceEvent;
 class ConferenceParticipantEvent;
 class ConferenceSubjectEvent;
+class Content;
 class Participant;
 class ParticipantDevice;
 
@@ -53,6 +56,7 @@ friend class LocalConferenceListEventHandler;
 public:
 	static Xsd::ConferenceInfo::MediaStatusType mediaDirectionToMediaStatus (LinphoneMediaDirection direction);
 	LocalConferenceEventHandler (Conference *conference, ConferenceListener* listener = nullptr);
+	~LocalConferenceEventHandler ();
 
 	void subscribeReceived (LinphoneEvent *lev);
 	void subscriptionStateChanged (LinphoneEvent *lev, LinphoneSubscriptionState state);
@@ -155,17 +159,48 @@ protected:
 	Conference *conf = nullptr;
 	ConferenceListener *confListener ;
 
+	// Must be called when the conference changes without its version being incremented.
+	void invalidateFullState ();
+
 private:
+	// NOTIFYs are queued to keep their order for each device.
+	std::deque<std::pair<std::weak_ptr<ParticipantDevice>, std::shared_ptr<Content>>> pendingNotifies;
+	belle_sip_source_t *pendingNotifiesTimer = nullptr;
+
+	// Last full state sent, reused by the devices subscribing at the same version of the conference.
+	struct FullStateSnapshot {
+		unsigned int version = 0;
+		std::string key;
+		std::string body;
+		std::shared_ptr<Content> content;
+	};
+	FullStateSnapshot fullStateSnapshot;
 
 	std::string createNotify (Xsd::ConferenceInfo::ConferenceType confInfo, bool isFullState = false);
 	std::string createNotifySubjectChanged (const std::string &subject);
 	std::string createNotifyEphemeralLifetime (const long & lifetime);
 	std::string createNotifyEphemeralMode (const EventLog::Type & type);
-	void notifyParticipant (const std::string &notify, const std::shared_ptr<Participant> &participant);
+	// The body is serialized once per event, then shared by the NOTIFYs of all the devices.
+	std::shared_ptr<Content> createNotifyContent (const std::string &notify, bool multipart) const;
+	void notifyParticipant (const std::shared_ptr<Content> &content, const std::shared_ptr<Participant> &participant);
 	void notifyParticipantDevice (const std::string &notify, const std::shared_ptr<ParticipantDevice> &device, bool multipart = false);
+	// A full state replaces the NOTIFYs still queued for the device.
+	void notifyParticipantDevice (const std::shared_ptr<Content> &content, const std::shared_ptr<ParticipantDevice> &device, bool fullState = false);
+
+	// Sends at most [misc] conference_notify_batch_size NOTIFYs per main loop iteration, the next ones are sent by a timer.
+	void sendPendingNotifies ();
 
 	std::shared_ptr<Participant> getConferenceParticipant (const Address & address) const;
 
+	std::list<std::shared_ptr<Participant>> getFullStateParticipants () const;
+	size_t getUsersAndDevicesCount (const std::list<std::shared_ptr<Participant>> &participants) const;
+	// Gathers what a full state depends on without incrementing the version of the conference.
+	std::string getFullStateKey (const std::list<std::shared_ptr<Participant>> &participants) const;
+	bool isFullStateSnapshotValid (const std::list<std::shared_ptr<Participant>> &participants) const;
+	std::shared_ptr<Content> getFullStateContent (LinphoneEvent *lev);
+	// Compares the estimated size of a full state with the one of the events missed since lastNotifyId.
+	bool isFullStateSmallerThanDelta (unsigned int lastNotifyId);
+
 	void addMediaCapabilities(const std::shared_ptr<ParticipantDevice> & device, Xsd::ConferenceInfo::EndpointType & endpoint);
 	void addAvailableMediaCapabilities(const LinphoneMediaDirection audioDirection, const LinphoneMediaDirection videoDirection, const LinphoneMediaDirection textDirection, Xsd::ConferenceInfo::ConferenceDescriptionType & confDescr);
 
@@ -22,6 +22,7 @@
 #include "linphone/utils/algorithm.h"
 #include "linphone/utils/utils.h"
 
+#include "conference-info-parser.h"
 #include "conference/participant.h"
 #include "conference/remote-conference.h"
 #include "content/content-manager.h"
@@ -68,316 +69,307 @@ RemoteConferenceEventHandler::~RemoteConferenceEventHandler () {
 // -----------------------------------------------------------------------------
 
 void RemoteConferenceEventHandler::conferenceInfoNotifyReceived (const string &xmlBody) {
-	istringstream data(xmlBody);
-	unique_ptr<ConferenceType> confInfo;
-	try {
-		confInfo = parseConferenceInfo(data, Xsd::XmlSchema::Flags::dont_validate);
-	} catch (const exception &) {
-		lError() << "Error while parsing conference-info notify for: " << getConferenceId();
-		return;
+	notifyCreationTime = time(nullptr);
+	notifyIsFullState = false;
+	notifyIgnored = false;
+	notifyHasUsers = false;
+
+	LinphoneConfig *config = linphone_core_get_config(conf->getCore()->getCCore());
+	if (linphone_config_get_bool(config, "misc", "conference_info_streaming_parser", TRUE)) {
+		if (!ConferenceInfoParser::parse(xmlBody, *this)) {
+			lError() << "Error while parsing conference-info notify for: " << getConferenceId();
+			notifyParticipant = nullptr;
+			return;
+		}
+	} else {
+		istringstream data(xmlBody);
+		try {
+			unique_ptr<ConferenceType> confInfo = parseConferenceInfo(data, Xsd::XmlSchema::Flags::dont_validate);
+			ConferenceInfoParser::walk(*confInfo, *this);
+		} catch (const exception &) {
+			lError() << "Error while parsing conference-info notify for: " << getConferenceId();
+			notifyParticipant = nullptr;
+			return;
+		}
 	}
+	notifyParticipant = nullptr;
 
-	IdentityAddress entityAddress(confInfo->getEntity().c_str());
-	if (entityAddress != getConferenceId().getPeerAddress())
+	if (notifyIgnored)
 		return;
 
-	auto &confDescription = confInfo->getConferenceDescription();
+	if (!notifyHasUsers) {
+		if (notifyIsFullState)
+			confListener->onParticipantsCleared();
+		return;
+	}
+
+	if (notifyIsFullState) {
+		confListener->onFirstNotifyReceived(getConferenceId().getPeerAddress());
+		conf->notifyFullState();
+		if (conf->getState() == ConferenceInterface::State::CreationPending) {
+			// Move to Created state when the list of participants is received
+			conf->setState(ConferenceInterface::State::Created);
+		}
+	}
+}
 
-	// 1. Compute event time.
-	time_t creationTime = time(nullptr);
-	{
-		auto &freeText = confDescription->getFreeText();
-		if (freeText.present())
-			creationTime = static_cast<time_t>(Utils::stoll(freeText.get()));
+bool RemoteConferenceEventHandler::onConferenceInfo (const ConferenceInfoParser::ConferenceInfo &conferenceInfo) {
+	IdentityAddress entityAddress(conferenceInfo.entity.c_str());
+	if (entityAddress != getConferenceId().getPeerAddress()) {
+		notifyIgnored = true;
+		return false;
 	}
 
-	// 2. Update last notify.
-	{
-		auto &version = confInfo->getVersion();
-		if (version.present()) {
-			unsigned int notifyVersion = version.get();
-			if (getLastNotify() >= notifyVersion) {
-				lWarning() << "Ignoring conference notify for: " << getConferenceId() << ", notify version received is: "
-					<< notifyVersion << ", should be stricly more than last notify id of conference: " << getLastNotify();
-				return;
-			}
-			conf->setLastNotify(version.get());
+	// Update last notify.
+	if (conferenceInfo.hasVersion) {
+		unsigned int notifyVersion = conferenceInfo.version;
+		if (getLastNotify() >= notifyVersion) {
+			lWarning() << "Ignoring conference notify for: " << getConferenceId() << ", notify version received is: "
+				<< notifyVersion << ", should be stricly more than last notify id of conference: " << getLastNotify();
+			notifyIgnored = true;
+			return false;
 		}
+		conf->setLastNotify(notifyVersion);
 	}
 
-	bool isFullState = confInfo->getState() == StateType::full;
-
-	// 3. Notify ephemeral settings, media, subject and keywords.
-	if (confDescription.present()) {
-		auto &subject = confDescription.get().getSubject();
-		if (subject.present() && !subject.get().empty()) {
-
-			if (conf->getSubject() != subject.get()) {
-				conf->Conference::setSubject(subject.get());
-				if (!isFullState) {
-					conf->notifySubjectChanged(
-						creationTime,
-						isFullState,
-						subject.get()
-					);
-				}
+	notifyIsFullState = conferenceInfo.state == ConferenceInfoParser::State::Full;
+	return true;
+}
+
+void RemoteConferenceEventHandler::onConferenceDescription (const ConferenceInfoParser::ConferenceDescription &description) {
+	// Compute event time.
+	if (description.hasFreeText)
+		notifyCreationTime = static_cast<time_t>(Utils::stoll(description.freeText));
+
+	const time_t creationTime = notifyCreationTime;
+	const bool isFullState = notifyIsFullState;
+
+	// Notify ephemeral settings, media, subject and keywords.
+	const string &subject = description.subject;
+	if (!subject.empty()) {
+		if (conf->getSubject() != subject) {
+			conf->Conference::setSubject(subject);
+			if (!isFullState) {
+				conf->notifySubjectChanged(
+					creationTime,
+					isFullState,
+					subject
+				);
 			}
 		}
+	}
 
-		auto &keywords = confDescription.get().getKeywords();
-		if (keywords.present() && !keywords.get().empty()) {
-			KeywordsType xmlKeywords = keywords.get();
-			confListener->onConferenceKeywordsChanged(
-				vector<string>(xmlKeywords.begin(), xmlKeywords.end())
-			);
+	if (!description.keywords.empty())
+		confListener->onConferenceKeywordsChanged(description.keywords);
+
+	for (const auto &mediaEntry : description.availableMedia) {
+		const bool enabled = (mediaEntry.direction == LinphoneMediaDirectionSendRecv);
+		if (mediaEntry.type.compare("audio") == 0) {
+			conf->confParams->enableAudio(enabled);
+		} else if (mediaEntry.type.compare("video") == 0) {
+			conf->confParams->enableVideo(enabled);
+		} else if (mediaEntry.type.compare("text") == 0) {
+			conf->confParams->enableChat(enabled);
+		} else {
+			lError() << "Unrecognized media type " << mediaEntry.type;
 		}
+	}
 
+	if (description.hasEphemeral) {
+		const string &ephemeralLifetime = description.ephemeralLifetime;
+		const string &ephemeralMode = description.ephemeralMode;
 
-		const auto &availableMedia = confDescription.get().getAvailableMedia();
-		if (availableMedia.present()) {
-			for (auto &mediaEntry : availableMedia.get().getEntry()) {
-				const std::string mediaType = mediaEntry.getType();
-				const LinphoneMediaDirection mediaDirection = RemoteConferenceEventHandler::mediaStatusToMediaDirection(mediaEntry.getStatus().get());
-				const bool enabled = (mediaDirection == LinphoneMediaDirectionSendRecv);
-				if (mediaType.compare("audio") == 0) {
-					conf->confParams->enableAudio(enabled);
-				} else if (mediaType.compare("video") == 0) {
-					conf->confParams->enableVideo(enabled);
-				} else if (mediaType.compare("text") == 0) {
-					conf->confParams->enableChat(enabled);
-				} else {
-					lError() << "Unrecognized media type " << mediaType;
-				}
-			}
+		const auto & core = conf->getCore();
+		auto chatRoom = core->findChatRoom(getConferenceId());
+		std::shared_ptr<LinphonePrivate::ClientGroupChatRoom> cgcr = nullptr;
+		if (chatRoom && (chatRoom->getConference().get() == conf)) {
+			cgcr = dynamic_pointer_cast<LinphonePrivate::ClientGroupChatRoom>(chatRoom);
 		}
+		if (cgcr) {
+			if (ephemeralMode.empty() || (ephemeralMode.compare("admin-managed") == 0)) {
+				cgcr->getCurrentParams()->setEphemeralMode(AbstractChatRoom::EphemeralMode::AdminManaged);
+				if (!ephemeralLifetime.empty()) {
+					const auto lifetime = std::stol(ephemeralLifetime);
+					cgcr->getCurrentParams()->setEphemeralLifetime(lifetime);
+					cgcr->getPrivate()->enableEphemeral((lifetime != 0));
+					if (!isFullState) {
+						conf->notifyEphemeralLifetimeChanged(
+							creationTime,
+							isFullState,
+							lifetime
+						);
 
-		auto & anySequence (confDescription.get().getAny());
-
-		for (const auto &anyElement : anySequence) {
-			auto name = xsd::cxx::xml::transcode<char>(anyElement.getLocalName());
-			auto nodeName = xsd::cxx::xml::transcode<char>(anyElement.getNodeName());
-			auto nodeValue = xsd::cxx::xml::transcode<char>(anyElement.getNodeValue());
-			if (nodeName == "linphone-cie:ephemeral") {
-				Ephemeral ephemeral{anyElement};
-				auto ephemeralLifetime = ephemeral.getLifetime();
-				auto ephemeralMode = ephemeral.getMode();
-
-				const auto & core = conf->getCore();
-				auto chatRoom = core->findChatRoom(getConferenceId());
-				std::shared_ptr<LinphonePrivate::ClientGroupChatRoom> cgcr = nullptr;
-				if (chatRoom && (chatRoom->getConference().get() == conf)) {
-					cgcr = dynamic_pointer_cast<LinphonePrivate::ClientGroupChatRoom>(chatRoom);
-				}
-				if (cgcr) {
-					if (ephemeralMode.empty() || (ephemeralMode.compare("admin-managed") == 0)) {
-						cgcr->getCurrentParams()->setEphemeralMode(AbstractChatRoom::EphemeralMode::AdminManaged);
-						if (!ephemeralLifetime.empty()) {
-							const auto lifetime = std::stol(ephemeralLifetime);
-							cgcr->getCurrentParams()->setEphemeralLifetime(lifetime);
-							cgcr->getPrivate()->enableEphemeral((lifetime != 0));
-							if (!isFullState) {
-								conf->notifyEphemeralLifetimeChanged(
-									creationTime,
-									isFullState,
-									lifetime
-								);
-
-								conf->notifyEphemeralMessageEnabled(
-									creationTime,
-									isFullState,
-									(lifetime != 0)
-								);
-							}
-
-
-						}
-					} else if (ephemeralMode.compare("device-managed") == 0) {
-						cgcr->getCurrentParams()->setEphemeralMode(AbstractChatRoom::EphemeralMode::DeviceManaged);
+						conf->notifyEphemeralMessageEnabled(
+							creationTime,
+							isFullState,
+							(lifetime != 0)
+						);
 					}
 				}
+			} else if (ephemeralMode.compare("device-managed") == 0) {
+				cgcr->getCurrentParams()->setEphemeralMode(AbstractChatRoom::EphemeralMode::DeviceManaged);
 			}
 		}
-
 	}
+}
 
-	if (isFullState)
+void RemoteConferenceEventHandler::onUsers () {
+	notifyHasUsers = true;
+	if (notifyIsFullState)
 		confListener->onParticipantsCleared();
+}
 
-	auto &users = confInfo->getUsers();
-	if (!users.present()) return;
-
-	// 4. Notify changes on users.
-	for (auto &user : users->getUser()) {
-		Address address(conf->getCore()->interpretUrl(user.getEntity().get()));
-		StateType state = user.getState();
-
-		shared_ptr<Participant> participant = conf->findParticipant(address);
-
-		if (state == StateType::deleted) {
-			if (conf->isMe(address)) {
-				lInfo() << "Participant " << address.asString() << " requested to be deleted is me.";
-				continue;
-			} else if (participant) {
-				conf->participants.remove(participant);
-
-				if (!isFullState && participant) {
-					conf->notifyParticipantRemoved(
-						creationTime,
-						isFullState,
-						participant
-					);
-				}
-
-				continue;
-			} else {
-				lWarning() << "Participant " << address.asString() << " removed but not in the list of participants!";
+void RemoteConferenceEventHandler::onUser (const ConferenceInfoParser::User &user) {
+	const time_t creationTime = notifyCreationTime;
+	const bool isFullState = notifyIsFullState;
+
+	// Notify changes on users.
+	Address address(conf->getCore()->interpretUrl(user.entity));
+	ConferenceInfoParser::State state = user.state;
+
+	shared_ptr<Participant> participant = conf->findParticipant(address);
+	notifyParticipant = nullptr;
+
+	if (state == ConferenceInfoParser::State::Deleted) {
+		if (conf->isMe(address)) {
+			lInfo() << "Participant " << address.asString() << " requested to be deleted is me.";
+			return;
+		} else if (participant) {
+			conf->participants.remove(participant);
+
+			if (!isFullState && participant) {
+				conf->notifyParticipantRemoved(
+					creationTime,
+					isFullState,
+					participant
+				);
 			}
-		} else if (state == StateType::full) {
-			if (conf->isMe(address)) {
-				lInfo() << "Participant " << address.asString() << " requested to be added is me.";
-			} else if (participant) {
-				lWarning() << "Participant " << *participant << " added but already in the list of participants!";
-			} else {
-				participant = Participant::create(conf,address);
-				conf->participants.push_back(participant);
-
-				if (!isFullState) {
-					conf->notifyParticipantAdded(
-						creationTime,
-						isFullState,
-						participant
-					);
-				}
+
+			return;
+		} else {
+			lWarning() << "Participant " << address.asString() << " removed but not in the list of participants!";
+		}
+	} else if (state == ConferenceInfoParser::State::Full) {
+		if (conf->isMe(address)) {
+			lInfo() << "Participant " << address.asString() << " requested to be added is me.";
+		} else if (participant) {
+			lWarning() << "Participant " << *participant << " added but already in the list of participants!";
+		} else {
+			participant = Participant::create(conf,address);
+			conf->participants.push_back(participant);
+
+			if (!isFullState) {
+				conf->notifyParticipantAdded(
+					creationTime,
+					isFullState,
+					participant
+				);
 			}
 		}
+	}
 
-		// Try to get participant again as it may have been added or removed earlier on
-		if (conf->isMe(address))
-			participant = conf->getMe();
-		else
-			participant = conf->findParticipant(address);
+	// Try to get participant again as it may have been added or removed earlier on
+	if (conf->isMe(address))
+		participant = conf->getMe();
+	else
+		participant = conf->findParticipant(address);
 
-		if (!participant) {
-			lWarning() << "Participant " << address.asString() << " is not in the list of participants however it is trying to change the list of devices or change role!";
-		} else {
+	if (!participant) {
+		lWarning() << "Participant " << address.asString() << " is not in the list of participants however it is trying to change the list of devices or change role!";
+		return;
+	}
 
-			auto &roles = user.getRoles();
-			if (roles) {
+	// The endpoints of this user are applied to this participant.
+	notifyParticipant = participant;
 
-				auto &entry = roles->getEntry();
-				bool isAdmin = (find(entry, "admin") != entry.end()
-						? true
-						: false);
+	if (user.hasRoles) {
+		const auto &entry = user.roles;
+		bool isAdmin = (find(entry, "admin") != entry.end()
+				? true
+				: false);
 
-				if (participant->isAdmin() != isAdmin) {
+		if (participant->isAdmin() != isAdmin) {
 
-					participant->setAdmin(isAdmin);
+			participant->setAdmin(isAdmin);
 
-					if (!isFullState) {
-						conf->notifyParticipantSetAdmin(
-							creationTime,
-							isFullState,
-							participant,
-							isAdmin
-						);
-					}
-				}
+			if (!isFullState) {
+				conf->notifyParticipantSetAdmin(
+					creationTime,
+					isFullState,
+					participant,
+					isAdmin
+				);
 			}
+		}
+	}
+}
 
-			for (const auto &endpoint : user.getEndpoint()) {
-				if (!endpoint.getEntity().present())
-					continue;
+void RemoteConferenceEventHandler::onEndpoint (const ConferenceInfoParser::User &user, const ConferenceInfoParser::Endpoint &endpoint) {
+	const shared_ptr<Participant> participant = notifyParticipant;
+	if (!participant)
+		return;
 
-				Address gruu(endpoint.getEntity().get());
-				StateType state = endpoint.getState();
+	const time_t creationTime = notifyCreationTime;
+	const bool isFullState = notifyIsFullState;
 
-				shared_ptr<ParticipantDevice> device = nullptr;
-				if (state == StateType::deleted) {
+	Address gruu(endpoint.entity);
+	ConferenceInfoParser::State state = endpoint.state;
 
-					// Take a pointer towards the device before deleting it in order to send the notification
-					device = participant->findDevice(gruu);
-					participant->removeDevice(gruu);
+	shared_ptr<ParticipantDevice> device = nullptr;
+	if (state == ConferenceInfoParser::State::Deleted) {
 
-					if (!isFullState && device && participant) {
-						conf->notifyParticipantDeviceRemoved(
-							creationTime,
-							isFullState,
-							participant,
-							device
-						);
-					}
+		// Take a pointer towards the device before deleting it in order to send the notification
+		device = participant->findDevice(gruu);
+		participant->removeDevice(gruu);
 
-				} else if (state == StateType::full) {
+		if (!isFullState && device && participant) {
+			conf->notifyParticipantDeviceRemoved(
+				creationTime,
+				isFullState,
+				participant,
+				device
+			);
+		}
 
-					device = participant->addDevice(gruu);
+	} else if (state == ConferenceInfoParser::State::Full) {
 
-					const string &name = endpoint.getDisplayText().present() ? endpoint.getDisplayText().get() : "";
+		device = participant->addDevice(gruu);
 
-					if (!name.empty())
-						device->setName(name);
+		const string &name = endpoint.displayText;
 
-					if (!isFullState) {
-						conf->notifyParticipantDeviceAdded(
-							creationTime,
-							isFullState,
-							participant,
-							device
-						);
-					}
-				} else {
-					device = participant->findDevice(gruu);
-				}
+		if (!name.empty())
+			device->setName(name);
 
-				if (state != StateType::deleted) {
-/*
-					auto & deviceAnySequence (endpoint.get().getAny());
-
-					for (auto anyElementIt = deviceAnySequence.begin(); anyElementIt != deviceAnySequence.end (); ++anyElementIt) {
-						const xercesc_3_1::DOMElement& anyElement (*anyElementIt);
-						string name (xsd::cxx::xml::transcode<char>(anyElement.getLocalName()));
-						string nodeName (xsd::cxx::xml::transcode<char>(anyElement.getNodeName()));
-						string nodeValue (xsd::cxx::xml::transcode<char>(anyElement.getNodeValue()));
-						if (nodeName.compare("linphone-cie:service-description") == 0) {
-							const auto service = ServiceDescription(anyElement);
-							const auto serviceId = service.getServiceId();
-							const auto serviceVersion = Utils::Version(service.getVersion());
-							if (serviceId.compare("ephemeral") == 0) {
-								device->enableAdminModeSupport((serviceVersion > Utils::Version(1,1)));
-							}
-						}
-					}
-*/
-
-					for (const auto &media : endpoint.getMedia()) {
-						const std::string mediaType = media.getType().get();
-						const LinphoneMediaDirection mediaDirection = RemoteConferenceEventHandler::mediaStatusToMediaDirection(media.getStatus().get());
-						if (mediaType.compare("audio") == 0) {
-							device->setAudioDirection(mediaDirection);
-
-							if (media.getSrcId()) {
-								const std::string srcId = media.getSrcId().get();
-								unsigned long ssrc = std::stoul(srcId);
-								device->setSsrc((uint32_t) ssrc);
-							}
-						} else if (mediaType.compare("video") == 0) {
-							device->setVideoDirection(mediaDirection);
-						} else if (mediaType.compare("text") == 0) {
-							device->setTextDirection(mediaDirection);
-						} else {
-							lError() << "Unrecognized media type " << mediaType;
-						}
-					}
-				}
-			}
+		if (!isFullState) {
+			conf->notifyParticipantDeviceAdded(
+				creationTime,
+				isFullState,
+				participant,
+				device
+			);
 		}
+	} else {
+		device = participant->findDevice(gruu);
 	}
 
-	if (isFullState) {
-		confListener->onFirstNotifyReceived(getConferenceId().getPeerAddress());
-		conf->notifyFullState();
-		if (conf->getState() == ConferenceInterface::State::CreationPending) {
-			// Move to Created state when the list of participants is received
-			conf->setState(ConferenceInterface::State::Created);
+	if (state != ConferenceInfoParser::State::Deleted) {
+		for (const auto &media : endpoint.media) {
+			const std::string &mediaType = media.type;
+			const LinphoneMediaDirection mediaDirection = media.direction;
+			if (mediaType.compare("audio") == 0) {
+				device->setAudioDirection(mediaDirection);
+
+				if (!media.srcId.empty()) {
+					unsigned long ssrc = std::stoul(media.srcId);
+					device->setSsrc((uint32_t) ssrc);
+				}
+			} else if (mediaType.compare("video") == 0) {
+				device->setVideoDirection(mediaDirection);
+			} else if (mediaType.compare("text") == 0) {
+				device->setTextDirection(mediaDirection);
+			} else {
+				lError() << "Unrecognized media type " << mediaType;
+			}
 		}
 	}
 }
@@ -25,6 +25,7 @@
 #include "xml/conference-info.h"
 #include "xml/conference-info-linphone-extension.h"
 #include "conference/conference-id.h"
+#include "conference-info-parser.h"
 #include "core/core-listener.h"
 #include "remote-conference-event-handler-base.h"
 #include "chat/chat-room/client-group-chat-room-p.h"
@@ -37,9 +38,10 @@ class Content;
 class ConferenceId;
 class Conference;
 class ConferenceListener;
+class Participant;
 class RemoteConferenceEventHandlerBase;
 
-class LINPHONE_PUBLIC RemoteConferenceEventHandler : public RemoteConferenceEventHandlerBase, public CoreListener {
+class LINPHONE_PUBLIC RemoteConferenceEventHandler : public RemoteConferenceEventHandlerBase, public CoreListener, private ConferenceInfoParser::Listener {
 	friend class ClientGroupChatRoom;
 
 public:
@@ -77,6 +79,22 @@ protected:
 
 private:
 	void unsubscribePrivate ();
+
+	// ConferenceInfoParser::Listener, applies a conference-info notify to the conference.
+	bool onConferenceInfo (const ConferenceInfoParser::ConferenceInfo &conferenceInfo) override;
+	void onConferenceDescription (const ConferenceInfoParser::ConferenceDescription &description) override;
+	void onUsers () override;
+	void onUser (const ConferenceInfoParser::User &user) override;
+	void onEndpoint (const ConferenceInfoParser::User &user, const ConferenceInfoParser::Endpoint &endpoint) override;
+
+	// State of the conference-info notify being applied.
+	time_t notifyCreationTime = 0;
+	bool notifyIsFullState = false;
+	bool notifyIgnored = false;
+	bool notifyHasUsers = false;
+	// Participant the endpoints of the current user belong to, null if they are ignored.
+	std::shared_ptr<Participant> notifyParticipant;
+
 	L_DISABLE_COPY(RemoteConferenceEventHandler);
 };
 
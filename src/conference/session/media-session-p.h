@@ -192,6 +192,7 @@ private:
 	void discoverMtu (const Address &remoteAddr);
 	void getLocalIp (const Address &remoteAddr);
 	void runStunTestsIfNeeded ();
+	void onStunDiscoveryDone (int ret);
 	void selectIncomingIpVersion ();
 	void selectOutgoingIpVersion ();
 
@@ -278,6 +279,8 @@ private:
 
 	LinphoneNatPolicy *natPolicy = nullptr;
 	std::unique_ptr<StunClient> stunClient;
+	// Run once the STUN discovery is done.
+	std::queue<std::function<void()>> stunDeferedTasks;
 
 	std::queue<std::function<void()>> iceDeferedGatheringTasks;
 	std::queue<std::function<void()>> iceDeferedCompletionTasks;
@@ -1147,9 +1147,33 @@ void MediaSessionPrivate::runStunTestsIfNeeded () {
 		int audioPort = portFromStreamIndex(mainAudioStreamIndex);
 		int videoPort = portFromStreamIndex(mainVideoStreamIndex);
 		int textPort = portFromStreamIndex(mainTextStreamIndex);
-		int ret = stunClient->run(audioPort, videoPort, textPort);
-		if (ret >= 0)
-			pingTime = ret;
+		stunClient->start(audioPort, videoPort, textPort, [this](int ret) {
+			onStunDiscoveryDone(ret);
+		});
+	}
+}
+
+void MediaSessionPrivate::onStunDiscoveryDone (int ret) {
+	if (ret >= 0)
+		pingTime = ret;
+
+	// The local media description made while the discovery was running has not been sent yet.
+	switch (state) {
+		case CallSession::State::Idle:
+		case CallSession::State::OutgoingInit:
+		case CallSession::State::IncomingReceived:
+		case CallSession::State::IncomingEarlyMedia:
+		case CallSession::State::PushIncomingReceived:
+			if (localDesc)
+				stunClient->updateMediaDescription(localDesc);
+			break;
+		default:
+			break;
+	}
+
+	while (!stunDeferedTasks.empty()) {
+		stunDeferedTasks.front()();
+		stunDeferedTasks.pop();
 	}
 }
 
@@ -2461,6 +2485,15 @@ void MediaSessionPrivate::accept (const MediaSessionParams *msp, bool wasRinging
 		queueIceGatheringTask(acceptCompletionTask);
 		return; /* Deferred until completion of ICE gathering */
 	}
+	if (stunClient && stunClient->isRunning()) {
+		/* The answer must carry the addresses found by the STUN discovery, which also still owns the RTP ports */
+		lInfo() << "Acceptance of incoming call is deferred to STUN discovery completion.";
+		stunDeferedTasks.push([this, acceptCompletionTask]() {
+			if ((state == CallSession::State::IncomingReceived) || (state == CallSession::State::IncomingEarlyMedia))
+				acceptCompletionTask();
+		});
+		return;
+	}
 	acceptCompletionTask();
 }
 
@@ -2699,6 +2732,21 @@ LinphoneStatus MediaSession::acceptEarlyMedia (const MediaSessionParams *msp) {
 		d->makeLocalMediaDescription(false, isCapabilityNegotiationEnabled(), false);
 		d->op->setSentCustomHeaders(d->getParams()->getPrivate()->getCustomHeaders());
 	}
+	if (d->stunClient && d->stunClient->isRunning()) {
+		/* Like the answer, the early media SDP must carry the addresses found by the STUN discovery */
+		lInfo() << "Early media of incoming call is deferred to STUN discovery completion.";
+		d->setState(CallSession::State::IncomingEarlyMedia, "Incoming call early media");
+		d->stunDeferedTasks.push([this]() {
+			L_D();
+			if (d->state != CallSession::State::IncomingEarlyMedia)
+				return;
+			d->op->notifyRinging(true, linphone_core_get_tag_100rel_support_level(getCore()->getCCore()));
+			std::shared_ptr<SalMediaDescription> & md = d->op->getFinalMediaDescription();
+			if (md)
+				d->updateStreams(md, d->state);
+		});
+		return 0;
+	}
 	d->op->notifyRinging(true, linphone_core_get_tag_100rel_support_level(getCore()->getCCore()));
 	d->setState(CallSession::State::IncomingEarlyMedia, "Incoming call early media");
 	std::shared_ptr<SalMediaDescription> & md = d->op->getFinalMediaDescription();
@@ -2827,6 +2875,15 @@ bool MediaSession::initiateOutgoing () {
 			defer |= ice_needs_defer;
 		}
 	}
+	if (d->stunClient && d->stunClient->isRunning()) {
+		/* Defer the start of the call after the STUN discovery, it may already have been started by the OPTIONS ping */
+		d->stunDeferedTasks.push([this]() {
+			L_D();
+			if (d->state == CallSession::State::OutgoingInit)
+				startInvite(nullptr, "");
+		});
+		defer = true;
+	}
 	return defer;
 }
 
@@ -55,7 +55,9 @@ public:
 		return it == mKeyToPair.cend() ? nullptr : &it->second.second;
 	}
 
-	void insert (const Key &key, const Value &value) {
+	// Return true if the oldest key was evicted.
+	bool insert (const Key &key, const Value &value) {
+		bool evicted = false;
 		auto it = mKeyToPair.find(key);
 		if (it != mKeyToPair.end()) {
 			mKeys.erase(it->second.first);
@@ -64,13 +66,16 @@ public:
 			Key lastKey = mKeys.back();
 			mKeys.pop_back();
 			mKeyToPair.erase(lastKey);
+			evicted = true;
 		}
 
 		mKeys.push_front(key);
 		mKeyToPair.insert({ key, { mKeys.begin(), value } });
+		return evicted;
 	}
 
-	void insert (const Key &key, Value &&value) {
+	bool insert (const Key &key, Value &&value) {
+		bool evicted = false;
 		auto it = mKeyToPair.find(key);
 		if (it != mKeyToPair.end()) {
 			mKeys.erase(it->second.first);
@@ -79,10 +84,20 @@ public:
 			Key lastKey = mKeys.back();
 			mKeys.pop_back();
 			mKeyToPair.erase(lastKey);
+			evicted = true;
 		}
 
 		mKeys.push_front(key);
 		mKeyToPair.insert({ key, std::make_pair(mKeys.begin(), std::move(value)) });
+		return evicted;
+	}
+
+	void erase (const Key &key) {
+		auto it = mKeyToPair.find(key);
+		if (it != mKeyToPair.end()) {
+			mKeys.erase(it->second.first);
+			mKeyToPair.erase(it);
+		}
 	}
 
 	void clear () {
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2010-2019 Belledonne Communications SARL.
+ *
+ * This file is part of Liblinphone.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _L_SHARDED_LRU_CACHE_H_
+#define _L_SHARDED_LRU_CACHE_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include "lru-cache.h"
+
+// =============================================================================
+
+LINPHONE_BEGIN_NAMESPACE
+
+struct LruCacheStats {
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+	uint64_t evictions = 0;
+};
+
+/*
+ * Bounded cache which can be used from several threads.
+ * The keys are spread over shards, each one is a LruCache protected by its own mutex, so that concurrent lookups
+ * of different keys rarely wait for each other.
+ */
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
+class ShardedLruCache {
+public:
+	ShardedLruCache (int capacity = LruCache<Key, Value>::DefaultCapacity) {
+		setCapacity(capacity);
+	}
+
+	int getCapacity () const {
+		return mCapacity;
+	}
+
+	// The cached values are dropped.
+	void setCapacity (int capacity) {
+		mCapacity = capacity;
+		const int shardCapacity = capacity / ShardCount > 0 ? capacity / ShardCount : 1;
+		for (Shard &shard : mShards) {
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			shard.cache.reset(new LruCache<Key, Value>(shardCapacity));
+		}
+	}
+
+	int getSize () const {
+		int size = 0;
+		for (const Shard &shard : mShards) {
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			size += shard.cache->getSize();
+		}
+		return size;
+	}
+
+	// Call function with the cached value, the value must not be used once the function returns.
+	template<typename Function>
+	bool find (const Key &key, Function function) {
+		Shard &shard = getShard(key);
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		Value *value = (*shard.cache)[key];
+		if (!value) {
+			mMisses.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		mHits.fetch_add(1, std::memory_order_relaxed);
+		function(*value);
+		return true;
+	}
+
+	void insert (const Key &key, Value &&value) {
+		Shard &shard = getShard(key);
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		if (shard.cache->insert(key, std::move(value)))
+			mEvictions.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void clear () {
+		for (Shard &shard : mShards) {
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			shard.cache->clear();
+		}
+	}
+
+	LruCacheStats getStats () const {
+		LruCacheStats stats;
+		stats.hits = mHits.load(std::memory_order_relaxed);
+		stats.misses = mMisses.load(std::memory_order_relaxed);
+		stats.evictions = mEvictions.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	static constexpr int ShardCount = 16;
+
+private:
+	struct Shard {
+		mutable std::mutex mutex;
+		std::unique_ptr<LruCache<Key, Value>> cache;
+	};
+
+	Shard &getShard (const Key &key) {
+		// Fold the hash so that the shard does not only depend on the bits which also select the bucket in the shard.
+		const size_t hash = Hash()(key);
+		return mShards[(hash ^ (hash >> 16)) % ShardCount];
+	}
+
+	std::array<Shard, ShardCount> mShards;
+	std::atomic<int> mCapacity{0};
+
+	std::atomic<uint64_t> mHits{0};
+	std::atomic<uint64_t> mMisses{0};
+	std::atomic<uint64_t> mEvictions{0};
+};
+
+LINPHONE_END_NAMESPACE
+
+#endif // ifndef _L_SHARDED_LRU_CACHE_H_
@@ -17,7 +17,9 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <iterator>
+#include <limits>
 
 #include "linphone/utils/algorithm.h"
 
@@ -47,6 +49,9 @@ using namespace std;
 
 LINPHONE_BEGIN_NAMESPACE
 
+// Period of the check that releases idle chat rooms in lazy loading mode.
+static constexpr unsigned int ChatRoomsReleaseIntervalMs = 30000;
+
 // -----------------------------------------------------------------------------
 // Helpers.
 // -----------------------------------------------------------------------------
@@ -235,33 +240,57 @@ shared_ptr<AbstractChatRoom> CorePrivate::createBasicChatRoom (
 }
 
 shared_ptr<AbstractChatRoom> CorePrivate::searchChatRoom (const shared_ptr<ChatRoomParams> &params, const IdentityAddress &localAddress, const IdentityAddress &remoteAddress, const std::list<IdentityAddress> &participants) const {
-	for (auto it = chatRoomsById.begin(); it != chatRoomsById.end(); it++) {
-		const auto &chatRoom = it->second;
-		const IdentityAddress &curLocalAddress = chatRoom->getLocalAddress();
-		const IdentityAddress &curRemoteAddress = chatRoom->getPeerAddress();
-		ChatRoom::CapabilitiesMask capabilities = chatRoom->getCapabilities();
+	const IdentityAddress localAddressWithoutGruu = localAddress.getAddressWithoutGruu();
+	const auto matchesParams = [&params](ChatRoom::CapabilitiesMask capabilities) {
+		if (!params)
+			return true;
 
-		if (params) {
-			if (!params->isGroup() && !(capabilities & ChatRoom::Capabilities::OneToOne))
-				continue;
+		if (!params->isGroup() && !(capabilities & ChatRoom::Capabilities::OneToOne))
+			return false;
 
-			if (params->isGroup() && !(capabilities & ChatRoom::Capabilities::Conference))
-				continue;
+		if (params->isGroup() && !(capabilities & ChatRoom::Capabilities::Conference))
+			return false;
 
-			if (params->isEncrypted() != bool(capabilities & ChatRoom::Capabilities::Encrypted))
-				continue;
+		return params->isEncrypted() == bool(capabilities & ChatRoom::Capabilities::Encrypted);
+	};
 
-			if (!params->getSubject().empty() && params->getSubject() != chatRoom->getSubject())
-				continue;
+	// Only load the chat rooms that can match according to their summary.
+	instantiateChatRooms([&](const MainDb::ChatRoomSummary &summary) {
+		const ChatRoom::CapabilitiesMask capabilities(summary.capabilities);
+		const IdentityAddress peerAddressWithoutGruu = summary.conferenceId.getPeerAddress().getAddressWithoutGruu();
+		if (
+			localAddressWithoutGruu != summary.conferenceId.getLocalAddress().getAddressWithoutGruu() ||
+			!matchesParams(capabilities) ||
+			(remoteAddress.isValid() && remoteAddress.getAddressWithoutGruu() != peerAddressWithoutGruu)
+		)
+			return false;
+
+		// The participant of a basic chat room is its peer, the ones of other chat rooms are only known once loaded.
+		if (capabilities & ChatRoom::Capabilities::Basic) {
+			for (const auto &participant : participants) {
+				if (participant.getAddressWithoutGruu() != peerAddressWithoutGruu)
+					return false;
+			}
 		}
+		return true;
+	});
 
-		if (localAddress.getAddressWithoutGruu() != curLocalAddress.getAddressWithoutGruu())
-			continue;
+	const auto matches = [&](const shared_ptr<AbstractChatRoom> &chatRoom) {
+		const IdentityAddress &curLocalAddress = chatRoom->getLocalAddress();
+		const IdentityAddress &curRemoteAddress = chatRoom->getPeerAddress();
+
+		if (!matchesParams(chatRoom->getCapabilities()))
+			return false;
+
+		if (params && !params->getSubject().empty() && params->getSubject() != chatRoom->getSubject())
+			return false;
+
+		if (localAddressWithoutGruu != curLocalAddress.getAddressWithoutGruu())
+			return false;
 
 		if (remoteAddress.isValid() && remoteAddress.getAddressWithoutGruu() != curRemoteAddress.getAddressWithoutGruu())
-			continue;
+			return false;
 
-		bool allFound = true;
 		for (const auto &participant : participants) {
 			bool found = false;
 			for (const auto &p : chatRoom->getParticipants()) {
@@ -270,14 +299,35 @@ shared_ptr<AbstractChatRoom> CorePrivate::searchChatRoom (const shared_ptr<ChatR
 					break;
 				}
 			}
-			if (!found) {
-				allFound = false;
-				break;
-			}
+			if (!found)
+				return false;
 		}
-		if (!allFound) continue;
+		return true;
+	};
 
-		return chatRoom;
+	// Only the chat rooms of the least shared participant, or of the remote address, can match.
+	if (!participants.empty() || remoteAddress.isValid()) {
+		vector<shared_ptr<AbstractChatRoom>> candidates;
+		bool first = true;
+		for (const auto &participant : participants) {
+			vector<shared_ptr<AbstractChatRoom>> participantChatRooms = getIndexedChatRooms(chatRoomsByParticipantAddress, participant);
+			if (first || participantChatRooms.size() < candidates.size())
+				candidates.swap(participantChatRooms);
+			first = false;
+		}
+		if (participants.empty())
+			candidates = getIndexedChatRooms(chatRoomsByPeerAddress, remoteAddress);
+
+		for (const auto &chatRoom : candidates) {
+			if (matches(chatRoom))
+				return chatRoom;
+		}
+		return nullptr;
+	}
+
+	for (auto it = chatRoomsById.begin(); it != chatRoomsById.end(); it++) {
+		if (matches(it->second))
+			return it->second;
 	}
 	return nullptr;
 }
@@ -412,6 +462,7 @@ void CorePrivate::insertChatRoom (const shared_ptr<AbstractChatRoom> &chatRoom)
 	L_ASSERT(chatRoom);
 
 	const ConferenceId &conferenceId = chatRoom->getConferenceId();
+	unloadedChatRooms.erase(conferenceId);
 	auto it = chatRoomsById.find(conferenceId);
 	// Chat room not exist or yes but with the same pointer!
 	L_ASSERT(it == chatRoomsById.end() || it->second == chatRoom);
@@ -419,7 +470,7 @@ void CorePrivate::insertChatRoom (const shared_ptr<AbstractChatRoom> &chatRoom)
 		// Remove chat room from workaround cache.
 		noCreatedClientGroupChatRooms.erase(chatRoom.get());
 		lInfo() << "Insert chat room " << conferenceId << " to core map";
-		chatRoomsById[conferenceId] = chatRoom;
+		setLoadedChatRoom(conferenceId, chatRoom);
 	}
 }
 
@@ -429,95 +480,249 @@ void CorePrivate::insertChatRoomWithDb (const shared_ptr<AbstractChatRoom> &chat
 }
 
 void CorePrivate::loadChatRooms () {
-	chatRoomsById.clear();
+	L_Q();
+
+	clearLoadedChatRooms();
+	unloadedChatRooms.clear();
 #ifdef HAVE_ADVANCED_IM
 	if (remoteListEventHandler)
 		remoteListEventHandler->clearHandlers();
 #endif
 
 	if (!mainDb->isInitialized()) return;
-	for (auto &chatRoom : mainDb->getChatRooms()) {
-		insertChatRoom(chatRoom);
+
+	LinphoneConfig *config = linphone_core_get_config(q->getCCore());
+	lazyChatRoomLoading = !!linphone_config_get_bool(config, "storage", "lazy_chat_room_loading", FALSE);
+	if (!lazyChatRoomLoading) {
+		for (auto &chatRoom : mainDb->getChatRooms()) {
+			insertChatRoom(chatRoom);
+		}
+		sendDeliveryNotifications();
+		return;
+	}
+
+	for (auto &summary : mainDb->getChatRoomSummaries()) {
+		const ConferenceId conferenceId = summary.conferenceId;
+		unloadedChatRooms[conferenceId] = move(summary);
 	}
+	lInfo() << "Lazy chat room loading: " << unloadedChatRooms.size() << " chat rooms indexed.";
+
+	// Client group chat rooms must subscribe to their conference events, load them now.
+	if (!linphone_core_conference_server_enabled(q->getCCore())) {
+		instantiateChatRooms([](const MainDb::ChatRoomSummary &summary) {
+			return !!(summary.capabilities & ChatRoom::CapabilitiesMask(ChatRoom::Capabilities::Conference));
+		});
+	}
+
+	maxLoadedChatRooms = size_t(max(0, linphone_config_get_int(config, "storage", "max_loaded_chat_rooms", 0)));
+	if (maxLoadedChatRooms > 0 && !chatRoomsReleaseTimer) {
+		chatRoomsReleaseTimer = q->createTimer([this]() -> bool {
+			releaseIdleChatRooms(maxLoadedChatRooms);
+			return true;
+		}, ChatRoomsReleaseIntervalMs, "release idle chat rooms");
+	}
+
 	sendDeliveryNotifications();
 }
 
-void CorePrivate::handleEphemeralMessages (time_t currentTime) {
-	if (!ephemeralMessages.empty()) {
-		shared_ptr<ChatMessage> msg = ephemeralMessages.front();
-		time_t expireTime = msg->getEphemeralExpireTime();
-		if (currentTime > expireTime) {
-			shared_ptr<LinphonePrivate::EventLog> event = LinphonePrivate::MainDb::getEvent(mainDb, msg->getStorageId());
-			shared_ptr<AbstractChatRoom> chatRoom = msg->getChatRoom();
-			if (chatRoom && event) {
-				LinphonePrivate::EventLog::deleteFromDatabase(event);
-				lInfo() << "[Ephemeral] Message deleted from database";
-				
-				// Notify ephemeral message deleted to message if exists.
-				LinphoneChatMessage *message = L_GET_C_BACK_PTR(msg.get());
-				if (message) {
-					LinphoneChatMessageCbs *cbs = linphone_chat_message_get_callbacks(message);
-					if (cbs && linphone_chat_message_cbs_get_ephemeral_message_deleted(cbs)) {
-						linphone_chat_message_cbs_get_ephemeral_message_deleted(cbs)(message);
-					}
-					_linphone_chat_message_notify_ephemeral_message_deleted(message);
-				}
+shared_ptr<AbstractChatRoom> CorePrivate::instantiateChatRoom (const ConferenceId &conferenceId) const {
+	auto it = unloadedChatRooms.find(conferenceId);
+	if (it == unloadedChatRooms.end())
+		return nullptr;
 
-				// Notify ephemeral message deleted to chat room & core.
-				LinphoneChatRoom *cr = L_GET_C_BACK_PTR(chatRoom);
-				_linphone_chat_room_notify_ephemeral_message_deleted(cr, L_GET_C_BACK_PTR(event));
-				linphone_core_notify_chat_room_ephemeral_message_deleted(linphone_chat_room_get_core(cr), cr);
+	// Remove the summary first, the chat room creation looks for it in the core.
+	unloadedChatRooms.erase(it);
+	shared_ptr<AbstractChatRoom> chatRoom = mainDb->getChatRoom(conferenceId);
+	if (!chatRoom) {
+		lError() << "Unable to load chat room " << conferenceId << " from database.";
+		return nullptr;
+	}
 
-			}
+	lDebug() << "Chat room " << conferenceId << " loaded on first use.";
+	setLoadedChatRoom(chatRoom->getConferenceId(), chatRoom);
+	return chatRoom;
+}
 
-			// Delete message from this list even when chatroom is gone.
-			ephemeralMessages.pop_front();
-			handleEphemeralMessages(currentTime);
-		} else {
-			startEphemeralMessageTimer(expireTime);
-		}
-	} else {
-		initEphemeralMessages();
+void CorePrivate::instantiateChatRooms (const function<bool (const MainDb::ChatRoomSummary &)> &predicate) const {
+	list<ConferenceId> conferenceIds;
+	for (const auto &entry : unloadedChatRooms) {
+		if (predicate(entry.second))
+			conferenceIds.push_back(entry.first);
+	}
+
+	for (const auto &conferenceId : conferenceIds)
+		instantiateChatRoom(conferenceId);
+}
+
+void CorePrivate::releaseIdleChatRooms (size_t maxCount) {
+	if (!lazyChatRoomLoading || chatRoomsById.size() <= maxCount)
+		return;
+
+	// Only basic chat rooms that nothing but the core refers to can go back to their summary.
+	list<ConferenceId> candidates;
+	for (const auto &entry : chatRoomsById) {
+		const shared_ptr<AbstractChatRoom> &chatRoom = entry.second;
+		if (chatRoom.use_count() > 1 || Wrapper::hasCBackPtr(chatRoom.get()))
+			continue;
+
+		if (!dynamic_pointer_cast<BasicChatRoom>(chatRoom) || chatRoom->getState() != ConferenceInterface::State::Created)
+			continue;
+
+		// Chat messages only have a weak reference on their chat room, those in use keep it loaded.
+		ChatRoomPrivate *dChatRoom = static_pointer_cast<ChatRoom>(chatRoom)->getPrivate();
+		if (dChatRoom->hasChatMessagesInUse())
+			continue;
+
+		if (!dChatRoom->getTransientChatMessages().empty() || dChatRoom->getImdnHandler()->hasUndeliveredImdnMessage())
+			continue;
+
+		if (any_of(ephemeralMessages.cbegin(), ephemeralMessages.cend(), [&chatRoom](const EphemeralMessage &ephemeralMessage) {
+			return ephemeralMessage.message->getChatRoom() == chatRoom;
+		}))
+			continue;
+
+		candidates.push_back(entry.first);
+	}
+
+	// Release the least recently updated chat rooms first.
+	candidates.sort([this](const ConferenceId &a, const ConferenceId &b) {
+		return chatRoomsById[a]->getLastUpdateTime() < chatRoomsById[b]->getLastUpdateTime();
+	});
+
+	size_t releasedCount = 0;
+	for (const auto &conferenceId : candidates) {
+		if (chatRoomsById.size() <= maxCount)
+			break;
+
+		MainDb::ChatRoomSummary summary = mainDb->getChatRoomSummary(conferenceId);
+		if (!summary.conferenceId.isValid())
+			continue;
+
+		eraseLoadedChatRoom(conferenceId);
+		unloadedChatRooms[conferenceId] = move(summary);
+		++releasedCount;
 	}
+
+	if (releasedCount > 0)
+		lInfo() << "Released " << releasedCount << " idle chat rooms, " << chatRoomsById.size() << " remain loaded.";
+}
+
+// Orders the ephemeral messages heap by earliest expire time.
+template<typename T>
+static bool expiresLater (const T &a, const T &b) {
+	return a.expireTime > b.expireTime;
+}
+
+void CorePrivate::handleEphemeralMessages (time_t currentTime) {
+	list<shared_ptr<ChatMessage>> expiredMessages;
+	while (!ephemeralMessages.empty() && currentTime > ephemeralMessages.front().expireTime) {
+		pop_heap(ephemeralMessages.begin(), ephemeralMessages.end(), expiresLater<EphemeralMessage>);
+		expiredMessages.push_back(move(ephemeralMessages.back().message));
+		ephemeralMessages.pop_back();
+	}
+	deleteEphemeralMessages(expiredMessages);
+
+	if (ephemeralMessages.empty() && ephemeralMessagesLoadedUntil != numeric_limits<time_t>::max())
+		loadEphemeralMessages();
+
+	if (!ephemeralMessages.empty())
+		startEphemeralMessageTimer(ephemeralMessages.front().expireTime);
 }
 
 void CorePrivate::initEphemeralMessages () {
 	L_Q();
-	if (mainDb && mainDb->isInitialized()) {
-		ephemeralMessages.clear();
-		ephemeralMessages = mainDb->getEphemeralMessages();
-		if (!ephemeralMessages.empty()) {
-			lInfo() << "[Ephemeral] list initiated on core " << linphone_core_get_identity(q->getCCore());
-			shared_ptr<ChatMessage> msg = ephemeralMessages.front();
-			startEphemeralMessageTimer(msg->getEphemeralExpireTime());
-		}
+	ephemeralMessages.clear();
+	loadEphemeralMessages();
+	if (!ephemeralMessages.empty()) {
+		lInfo() << "[Ephemeral] list initiated on core " << linphone_core_get_identity(q->getCCore());
+		startEphemeralMessageTimer(ephemeralMessages.front().expireTime);
 	}
 }
 
 void CorePrivate::updateEphemeralMessages (const shared_ptr<ChatMessage> &message) {
-	if (ephemeralMessages.empty()) {
-		// Can not determine this message will expire most quickly, so init this list.
-		initEphemeralMessages();
-	} else {
-		shared_ptr<ChatMessage> lastmsg = ephemeralMessages.back();
-		if (lastmsg->getEphemeralLifetime() < message->getEphemeralLifetime()) {
-			// The last message of this list will expire more quickly than this message, can not determine this message will expire most quickly in the remaining messages.
+	if (ephemeralMessagesLoadedUntil == 0) {
+		// Nothing loaded yet, the first batch may already contain this message.
+		loadEphemeralMessages();
+		if (any_of(ephemeralMessages.cbegin(), ephemeralMessages.cend(), [&message](const EphemeralMessage &ephemeralMessage) {
+			return ephemeralMessage.message == message;
+		})) {
+			startEphemeralMessageTimer(ephemeralMessages.front().expireTime);
 			return;
 		}
-		for (std::list<shared_ptr<ChatMessage>>::iterator it=ephemeralMessages.begin(); it!=ephemeralMessages.end(); ++it) {
-			shared_ptr<ChatMessage> msg = *it;
-			if (msg->getEphemeralExpireTime() > message->getEphemeralExpireTime()) {
-				// This message will expire more quickly than the last message of this list, add it.
-				if (it == ephemeralMessages.begin()) {
-					ephemeralMessages.push_front(message);
-					startEphemeralMessageTimer(message->getEphemeralExpireTime());
-				} else {
-					it = --it;
-					ephemeralMessages.insert(it, message);
-				}
-				return;
+	}
+
+	// Later messages are loaded from the database once the earlier ones are deleted.
+	if (message->getEphemeralExpireTime() >= ephemeralMessagesLoadedUntil)
+		return;
+
+	pushEphemeralMessage(message);
+	if (ephemeralMessages.front().message == message)
+		startEphemeralMessageTimer(message->getEphemeralExpireTime());
+}
+
+void CorePrivate::loadEphemeralMessages () {
+	if (!mainDb || !mainDb->isInitialized()) {
+		ephemeralMessagesLoadedUntil = numeric_limits<time_t>::max();
+		return;
+	}
+
+	list<shared_ptr<ChatMessage>> messages = mainDb->getEphemeralMessages(EphemeralMessagesBatchSize);
+	// Messages expiring at the same time as the last one of a full batch may remain in the database.
+	ephemeralMessagesLoadedUntil = messages.size() < EphemeralMessagesBatchSize
+		? numeric_limits<time_t>::max()
+		: messages.back()->getEphemeralExpireTime();
+
+	ephemeralMessages.reserve(ephemeralMessages.size() + messages.size());
+	for (const auto &message : messages)
+		pushEphemeralMessage(message);
+}
+
+void CorePrivate::pushEphemeralMessage (const shared_ptr<ChatMessage> &message) {
+	ephemeralMessages.push_back(EphemeralMessage{ message->getEphemeralExpireTime(), message });
+	push_heap(ephemeralMessages.begin(), ephemeralMessages.end(), expiresLater<EphemeralMessage>);
+}
+
+void CorePrivate::deleteEphemeralMessages (const list<shared_ptr<ChatMessage>> &messages) {
+	list<shared_ptr<const EventLog>> events;
+	list<pair<shared_ptr<ChatMessage>, shared_ptr<EventLog>>> deletedMessages;
+	for (const auto &message : messages) {
+		// Messages of a deleted chat room are only removed from the heap.
+		shared_ptr<EventLog> event = MainDb::getEvent(mainDb, message->getStorageId());
+		if (!event || !message->getChatRoom())
+			continue;
+		events.push_back(event);
+		deletedMessages.emplace_back(message, event);
+	}
+
+	if (events.empty())
+		return;
+
+	mainDb->deleteEvents(events);
+	lInfo() << "[Ephemeral] " << events.size() << " messages deleted from database";
+
+	vector<shared_ptr<AbstractChatRoom>> chatRooms;
+	for (const auto &deletedMessage : deletedMessages) {
+		// Notify ephemeral message deleted to message if exists.
+		LinphoneChatMessage *message = L_GET_C_BACK_PTR(deletedMessage.first.get());
+		if (message) {
+			LinphoneChatMessageCbs *cbs = linphone_chat_message_get_callbacks(message);
+			if (cbs && linphone_chat_message_cbs_get_ephemeral_message_deleted(cbs)) {
+				linphone_chat_message_cbs_get_ephemeral_message_deleted(cbs)(message);
 			}
+			_linphone_chat_message_notify_ephemeral_message_deleted(message);
 		}
+
+		// Notify ephemeral message deleted to chat room.
+		shared_ptr<AbstractChatRoom> chatRoom = deletedMessage.first->getChatRoom();
+		_linphone_chat_room_notify_ephemeral_message_deleted(L_GET_C_BACK_PTR(chatRoom), L_GET_C_BACK_PTR(deletedMessage.second));
+		if (find(chatRooms.cbegin(), chatRooms.cend(), chatRoom) == chatRooms.cend())
+			chatRooms.push_back(chatRoom);
+	}
+
+	// The core is notified once per chat room.
+	for (const auto &chatRoom : chatRooms) {
+		LinphoneChatRoom *cr = L_GET_C_BACK_PTR(chatRoom);
+		linphone_core_notify_chat_room_ephemeral_message_deleted(linphone_chat_room_get_core(cr), cr);
 	}
 }
 
@@ -537,11 +742,11 @@ void CorePrivate::replaceChatRoom (const shared_ptr<AbstractChatRoom> &replacedC
 	const ConferenceId &newConferenceId = newChatRoom->getConferenceId();
 
 	if (replacedChatRoom->getCapabilities() & ChatRoom::Capabilities::Proxy) {
-		chatRoomsById.erase(replacedConferenceId);
-		chatRoomsById[newConferenceId] = replacedChatRoom;
+		eraseLoadedChatRoom(replacedConferenceId);
+		setLoadedChatRoom(newConferenceId, replacedChatRoom);
 	} else {
-		chatRoomsById.erase(replacedConferenceId);
-		chatRoomsById[newConferenceId] = newChatRoom;
+		eraseLoadedChatRoom(replacedConferenceId);
+		setLoadedChatRoom(newConferenceId, newChatRoom);
 	}
 }
 
@@ -551,9 +756,14 @@ shared_ptr<AbstractChatRoom> CorePrivate::findExhumableOneToOneChatRoom (
 		bool encrypted) const {
 #ifdef HAVE_ADVANCED_IM
 	lInfo() << "Looking for exhumable 1-1 chat room with local address [" << localAddress.asString() << "] and participant [" << participantAddress.asString() << "]";
-	
-	for (auto it = chatRoomsById.begin(); it != chatRoomsById.end(); it++) {
-		const auto &chatRoom = it->second;
+
+	instantiateChatRooms([&localAddress](const MainDb::ChatRoomSummary &summary) {
+		return (summary.capabilities & ChatRoom::CapabilitiesMask(ChatRoom::Capabilities::Conference))
+			&& (summary.capabilities & ChatRoom::CapabilitiesMask(ChatRoom::Capabilities::OneToOne))
+			&& localAddress.getAddressWithoutGruu() == summary.conferenceId.getLocalAddress().getAddressWithoutGruu();
+	});
+
+	for (const auto &chatRoom : getIndexedChatRooms(chatRoomsByParticipantAddress, participantAddress)) {
 		const IdentityAddress &curLocalAddress = chatRoom->getLocalAddress();
 		ChatRoom::CapabilitiesMask capabilities = chatRoom->getCapabilities();
 		// Don't check if terminated, it can be exhumed before the BYE has been received
@@ -575,6 +785,11 @@ shared_ptr<AbstractChatRoom> CorePrivate::findExhumableOneToOneChatRoom (
 
 shared_ptr<AbstractChatRoom> CorePrivate::findExumedChatRoomFromPreviousConferenceId(const ConferenceId conferenceId) const {
 #ifdef HAVE_ADVANCED_IM
+	instantiateChatRooms([&conferenceId](const MainDb::ChatRoomSummary &summary) {
+		const list<ConferenceId> &previousIds = summary.previousConferenceIds;
+		return find(previousIds.cbegin(), previousIds.cend(), conferenceId) != previousIds.cend();
+	});
+
 	for (auto it = chatRoomsById.begin(); it != chatRoomsById.end(); it++) {
 		const shared_ptr<AbstractChatRoom> &chatRoom = it->second;
 		ChatRoom::CapabilitiesMask capabilities = chatRoom->getCapabilities();
@@ -602,13 +817,104 @@ void CorePrivate::updateChatRoomConferenceId (const shared_ptr<AbstractChatRoom>
 	const ConferenceId &newConferenceId = chatRoom->getConferenceId();
 	lInfo() << "Chat room [" << oldConferenceId << "] has been exhumed into [" << newConferenceId << "]";
 
-	chatRoomsById.erase(oldConferenceId);
-	chatRoomsById[newConferenceId] = chatRoom;
+	eraseLoadedChatRoom(oldConferenceId);
+	setLoadedChatRoom(newConferenceId, chatRoom);
 
 	mainDb->updateChatRoomConferenceId(oldConferenceId, newConferenceId);
 #endif
 }
 
+void CorePrivate::updateChatRoomIndex (const shared_ptr<AbstractChatRoom> &chatRoom) const {
+	const ConferenceId &conferenceId = chatRoom->getConferenceId();
+	auto it = chatRoomsById.find(conferenceId);
+	if (it == chatRoomsById.end())
+		return;
+
+	// The loaded chat room may be a proxy of the given one, it exposes the same participants.
+	unindexChatRoom(conferenceId);
+	indexChatRoom(conferenceId, it->second);
+}
+
+// -----------------------------------------------------------------------------
+
+// Made of the fields compared by IdentityAddress::operator==, except the gruu: the scheme must not split the rooms of a person.
+static string getChatRoomIndexKey (const IdentityAddress &address) {
+	return address.getUsername() + "@" + address.getDomain();
+}
+
+static void addToChatRoomIndex (unordered_map<string, vector<ConferenceId>> &index, const string &key, const ConferenceId &conferenceId) {
+	vector<ConferenceId> &conferenceIds = index[key];
+	if (find(conferenceIds.cbegin(), conferenceIds.cend(), conferenceId) == conferenceIds.cend())
+		conferenceIds.push_back(conferenceId);
+}
+
+static void removeFromChatRoomIndex (unordered_map<string, vector<ConferenceId>> &index, const string &key, const ConferenceId &conferenceId) {
+	auto it = index.find(key);
+	if (it == index.end())
+		return;
+
+	vector<ConferenceId> &conferenceIds = it->second;
+	conferenceIds.erase(remove(conferenceIds.begin(), conferenceIds.end(), conferenceId), conferenceIds.end());
+	if (conferenceIds.empty())
+		index.erase(it);
+}
+
+void CorePrivate::setLoadedChatRoom (const ConferenceId &conferenceId, const shared_ptr<AbstractChatRoom> &chatRoom) const {
+	unindexChatRoom(conferenceId);
+	chatRoomsById[conferenceId] = chatRoom;
+	indexChatRoom(conferenceId, chatRoom);
+}
+
+void CorePrivate::eraseLoadedChatRoom (const ConferenceId &conferenceId) const {
+	unindexChatRoom(conferenceId);
+	chatRoomsById.erase(conferenceId);
+}
+
+void CorePrivate::clearLoadedChatRooms () {
+	chatRoomsById.clear();
+	chatRoomsByPeerAddress.clear();
+	chatRoomsByParticipantAddress.clear();
+	chatRoomIndexEntries.clear();
+}
+
+void CorePrivate::indexChatRoom (const ConferenceId &conferenceId, const shared_ptr<AbstractChatRoom> &chatRoom) const {
+	// The keys are kept to unindex the chat room once its addresses have changed.
+	ChatRoomIndexEntry &entry = chatRoomIndexEntries[conferenceId];
+	entry.peerKey = getChatRoomIndexKey(chatRoom->getPeerAddress());
+	addToChatRoomIndex(chatRoomsByPeerAddress, entry.peerKey, conferenceId);
+
+	for (const auto &participant : chatRoom->getParticipants()) {
+		entry.participantKeys.push_back(getChatRoomIndexKey(participant->getAddress()));
+		addToChatRoomIndex(chatRoomsByParticipantAddress, entry.participantKeys.back(), conferenceId);
+	}
+}
+
+void CorePrivate::unindexChatRoom (const ConferenceId &conferenceId) const {
+	auto it = chatRoomIndexEntries.find(conferenceId);
+	if (it == chatRoomIndexEntries.end())
+		return;
+
+	removeFromChatRoomIndex(chatRoomsByPeerAddress, it->second.peerKey, conferenceId);
+	for (const auto &key : it->second.participantKeys)
+		removeFromChatRoomIndex(chatRoomsByParticipantAddress, key, conferenceId);
+	chatRoomIndexEntries.erase(it);
+}
+
+vector<shared_ptr<AbstractChatRoom>> CorePrivate::getIndexedChatRooms (const ChatRoomIndex &index, const IdentityAddress &address) const {
+	vector<shared_ptr<AbstractChatRoom>> chatRooms;
+	auto it = index.find(getChatRoomIndexKey(address));
+	if (it == index.cend())
+		return chatRooms;
+
+	chatRooms.reserve(it->second.size());
+	for (const auto &conferenceId : it->second) {
+		auto chatRoomIt = chatRoomsById.find(conferenceId);
+		if (chatRoomIt != chatRoomsById.cend())
+			chatRooms.push_back(chatRoomIt->second);
+	}
+	return chatRooms;
+}
+
 // -----------------------------------------------------------------------------
 
 static bool compare_chat_room (const shared_ptr<AbstractChatRoom>& first, const shared_ptr<AbstractChatRoom>& second) {
@@ -633,39 +939,53 @@ string Core::getConferenceFactoryUri(const shared_ptr<Core> &core, const Identit
 
 // -----------------------------------------------------------------------------
 
-list<shared_ptr<AbstractChatRoom>> Core::getChatRooms () const {
-	L_D();
-
-	LinphoneCore *lc = getCCore();
+// Returns whether a chat room is hidden from the listings, according to the configuration of the core.
+static function<bool (const IdentityAddress &, int, bool)> getChatRoomHiddenPredicate (LinphoneCore *lc) {
 	LinphoneConfig *config = linphone_core_get_config(lc);
 	bool hideEmptyChatRooms = !!linphone_config_get_int(config, "misc", "hide_empty_chat_rooms", 1);
 	bool hideChatRoomsFromRemovedProxyConfig = !!linphone_config_get_int(config, "misc", "hide_chat_rooms_from_removed_proxies", 1);
 
-	list<shared_ptr<AbstractChatRoom>> rooms;
-	for (auto it = d->chatRoomsById.begin(); it != d->chatRoomsById.end(); it++) {
-		const auto &chatRoom = it->second;
+	return [lc, hideEmptyChatRooms, hideChatRoomsFromRemovedProxyConfig](const IdentityAddress &localAddress, int capabilities, bool isEmpty) {
 		if (hideEmptyChatRooms) {
-			if (chatRoom->isEmpty() && (chatRoom->getCapabilities() & LinphoneChatRoomCapabilitiesOneToOne)) {
-				continue;
+			if (isEmpty && (capabilities & LinphoneChatRoomCapabilitiesOneToOne)) {
+				return true;
 			}
 		}
 
 		if (hideChatRoomsFromRemovedProxyConfig) {
 			const bctbx_list_t *it;
-			bool found = false;
 			for (it = linphone_core_get_proxy_config_list(lc); it != NULL; it = it->next) {
 				LinphoneProxyConfig *cfg = (LinphoneProxyConfig *)it->data;
 				const LinphoneAddress *identityAddr = linphone_proxy_config_get_identity_address(cfg);
-				if (L_GET_CPP_PTR_FROM_C_OBJECT(identityAddr)->weakEqual(chatRoom->getLocalAddress().asAddress())) {
-					found = true;
-					break;
+				if (L_GET_CPP_PTR_FROM_C_OBJECT(identityAddr)->weakEqual(localAddress.asAddress())) {
+					return false;
 				}
 			}
-			if (!found) {
-				continue;
-			}
+			return true;
 		}
 
+		return false;
+	};
+}
+
+list<shared_ptr<AbstractChatRoom>> Core::getChatRooms (LinphoneChatRoomCapabilitiesMask mask) const {
+	L_D();
+
+	const auto isHidden = getChatRoomHiddenPredicate(getCCore());
+
+	// Listed chat rooms are about to be used, load them.
+	d->instantiateChatRooms([&isHidden, mask](const MainDb::ChatRoomSummary &summary) {
+		return (summary.capabilities & mask) == mask &&
+			!isHidden(summary.conferenceId.getLocalAddress(), summary.capabilities, summary.lastMessageId == 0);
+	});
+
+	list<shared_ptr<AbstractChatRoom>> rooms;
+	for (auto it = d->chatRoomsById.begin(); it != d->chatRoomsById.end(); it++) {
+		const auto &chatRoom = it->second;
+		const int capabilities = chatRoom->getCapabilities();
+		if ((capabilities & mask) != mask || isHidden(chatRoom->getLocalAddress(), capabilities, chatRoom->isEmpty()))
+			continue;
+
 		rooms.push_front(chatRoom);
 	}
 
@@ -673,6 +993,31 @@ list<shared_ptr<AbstractChatRoom>> Core::getChatRooms () const {
 	return rooms;
 }
 
+list<IdentityAddress> Core::getChatRoomPeerAddresses (LinphoneChatRoomCapabilitiesMask mask) const {
+	L_D();
+
+	const auto isHidden = getChatRoomHiddenPredicate(getCCore());
+
+	list<IdentityAddress> peerAddresses;
+	for (const auto &entry : d->chatRoomsById) {
+		const auto &chatRoom = entry.second;
+		const int capabilities = chatRoom->getCapabilities();
+		if ((capabilities & mask) == mask && !isHidden(chatRoom->getLocalAddress(), capabilities, chatRoom->isEmpty()))
+			peerAddresses.push_back(chatRoom->getPeerAddress());
+	}
+
+	for (const auto &entry : d->unloadedChatRooms) {
+		const MainDb::ChatRoomSummary &summary = entry.second;
+		if (
+			(summary.capabilities & mask) == mask &&
+			!isHidden(summary.conferenceId.getLocalAddress(), summary.capabilities, summary.lastMessageId == 0)
+		)
+			peerAddresses.push_back(summary.conferenceId.getPeerAddress());
+	}
+
+	return peerAddresses;
+}
+
 shared_ptr<AbstractChatRoom> Core::findChatRoom (const ConferenceId &conferenceId, bool logIfNotFound) const {
 	L_D();
 
@@ -682,6 +1027,10 @@ shared_ptr<AbstractChatRoom> Core::findChatRoom (const ConferenceId &conferenceI
 		return it->second;
 	}
 
+	shared_ptr<AbstractChatRoom> chatRoom = d->instantiateChatRoom(conferenceId);
+	if (chatRoom)
+		return chatRoom;
+
 	auto alreadyExhumedOneToOne = d->findExumedChatRoomFromPreviousConferenceId(conferenceId);
 	if (alreadyExhumedOneToOne) {
 		lWarning() << "Found conference id as already exhumed chat room with new conference ID " << alreadyExhumedOneToOne->getConferenceId() << ".";
@@ -697,9 +1046,12 @@ shared_ptr<AbstractChatRoom> Core::findChatRoom (const ConferenceId &conferenceI
 list<shared_ptr<AbstractChatRoom>> Core::findChatRooms (const IdentityAddress &peerAddress) const {
 	L_D();
 
+	d->instantiateChatRooms([&peerAddress](const MainDb::ChatRoomSummary &summary) {
+		return summary.conferenceId.getPeerAddress() == peerAddress;
+	});
+
 	list<shared_ptr<AbstractChatRoom>> output;
-	for (auto it = d->chatRoomsById.begin(); it != d->chatRoomsById.end(); it++) {
-		const auto &chatRoom = it->second;
+	for (const auto &chatRoom : d->getIndexedChatRooms(d->chatRoomsByPeerAddress, peerAddress)) {
 		if (chatRoom->getPeerAddress() == peerAddress) {
 			output.push_front(chatRoom);
 		}
@@ -716,8 +1068,31 @@ shared_ptr<AbstractChatRoom> Core::findOneToOneChatRoom (
 	bool encrypted
 ) const {
 	L_D();
-	for (auto it = d->chatRoomsById.begin(); it != d->chatRoomsById.end(); it++) {
-		const auto &chatRoom = it->second;
+
+	// The participant of a basic chat room is its peer, the ones of other chat rooms are only known once loaded.
+	d->instantiateChatRooms([&](const MainDb::ChatRoomSummary &summary) {
+		ChatRoom::CapabilitiesMask capabilities = summary.capabilities;
+		if (capabilities & ChatRoom::Capabilities::Basic) {
+			if (conferenceOnly || participantAddress.getAddressWithoutGruu() != summary.conferenceId.getPeerAddress().getAddressWithoutGruu())
+				return false;
+		} else if (basicOnly)
+			return false;
+
+		return (capabilities & ChatRoom::Capabilities::OneToOne)
+			&& encrypted == bool(capabilities & ChatRoom::Capabilities::Encrypted)
+			&& localAddress.getAddressWithoutGruu() == summary.conferenceId.getLocalAddress().getAddressWithoutGruu();
+	});
+
+	// Client group chat rooms are indexed by their participants and basic chat rooms by their peer address.
+	vector<shared_ptr<AbstractChatRoom>> candidates;
+	if (!basicOnly)
+		candidates = d->getIndexedChatRooms(d->chatRoomsByParticipantAddress, participantAddress);
+	if (!conferenceOnly) {
+		vector<shared_ptr<AbstractChatRoom>> peerChatRooms = d->getIndexedChatRooms(d->chatRoomsByPeerAddress, participantAddress);
+		candidates.insert(candidates.end(), peerChatRooms.begin(), peerChatRooms.end());
+	}
+
+	for (const auto &chatRoom : candidates) {
 		const IdentityAddress &curLocalAddress = chatRoom->getLocalAddress();
 		ChatRoom::CapabilitiesMask capabilities = chatRoom->getCapabilities();
 
@@ -816,7 +1191,7 @@ void Core::deleteChatRoom (const shared_ptr<const AbstractChatRoom> &chatRoom) {
 	d->noCreatedClientGroupChatRooms.erase(chatRoom.get());
 	auto chatRoomsByIdIt = d->chatRoomsById.find(conferenceId);
 	if (chatRoomsByIdIt != d->chatRoomsById.end()) {
-		d->chatRoomsById.erase(chatRoomsByIdIt);
+		d->eraseLoadedChatRoom(conferenceId);
 		if (d->mainDb->isInitialized()) d->mainDb->deleteChatRoom(conferenceId);
 	} else {
 		lError() << "Unable to delete chat room with conference ID " << conferenceId << " because it cannot be found.";
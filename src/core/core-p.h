@@ -27,8 +27,10 @@
 #include "chat/chat-room/abstract-chat-room.h"
 #include "core.h"
 #include "db/main-db.h"
+#include "nat/stun-client.h"
 #include "object/object-p.h"
 #include "sal/call-op.h"
+#include "search/friend-search-index.h"
 #include "auth-info/auth-stack.h"
 #include "conference/session/tone-manager.h"
 #include "utils/background-task.h"
@@ -82,6 +84,10 @@ public:
 	bool setInputAudioDevice(AudioDevice *audioDevice);
 
 	void loadChatRooms ();
+	// Lazy chat room loading: unloaded chat rooms are only known by their summary until first use.
+	std::shared_ptr<AbstractChatRoom> instantiateChatRoom (const ConferenceId &conferenceId) const;
+	void instantiateChatRooms (const std::function<bool (const MainDb::ChatRoomSummary &)> &predicate) const;
+	void releaseIdleChatRooms (size_t maxCount);
 	void handleEphemeralMessages (time_t currentTime);
 	void initEphemeralMessages ();
 	void updateEphemeralMessages (const std::shared_ptr<ChatMessage> &message);
@@ -137,6 +143,8 @@ public:
 	void replaceChatRoom (const std::shared_ptr<AbstractChatRoom> &replacedChatRoom, const std::shared_ptr<AbstractChatRoom> &newChatRoom);
 
 	void updateChatRoomConferenceId (const std::shared_ptr<AbstractChatRoom> &chatRoom, ConferenceId newConferenceId);
+	// The participants of a loaded chat room changed, refresh its entries in the chat room indexes.
+	void updateChatRoomIndex (const std::shared_ptr<AbstractChatRoom> &chatRoom) const;
 	std::shared_ptr<AbstractChatRoom> findExhumableOneToOneChatRoom (
 		const IdentityAddress &localAddress,
 		const IdentityAddress &participantAddress,
@@ -147,6 +155,10 @@ public:
 	belle_sip_main_loop_t *getMainLoop();
 	bool basicToFlexisipChatroomMigrationEnabled()const;
 	std::unique_ptr<MainDb> mainDb;
+	// Built by the first MagicSearch, then kept in sync by the friend lists.
+	std::unique_ptr<FriendSearchIndex> friendSearchIndex;
+	// Results of the STUN discoveries, cleared when the network changes.
+	std::unordered_map<std::string, StunClient::CacheEntry> stunCache;
 #ifdef HAVE_ADVANCED_IM
 	std::unique_ptr<RemoteConferenceListEventHandler> remoteListEventHandler;
 	std::unique_ptr<LocalConferenceListEventHandler> localListEventHandler;
@@ -174,12 +186,44 @@ private:
 	bool isInBackground = false;
 	static int ephemeralMessageTimerExpired (void *data, unsigned int revents);
 
+	using ChatRoomIndex = std::unordered_map<std::string, std::vector<ConferenceId>>;
+	struct ChatRoomIndexEntry {
+		std::string peerKey;
+		std::vector<std::string> participantKeys;
+	};
+
+	// chatRoomsById is only modified through these methods, which keep the indexes in sync.
+	void setLoadedChatRoom (const ConferenceId &conferenceId, const std::shared_ptr<AbstractChatRoom> &chatRoom) const;
+	void eraseLoadedChatRoom (const ConferenceId &conferenceId) const;
+	void clearLoadedChatRooms ();
+	void indexChatRoom (const ConferenceId &conferenceId, const std::shared_ptr<AbstractChatRoom> &chatRoom) const;
+	void unindexChatRoom (const ConferenceId &conferenceId) const;
+	// Loaded chat rooms indexed under the address without gruu, a superset of the ones a lookup returns.
+	std::vector<std::shared_ptr<AbstractChatRoom>> getIndexedChatRooms (const ChatRoomIndex &index, const IdentityAddress &address) const;
+
+	struct EphemeralMessage {
+		time_t expireTime;
+		std::shared_ptr<ChatMessage> message;
+	};
+
+	void loadEphemeralMessages ();
+	void pushEphemeralMessage (const std::shared_ptr<ChatMessage> &message);
+	void deleteEphemeralMessages (const std::list<std::shared_ptr<ChatMessage>> &messages);
+
 	std::list<CoreListener *> listeners;
 
 	std::list<std::shared_ptr<Call>> calls;
 	std::shared_ptr<Call> currentCall;
 
-	std::unordered_map<ConferenceId, std::shared_ptr<AbstractChatRoom>> chatRoomsById;
+	mutable std::unordered_map<ConferenceId, std::shared_ptr<AbstractChatRoom>> chatRoomsById;
+	mutable std::unordered_map<ConferenceId, MainDb::ChatRoomSummary> unloadedChatRooms;
+	// Secondary indexes of chatRoomsById by address without gruu, so that lookups do not scan all the chat rooms.
+	mutable ChatRoomIndex chatRoomsByPeerAddress;
+	mutable ChatRoomIndex chatRoomsByParticipantAddress;
+	mutable std::unordered_map<ConferenceId, ChatRoomIndexEntry> chatRoomIndexEntries;
+	bool lazyChatRoomLoading = false;
+	size_t maxLoadedChatRooms = 0; // 0 means unlimited.
+	belle_sip_source_t *chatRoomsReleaseTimer = nullptr;
 
 	std::unique_ptr<EncryptionEngine> imee;
 
@@ -192,7 +236,11 @@ private:
 	std::unordered_map<const AbstractChatRoom *, std::shared_ptr<const AbstractChatRoom>> noCreatedClientGroupChatRooms;
 	AuthStack authStack;
 
-	std::list<std::shared_ptr<ChatMessage>> ephemeralMessages;
+	// Min-heap by expire time of the next ephemeral messages to delete. It holds every started ephemeral message which
+	// expires before ephemeralMessagesLoadedUntil, the later ones are loaded from the database once it is empty.
+	std::vector<EphemeralMessage> ephemeralMessages;
+	time_t ephemeralMessagesLoadedUntil = 0;
+	static constexpr unsigned int EphemeralMessagesBatchSize = 100;
 	belle_sip_source_t *ephemeralTimer = nullptr;
 	belle_sip_source_t *pushTimer = nullptr;
 	unsigned long pushReceivedBackgroundTaskId;
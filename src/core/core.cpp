@@ -36,6 +36,7 @@
 #endif
 
 #include "address/address.h"
+#include "address/identity-address-parser.h"
 #include "call/call.h"
 #include "chat/encryption/encryption-engine.h"
 #ifdef HAVE_LIME_X3DH
@@ -82,6 +83,11 @@ const Utils::Version CorePrivate::ephemeralProtocolVersion(1, 1);
 void CorePrivate::init () {
 	L_Q();
 
+	// The address caches are shared by all the cores of the process.
+	LinphoneConfig *config = linphone_core_get_config(L_GET_C_BACK_PTR(q));
+	Address::setSipAddressesCacheSize(linphone_config_get_int(config, "misc", "sip_address_cache_size", Address::DefaultSipAddressesCacheSize));
+	IdentityAddressParser::getInstance()->setCacheSize(linphone_config_get_int(config, "misc", "identity_address_cache_size", IdentityAddressParser::DefaultCacheSize));
+
 	mainDb.reset(new MainDb(q->getSharedFromThis()));
 #ifdef HAVE_ADVANCED_IM
 	remoteListEventHandler = makeUnique<RemoteConferenceListEventHandler>(q->getSharedFromThis());
@@ -126,6 +132,12 @@ void CorePrivate::init () {
 				lWarning() << "Opening database took " << duration << " ms !";
 			}
 
+			mainDb->setEventQueueParameters(
+				(unsigned int)linphone_config_get_int(linphone_core_get_config(lc), "storage", "event_batch_max_size", 0),
+				(unsigned int)linphone_config_get_int(linphone_core_get_config(lc), "storage", "event_batch_window_ms", 100)
+			);
+			mainDb->enableAsyncMode(!!linphone_config_get_bool(linphone_core_get_config(lc), "storage", "async_mode", FALSE));
+
 			loadChatRooms();
 		} else lWarning() << "Database explicitely not requested, this Core is built with no database support.";
 
@@ -249,6 +261,7 @@ void CorePrivate::shutdown() {
 
 	stopEphemeralMessageTimer();
 	ephemeralMessages.clear();
+	ephemeralMessagesLoadedUntil = 0;
 
 	for (auto it = chatRoomsById.begin(); it != chatRoomsById.end(); it++) {
 		const auto &chatRoom = it->second;
@@ -277,10 +290,15 @@ void CorePrivate::uninit() {
 		q->enableLimeX3dh(false);
 	}
 
-	const list<shared_ptr<AbstractChatRoom>> chatRooms = q->getChatRooms();
+	if (chatRoomsReleaseTimer) {
+		q->destroyTimer(chatRoomsReleaseTimer);
+		chatRoomsReleaseTimer = nullptr;
+	}
+	unloadedChatRooms.clear();
+
 	shared_ptr<ChatRoom> cr;
-	for (const auto &chatRoom : chatRooms) {
-		cr = dynamic_pointer_cast<ChatRoom>(chatRoom);
+	for (const auto &entry : chatRoomsById) {
+		cr = dynamic_pointer_cast<ChatRoom>(entry.second);
 		if (cr) {
 			cr->getPrivate()->getImdnHandler()->onLinphoneCoreStop();
 #ifdef HAVE_ADVANCED_IM
@@ -300,7 +318,7 @@ void CorePrivate::uninit() {
 		}
 	}
 
-	chatRoomsById.clear();
+	clearLoadedChatRooms();
 
 	for (const auto &audioVideoConference : q->audioVideoConferenceById) {
 		// Terminate audio video conferences just before core is stopped
@@ -318,8 +336,15 @@ void CorePrivate::uninit() {
 	localListEventHandler.reset();
 #endif
 
+	LruCacheStats sipStats = Address::getSipAddressesCacheStats();
+	LruCacheStats identityStats = IdentityAddressParser::getInstance()->getCacheStats();
+	lInfo() << "SIP address cache: " << sipStats.hits << " hits, " << sipStats.misses << " misses, " << sipStats.evictions << " evictions. "
+		<< "Identity address cache: " << identityStats.hits << " hits, " << identityStats.misses << " misses, " << identityStats.evictions << " evictions.";
 	Address::clearSipAddressesCache();
 	if (mainDb != nullptr) {
+		// Store pending events, release the flush timer and stop the database worker.
+		mainDb->setEventQueueParameters(0, 0);
+		mainDb->enableAsyncMode(false);
 		mainDb->disconnect();
 	}
 }
@@ -333,6 +358,7 @@ void CorePrivate::notifyGlobalStateChanged (LinphoneGlobalState state) {
 }
 
 void CorePrivate::notifyNetworkReachable (bool sipNetworkReachable, bool mediaNetworkReachable) {
+	stunCache.clear();
 	auto listenersCopy = listeners; // Allow removal of a listener in its own call
 	for (const auto &listener : listenersCopy)
 		listener->onNetworkReachable(sipNetworkReachable, mediaNetworkReachable);
@@ -369,6 +395,9 @@ void CorePrivate::notifyEnteringBackground () {
 	if (q->isFriendListSubscriptionEnabled())
 		enableFriendListsSubscription(false);
 
+	// Give memory back while in background, chat rooms are loaded again on first use.
+	releaseIdleChatRooms(0);
+
 #if TARGET_OS_IPHONE
 	LinphoneCore *lc = L_GET_C_BACK_PTR(q);
 	/* Stop the dtmf stream in case it was started.*/
@@ -1181,6 +1210,10 @@ int Core::getUnreadChatMessageCount (const IdentityAddress &localAddress) const
 		if (addressToCompare.weakEqual(chatRoom->getLocalAddress().asAddress()))
 			count += chatRoom->getUnreadChatMessageCount();
 	}
+	for (const auto &entry : d->unloadedChatRooms) {
+		if (addressToCompare.weakEqual(entry.first.getLocalAddress().asAddress()))
+			count += entry.second.unreadChatMessageCount;
+	}
 	return count;
 }
 
@@ -1198,6 +1231,15 @@ int Core::getUnreadChatMessageCountFromActiveLocals () const {
 			}
 		}
 	}
+	for (const auto &entry : d->unloadedChatRooms) {
+		for (auto it = linphone_core_get_proxy_config_list(getCCore()); it != NULL; it = it->next) {
+			LinphoneProxyConfig *cfg = (LinphoneProxyConfig *)it->data;
+			const LinphoneAddress *identityAddr = linphone_proxy_config_get_identity_address(cfg);
+			if (L_GET_CPP_PTR_FROM_C_OBJECT(identityAddr)->weakEqual(entry.first.getLocalAddress().asAddress())) {
+				count += entry.second.unreadChatMessageCount;
+			}
+		}
+	}
 	return count;
 }
 
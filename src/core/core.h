@@ -76,6 +76,7 @@ class LINPHONE_PUBLIC Core : public Object {
 	friend class Imdn;
 	friend class LocalConferenceEventHandler;
 	friend class MainDb;
+	friend class MagicSearch;
 	friend class MainDbEventKey;
 	friend class MediaSessionPrivate;
 	friend class RemoteConferenceEventHandler;
@@ -135,7 +136,10 @@ public:
 	// ChatRoom.
 	// ---------------------------------------------------------------------------
 
-	std::list<std::shared_ptr<AbstractChatRoom>> getChatRooms () const;
+	// Listed chat rooms are loaded. Only the chat rooms having all the capabilities of mask are listed.
+	std::list<std::shared_ptr<AbstractChatRoom>> getChatRooms (LinphoneChatRoomCapabilitiesMask mask = 0) const;
+	// Peer addresses of the chat rooms getChatRooms() would list, without loading them.
+	std::list<IdentityAddress> getChatRoomPeerAddresses (LinphoneChatRoomCapabilitiesMask mask = 0) const;
 
 	std::shared_ptr<AbstractChatRoom> findChatRoom (const ConferenceId &conferenceId, bool logIfNotFound = true) const;
 	std::list<std::shared_ptr<AbstractChatRoom>> findChatRooms (const IdentityAddress &peerAddress) const;
@@ -38,6 +38,8 @@ class AbstractDbPrivate : public ObjectPrivate {
 public:
 #ifdef HAVE_DB_STORAGE
 	DbSession dbSession;
+	// Uri of the connection, used to open other sessions on the same database.
+	std::string uri;
 #endif
 
 private:
@@ -73,9 +73,8 @@ bool AbstractDb::connect (Backend backend, const string &nameParams) {
 	#endif // if (TARGET_OS_IPHONE || defined(__ANDROID__))
 
 	d->backend = backend;
-	d->dbSession = DbSession(
-		(backend == Mysql ? "mysql://" : "sqlite3://") + nameParams
-	);
+	d->uri = (backend == Mysql ? "mysql://" : "sqlite3://") + nameParams;
+	d->dbSession = DbSession(d->uri);
 
 	if (d->dbSession) {
 		try {
@@ -97,6 +96,9 @@ bool AbstractDb::connect (Backend backend, const string &nameParams) {
 void AbstractDb::disconnect () {
 #ifdef HAVE_DB_STORAGE
 	L_D();
+	if (d->dbSession)
+		lInfo() << "Database statement cache: " << d->dbSession.getStatementCacheHits() << " hits, "
+			<< d->dbSession.getStatementCacheMisses() << " misses.";
 	d->dbSession = DbSession();
 #endif
 }
@@ -116,6 +118,8 @@ bool AbstractDb::forceReconnect () {
 		for (int i = 0; i < retryCount; ++i) {
 			try {
 				lInfo() << "Reconnect... Try: " << i;
+				// Prepared statements are bound to the previous connection.
+				d->dbSession.clearStatementCache();
 				d->dbSession.getBackendSession()->reconnect(); // Equivalent to close and connect.
 				d->safeInit();
 				lInfo() << "Database reconnection successful!";
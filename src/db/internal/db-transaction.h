@@ -34,14 +34,16 @@ LINPHONE_BEGIN_NAMESPACE
 
 class SmartTransaction {
 public:
-	SmartTransaction (soci::session *session, const char *name) :
-	mSession(session), mName(name), mIsCommitted(false) {
-		lDebug() << "Start transaction " << this << " in MainDb::" << mName << ".";
-		mSession->begin();
+	// A nested transaction runs in the enclosing one, which begins and ends it.
+	SmartTransaction (soci::session *session, const char *name, bool nested = false) :
+	mSession(session), mName(name), mIsCommitted(false), mIsNested(nested) {
+		lDebug() << "Start transaction " << this << " in MainDb::" << mName << (mIsNested ? " (nested)." : ".");
+		if (!mIsNested)
+			mSession->begin();
 	}
 
 	~SmartTransaction () {
-		if (!mIsCommitted) {
+		if (!mIsCommitted && !mIsNested) {
 			lDebug() << "Rollback transaction " << this << " in MainDb::" << mName << ".";
 			mSession->rollback();
 		}
@@ -55,13 +57,15 @@ public:
 
 		lDebug() << "Commit transaction " << this << " in MainDb::" << mName << ".";
 		mIsCommitted = true;
-		mSession->commit();
+		if (!mIsNested)
+			mSession->commit();
 	}
 
 private:
 	soci::session *mSession;
 	const char *mName;
 	bool mIsCommitted;
+	bool mIsNested;
 
 	L_DISABLE_COPY(SmartTransaction);
 };
@@ -93,15 +97,21 @@ public:
 	DbTransaction (DbTransactionInfo &info, Function &&function) : mFunction(std::move(function)) {
 		MainDb *mainDb = info.mainDb;
 		const char *name = info.name;
-		soci::session *session = mainDb->getPrivate()->dbSession.getBackendSession();
+		MainDbPrivate *dMainDb = mainDb->getPrivate();
+		soci::session *session = dMainDb->dbSession.getBackendSession();
+
+		// A chat room can be loaded lazily while another transaction is running.
+		const bool nested = dMainDb->transactionDepth > 0;
+		DepthGuard depthGuard(dMainDb->transactionDepth);
 
 		try {
-			SmartTransaction tr(session, name);
+			SmartTransaction tr(session, name, nested);
 			mResult = exec<InternalReturnType>(tr);
 		} catch (const soci::soci_error &e) {
 			lWarning() << "Caught exception in MainDb::" << name << "(" << e.what() << ").";
 			soci::soci_error::error_category category = e.get_error_category();
 			if (
+				!nested &&
 				(category == soci::soci_error::connection_error || category == soci::soci_error::unknown) &&
 				mainDb->forceReconnect()
 			) {
@@ -127,6 +137,18 @@ public:
 	}
 
 private:
+	struct DepthGuard {
+		DepthGuard (int &depth) : mDepth(depth) {
+			++mDepth;
+		}
+
+		~DepthGuard () {
+			--mDepth;
+		}
+
+		int &mDepth;
+	};
+
 	// Exec function with no return type.
 	template<typename T>
 	typename std::enable_if<std::is_same<T, void>::value, bool>::type exec (SmartTransaction &tr) const {
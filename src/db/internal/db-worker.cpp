@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2010-2019 Belledonne Communications SARL.
+ *
+ * This file is part of Liblinphone.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "linphone/utils/utils.h"
+
+#include "db-worker.h"
+#include "logger/logger.h"
+
+// =============================================================================
+
+using namespace std;
+
+LINPHONE_BEGIN_NAMESPACE
+
+namespace {
+	// Both sessions may access the database file at the same time.
+	constexpr int SqliteBusyTimeoutMs = 5000;
+}
+
+DbWorker::DbWorker (const string &uri, bool isSqlite) : mUri(uri), mIsSqlite(isSqlite), mThread(&DbWorker::run, this) {}
+
+DbWorker::~DbWorker () {
+	{
+		lock_guard<mutex> lock(mMutex);
+		mStopped = true;
+	}
+	mTaskCondition.notify_one();
+	mThread.join();
+}
+
+void DbWorker::post (const char *name, Task task) {
+	postWrite(name, nullptr, move(task));
+}
+
+void DbWorker::postWrite (const char *name, const char *table, Task task) {
+	{
+		lock_guard<mutex> lock(mMutex);
+		mTasks.push(PendingTask{ name, table, move(task) });
+		if (table) {
+			++mPendingWrites[table];
+			++mPendingWriteCount;
+		}
+	}
+	mTaskCondition.notify_one();
+}
+
+void DbWorker::waitUntilIdle () {
+	if (this_thread::get_id() == mThread.get_id())
+		return;
+
+	unique_lock<mutex> lock(mMutex);
+	mIdleCondition.wait(lock, [this] { return mTasks.empty() && !mBusy; });
+}
+
+void DbWorker::waitForWrites (initializer_list<const char *> tables) {
+	if (this_thread::get_id() == mThread.get_id())
+		return;
+
+	unique_lock<mutex> lock(mMutex);
+	if (!hasPendingWrites(tables))
+		return;
+
+	lDebug() << "Wait for the writes of the database worker.";
+	mIdleCondition.wait(lock, [this, &tables] { return !hasPendingWrites(tables); });
+}
+
+bool DbWorker::hasPendingWrites (initializer_list<const char *> tables) const {
+	if (tables.size() == 0)
+		return mPendingWriteCount > 0;
+
+	for (const char *table : tables) {
+		auto it = mPendingWrites.find(table);
+		if (it != mPendingWrites.cend() && it->second > 0)
+			return true;
+	}
+	return false;
+}
+
+void DbWorker::run () {
+	DbSession session(mUri);
+	if (session) {
+		try {
+			session.enableForeignKeys(true);
+			if (mIsSqlite)
+				*session.getBackendSession() << "PRAGMA busy_timeout = " + Utils::toString(SqliteBusyTimeoutMs);
+		} catch (const exception &e) {
+			lError() << "Unable to configure database worker session: " << e.what();
+		}
+	} else
+		lError() << "Database worker unable to open its session, tasks will be dropped.";
+
+	unique_lock<mutex> lock(mMutex);
+	for (;;) {
+		mTaskCondition.wait(lock, [this] { return mStopped || !mTasks.empty(); });
+		if (mTasks.empty())
+			break; // Stopped and every task executed.
+
+		PendingTask task = move(mTasks.front());
+		mTasks.pop();
+		mBusy = true;
+		lock.unlock();
+
+		execute(session, task.name, task.task);
+		task.task = nullptr;
+
+		lock.lock();
+		mBusy = false;
+		if (task.table) {
+			--mPendingWrites[task.table];
+			--mPendingWriteCount;
+			mIdleCondition.notify_all();
+		} else if (mTasks.empty())
+			mIdleCondition.notify_all();
+	}
+}
+
+void DbWorker::execute (const DbSession &session, const char *name, Task &task) {
+	if (!session) {
+		lWarning() << "Unable to execute `" << name << "` in database worker: no session.";
+		return;
+	}
+
+	try {
+		soci::transaction tr(*session.getBackendSession());
+		task(session);
+		tr.commit();
+	} catch (const exception &e) {
+		lError() << "Unable to execute `" << name << "` in database worker: " << e.what();
+	}
+}
+
+LINPHONE_END_NAMESPACE
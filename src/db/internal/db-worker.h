@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2010-2019 Belledonne Communications SARL.
+ *
+ * This file is part of Liblinphone.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _L_DB_WORKER_H_
+#define _L_DB_WORKER_H_
+
+#include <condition_variable>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+
+#include "db/session/db-session.h"
+
+// =============================================================================
+
+LINPHONE_BEGIN_NAMESPACE
+
+// Thread owning its own database session. Tasks are executed one at a time, in submission order,
+// each one in its own transaction.
+class DbWorker {
+public:
+	using Task = std::function<void (const DbSession &session)>;
+
+	DbWorker (const std::string &uri, bool isSqlite);
+	// Executes the pending tasks before joining the thread.
+	~DbWorker ();
+
+	void post (const char *name, Task task);
+	// Same as post() for a task writing in table, see waitForWrites().
+	void postWrite (const char *name, const char *table, Task task);
+
+	// Blocks until every posted task is executed.
+	void waitUntilIdle ();
+	// Blocks until the writes posted in one of the tables are executed, in any table if tables is empty.
+	void waitForWrites (std::initializer_list<const char *> tables);
+
+private:
+	void run ();
+	void execute (const DbSession &session, const char *name, Task &task);
+
+	std::string mUri;
+	bool mIsSqlite;
+
+	std::mutex mMutex;
+	std::condition_variable mTaskCondition;
+	std::condition_variable mIdleCondition;
+	struct PendingTask {
+		const char *name;
+		const char *table;
+		Task task;
+	};
+
+	bool hasPendingWrites (std::initializer_list<const char *> tables) const;
+
+	std::queue<PendingTask> mTasks;
+	std::unordered_map<std::string, int> mPendingWrites;
+	int mPendingWriteCount = 0;
+	bool mBusy = false;
+	bool mStopped = false;
+
+	// Must be the last member, the thread uses the other ones.
+	std::thread mThread;
+
+	L_DISABLE_COPY(DbWorker);
+};
+
+LINPHONE_END_NAMESPACE
+
+#endif // ifndef _L_DB_WORKER_H_
@@ -109,6 +109,12 @@ namespace Statements {
 			LEFT JOIN sip_address AS participant_sip_address ON participant_sip_address.id = participant_sip_address_id
 			LEFT JOIN sip_address AS reply_sender_address ON reply_sender_address.id = reply_sender_address_id
 			WHERE chat_room_id = :1
+		)",
+
+		/* SelectContentTypeId */ R"(
+			SELECT id
+			FROM content_type
+			WHERE value = :1
 		)"
 	};
 
@@ -34,6 +34,7 @@ namespace Statements {
 		SelectOneToOneChatRoomId,
 		SelectConferenceEvent,
 		SelectConferenceEvents,
+		SelectContentTypeId,
 		SelectCount
 	};
 
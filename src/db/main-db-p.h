@@ -22,10 +22,15 @@
 
 #include <unordered_map>
 
+#include <belle-sip/types.h>
+
 #include "linphone/utils/utils.h"
 
 #include "abstract/abstract-db-p.h"
 #include "containers/lru-cache.h"
+#ifdef HAVE_DB_STORAGE
+#include "db/internal/db-worker.h"
+#endif
 #include "event-log/event-log.h"
 #include "main-db.h"
 
@@ -41,7 +46,61 @@ public:
 	mutable std::unordered_map<long long, std::weak_ptr<ChatMessage>> storageIdToChatMessage;
 	mutable std::unordered_map<long long, ConferenceId> storageIdToConferenceId;
 
+#ifdef HAVE_DB_STORAGE
+	// Set in async mode. Synchronous operations only wait for the pending writes they conflict with.
+	std::unique_ptr<DbWorker> dbWorker;
+#endif
+
+	// Number of running L_DB_TRANSACTION, greater than 1 when they are nested.
+	int transactionDepth = 0;
+
 private:
+#ifdef HAVE_DB_STORAGE
+	// Lookups and statements shared by the events of a MainDb::addEvents() call.
+	struct BatchInsertContext {
+		std::unordered_map<std::string, long long> sipAddressIds;
+		std::unordered_map<std::string, long long> contentTypeIds;
+		std::unordered_map<ConferenceId, long long> chatRoomIds;
+
+		int eventType = 0;
+		tm eventCreationTime;
+		std::unique_ptr<soci::statement> insertEventStatement;
+	};
+
+	std::unique_ptr<BatchInsertContext> batchInsertContext;
+
+	// Content of a chat room row and of its participants. It is fetched without using the core
+	// so that it can be done by the database worker.
+	struct ChatRoomRecord {
+		struct Device {
+			std::string address;
+			std::string name;
+			int state = 0;
+		};
+
+		struct Participant {
+			std::string address;
+			bool isAdmin = false;
+			std::list<Device> devices;
+		};
+
+		long long id = -1;
+		std::string peerAddress;
+		std::string localAddress;
+		time_t creationTime = 0;
+		time_t lastUpdateTime = 0;
+		int capabilities = 0;
+		std::string subject;
+		unsigned int lastNotifyId = 0;
+		bool hasBeenLeft = false;
+		long long lastMessageId = 0;
+		bool ephemeralEnabled = false;
+		long ephemeralLifetime = 0;
+		std::list<Participant> participants;
+		std::list<std::string> previousPeerAddresses;
+	};
+#endif
+
 	// ---------------------------------------------------------------------------
 	// Misc helpers.
 	// ---------------------------------------------------------------------------
@@ -49,6 +108,19 @@ private:
 	std::shared_ptr<AbstractChatRoom> findChatRoom (const ConferenceId &conferenceId) const;
 	std::shared_ptr<MediaConference::Conference> findAudioVideoConference (const ConferenceId &conferenceId) const;
 
+	// Select query of the conference events of a chat room matching the mask, built once per mask.
+	const std::string &getConferenceEventsQuery (MainDb::FilterMask mask) const;
+
+#ifdef HAVE_DB_STORAGE
+	// Executes task in the database worker if async mode is enabled, in a transaction of the main session otherwise.
+	// table is the one written by task, see waitForPendingWrites().
+	void executeWrite (const char *name, const char *table, const DbWorker::Task &task) const;
+	// Keeps the order of the operations: blocks until the writes of the worker in one of the tables are executed,
+	// in any table if tables is empty.
+	void waitForPendingWrites (std::initializer_list<const char *> tables = {}) const;
+	// Executes task in the database worker then done in the core iterate thread. Requires async mode.
+	void executeAsync (const char *name, const DbWorker::Task &task, const std::function<void ()> &done) const;
+#endif
 
 	// ---------------------------------------------------------------------------
 	// Low level API.
@@ -78,6 +150,13 @@ private:
 	void deleteChatRoomParticipant (long long chatRoomId, long long participantSipAddressId);
 	void deleteChatRoomParticipantDevice (long long participantId, long long participantDeviceSipAddressId);
 
+#ifdef HAVE_DB_STORAGE
+	// Records of every chat room, or only the one of chatRoomId if it is positive.
+	static std::list<ChatRoomRecord> selectChatRoomRecords (const DbSession &session, bool isMysql, long long chatRoomId = -1);
+	std::list<MainDb::ChatRoomSummary> selectChatRoomSummaries (long long chatRoomId = -1) const;
+	std::list<std::shared_ptr<AbstractChatRoom>> createChatRooms (const std::list<ChatRoomRecord> &records) const;
+#endif
+
 	// ---------------------------------------------------------------------------
 	// Events API.
 	// ---------------------------------------------------------------------------
@@ -163,6 +242,7 @@ private:
 	) const;
 #endif
 
+	long long insertEventByType (const std::shared_ptr<EventLog> &eventLog);
 	long long insertEvent (const std::shared_ptr<EventLog> &eventLog);
 	long long insertConferenceEvent (const std::shared_ptr<EventLog> &eventLog, long long *chatRoomId = nullptr);
 	long long insertConferenceCallEvent (const std::shared_ptr<EventLog> &eventLog);
@@ -220,6 +300,15 @@ private:
 	// ---------------------------------------------------------------------------
 
 	mutable LruCache<ConferenceId, int> unreadChatMessageCountCache;
+	mutable std::unordered_map<int, std::string> conferenceEventsQueries;
+
+	// Write-behind queue of MainDb::queueEvent().
+	std::list<std::shared_ptr<EventLog>> queuedEvents;
+	belle_sip_source_t *queuedEventsTimer = nullptr;
+	unsigned int eventQueueMaxSize = 0;
+
+	// Alive while async mode is enabled, async results are dropped once it is released.
+	std::shared_ptr<bool> asyncModeToken;
 
 	L_DECLARE_PUBLIC(MainDb);
 };
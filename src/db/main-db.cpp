@@ -23,6 +23,7 @@
 #endif
 
 #include <ctime>
+#include <limits>
 
 #include "linphone/utils/algorithm.h"
 #include "linphone/utils/static-string.h"
@@ -62,7 +63,7 @@ LINPHONE_BEGIN_NAMESPACE
 
 #ifdef HAVE_DB_STORAGE
 namespace {
-	constexpr unsigned int ModuleVersionEvents = makeVersion(1, 0, 16);
+	constexpr unsigned int ModuleVersionEvents = makeVersion(1, 0, 19);
 	constexpr unsigned int ModuleVersionFriends = makeVersion(1, 0, 0);
 	constexpr unsigned int ModuleVersionLegacyFriendsImport = makeVersion(1, 0, 0);
 	constexpr unsigned int ModuleVersionLegacyHistoryImport = makeVersion(1, 0, 0);
@@ -129,6 +130,91 @@ static T getValueFromRow (const soci::row &row, int index, bool &isNull) {
 	}
 	return row.get<T>(size_t(index));
 }
+
+// Execute a select statement returning a single id through the statement cache of the session.
+template<typename... Uses>
+static long long selectIdFromCachedStatement (const DbSession &dbSession, Statements::Select statementId, Uses &&...uses) {
+	soci::statement &statement = dbSession.getCachedStatement(statementId, Statements::get(statementId));
+
+	long long id = -1;
+	bool gotData = false;
+	try {
+		statement.exchange(soci::into(id));
+		int dummy[] = { 0, (statement.exchange(std::forward<Uses>(uses)), 0)... };
+		(void)dummy;
+		statement.define_and_bind();
+		gotData = statement.execute(true);
+		const long long result = gotData ? id : -1;
+		// Step to the end so that the statement does not keep the read transaction open until its next use.
+		while (gotData && statement.fetch()) {}
+		id = result;
+	} catch (...) {
+		statement.bind_clean_up();
+		throw;
+	}
+	statement.bind_clean_up();
+
+	return id;
+}
+
+// Same as MainDbPrivate::selectChatRoomId() but usable with any session, like the one of the database worker.
+static long long selectChatRoomIdInSession (const DbSession &dbSession, const string &peerAddress, const string &localAddress) {
+	const long long peerSipAddressId = selectIdFromCachedStatement(
+		dbSession, Statements::SelectSipAddressId, soci::use(peerAddress)
+	);
+	if (peerSipAddressId < 0)
+		return -1;
+
+	const long long localSipAddressId = selectIdFromCachedStatement(
+		dbSession, Statements::SelectSipAddressId, soci::use(localAddress)
+	);
+	if (localSipAddressId < 0)
+		return -1;
+
+	return selectIdFromCachedStatement(
+		dbSession, Statements::SelectChatRoomId, soci::use(peerSipAddressId), soci::use(localSipAddressId)
+	);
+}
+
+// Same as MainDbPrivate::insertSipAddress() but usable with any session.
+static long long insertSipAddressInSession (const DbSession &dbSession, const string &sipAddress) {
+	const long long sipAddressId = selectIdFromCachedStatement(
+		dbSession, Statements::SelectSipAddressId, soci::use(sipAddress)
+	);
+	if (sipAddressId >= 0)
+		return sipAddressId;
+
+	*dbSession.getBackendSession() << "INSERT INTO sip_address (value) VALUES (:sipAddress)", soci::use(sipAddress);
+	return dbSession.getLastInsertId();
+}
+
+// Shared by MainDbPrivate::setChatMessageParticipantState() and the database worker.
+static void setChatMessageParticipantStateInSession (
+	const DbSession &dbSession,
+	long long eventId,
+	long long participantSipAddressId,
+	ChatMessage::State state,
+	const tm &stateChangeTm
+) {
+	soci::session *session = dbSession.getBackendSession();
+
+	/* setChatMessageParticipantState can be called by updateConferenceChatMessageEvent, which try to update participant state
+	 by message state. However, we can not change state Displayed/DeliveredToUser to Delivered/NotDelivered. */
+	int intState;
+	*session << "SELECT state FROM chat_message_participant WHERE event_id = :eventId",
+		soci::into(intState), soci::use(eventId);
+	ChatMessage::State dbState = ChatMessage::State(intState);
+	if (int(state) < intState && (dbState == ChatMessage::State::Displayed || dbState == ChatMessage::State::DeliveredToUser)) {
+		lInfo() << "setChatMessageParticipantState: can not change state from " << dbState << " to " << state;
+		return;
+	}
+
+	const int stateInt = int(state);
+	*session << "UPDATE chat_message_participant SET state = :state,"
+		" state_change_time = :stateChangeTm"
+		" WHERE event_id = :eventId AND participant_sip_address_id = :participantSipAddressId",
+		soci::use(stateInt), soci::use(stateChangeTm), soci::use(eventId), soci::use(participantSipAddressId);
+}
 #endif
 
 // -----------------------------------------------------------------------------
@@ -286,6 +372,71 @@ shared_ptr<MediaConference::Conference> MainDbPrivate::findAudioVideoConference
 		lError() << "Unable to find chat room: " << conferenceId << ".";
 	return conference;
 }
+
+const string &MainDbPrivate::getConferenceEventsQuery (MainDb::FilterMask mask) const {
+#ifdef HAVE_DB_STORAGE
+	auto it = conferenceEventsQueries.find(mask);
+	if (it != conferenceEventsQueries.cend())
+		return it->second;
+
+	string &query = conferenceEventsQueries[mask];
+	query = Statements::get(Statements::SelectConferenceEvents) + buildSqlEventFilter({
+		MainDb::ConferenceCallFilter,
+		MainDb::ConferenceChatMessageFilter,
+		MainDb::ConferenceInfoFilter,
+		MainDb::ConferenceInfoNoDeviceFilter,
+		MainDb::ConferenceChatMessageSecurityFilter
+	}, mask, "AND");
+	return query;
+#else
+	static const string emptyQuery;
+	return emptyQuery;
+#endif
+}
+
+#ifdef HAVE_DB_STORAGE
+void MainDbPrivate::executeWrite (const char *name, const char *table, const DbWorker::Task &task) const {
+	if (dbWorker) {
+		dbWorker->postWrite(name, table, task);
+		return;
+	}
+
+	L_Q();
+	L_DB_TRANSACTION_C(q) {
+		task(dbSession);
+		tr.commit();
+	};
+}
+
+void MainDbPrivate::waitForPendingWrites (initializer_list<const char *> tables) const {
+	if (dbWorker)
+		dbWorker->waitForWrites(tables);
+}
+
+void MainDbPrivate::executeAsync (const char *name, const DbWorker::Task &task, const function<void ()> &done) const {
+	L_Q();
+
+	// done is only copied and destroyed in the core iterate thread, the worker only moves it.
+	Core *core = q->getCore().get();
+	weak_ptr<bool> token = asyncModeToken;
+	auto doneHolder = make_shared<function<void ()>>(done);
+	dbWorker->post(name, [name, core, token, task, doneHolder](const DbSession &session) mutable {
+		try {
+			task(session);
+		} catch (const exception &e) {
+			lError() << "Unable to execute `" << name << "` in database worker: " << e.what();
+		}
+
+		// The worker is stopped before the core is released.
+		core->doLater([token, doneHolder]() {
+			if (!token.expired())
+				(*doneHolder)();
+		});
+		doneHolder.reset();
+	});
+}
+#endif
+
 // -----------------------------------------------------------------------------
 // Low level API.
 // -----------------------------------------------------------------------------
@@ -298,7 +449,10 @@ long long MainDbPrivate::insertSipAddress (const string &sipAddress) {
 
 	lInfo() << "Insert new sip address in database: `" << sipAddress << "`.";
 	*dbSession.getBackendSession() << "INSERT INTO sip_address (value) VALUES (:sipAddress)", soci::use(sipAddress);
-	return dbSession.getLastInsertId();
+	sipAddressId = dbSession.getLastInsertId();
+	if (batchInsertContext)
+		batchInsertContext->sipAddressIds[sipAddress] = sipAddressId;
+	return sipAddressId;
 #else
 	return -1;
 #endif
@@ -337,14 +491,22 @@ long long MainDbPrivate::insertContentType (const string &contentType) {
 #ifdef HAVE_DB_STORAGE
 	soci::session *session = dbSession.getBackendSession();
 
-	long long contentTypeId;
-	*session << "SELECT id FROM content_type WHERE value = :contentType", soci::use(contentType), soci::into(contentTypeId);
-	if (session->got_data())
-		return contentTypeId;
+	if (batchInsertContext) {
+		auto it = batchInsertContext->contentTypeIds.find(contentType);
+		if (it != batchInsertContext->contentTypeIds.cend())
+			return it->second;
+	}
 
-	lInfo() << "Insert new content type in database: `" << contentType << "`.";
-	*session << "INSERT INTO content_type (value) VALUES (:contentType)", soci::use(contentType);
-	return dbSession.getLastInsertId();
+	long long contentTypeId = selectIdFromCachedStatement(dbSession, Statements::SelectContentTypeId, soci::use(contentType));
+	if (contentTypeId < 0) {
+		lInfo() << "Insert new content type in database: `" << contentType << "`.";
+		*session << "INSERT INTO content_type (value) VALUES (:contentType)", soci::use(contentType);
+		contentTypeId = dbSession.getLastInsertId();
+	}
+
+	if (batchInsertContext)
+		batchInsertContext->contentTypeIds[contentType] = contentTypeId;
+	return contentTypeId;
 #else
 	return -1;
 #endif
@@ -509,13 +671,19 @@ void MainDbPrivate::insertChatMessageParticipant (long long chatMessageId, long
 
 long long MainDbPrivate::selectSipAddressId (const string &sipAddress) const {
 #ifdef HAVE_DB_STORAGE
-	long long sipAddressId;
+	if (batchInsertContext) {
+		auto it = batchInsertContext->sipAddressIds.find(sipAddress);
+		if (it != batchInsertContext->sipAddressIds.cend())
+			return it->second;
+	}
 
-	soci::session *session = dbSession.getBackendSession();
-	*session << Statements::get(Statements::SelectSipAddressId),
-		soci::use(sipAddress), soci::into(sipAddressId);
+	long long sipAddressId = selectIdFromCachedStatement(dbSession, Statements::SelectSipAddressId, soci::use(sipAddress));
+	if (sipAddressId < 0)
+		return -1;
 
-	return session->got_data() ? sipAddressId : -1;
+	if (batchInsertContext)
+		batchInsertContext->sipAddressIds[sipAddress] = sipAddressId;
+	return sipAddressId;
 #else
 	return -1;
 #endif
@@ -523,13 +691,9 @@ long long MainDbPrivate::selectSipAddressId (const string &sipAddress) const {
 
 long long MainDbPrivate::selectChatRoomId (long long peerSipAddressId, long long localSipAddressId) const {
 #ifdef HAVE_DB_STORAGE
-	long long chatRoomId;
-
-	soci::session *session = dbSession.getBackendSession();
-	*session << Statements::get(Statements::SelectChatRoomId),
-		soci::use(peerSipAddressId), soci::use(localSipAddressId), soci::into(chatRoomId);
-
-	return session->got_data() ? chatRoomId : -1;
+	return selectIdFromCachedStatement(
+		dbSession, Statements::SelectChatRoomId, soci::use(peerSipAddressId), soci::use(localSipAddressId)
+	);
 #else
 	return -1;
 #endif
@@ -537,6 +701,12 @@ long long MainDbPrivate::selectChatRoomId (long long peerSipAddressId, long long
 
 long long MainDbPrivate::selectChatRoomId (const ConferenceId &conferenceId) const {
 #ifdef HAVE_DB_STORAGE
+	if (batchInsertContext) {
+		auto it = batchInsertContext->chatRoomIds.find(conferenceId);
+		if (it != batchInsertContext->chatRoomIds.cend())
+			return it->second;
+	}
+
 	long long peerSipAddressId = selectSipAddressId(conferenceId.getPeerAddress().asString());
 	if (peerSipAddressId < 0)
 		return -1;
@@ -548,6 +718,8 @@ long long MainDbPrivate::selectChatRoomId (const ConferenceId &conferenceId) con
 	long long id = selectChatRoomId(peerSipAddressId, localSipAddressId);
 	if (id != -1) {
 		cache(conferenceId, id);
+		if (batchInsertContext)
+			batchInsertContext->chatRoomIds[conferenceId] = id;
 	}
 
 	return id;
@@ -582,13 +754,9 @@ ConferenceId MainDbPrivate::selectConferenceId (const long long chatRoomId) cons
 
 long long MainDbPrivate::selectChatRoomParticipantId (long long chatRoomId, long long participantSipAddressId) const {
 #ifdef HAVE_DB_STORAGE
-	long long chatRoomParticipantId;
-
-	soci::session *session = dbSession.getBackendSession();
-	*session << Statements::get(Statements::SelectChatRoomParticipantId),
-		soci::use(chatRoomId), soci::use(participantSipAddressId), soci::into(chatRoomParticipantId);
-
-	return session->got_data() ? chatRoomParticipantId : -1;
+	return selectIdFromCachedStatement(
+		dbSession, Statements::SelectChatRoomParticipantId, soci::use(chatRoomId), soci::use(participantSipAddressId)
+	);
 #else
 	return -1;
 #endif
@@ -596,17 +764,14 @@ long long MainDbPrivate::selectChatRoomParticipantId (long long chatRoomId, long
 
 long long MainDbPrivate::selectOneToOneChatRoomId (long long sipAddressIdA, long long sipAddressIdB, bool encrypted) const {
 #ifdef HAVE_DB_STORAGE
-	long long chatRoomId;
 	const int encryptedCapability = int(ChatRoom::Capabilities::Encrypted);
 	const int expectedCapabilities = encrypted ? encryptedCapability : 0;
 
-	soci::session *session = dbSession.getBackendSession();
-	*session << Statements::get(Statements::SelectOneToOneChatRoomId),
+	return selectIdFromCachedStatement(
+		dbSession, Statements::SelectOneToOneChatRoomId,
 		soci::use(sipAddressIdA, "1"), soci::use(sipAddressIdB, "2"),
-		soci::use(encryptedCapability, "3"), soci::use(expectedCapabilities, "4"),
-		soci::into(chatRoomId);
-
-	return session->got_data() ? chatRoomId : -1;
+		soci::use(encryptedCapability, "3"), soci::use(expectedCapabilities, "4")
+	);
 #else
 	return -1;
 #endif
@@ -909,8 +1074,69 @@ shared_ptr<EventLog> MainDbPrivate::selectConferenceSubjectEvent (
 
 // -----------------------------------------------------------------------------
 
+long long MainDbPrivate::insertEventByType (const shared_ptr<EventLog> &eventLog) {
+	switch (eventLog->getType()) {
+		case EventLog::Type::None:
+			return -1;
+
+		case EventLog::Type::ConferenceCreated:
+		case EventLog::Type::ConferenceTerminated:
+			return insertConferenceEvent(eventLog);
+
+		case EventLog::Type::ConferenceCallStart:
+		case EventLog::Type::ConferenceCallEnd:
+			return insertConferenceCallEvent(eventLog);
+
+		case EventLog::Type::ConferenceChatMessage:
+			return insertConferenceChatMessageEvent(eventLog);
+
+		case EventLog::Type::ConferenceParticipantAdded:
+		case EventLog::Type::ConferenceParticipantRemoved:
+		case EventLog::Type::ConferenceParticipantSetAdmin:
+		case EventLog::Type::ConferenceParticipantUnsetAdmin:
+			return insertConferenceParticipantEvent(eventLog);
+
+		case EventLog::Type::ConferenceParticipantDeviceAdded:
+		case EventLog::Type::ConferenceParticipantDeviceRemoved:
+		case EventLog::Type::ConferenceParticipantDeviceMediaChanged:
+			return insertConferenceParticipantDeviceEvent(eventLog);
+
+		case EventLog::Type::ConferenceSecurityEvent:
+			return insertConferenceSecurityEvent(eventLog);
+
+		case EventLog::Type::ConferenceAvailableMediaChanged:
+			return insertConferenceAvailableMediaEvent(eventLog);
+
+		case EventLog::Type::ConferenceSubjectChanged:
+			return insertConferenceSubjectEvent(eventLog);
+
+		case EventLog::Type::ConferenceEphemeralMessageLifetimeChanged:
+		case EventLog::Type::ConferenceEphemeralMessageEnabled:
+		case EventLog::Type::ConferenceEphemeralMessageDisabled:
+		case EventLog::Type::ConferenceEphemeralMessageManagedByAdmin:
+		case EventLog::Type::ConferenceEphemeralMessageManagedByParticipants:
+			return insertConferenceEphemeralMessageEvent(eventLog);
+	}
+
+	return -1;
+}
+
 long long MainDbPrivate::insertEvent (const shared_ptr<EventLog> &eventLog) {
 #ifdef HAVE_DB_STORAGE
+	if (batchInsertContext) {
+		BatchInsertContext &context = *batchInsertContext;
+		if (!context.insertEventStatement)
+			context.insertEventStatement = makeUnique<soci::statement>((dbSession.getBackendSession()->prepare <<
+				"INSERT INTO event (type, creation_time) VALUES (:type, :creationTime)",
+				soci::use(context.eventType), soci::use(context.eventCreationTime)
+			));
+
+		context.eventType = int(eventLog->getType());
+		context.eventCreationTime = Utils::getTimeTAsTm(eventLog->getCreationTime());
+		context.insertEventStatement->execute(true);
+		return dbSession.getLastInsertId();
+	}
+
 	const int &type = int(eventLog->getType());
 	const tm &creationTime = Utils::getTimeTAsTm(eventLog->getCreationTime());
 	*dbSession.getBackendSession() << "INSERT INTO event (type, creation_time) VALUES (:type, :creationTime)",
@@ -1325,25 +1551,9 @@ void MainDbPrivate::setChatMessageParticipantState (
 	MainDbKeyPrivate *dEventKey = static_cast<MainDbKey &>(dEventLog->dbKey).getPrivate();
 	const long long &eventId = dEventKey->storageId;
 
-	/* setChatMessageParticipantState can be called by updateConferenceChatMessageEvent, which try to update participant state
-	 by message state. However, we can not change state Displayed/DeliveredToUser to Delivered/NotDelivered. */
-	int intState;
-	*dbSession.getBackendSession() << "SELECT state FROM chat_message_participant WHERE event_id = :eventId",
-		soci::into(intState),  soci::use(eventId);
-	ChatMessage::State dbState = ChatMessage::State(intState);
-	if (int(state) < intState && (dbState == ChatMessage::State::Displayed || dbState == ChatMessage::State::DeliveredToUser)) {
-		lInfo() << "setChatMessageParticipantState: can not change state from " << dbState << " to " << state;
-		return;
-	}
-
-	const long long &participantSipAddressId = selectSipAddressId(participantAddress.asString());
-	int stateInt = int(state);
-	const tm &stateChangeTm = Utils::getTimeTAsTm(stateChangeTime);
-
-	*dbSession.getBackendSession() << "UPDATE chat_message_participant SET state = :state,"
-		" state_change_time = :stateChangeTm"
-		" WHERE event_id = :eventId AND participant_sip_address_id = :participantSipAddressId",
-		soci::use(stateInt), soci::use(stateChangeTm), soci::use(eventId), soci::use(participantSipAddressId);
+	setChatMessageParticipantStateInSession(
+		dbSession, eventId, selectSipAddressId(participantAddress.asString()), state, Utils::getTimeTAsTm(stateChangeTime)
+	);
 #endif
 }
 
@@ -1637,6 +1847,21 @@ void MainDbPrivate::updateSchema () {
 	if (version < makeVersion(1, 0, 16)) {
 		*session << "ALTER TABLE chat_message_file_content ADD COLUMN duration INT NOT NULL DEFAULT -1";
 	}
+
+	if (version < makeVersion(1, 0, 17)) {
+		// Allow history pages to be fetched by event id without scanning the whole chat room.
+		*session << "CREATE INDEX conference_event_chat_room_index ON conference_event (chat_room_id, event_id)";
+	}
+
+	if (version < makeVersion(1, 0, 18)) {
+		// Expired queued messages are deleted by date.
+		*session << "CREATE INDEX server_chat_room_queued_message_time_index ON server_chat_room_queued_message (chat_room_id, time)";
+	}
+
+	if (version < makeVersion(1, 0, 19)) {
+		// Ephemeral messages are loaded by expire time.
+		*session << "CREATE INDEX chat_message_ephemeral_event_expired_time_index ON chat_message_ephemeral_event (expired_time)";
+	}
 #endif
 }
 
@@ -2312,6 +2537,40 @@ void MainDb::init () {
 			"    ON DELETE CASCADE"
 			") " + charset;
 
+		*session <<
+			"CREATE TABLE IF NOT EXISTS server_chat_room_queued_message ("
+			"  id" + primaryKeyStr("BIGINT UNSIGNED") + ","
+
+			"  chat_room_id" + primaryKeyRefStr("BIGINT UNSIGNED") + " NOT NULL,"
+			"  from_sip_address_id" + primaryKeyRefStr("BIGINT UNSIGNED") + " NOT NULL,"
+			"  content_type VARCHAR(255) NOT NULL,"
+			"  body TEXT,"
+			"  headers TEXT,"
+			"  time" + timestampType() + " NOT NULL,"
+
+			"  FOREIGN KEY (chat_room_id)"
+			"    REFERENCES chat_room(id)"
+			"    ON DELETE CASCADE,"
+			"  FOREIGN KEY (from_sip_address_id)"
+			"    REFERENCES sip_address(id)"
+			"    ON DELETE CASCADE"
+			") " + charset;
+
+		*session <<
+			"CREATE TABLE IF NOT EXISTS server_chat_room_queued_message_device ("
+			"  message_id" + primaryKeyRefStr("BIGINT UNSIGNED") + ","
+			"  device_sip_address_id" + primaryKeyRefStr("BIGINT UNSIGNED") + ","
+
+			"  PRIMARY KEY (message_id, device_sip_address_id),"
+
+			"  FOREIGN KEY (message_id)"
+			"    REFERENCES server_chat_room_queued_message(id)"
+			"    ON DELETE CASCADE,"
+			"  FOREIGN KEY (device_sip_address_id)"
+			"    REFERENCES sip_address(id)"
+			"    ON DELETE CASCADE"
+			") " + charset;
+
 		d->updateSchema();
 
 		d->updateModuleVersion("events", ModuleVersionEvents);
@@ -2332,65 +2591,13 @@ bool MainDb::addEvent (const shared_ptr<EventLog> &eventLog) {
 		return false;
 	}
 
-	return L_DB_TRANSACTION {
-		L_D();
-
-		long long eventId = -1;
+	L_D();
+	d->waitForPendingWrites({ "conference_chat_message_event" });
 
+	return L_DB_TRANSACTION {
 		EventLog::Type type = eventLog->getType();
 		lInfo() << "MainDb::addEvent() of type " << type << " (value " << static_cast<int>(type) << ")";
-		switch (type) {
-			case EventLog::Type::None:
-				return false;
-
-			case EventLog::Type::ConferenceCreated:
-			case EventLog::Type::ConferenceTerminated:
-				eventId = d->insertConferenceEvent(eventLog);
-				break;
-
-			case EventLog::Type::ConferenceCallStart:
-			case EventLog::Type::ConferenceCallEnd:
-				eventId = d->insertConferenceCallEvent(eventLog);
-				break;
-
-			case EventLog::Type::ConferenceChatMessage:
-				eventId = d->insertConferenceChatMessageEvent(eventLog);
-				break;
-
-			case EventLog::Type::ConferenceParticipantAdded:
-			case EventLog::Type::ConferenceParticipantRemoved:
-			case EventLog::Type::ConferenceParticipantSetAdmin:
-			case EventLog::Type::ConferenceParticipantUnsetAdmin:
-				eventId = d->insertConferenceParticipantEvent(eventLog);
-				break;
-
-			case EventLog::Type::ConferenceParticipantDeviceAdded:
-			case EventLog::Type::ConferenceParticipantDeviceRemoved:
-			case EventLog::Type::ConferenceParticipantDeviceMediaChanged:
-				eventId = d->insertConferenceParticipantDeviceEvent(eventLog);
-				break;
-
-			case EventLog::Type::ConferenceSecurityEvent:
-				eventId = d->insertConferenceSecurityEvent(eventLog);
-				break;
-
-			case EventLog::Type::ConferenceAvailableMediaChanged:
-				eventId = d->insertConferenceAvailableMediaEvent(eventLog);
-				break;
-
-			case EventLog::Type::ConferenceSubjectChanged:
-				eventId = d->insertConferenceSubjectEvent(eventLog);
-				break;
-
-			case EventLog::Type::ConferenceEphemeralMessageLifetimeChanged:
-			case EventLog::Type::ConferenceEphemeralMessageEnabled:
-			case EventLog::Type::ConferenceEphemeralMessageDisabled:
-			case EventLog::Type::ConferenceEphemeralMessageManagedByAdmin:
-			case EventLog::Type::ConferenceEphemeralMessageManagedByParticipants:
-				eventId = d->insertConferenceEphemeralMessageEvent(eventLog);
-				break;
-		}
-
+		long long eventId = d->insertEventByType(eventLog);
 		if (eventId >= 0) {
 			tr.commit();
 			d->cache(eventLog, eventId);
@@ -2408,44 +2615,146 @@ bool MainDb::addEvent (const shared_ptr<EventLog> &eventLog) {
 #endif
 }
 
-bool MainDb::updateEvent (const shared_ptr<EventLog> &eventLog) {
+bool MainDb::addEvents (const list<shared_ptr<EventLog>> &eventLogs) {
 #ifdef HAVE_DB_STORAGE
-	if (!eventLog->getPrivate()->dbKey.isValid()) {
-		lWarning() << "Unable to update an event that wasn't inserted yet!!!";
-		return false;
-	}
+	if (eventLogs.empty())
+		return true;
 
-	return L_DB_TRANSACTION {
-		L_D();
+	L_D();
+	d->waitForPendingWrites({ "conference_chat_message_event" });
 
-		switch (eventLog->getType()) {
-			case EventLog::Type::None:
-				return false;
+	bool result = L_DB_TRANSACTION {
+		lInfo() << "MainDb::addEvents() of " << eventLogs.size() << " events.";
 
-			case EventLog::Type::ConferenceChatMessage:
-				d->updateConferenceChatMessageEvent(eventLog);
-				break;
+		// Lookups of sip addresses, content types and chat rooms are shared by all events of the batch
+		// and the event insertion statement is prepared only once.
+		d->batchInsertContext = makeUnique<MainDbPrivate::BatchInsertContext>();
 
-			case EventLog::Type::ConferenceCreated:
-			case EventLog::Type::ConferenceTerminated:
-			case EventLog::Type::ConferenceCallStart:
-			case EventLog::Type::ConferenceCallEnd:
-			case EventLog::Type::ConferenceParticipantAdded:
-			case EventLog::Type::ConferenceParticipantRemoved:
-			case EventLog::Type::ConferenceParticipantSetAdmin:
-			case EventLog::Type::ConferenceParticipantUnsetAdmin:
-			case EventLog::Type::ConferenceParticipantDeviceAdded:
-			case EventLog::Type::ConferenceParticipantDeviceRemoved:
-			case EventLog::Type::ConferenceParticipantDeviceMediaChanged:
-			case EventLog::Type::ConferenceSecurityEvent:
-			case EventLog::Type::ConferenceAvailableMediaChanged:
-			case EventLog::Type::ConferenceSubjectChanged:
-			case EventLog::Type::ConferenceEphemeralMessageLifetimeChanged:
-			case EventLog::Type::ConferenceEphemeralMessageEnabled:
-			case EventLog::Type::ConferenceEphemeralMessageDisabled:
-			case EventLog::Type::ConferenceEphemeralMessageManagedByAdmin:
-			case EventLog::Type::ConferenceEphemeralMessageManagedByParticipants:
-				return false;
+		bool allInserted = true;
+		list<pair<shared_ptr<EventLog>, long long>> insertedEvents;
+		for (const auto &eventLog : eventLogs) {
+			if (eventLog->getPrivate()->dbKey.isValid()) {
+				lWarning() << "Unable to add an event twice!!!";
+				allInserted = false;
+				continue;
+			}
+
+			long long eventId = d->insertEventByType(eventLog);
+			if (eventId < 0) {
+				lError() << "MainDb::addEvents() failed to insert event of type " << eventLog->getType() << ".";
+				allInserted = false;
+				continue;
+			}
+			insertedEvents.emplace_back(eventLog, eventId);
+		}
+
+		d->batchInsertContext.reset();
+		tr.commit();
+
+		d->storageIdToEvent.reserve(d->storageIdToEvent.size() + insertedEvents.size());
+		for (const auto &insertedEvent : insertedEvents) {
+			const shared_ptr<EventLog> &eventLog = insertedEvent.first;
+			d->cache(eventLog, insertedEvent.second);
+			if (eventLog->getType() == EventLog::Type::ConferenceChatMessage)
+				d->cache(static_pointer_cast<ConferenceChatMessageEvent>(eventLog)->getChatMessage(), insertedEvent.second);
+		}
+
+		return allInserted;
+	};
+
+	// Also reached when the transaction failed.
+	d->batchInsertContext.reset();
+	return result;
+#else
+	return false;
+#endif
+}
+
+void MainDb::setEventQueueParameters (unsigned int maxSize, unsigned int windowMs) {
+	L_D();
+
+	flushQueuedEvents();
+	if (d->queuedEventsTimer) {
+		getCore()->destroyTimer(d->queuedEventsTimer);
+		d->queuedEventsTimer = nullptr;
+	}
+
+	d->eventQueueMaxSize = maxSize;
+	if (maxSize == 0)
+		return;
+
+	lInfo() << "MainDb events are stored by batches of at most " << maxSize << " events or every " << windowMs << " ms.";
+	if (windowMs > 0) {
+		d->queuedEventsTimer = getCore()->createTimer([this]() -> bool {
+			flushQueuedEvents();
+			return true;
+		}, windowMs, "MainDb queued events flush");
+	}
+}
+
+void MainDb::queueEvent (const shared_ptr<EventLog> &eventLog) {
+	L_D();
+
+	if (d->eventQueueMaxSize == 0) {
+		addEvent(eventLog);
+		return;
+	}
+
+	d->queuedEvents.push_back(eventLog);
+	if (d->queuedEvents.size() >= d->eventQueueMaxSize)
+		flushQueuedEvents();
+}
+
+void MainDb::flushQueuedEvents () {
+	L_D();
+
+	if (d->queuedEvents.empty())
+		return;
+
+	list<shared_ptr<EventLog>> eventLogs;
+	eventLogs.swap(d->queuedEvents);
+	addEvents(eventLogs);
+}
+
+bool MainDb::updateEvent (const shared_ptr<EventLog> &eventLog) {
+#ifdef HAVE_DB_STORAGE
+	if (!eventLog->getPrivate()->dbKey.isValid()) {
+		lWarning() << "Unable to update an event that wasn't inserted yet!!!";
+		return false;
+	}
+
+	L_D();
+	d->waitForPendingWrites({ "conference_chat_message_event", "chat_message_participant" });
+
+	return L_DB_TRANSACTION {
+		switch (eventLog->getType()) {
+			case EventLog::Type::None:
+				return false;
+
+			case EventLog::Type::ConferenceChatMessage:
+				d->updateConferenceChatMessageEvent(eventLog);
+				break;
+
+			case EventLog::Type::ConferenceCreated:
+			case EventLog::Type::ConferenceTerminated:
+			case EventLog::Type::ConferenceCallStart:
+			case EventLog::Type::ConferenceCallEnd:
+			case EventLog::Type::ConferenceParticipantAdded:
+			case EventLog::Type::ConferenceParticipantRemoved:
+			case EventLog::Type::ConferenceParticipantSetAdmin:
+			case EventLog::Type::ConferenceParticipantUnsetAdmin:
+			case EventLog::Type::ConferenceParticipantDeviceAdded:
+			case EventLog::Type::ConferenceParticipantDeviceRemoved:
+			case EventLog::Type::ConferenceParticipantDeviceMediaChanged:
+			case EventLog::Type::ConferenceSecurityEvent:
+			case EventLog::Type::ConferenceAvailableMediaChanged:
+			case EventLog::Type::ConferenceSubjectChanged:
+			case EventLog::Type::ConferenceEphemeralMessageLifetimeChanged:
+			case EventLog::Type::ConferenceEphemeralMessageEnabled:
+			case EventLog::Type::ConferenceEphemeralMessageDisabled:
+			case EventLog::Type::ConferenceEphemeralMessageManagedByAdmin:
+			case EventLog::Type::ConferenceEphemeralMessageManagedByParticipants:
+				return false;
 		}
 
 		tr.commit();
@@ -2470,6 +2779,7 @@ bool MainDb::deleteEvent (const shared_ptr<const EventLog> &eventLog) {
 	L_ASSERT(core);
 
 	MainDb &mainDb = *core->getPrivate()->mainDb.get();
+	mainDb.getPrivate()->waitForPendingWrites();
 
 	return L_DB_TRANSACTION_C(&mainDb) {
 		MainDbPrivate *const d = mainDb.getPrivate();
@@ -2507,6 +2817,78 @@ bool MainDb::deleteEvent (const shared_ptr<const EventLog> &eventLog) {
 #endif
 }
 
+bool MainDb::deleteEvents (const list<shared_ptr<const EventLog>> &eventLogs) {
+#ifdef HAVE_DB_STORAGE
+	list<pair<shared_ptr<const EventLog>, long long>> validEventLogs;
+	for (const auto &eventLog : eventLogs) {
+		const EventLogPrivate *dEventLog = eventLog->getPrivate();
+		if (!dEventLog->dbKey.isValid()) {
+			lWarning() << "Unable to delete invalid event.";
+			continue;
+		}
+		validEventLogs.emplace_back(eventLog, static_cast<MainDbKey &>(dEventLog->dbKey).getPrivate()->storageId);
+	}
+
+	if (validEventLogs.empty())
+		return validEventLogs.size() == eventLogs.size();
+
+	L_D();
+	d->waitForPendingWrites();
+
+	bool result = L_DB_TRANSACTION {
+		lInfo() << "MainDb::deleteEvents() of " << validEventLogs.size() << " events.";
+
+		soci::session *session = d->dbSession.getBackendSession();
+
+		long long eventId;
+		soci::statement deleteStatement = (session->prepare << "DELETE FROM event WHERE id = :id", soci::use(eventId));
+
+		set<long long> dbChatRoomIds;
+		for (const auto &validEventLog : validEventLogs) {
+			eventId = validEventLog.second;
+			deleteStatement.execute(true);
+
+			const shared_ptr<const EventLog> &eventLog = validEventLog.first;
+			if (eventLog->getType() == EventLog::Type::ConferenceChatMessage) {
+				shared_ptr<ChatMessage> chatMessage(static_pointer_cast<const ConferenceChatMessageEvent>(eventLog)->getChatMessage());
+				dbChatRoomIds.insert(d->selectChatRoomId(chatMessage->getChatRoom()->getConferenceId()));
+			}
+		}
+
+		long long dbChatRoomId;
+		soci::statement lastMessageStatement = (session->prepare << "UPDATE chat_room SET last_message_id = IFNULL((SELECT id FROM conference_event_simple_view WHERE chat_room_id = chat_room.id AND type = " << mapEventFilterToSql(ConferenceChatMessageFilter) << " ORDER BY id DESC LIMIT 1), 0) WHERE id = :1", soci::use(dbChatRoomId));
+		for (long long id : dbChatRoomIds) {
+			dbChatRoomId = id;
+			lastMessageStatement.execute(true);
+		}
+
+		tr.commit();
+
+		for (const auto &validEventLog : validEventLogs) {
+			const shared_ptr<const EventLog> &eventLog = validEventLog.first;
+			const_cast<EventLogPrivate *>(eventLog->getPrivate())->resetStorageId();
+
+			if (eventLog->getType() != EventLog::Type::ConferenceChatMessage)
+				continue;
+
+			shared_ptr<ChatMessage> chatMessage(static_pointer_cast<const ConferenceChatMessageEvent>(eventLog)->getChatMessage());
+			chatMessage->getPrivate()->resetStorageId();
+			if (chatMessage->getDirection() == ChatMessage::Direction::Incoming && !chatMessage->getPrivate()->isMarkedAsRead()) {
+				int *count = d->unreadChatMessageCountCache[chatMessage->getChatRoom()->getConferenceId()];
+				if (count)
+					--*count;
+			}
+		}
+
+		return true;
+	};
+
+	return result && validEventLogs.size() == eventLogs.size();
+#else
+	return false;
+#endif
+}
+
 int MainDb::getEventCount (FilterMask mask) const {
 #ifdef HAVE_DB_STORAGE
 	const string query = "SELECT COUNT(*) FROM event" +
@@ -2542,6 +2924,8 @@ shared_ptr<EventLog> MainDb::getEvent (const unique_ptr<MainDb> &mainDb, const l
 	if (event)
 		return event;
 
+	d->waitForPendingWrites({ "conference_chat_message_event", "chat_message_ephemeral_event" });
+
 	return L_DB_TRANSACTION_C(mainDb.get()) {
 		// TODO: Improve. Deal with all events in the future.
 		soci::row row;
@@ -2610,6 +2994,33 @@ list<shared_ptr<EventLog>> MainDb::getConferenceNotifiedEvents (
 #endif
 }
 
+int MainDb::getConferenceNotifiedEventCount (
+	const ConferenceId &conferenceId,
+	unsigned int lastNotifyId
+) const {
+#ifdef HAVE_DB_STORAGE
+	static const string query = "SELECT COUNT(*) FROM conference_notified_event"
+		"  JOIN conference_event ON conference_event.event_id = conference_notified_event.event_id"
+		"  WHERE conference_event.chat_room_id = :chatRoomId AND conference_notified_event.notify_id > :lastNotifyId";
+
+	return L_DB_TRANSACTION {
+		L_D();
+
+		int count = 0;
+
+		const long long &dbChatRoomId = d->selectChatRoomId(conferenceId);
+		if (dbChatRoomId < 0)
+			return count;
+
+		soci::session *session = d->dbSession.getBackendSession();
+		*session << query, soci::use(dbChatRoomId), soci::use(lastNotifyId), soci::into(count);
+		return count;
+	};
+#else
+	return 0;
+#endif
+}
+
 int MainDb::getChatMessageCount (const ConferenceId &conferenceId) const {
 #ifdef HAVE_DB_STORAGE
 	/*
@@ -2670,6 +3081,8 @@ int MainDb::getUnreadChatMessageCount (const ConferenceId &conferenceId) const {
 	);
 	*/
 
+	d->waitForPendingWrites({ "conference_chat_message_event" });
+
 	return L_DB_TRANSACTION {
 		int count = 0;
 
@@ -2709,15 +3122,27 @@ void MainDb::markChatMessagesAsRead (const ConferenceId &conferenceId) const {
 	);
 	*/
 
-	L_DB_TRANSACTION {
-		L_D();
+	L_D();
 
-		const long long &dbChatRoomId = d->selectChatRoomId(conferenceId);
-		*d->dbSession.getBackendSession() << query, soci::use(dbChatRoomId);
+	if (!d->dbWorker) {
+		const bool marked = L_DB_TRANSACTION {
+			const long long &dbChatRoomId = d->selectChatRoomId(conferenceId);
+			*d->dbSession.getBackendSession() << query, soci::use(dbChatRoomId);
+			tr.commit();
+		};
+		if (marked)
+			d->unreadChatMessageCountCache.insert(conferenceId, 0);
+		return;
+	}
 
-		tr.commit();
-		d->unreadChatMessageCountCache.insert(conferenceId, 0);
-	};
+	const string peerAddress = conferenceId.getPeerAddress().asString();
+	const string localAddress = conferenceId.getLocalAddress().asString();
+	d->executeWrite("markChatMessagesAsRead", "conference_chat_message_event", [peerAddress, localAddress](const DbSession &dbSession) {
+		const long long dbChatRoomId = selectChatRoomIdInSession(dbSession, peerAddress, localAddress);
+		*dbSession.getBackendSession() << query, soci::use(dbChatRoomId);
+	});
+	// The write may still fail in the worker, the count is read again once it is done.
+	d->unreadChatMessageCountCache.erase(conferenceId);
 #endif
 }
 
@@ -2727,13 +3152,14 @@ void MainDb::updateChatRoomEphemeralEnabled (const ConferenceId &conferenceId, b
 	"  SET ephemeral_enabled = :ephemeralEnabled"
 	" WHERE id = :chatRoomId";
 
-	L_DB_TRANSACTION {
-		L_D();
-		const long long &dbChatRoomId = d->selectChatRoomId(conferenceId);
-		*d->dbSession.getBackendSession() << query, soci::use(ephemeralEnabled ? 1:0), soci::use(dbChatRoomId);
+	L_D();
 
-		tr.commit();
-	};
+	const string peerAddress = conferenceId.getPeerAddress().asString();
+	const string localAddress = conferenceId.getLocalAddress().asString();
+	d->executeWrite("updateChatRoomEphemeralEnabled", "chat_room", [peerAddress, localAddress, ephemeralEnabled](const DbSession &dbSession) {
+		const long long dbChatRoomId = selectChatRoomIdInSession(dbSession, peerAddress, localAddress);
+		*dbSession.getBackendSession() << query, soci::use(ephemeralEnabled ? 1:0), soci::use(dbChatRoomId);
+	});
 #endif
 }
 
@@ -2743,13 +3169,14 @@ void MainDb::updateChatRoomEphemeralLifetime (const ConferenceId &conferenceId,
 	"  SET ephemeral_messages_lifetime = :ephemeralLifetime"
 	" WHERE id = :chatRoomId";
 
-	L_DB_TRANSACTION {
-		L_D();
-		const long long &dbChatRoomId = d->selectChatRoomId(conferenceId);
-		*d->dbSession.getBackendSession() << query, soci::use(time), soci::use(dbChatRoomId);
+	L_D();
 
-		tr.commit();
-	};
+	const string peerAddress = conferenceId.getPeerAddress().asString();
+	const string localAddress = conferenceId.getLocalAddress().asString();
+	d->executeWrite("updateChatRoomEphemeralLifetime", "chat_room", [peerAddress, localAddress, time](const DbSession &dbSession) {
+		const long long dbChatRoomId = selectChatRoomIdInSession(dbSession, peerAddress, localAddress);
+		*dbSession.getBackendSession() << query, soci::use(time), soci::use(dbChatRoomId);
+	});
 #endif
 }
 
@@ -2759,12 +3186,13 @@ void MainDb::updateEphemeralMessageInfos (const long long &eventId, const time_t
 	"  SET expired_time = :expireTime"
 	"  WHERE event_id = :eventId";
 
-	L_DB_TRANSACTION {
-		L_D();
-		const tm &expireTime = Utils::getTimeTAsTm(eTime);
-		*d->dbSession.getBackendSession() << query, soci::use(expireTime), soci::use(eventId);
-		tr.commit();
-	};
+	L_D();
+
+	const tm expireTime = Utils::getTimeTAsTm(eTime);
+	const long long id = eventId;
+	d->executeWrite("updateEphemeralMessageInfos", "chat_message_ephemeral_event", [expireTime, id](const DbSession &dbSession) {
+		*dbSession.getBackendSession() << query, soci::use(expireTime), soci::use(id);
+	});
 #endif
 }
 
@@ -2779,9 +3207,10 @@ list<shared_ptr<ChatMessage>> MainDb::getUnreadChatMessages (const ConferenceId
 		", local=" + conferenceId.getLocalAddress().asString() + ")."
 	);
 
-	return L_DB_TRANSACTION {
-		L_D();
+	L_D();
+	d->waitForPendingWrites({ "conference_chat_message_event", "chat_message_ephemeral_event" });
 
+	return L_DB_TRANSACTION {
 		soci::session *session = d->dbSession.getBackendSession();
 
 		long long dbChatRoomId = d->selectChatRoomId(conferenceId);
@@ -2808,10 +3237,10 @@ list<shared_ptr<ChatMessage>> MainDb::getUnreadChatMessages (const ConferenceId
 #endif
 }
 
-list<shared_ptr<ChatMessage>> MainDb::getEphemeralMessages () const {
+list<shared_ptr<ChatMessage>> MainDb::getEphemeralMessages (unsigned int maxCount) const {
 #ifdef HAVE_DB_STORAGE
 	// Keep chat_room_id at the end of the query !!!
-	string query =
+	static const string query =
 		"SELECT conference_event_view.id AS event_id, type, creation_time, from_sip_address.value, to_sip_address.value, time, imdn_message_id, state, direction, is_secured, notify_id, device_sip_address.value, participant_sip_address.value, subject, delivery_notification_required, display_notification_required, security_alert, faulty_device, marked_as_read, forward_info, ephemeral_lifetime, expired_time, lifetime, reply_message_id, reply_sender_address.value, chat_room_id"
 		" FROM conference_event_view"
 		" LEFT JOIN sip_address AS from_sip_address ON from_sip_address.id = from_sip_address_id"
@@ -2819,17 +3248,24 @@ list<shared_ptr<ChatMessage>> MainDb::getEphemeralMessages () const {
 		" LEFT JOIN sip_address AS device_sip_address ON device_sip_address.id = device_sip_address_id"
 		" LEFT JOIN sip_address AS participant_sip_address ON participant_sip_address.id = participant_sip_address_id"
 		" LEFT JOIN sip_address AS reply_sender_address ON reply_sender_address.id = reply_sender_address_id"
-		" WHERE event_id in ("
-		" SELECT event_id"
-		" FROM chat_message_ephemeral_event"
-		" WHERE expired_time > :nullTime"
-		" ORDER BY expired_time ASC";
-	query += getBackend() == MainDb::Backend::Sqlite3 ? " LIMIT :maxMessages) ORDER BY expired_time ASC" : " ) ORDER BY expired_time ASC";
+		" WHERE event_id IN ("
+		// The derived table allows the limit with MySQL, the index on expired_time avoids a sort.
+		"  SELECT event_id FROM ("
+		"   SELECT event_id"
+		"   FROM chat_message_ephemeral_event"
+		"   WHERE expired_time > :nullTime"
+		"   ORDER BY expired_time ASC"
+		"   LIMIT :maxMessages"
+		"  ) AS next_ephemeral_event"
+		" ) ORDER BY expired_time ASC";
+
+	L_D();
+	d->waitForPendingWrites({ "conference_chat_message_event", "chat_message_ephemeral_event" });
 
 	return L_DB_TRANSACTION {
-		L_D();
 		list<shared_ptr<ChatMessage>> chatMessages;
-		soci::rowset<soci::row> rows = getBackend() == MainDb::Backend::Sqlite3 ? (d->dbSession.getBackendSession()->prepare << query, soci::use(Utils::getTimeTAsTm(0)),  soci::use(EPHEMERAL_MESSAGE_TASKS_MAX_NB)) : (d->dbSession.getBackendSession()->prepare << query, soci::use(Utils::getTimeTAsTm(0)));
+		const tm nullTime = Utils::getTimeTAsTm(0);
+		soci::rowset<soci::row> rows = (d->dbSession.getBackendSession()->prepare << query, soci::use(nullTime), soci::use(maxCount));
 		for (const auto &row : rows) {
 			const long long &dbChatRoomId = d->dbSession.resolveId(row, (int)row.size()-1);
 			ConferenceId conferenceId = d->getConferenceIdFromCache(dbChatRoomId);
@@ -2860,9 +3296,10 @@ list<MainDb::ParticipantState> MainDb::getChatMessageParticipantsByImdnState (
 	ChatMessage::State state
 ) const {
 #ifdef HAVE_DB_STORAGE
-	return L_DB_TRANSACTION {
-		L_D();
+	L_D();
+	d->waitForPendingWrites({ "chat_message_participant" });
 
+	return L_DB_TRANSACTION {
 		const EventLogPrivate *dEventLog = eventLog->getPrivate();
 		MainDbKeyPrivate *dEventKey = static_cast<MainDbKey &>(dEventLog->dbKey).getPrivate();
 		const long long &eventId = dEventKey->storageId;
@@ -2888,9 +3325,10 @@ list<MainDb::ParticipantState> MainDb::getChatMessageParticipantsByImdnState (
 
 list<ChatMessage::State> MainDb::getChatMessageParticipantStates (const shared_ptr<EventLog> &eventLog) const {
 #ifdef HAVE_DB_STORAGE
-	return L_DB_TRANSACTION {
-		L_D();
+	L_D();
+	d->waitForPendingWrites({ "chat_message_participant" });
 
+	return L_DB_TRANSACTION {
 		const EventLogPrivate *dEventLog = eventLog->getPrivate();
 		MainDbKeyPrivate *dEventKey = static_cast<MainDbKey &>(dEventLog->dbKey).getPrivate();
 		const long long &eventId = dEventKey->storageId;
@@ -2918,9 +3356,10 @@ ChatMessage::State MainDb::getChatMessageParticipantState (
 	const IdentityAddress &participantAddress
 ) const {
 #ifdef HAVE_DB_STORAGE
-	return L_DB_TRANSACTION {
-		L_D();
+	L_D();
+	d->waitForPendingWrites({ "chat_message_participant" });
 
+	return L_DB_TRANSACTION {
 		const EventLogPrivate *dEventLog = eventLog->getPrivate();
 		MainDbKeyPrivate *dEventKey = static_cast<MainDbKey &>(dEventLog->dbKey).getPrivate();
 		const long long &eventId = dEventKey->storageId;
@@ -2945,11 +3384,27 @@ void MainDb::setChatMessageParticipantState (
 	time_t stateChangeTime
 ) {
 #ifdef HAVE_DB_STORAGE
-	L_DB_TRANSACTION {
-		L_D();
-		d->setChatMessageParticipantState(eventLog, participantAddress, state, stateChangeTime);
-		tr.commit();
-	};
+	L_D();
+
+	if (!d->dbWorker) {
+		L_DB_TRANSACTION {
+			d->setChatMessageParticipantState(eventLog, participantAddress, state, stateChangeTime);
+			tr.commit();
+		};
+		return;
+	}
+
+	const long long eventId = static_cast<MainDbKey &>(eventLog->getPrivate()->dbKey).getPrivate()->storageId;
+	const string participant = participantAddress.asString();
+	const tm stateChangeTm = Utils::getTimeTAsTm(stateChangeTime);
+	d->executeWrite("setChatMessageParticipantState", "chat_message_participant",
+		[eventId, participant, state, stateChangeTm](const DbSession &dbSession) {
+			const long long participantSipAddressId = selectIdFromCachedStatement(
+				dbSession, Statements::SelectSipAddressId, soci::use(participant)
+			);
+			setChatMessageParticipantStateInSession(dbSession, eventId, participantSipAddressId, state, stateChangeTm);
+		}
+	);
 #endif
 }
 
@@ -2989,9 +3444,10 @@ shared_ptr<ChatMessage> MainDb::getLastChatMessage (const ConferenceId &conferen
 			" LEFT JOIN sip_address AS reply_sender_address ON reply_sender_address.id = reply_sender_address_id"
 			" WHERE event_id = (SELECT last_message_id FROM chat_room WHERE id = :1)";
 
-	return L_DB_TRANSACTION {
-		L_D();
+	L_D();
+	d->waitForPendingWrites({ "conference_chat_message_event", "chat_message_ephemeral_event" });
 
+	return L_DB_TRANSACTION {
 		soci::session *session = d->dbSession.getBackendSession();
 		shared_ptr<ChatMessage> chatMessage = nullptr;
 
@@ -3029,9 +3485,10 @@ list<shared_ptr<ChatMessage>> MainDb::findChatMessages (
 		", local=" + conferenceId.getLocalAddress().asString() + ")."
 	);
 	*/
-	return L_DB_TRANSACTION {
-		L_D();
+	L_D();
+	d->waitForPendingWrites({ "conference_chat_message_event", "chat_message_ephemeral_event" });
 
+	return L_DB_TRANSACTION {
 		shared_ptr<AbstractChatRoom> chatRoom = d->findChatRoom(conferenceId);
 		list<shared_ptr<ChatMessage>> chatMessages;
 		if (!chatRoom)
@@ -3068,9 +3525,10 @@ list<shared_ptr<ChatMessage>> MainDb::findChatMessagesFromCallId (const std::str
 			" LEFT JOIN sip_address AS reply_sender_address ON reply_sender_address.id = reply_sender_address_id"
 			" WHERE call_id = :callId";
 
-	return L_DB_TRANSACTION {
-		L_D();
+	L_D();
+	d->waitForPendingWrites({ "conference_chat_message_event", "chat_message_ephemeral_event" });
 
+	return L_DB_TRANSACTION {
 		list<shared_ptr<ChatMessage>> chatMessages;
 		soci::rowset<soci::row> rows = (
 			d->dbSession.getBackendSession()->prepare << query, soci::use(callId)
@@ -3122,9 +3580,10 @@ list<shared_ptr<ChatMessage>> MainDb::findChatMessagesToBeNotifiedAsDelivered ()
 	);
 	*/
 
-	return L_DB_TRANSACTION {
-		L_D();
+	L_D();
+	d->waitForPendingWrites({ "conference_chat_message_event", "chat_message_ephemeral_event" });
 
+	return L_DB_TRANSACTION {
 		list<shared_ptr<ChatMessage>> chatMessages;
 		const int &direction = int(ChatMessage::Direction::Incoming);
 		soci::rowset<soci::row> rows = (
@@ -3184,9 +3643,7 @@ list<shared_ptr<EventLog>> MainDb::getHistoryRange (
 		return events;
 	}
 
-	string query = Statements::get(Statements::SelectConferenceEvents) + buildSqlEventFilter({
-		ConferenceCallFilter, ConferenceChatMessageFilter, ConferenceInfoFilter, ConferenceInfoNoDeviceFilter, ConferenceChatMessageSecurityFilter
-	}, mask, "AND");
+	string query = d->getConferenceEventsQuery(mask);
 	query += " ORDER BY event_id DESC";
 
 	if (end > 0)
@@ -3205,6 +3662,8 @@ list<shared_ptr<EventLog>> MainDb::getHistoryRange (
 	);
 	*/
 
+	d->waitForPendingWrites({ "conference_chat_message_event", "chat_message_ephemeral_event" });
+
 	return L_DB_TRANSACTION {
 		L_D();
 
@@ -3227,6 +3686,72 @@ list<shared_ptr<EventLog>> MainDb::getHistoryRange (
 #endif
 }
 
+list<shared_ptr<EventLog>> MainDb::getHistoryBefore (
+	const ConferenceId &conferenceId,
+	long long lastEventId,
+	int count,
+	FilterMask mask
+) const {
+#ifdef HAVE_DB_STORAGE
+	list<shared_ptr<EventLog>> events;
+	if (count <= 0) {
+		lWarning() << "Unable to get history. Invalid count.";
+		return events;
+	}
+
+	L_D();
+
+	// Keyset pagination: the cost of a page does not depend on its depth in the history.
+	string query = d->getConferenceEventsQuery(mask);
+	if (lastEventId >= 0)
+		query += " AND conference_event_view.id < :lastEventId";
+	query += " ORDER BY event_id DESC LIMIT " + Utils::toString(count);
+
+	d->waitForPendingWrites({ "conference_chat_message_event", "chat_message_ephemeral_event" });
+
+	return L_DB_TRANSACTION {
+		L_D();
+
+		shared_ptr<AbstractChatRoom> chatRoom = d->findChatRoom(conferenceId);
+		if (!chatRoom)
+			return events;
+
+		const long long &dbChatRoomId = d->selectChatRoomId(conferenceId);
+		soci::session *session = d->dbSession.getBackendSession();
+		soci::rowset<soci::row> rows = lastEventId >= 0
+			? (session->prepare << query, soci::use(dbChatRoomId), soci::use(lastEventId))
+			: (session->prepare << query, soci::use(dbChatRoomId));
+		for (const auto &row : rows) {
+			shared_ptr<EventLog> event = d->selectGenericConferenceEvent(chatRoom, row);
+			if (event)
+				events.push_front(event);
+		}
+
+		return events;
+	};
+#else
+	return list<shared_ptr<EventLog>>();
+#endif
+}
+
+list<shared_ptr<EventLog>> MainDb::getHistoryBefore (
+	const ConferenceId &conferenceId,
+	const shared_ptr<const EventLog> &lastEvent,
+	int count,
+	FilterMask mask
+) const {
+	long long lastEventId = -1;
+	if (lastEvent) {
+		const EventLogPrivate *dEventLog = lastEvent->getPrivate();
+		if (!dEventLog->dbKey.isValid()) {
+			lWarning() << "Unable to get history before an event that is not stored.";
+			return list<shared_ptr<EventLog>>();
+		}
+		lastEventId = static_cast<const MainDbKey &>(dEventLog->dbKey).getPrivate()->storageId;
+	}
+	return getHistoryBefore(conferenceId, lastEventId, count, mask);
+}
+
 int MainDb::getHistorySize (const ConferenceId &conferenceId, FilterMask mask) const {
 #ifdef HAVE_DB_STORAGE
 	const string query = "SELECT COUNT(*) FROM event, conference_event"
@@ -3267,9 +3792,10 @@ void MainDb::cleanHistory (const ConferenceId &conferenceId, FilterMask mask) {
 	);
 	*/
 
-	L_DB_TRANSACTION {
-		L_D();
+	L_D();
+	d->waitForPendingWrites();
 
+	L_DB_TRANSACTION {
 		const long long &dbChatRoomId = d->selectChatRoomId(conferenceId);
 
 		d->invalidConferenceEventsFromQuery(query, dbChatRoomId);
@@ -3375,202 +3901,331 @@ void MainDb::loadChatMessageContents (const shared_ptr<ChatMessage> &chatMessage
 
 void MainDb::disableDeliveryNotificationRequired (const std::shared_ptr<const EventLog> &eventLog) {
 #ifdef HAVE_DB_STORAGE
-	shared_ptr<ChatMessage> chatMessage(static_pointer_cast<const ConferenceChatMessageEvent>(eventLog)->getChatMessage());
-	const long long &eventId = static_cast<MainDbKey &>(eventLog->getPrivate()->dbKey).getPrivate()->storageId;
+	L_D();
 
-	L_DB_TRANSACTION {
-		L_D();
-		*d->dbSession.getBackendSession() << "UPDATE conference_chat_message_event SET delivery_notification_required = 0"
+	const long long eventId = static_cast<MainDbKey &>(eventLog->getPrivate()->dbKey).getPrivate()->storageId;
+	d->executeWrite("disableDeliveryNotificationRequired", "conference_chat_message_event", [eventId](const DbSession &dbSession) {
+		*dbSession.getBackendSession() << "UPDATE conference_chat_message_event SET delivery_notification_required = 0"
 			" WHERE event_id = :eventId", soci::use(eventId);
-		tr.commit();
-	};
+	});
 #endif
 }
 
 void MainDb::disableDisplayNotificationRequired (const std::shared_ptr<const EventLog> &eventLog) {
 #ifdef HAVE_DB_STORAGE
-	shared_ptr<ChatMessage> chatMessage(static_pointer_cast<const ConferenceChatMessageEvent>(eventLog)->getChatMessage());
-	const long long &eventId = static_cast<MainDbKey &>(eventLog->getPrivate()->dbKey).getPrivate()->storageId;
+	L_D();
 
-	L_DB_TRANSACTION {
-		L_D();
-		*d->dbSession.getBackendSession() << "UPDATE conference_chat_message_event"
+	const long long eventId = static_cast<MainDbKey &>(eventLog->getPrivate()->dbKey).getPrivate()->storageId;
+	d->executeWrite("disableDisplayNotificationRequired", "conference_chat_message_event", [eventId](const DbSession &dbSession) {
+		*dbSession.getBackendSession() << "UPDATE conference_chat_message_event"
 			" SET delivery_notification_required = 0, display_notification_required = 0"
 			" WHERE event_id = :eventId", soci::use(eventId);
-		tr.commit();
-	};
+	});
 #endif
 }
 
 // -----------------------------------------------------------------------------
 
-list<shared_ptr<AbstractChatRoom>> MainDb::getChatRooms () const {
 #ifdef HAVE_DB_STORAGE
+list<MainDbPrivate::ChatRoomRecord> MainDbPrivate::selectChatRoomRecords (
+	const DbSession &dbSession,
+	bool isMysql,
+	long long chatRoomId
+) {
 	static const string query = "SELECT chat_room.id, peer_sip_address.value, local_sip_address.value,"
 		" creation_time, last_update_time, capabilities, subject, last_notify_id, flags, last_message_id,"
 		" ephemeral_enabled, ephemeral_messages_lifetime"
 		" FROM chat_room, sip_address AS peer_sip_address, sip_address AS local_sip_address"
-		" WHERE chat_room.peer_sip_address_id = peer_sip_address.id AND chat_room.local_sip_address_id = local_sip_address.id"
-		" ORDER BY last_update_time DESC";
+		" WHERE chat_room.peer_sip_address_id = peer_sip_address.id AND chat_room.local_sip_address_id = local_sip_address.id";
+	static const string allChatRoomsQuery = query + " ORDER BY last_update_time DESC";
+	static const string oneChatRoomQuery = query + " AND chat_room.id = :chatRoomId";
 
-	DurationLogger durationLogger("Get chat rooms.");
+	list<ChatRoomRecord> records;
+	soci::session *session = dbSession.getBackendSession();
 
-	return L_DB_TRANSACTION {
-		L_D();
+	soci::rowset<soci::row> rows = chatRoomId < 0
+		? (session->prepare << allChatRoomsQuery)
+		: (session->prepare << oneChatRoomQuery, soci::use(chatRoomId));
+	for (const auto &row : rows) {
+		ChatRoomRecord record;
+		record.id = dbSession.resolveId(row, 0);
+		record.peerAddress = row.get<string>(1);
+		record.localAddress = row.get<string>(2);
+		record.creationTime = dbSession.getTime(row, 3);
+		record.lastUpdateTime = dbSession.getTime(row, 4);
+		record.capabilities = row.get<int>(5);
+		record.subject = row.get<string>(6, "");
+		record.lastNotifyId = isMysql
+			? row.get<unsigned int>(7, 0)
+			: static_cast<unsigned int>(row.get<int>(7, 0));
+		record.hasBeenLeft = !!row.get<int>(8, 0);
+		record.lastMessageId = dbSession.resolveId(row, 9);
+		record.ephemeralEnabled = !!row.get<int>(10, 0);
+		record.ephemeralLifetime = (long)row.get<double>(11);
+		records.push_back(move(record));
+	}
 
-		list<shared_ptr<AbstractChatRoom>> chatRooms;
-		shared_ptr<Core> core = getCore();
+#ifdef HAVE_ADVANCED_IM
+	for (auto &record : records) {
+		if (!(record.capabilities & ChatRoom::CapabilitiesMask(ChatRoom::Capabilities::Conference)))
+			continue;
 
-		soci::session *session = d->dbSession.getBackendSession();
+		// Fetch participants.
+		static const string query = "SELECT chat_room_participant.id, sip_address.value, is_admin"
+			" FROM sip_address, chat_room, chat_room_participant"
+			" WHERE chat_room.id = :chatRoomId"
+			" AND sip_address.id = chat_room_participant.participant_sip_address_id"
+			" AND chat_room_participant.chat_room_id = chat_room.id";
 
-		soci::rowset<soci::row> rows = (session->prepare << query);
+		soci::rowset<soci::row> rows = (session->prepare << query, soci::use(record.id));
 		for (const auto &row : rows) {
-			ConferenceId conferenceId = ConferenceId(
-				ConferenceAddress(row.get<string>(1)),
-				ConferenceAddress(row.get<string>(2))
-			);
-			
-			shared_ptr<AbstractChatRoom> chatRoom = core->findChatRoom(conferenceId, false);
-			if (chatRoom) {
-				chatRooms.push_back(chatRoom);
-				continue;
+			ChatRoomRecord::Participant participant;
+			participant.address = row.get<string>(1);
+			participant.isAdmin = !!row.get<int>(2);
+
+			// Fetch devices.
+			{
+				const long long &participantId = dbSession.resolveId(row, 0);
+				static const string query = "SELECT sip_address.value, state, name FROM chat_room_participant_device, sip_address"
+					" WHERE chat_room_participant_id = :participantId"
+					" AND participant_device_sip_address_id = sip_address.id";
+
+				soci::rowset<soci::row> rows = (session->prepare << query, soci::use(participantId));
+				for (const auto &row : rows) {
+					ChatRoomRecord::Device device;
+					device.address = row.get<string>(0);
+					device.state = row.get<int>(1, 0);
+					device.name = row.get<string>(2, "");
+					participant.devices.push_back(move(device));
+				}
 			}
 
-			const long long &dbChatRoomId = d->dbSession.resolveId(row, 0);
-			d->cache(conferenceId, dbChatRoomId);
+			record.participants.push_back(move(participant));
+		}
+
+		if (record.capabilities & ChatRoom::CapabilitiesMask(ChatRoom::Capabilities::OneToOne)) {
+			static const string query = "SELECT sip_address.value FROM one_to_one_chat_room_previous_conference_id, sip_address"
+				" WHERE chat_room_id = :chatRoomId"
+				" AND sip_address_id = sip_address.id";
+			soci::rowset<soci::row> rows = (session->prepare << query, soci::use(record.id));
+			for (const auto &row : rows)
+				record.previousPeerAddresses.push_back(row.get<string>(0));
+		}
+	}
+#endif
 
-			time_t creationTime = d->dbSession.getTime(row, 3);
-			time_t lastUpdateTime = d->dbSession.getTime(row, 4);
-			int capabilities = row.get<int>(5);
-			string subject = row.get<string>(6, "");
-			const long long &lastMessageId = d->dbSession.resolveId(row, 9);
+	return records;
+}
 
-			shared_ptr<ChatRoomParams> params = ChatRoomParams::fromCapabilities(capabilities);
-			if (capabilities & ChatRoom::CapabilitiesMask(ChatRoom::Capabilities::Basic)) {
-				chatRoom = core->getPrivate()->createBasicChatRoom(conferenceId, capabilities, params);
-				chatRoom->setSubject(subject);
-			} else if (capabilities & ChatRoom::CapabilitiesMask(ChatRoom::Capabilities::Conference)) {
-#ifdef HAVE_ADVANCED_IM
-				list<shared_ptr<Participant>> participants;
-
-				static const string query = "SELECT chat_room_participant.id, sip_address.value, is_admin"
-					" FROM sip_address, chat_room, chat_room_participant"
-					" WHERE chat_room.id = :chatRoomId"
-					" AND sip_address.id = chat_room_participant.participant_sip_address_id"
-					" AND chat_room_participant.chat_room_id = chat_room.id";
-
-				// Fetch participants.
-				unsigned int lastNotifyId = getBackend() == Backend::Mysql
-					? row.get<unsigned int>(7, 0)
-					: static_cast<unsigned int>(row.get<int>(7, 0));
-				soci::rowset<soci::row> rows = (session->prepare << query, soci::use(dbChatRoomId));
-				shared_ptr<Participant> me;
-				for (const auto &row : rows) {
-					shared_ptr<Participant> participant = Participant::create(nullptr, IdentityAddress(row.get<string>(1)));
-					participant->setAdmin(!!row.get<int>(2));
-
-					// Fetch devices.
-					{
-						const long long &participantId = d->dbSession.resolveId(row, 0);
-						static const string query = "SELECT sip_address.value, state, name FROM chat_room_participant_device, sip_address"
-							" WHERE chat_room_participant_id = :participantId"
-							" AND participant_device_sip_address_id = sip_address.id";
-
-						soci::rowset<soci::row> rows = (session->prepare << query, soci::use(participantId));
-						for (const auto &row : rows) {
-							shared_ptr<ParticipantDevice> device = participant->addDevice(IdentityAddress(row.get<string>(0)), row.get<string>(2, ""));
-							device->setState(ParticipantDevice::State(static_cast<unsigned int>(row.get<int>(1, 0))));
-						}
-					}
+list<shared_ptr<AbstractChatRoom>> MainDbPrivate::createChatRooms (const list<ChatRoomRecord> &records) const {
+	L_Q();
 
-					if (participant->getAddress() == conferenceId.getLocalAddress().getAddressWithoutGruu())
-						me = participant;
-					else
-						participants.push_back(participant);
+	list<shared_ptr<AbstractChatRoom>> chatRooms;
+	shared_ptr<Core> core = q->getCore();
+
+	for (const auto &record : records) {
+		ConferenceId conferenceId = ConferenceId(
+			ConferenceAddress(record.peerAddress),
+			ConferenceAddress(record.localAddress)
+		);
+
+		shared_ptr<AbstractChatRoom> chatRoom = core->findChatRoom(conferenceId, false);
+		if (chatRoom) {
+			chatRooms.push_back(chatRoom);
+			continue;
+		}
+
+		cache(conferenceId, record.id);
+
+		const int capabilities = record.capabilities;
+		shared_ptr<ChatRoomParams> params = ChatRoomParams::fromCapabilities(capabilities);
+		if (capabilities & ChatRoom::CapabilitiesMask(ChatRoom::Capabilities::Basic)) {
+			chatRoom = core->getPrivate()->createBasicChatRoom(conferenceId, capabilities, params);
+			chatRoom->setSubject(record.subject);
+		} else if (capabilities & ChatRoom::CapabilitiesMask(ChatRoom::Capabilities::Conference)) {
+#ifdef HAVE_ADVANCED_IM
+			list<shared_ptr<Participant>> participants;
+			shared_ptr<Participant> me;
+			for (const auto &participantRecord : record.participants) {
+				shared_ptr<Participant> participant = Participant::create(nullptr, IdentityAddress(participantRecord.address));
+				participant->setAdmin(participantRecord.isAdmin);
+
+				for (const auto &deviceRecord : participantRecord.devices) {
+					shared_ptr<ParticipantDevice> device = participant->addDevice(IdentityAddress(deviceRecord.address), deviceRecord.name);
+					device->setState(ParticipantDevice::State(static_cast<unsigned int>(deviceRecord.state)));
 				}
 
-				Conference *conference = nullptr;
-				if (!linphone_core_conference_server_enabled(core->getCCore())) {
-					bool hasBeenLeft = !!row.get<int>(8, 0);
-					if (!me) {
-						lError() << "Unable to find me in: (peer=" + conferenceId.getPeerAddress().asString() +
-							", local=" + conferenceId.getLocalAddress().asString() + ").";
-						continue;
-					}
-					shared_ptr<ClientGroupChatRoom> clientGroupChatRoom(new ClientGroupChatRoom(
-						core,
-						conferenceId,
-						me,
-						capabilities,
-						params,
-						subject,
-						move(participants),
-						lastNotifyId,
-						hasBeenLeft
-					));
-					chatRoom = clientGroupChatRoom;
-					conference = clientGroupChatRoom->getConference().get();
-					chatRoom->setState(ConferenceInterface::State::Instantiated);
-					chatRoom->enableEphemeral(!!row.get<int>(10, 0), false);
-					chatRoom->setEphemeralLifetime((long)row.get<double>(11), false);
-					chatRoom->setState(hasBeenLeft
-						? ConferenceInterface::State::Terminated
-						: ConferenceInterface::State::Created
-					);
-
-					if (capabilities & ChatRoom::CapabilitiesMask(ChatRoom::Capabilities::OneToOne)) {
-						// TODO: load previous IDs if any
-						static const string query = "SELECT sip_address.value FROM one_to_one_chat_room_previous_conference_id, sip_address"
-							" WHERE chat_room_id = :chatRoomId"
-							" AND sip_address_id = sip_address.id";
-						soci::rowset<soci::row> rows = (session->prepare << query, soci::use(dbChatRoomId));
-						for (const auto &row : rows) {
-							ConferenceId previousId = ConferenceId(ConferenceAddress(row.get<string>(0)), conferenceId.getLocalAddress());
-							if (previousId != conferenceId) {
-								lInfo() << "Keeping around previous chat room ID [" << previousId << "] in case BYE is received for exhumed chat room [" << conferenceId << "]";
-								clientGroupChatRoom->getPrivate()->addConferenceIdToPreviousList(previousId);
-							}
-						}
-					}
+				if (participant->getAddress() == conferenceId.getLocalAddress().getAddressWithoutGruu())
+					me = participant;
+				else
+					participants.push_back(participant);
+			}
 
-				} else {
-					auto serverGroupChatRoom = std::make_shared<ServerGroupChatRoom>(
-						core,
-						conferenceId.getPeerAddress(),
-						capabilities,
-						params,
-						subject,
-						move(participants),
-						lastNotifyId
-					);
-					chatRoom = serverGroupChatRoom;
-					conference = serverGroupChatRoom->getConference().get();
-					chatRoom->setState(ConferenceInterface::State::Instantiated);
-					chatRoom->enableEphemeral(!!row.get<int>(10, 0), false);
-					chatRoom->setEphemeralLifetime((long)row.get<double>(11), false);
-					chatRoom->setState(ConferenceInterface::State::Created);
+			Conference *conference = nullptr;
+			if (!linphone_core_conference_server_enabled(core->getCCore())) {
+				bool hasBeenLeft = record.hasBeenLeft;
+				if (!me) {
+					lError() << "Unable to find me in: (peer=" + conferenceId.getPeerAddress().asString() +
+						", local=" + conferenceId.getLocalAddress().asString() + ").";
+					continue;
+				}
+				shared_ptr<ClientGroupChatRoom> clientGroupChatRoom(new ClientGroupChatRoom(
+					core,
+					conferenceId,
+					me,
+					capabilities,
+					params,
+					record.subject,
+					move(participants),
+					record.lastNotifyId,
+					hasBeenLeft
+				));
+				chatRoom = clientGroupChatRoom;
+				conference = clientGroupChatRoom->getConference().get();
+				chatRoom->setState(ConferenceInterface::State::Instantiated);
+				chatRoom->enableEphemeral(record.ephemeralEnabled, false);
+				chatRoom->setEphemeralLifetime(record.ephemeralLifetime, false);
+				chatRoom->setState(hasBeenLeft
+					? ConferenceInterface::State::Terminated
+					: ConferenceInterface::State::Created
+				);
+
+				for (const auto &previousPeerAddress : record.previousPeerAddresses) {
+					ConferenceId previousId = ConferenceId(ConferenceAddress(previousPeerAddress), conferenceId.getLocalAddress());
+					if (previousId != conferenceId) {
+						lInfo() << "Keeping around previous chat room ID [" << previousId << "] in case BYE is received for exhumed chat room [" << conferenceId << "]";
+						clientGroupChatRoom->getPrivate()->addConferenceIdToPreviousList(previousId);
+					}
 				}
-				for (auto participant : chatRoom->getParticipants())
-					participant->setConference(conference);
+			} else {
+				auto serverGroupChatRoom = std::make_shared<ServerGroupChatRoom>(
+					core,
+					conferenceId.getPeerAddress(),
+					capabilities,
+					params,
+					record.subject,
+					move(participants),
+					record.lastNotifyId
+				);
+				chatRoom = serverGroupChatRoom;
+				conference = serverGroupChatRoom->getConference().get();
+				chatRoom->setState(ConferenceInterface::State::Instantiated);
+				chatRoom->enableEphemeral(record.ephemeralEnabled, false);
+				chatRoom->setEphemeralLifetime(record.ephemeralLifetime, false);
+				chatRoom->setState(ConferenceInterface::State::Created);
+			}
+			for (auto participant : chatRoom->getParticipants())
+				participant->setConference(conference);
 #else
-				lWarning() << "Advanced IM such as group chat is disabled!";
+			lWarning() << "Advanced IM such as group chat is disabled!";
 #endif
-			}
+		}
 
-			if (!chatRoom)
-				continue; // Not fetched.
+		if (!chatRoom)
+			continue; // Not fetched.
 
-			AbstractChatRoomPrivate *dChatRoom = chatRoom->getPrivate();
-			dChatRoom->setCreationTime(creationTime);
-			dChatRoom->setLastUpdateTime(lastUpdateTime);
-			dChatRoom->setIsEmpty(lastMessageId == 0);
+		AbstractChatRoomPrivate *dChatRoom = chatRoom->getPrivate();
+		dChatRoom->setCreationTime(record.creationTime);
+		dChatRoom->setLastUpdateTime(record.lastUpdateTime);
+		dChatRoom->setIsEmpty(record.lastMessageId == 0);
 
-			lDebug() << "Found chat room in DB: (peer=" <<
-				conferenceId.getPeerAddress().asString() << ", local=" << conferenceId.getLocalAddress().asString() << ").";
+		lDebug() << "Found chat room in DB: (peer=" <<
+			conferenceId.getPeerAddress().asString() << ", local=" << conferenceId.getLocalAddress().asString() << ").";
 
-			chatRooms.push_back(chatRoom);
+		chatRooms.push_back(chatRoom);
+	}
+
+	return chatRooms;
+}
+
+list<MainDb::ChatRoomSummary> MainDbPrivate::selectChatRoomSummaries (long long chatRoomId) const {
+	static const string query = "SELECT chat_room.id, peer_sip_address.value, local_sip_address.value,"
+		" capabilities, last_update_time, last_message_id"
+		" FROM chat_room, sip_address AS peer_sip_address, sip_address AS local_sip_address"
+		" WHERE chat_room.peer_sip_address_id = peer_sip_address.id AND chat_room.local_sip_address_id = local_sip_address.id";
+	static const string oneChatRoomQuery = query + " AND chat_room.id = :chatRoomId";
+
+	static const string unreadQuery = "SELECT chat_room_id, COUNT(*)"
+		" FROM conference_event, conference_chat_message_event"
+		" WHERE conference_event.event_id = conference_chat_message_event.event_id AND marked_as_read = 0";
+	static const string allUnreadQuery = unreadQuery + " GROUP BY chat_room_id";
+	static const string oneUnreadQuery = unreadQuery + " AND chat_room_id = :chatRoomId GROUP BY chat_room_id";
+
+	static const string previousIdsQuery = "SELECT chat_room_id, sip_address.value"
+		" FROM one_to_one_chat_room_previous_conference_id, sip_address"
+		" WHERE sip_address_id = sip_address.id";
+	static const string onePreviousIdsQuery = previousIdsQuery + " AND chat_room_id = :chatRoomId";
+
+	list<MainDb::ChatRoomSummary> summaries;
+	unordered_map<long long, MainDb::ChatRoomSummary *> summariesById;
+	soci::session *session = dbSession.getBackendSession();
+
+	soci::rowset<soci::row> rows = chatRoomId < 0
+		? (session->prepare << query)
+		: (session->prepare << oneChatRoomQuery, soci::use(chatRoomId));
+	for (const auto &row : rows) {
+		MainDb::ChatRoomSummary summary;
+		summary.conferenceId = ConferenceId(
+			ConferenceAddress(row.get<string>(1)),
+			ConferenceAddress(row.get<string>(2))
+		);
+		summary.capabilities = row.get<int>(3);
+		summary.lastUpdateTime = dbSession.getTime(row, 4);
+		summary.lastMessageId = dbSession.resolveId(row, 5);
+
+		const long long dbChatRoomId = dbSession.resolveId(row, 0);
+		cache(summary.conferenceId, dbChatRoomId);
+		summaries.push_back(move(summary));
+		summariesById[dbChatRoomId] = &summaries.back();
+	}
+
+	long long dbChatRoomId;
+
+	// Unread counts of all chat rooms in a single query.
+	int count;
+	soci::statement unreadStatement = chatRoomId < 0
+		? (session->prepare << allUnreadQuery, soci::into(dbChatRoomId), soci::into(count))
+		: (session->prepare << oneUnreadQuery, soci::into(dbChatRoomId), soci::into(count), soci::use(chatRoomId));
+	unreadStatement.execute();
+	while (unreadStatement.fetch()) {
+		auto it = summariesById.find(dbChatRoomId);
+		if (it != summariesById.end())
+			it->second->unreadChatMessageCount = count;
+	}
+
+	string previousPeerAddress;
+	soci::statement previousIdsStatement = chatRoomId < 0
+		? (session->prepare << previousIdsQuery, soci::into(dbChatRoomId), soci::into(previousPeerAddress))
+		: (session->prepare << onePreviousIdsQuery, soci::into(dbChatRoomId), soci::into(previousPeerAddress), soci::use(chatRoomId));
+	previousIdsStatement.execute();
+	while (previousIdsStatement.fetch()) {
+		auto it = summariesById.find(dbChatRoomId);
+		if (it != summariesById.end()) {
+			const ConferenceId &conferenceId = it->second->conferenceId;
+			it->second->previousConferenceIds.push_back(
+				ConferenceId(ConferenceAddress(previousPeerAddress), conferenceId.getLocalAddress())
+			);
 		}
+	}
+
+	for (const auto &summary : summaries)
+		unreadChatMessageCountCache.insert(summary.conferenceId, summary.unreadChatMessageCount);
+
+	return summaries;
+}
+#endif
+
+list<shared_ptr<AbstractChatRoom>> MainDb::getChatRooms () const {
+#ifdef HAVE_DB_STORAGE
+	DurationLogger durationLogger("Get chat rooms.");
+
+	L_D();
+	d->waitForPendingWrites({ "chat_room" });
 
+	return L_DB_TRANSACTION {
+		list<shared_ptr<AbstractChatRoom>> chatRooms = d->createChatRooms(
+			d->selectChatRoomRecords(d->dbSession, getBackend() == Backend::Mysql)
+		);
 		tr.commit();
 
 		return chatRooms;
@@ -3580,6 +4235,64 @@ list<shared_ptr<AbstractChatRoom>> MainDb::getChatRooms () const {
 #endif
 }
 
+list<MainDb::ChatRoomSummary> MainDb::getChatRoomSummaries () const {
+#ifdef HAVE_DB_STORAGE
+	DurationLogger durationLogger("Get chat room summaries.");
+
+	L_D();
+	d->waitForPendingWrites({ "chat_room", "conference_chat_message_event" });
+
+	return L_DB_TRANSACTION {
+		return d->selectChatRoomSummaries();
+	};
+#else
+	return list<ChatRoomSummary>();
+#endif
+}
+
+MainDb::ChatRoomSummary MainDb::getChatRoomSummary (const ConferenceId &conferenceId) const {
+#ifdef HAVE_DB_STORAGE
+	L_D();
+	d->waitForPendingWrites({ "chat_room", "conference_chat_message_event" });
+
+	return L_DB_TRANSACTION {
+		list<ChatRoomSummary> summaries;
+		const long long dbChatRoomId = d->selectChatRoomId(conferenceId);
+		if (dbChatRoomId >= 0)
+			summaries = d->selectChatRoomSummaries(dbChatRoomId);
+
+		return summaries.empty() ? ChatRoomSummary() : summaries.front();
+	};
+#else
+	return ChatRoomSummary();
+#endif
+}
+
+shared_ptr<AbstractChatRoom> MainDb::getChatRoom (const ConferenceId &conferenceId) const {
+#ifdef HAVE_DB_STORAGE
+	L_D();
+	d->waitForPendingWrites({ "chat_room" });
+
+	return L_DB_TRANSACTION {
+		shared_ptr<AbstractChatRoom> chatRoom;
+		const long long dbChatRoomId = d->selectChatRoomId(conferenceId);
+		if (dbChatRoomId < 0)
+			return chatRoom;
+
+		list<shared_ptr<AbstractChatRoom>> chatRooms = d->createChatRooms(
+			d->selectChatRoomRecords(d->dbSession, getBackend() == Backend::Mysql, dbChatRoomId)
+		);
+		if (!chatRooms.empty())
+			chatRoom = chatRooms.front();
+		tr.commit();
+
+		return chatRoom;
+	};
+#else
+	return nullptr;
+#endif
+}
+
 void MainDbPrivate::insertNewPreviousConferenceId(const ConferenceId& currentConfId, const ConferenceId& previousConfId) {
 #ifdef HAVE_DB_STORAGE
 	const long long &previousConferenceSipAddressId = selectSipAddressId(previousConfId.getPeerAddress().asString());
@@ -3641,9 +4354,10 @@ void MainDb::insertChatRoom (const shared_ptr<AbstractChatRoom> &chatRoom, unsig
 
 void MainDb::deleteChatRoom (const ConferenceId &conferenceId) {
 #ifdef HAVE_DB_STORAGE
-	L_DB_TRANSACTION {
-		L_D();
+	L_D();
+	d->waitForPendingWrites();
 
+	L_DB_TRANSACTION {
 		const long long &dbChatRoomId = d->selectChatRoomId(conferenceId);
 
 		d->invalidConferenceEventsFromQuery(
@@ -3661,9 +4375,10 @@ void MainDb::deleteChatRoom (const ConferenceId &conferenceId) {
 
 void MainDb::updateChatRoomConferenceId (const ConferenceId oldConferenceId, const ConferenceId &newConferenceId) {
 #ifdef HAVE_DB_STORAGE
-	L_DB_TRANSACTION {
-		L_D();
+	L_D();
+	d->waitForPendingWrites();
 
+	L_DB_TRANSACTION {
 		const long long &peerSipAddressId = d->insertSipAddress(newConferenceId.getPeerAddress().asString());
 		const long long &dbChatRoomId = d->selectChatRoomId(oldConferenceId);
 
@@ -3695,9 +4410,10 @@ void MainDb::migrateBasicToClientGroupChatRoom (
 	L_ASSERT(basicChatRoom->getCapabilities().isSet(ChatRoom::Capabilities::Basic));
 	L_ASSERT(clientGroupChatRoom->getCapabilities().isSet(ChatRoom::Capabilities::Conference));
 
-	L_DB_TRANSACTION {
-		L_D();
+	L_D();
+	d->waitForPendingWrites();
 
+	L_DB_TRANSACTION {
 		// TODO: Update events and chat messages. (Or wait signals.)
 		const long long &dbChatRoomId = d->selectChatRoomId(basicChatRoom->getConferenceId());
 
@@ -3903,9 +4619,248 @@ void MainDb::deleteChatRoomParticipantDevice (
 	d->deleteChatRoomParticipantDevice(participantId, participantSipAddressId);
 #endif
 }
+
+void MainDb::insertServerQueuedMessage (const ConferenceId &conferenceId, const ServerQueuedMessage &message) {
+#ifdef HAVE_DB_STORAGE
+	L_D();
+
+	const string peerAddress = conferenceId.getPeerAddress().asString();
+	const string localAddress = conferenceId.getLocalAddress().asString();
+	const tm messageTm = Utils::getTimeTAsTm(message.time);
+	d->executeWrite("insertServerQueuedMessage", "server_chat_room_queued_message", [peerAddress, localAddress, message, messageTm](const DbSession &dbSession) {
+		const long long dbChatRoomId = selectChatRoomIdInSession(dbSession, peerAddress, localAddress);
+		if (dbChatRoomId < 0)
+			return;
+
+		soci::session *session = dbSession.getBackendSession();
+		const long long fromSipAddressId = insertSipAddressInSession(dbSession, message.fromAddress);
+		*session << "INSERT INTO server_chat_room_queued_message (chat_room_id, from_sip_address_id, content_type, body, headers, time)"
+			" VALUES (:chatRoomId, :fromSipAddressId, :contentType, :body, :headers, :time)",
+			soci::use(dbChatRoomId), soci::use(fromSipAddressId), soci::use(message.contentType),
+			soci::use(message.body), soci::use(message.headers), soci::use(messageTm);
+		const long long messageId = dbSession.getLastInsertId();
+
+		for (const auto &deviceAddress : message.deviceAddresses) {
+			const long long deviceSipAddressId = insertSipAddressInSession(dbSession, deviceAddress);
+			*session << "INSERT INTO server_chat_room_queued_message_device (message_id, device_sip_address_id)"
+				" VALUES (:messageId, :deviceSipAddressId)",
+				soci::use(messageId), soci::use(deviceSipAddressId);
+		}
+	});
+#endif
+}
+
+list<MainDb::ServerQueuedMessage> MainDb::getServerQueuedMessages (const ConferenceId &conferenceId) const {
+#ifdef HAVE_DB_STORAGE
+	static const string query = "SELECT server_chat_room_queued_message.id, from_sip_address.value, content_type, body, headers, time,"
+		"  device_sip_address.value"
+		" FROM server_chat_room_queued_message"
+		" JOIN sip_address AS from_sip_address ON from_sip_address.id = from_sip_address_id"
+		" JOIN server_chat_room_queued_message_device ON message_id = server_chat_room_queued_message.id"
+		" JOIN sip_address AS device_sip_address ON device_sip_address.id = device_sip_address_id"
+		" WHERE chat_room_id = :chatRoomId"
+		" ORDER BY time, server_chat_room_queued_message.id";
+
+	L_D();
+	d->waitForPendingWrites({ "server_chat_room_queued_message" });
+
+	return L_DB_TRANSACTION {
+		list<ServerQueuedMessage> messages;
+		const long long &dbChatRoomId = d->selectChatRoomId(conferenceId);
+		if (dbChatRoomId < 0)
+			return messages;
+
+		// One row per device, the rows of a message are contiguous.
+		long long lastMessageId = -1;
+		soci::rowset<soci::row> rows = (d->dbSession.getBackendSession()->prepare << query, soci::use(dbChatRoomId));
+		for (const auto &row : rows) {
+			const long long messageId = d->dbSession.resolveId(row, 0);
+			if (messageId != lastMessageId) {
+				ServerQueuedMessage message;
+				message.fromAddress = row.get<string>(1);
+				message.contentType = row.get<string>(2);
+				message.body = row.get<string>(3, "");
+				message.headers = row.get<string>(4, "");
+				message.time = d->dbSession.getTime(row, 5);
+				messages.push_back(move(message));
+				lastMessageId = messageId;
+			}
+			messages.back().deviceAddresses.push_back(row.get<string>(6));
+		}
+
+		return messages;
+	};
+#else
+	return list<ServerQueuedMessage>();
+#endif
+}
+
+void MainDb::deleteServerQueuedMessages (const ConferenceId &conferenceId, const string &deviceAddress) {
+#ifdef HAVE_DB_STORAGE
+	L_D();
+
+	const string peerAddress = conferenceId.getPeerAddress().asString();
+	const string localAddress = conferenceId.getLocalAddress().asString();
+	d->executeWrite("deleteServerQueuedMessages", "server_chat_room_queued_message", [peerAddress, localAddress, deviceAddress](const DbSession &dbSession) {
+		const long long dbChatRoomId = selectChatRoomIdInSession(dbSession, peerAddress, localAddress);
+		const long long deviceSipAddressId = selectIdFromCachedStatement(
+			dbSession, Statements::SelectSipAddressId, soci::use(deviceAddress)
+		);
+		if (dbChatRoomId < 0 || deviceSipAddressId < 0)
+			return;
+
+		soci::session *session = dbSession.getBackendSession();
+		*session << "DELETE FROM server_chat_room_queued_message_device"
+			" WHERE device_sip_address_id = :deviceSipAddressId AND message_id IN ("
+			"  SELECT id FROM server_chat_room_queued_message WHERE chat_room_id = :chatRoomId"
+			" )", soci::use(deviceSipAddressId), soci::use(dbChatRoomId);
+		*session << "DELETE FROM server_chat_room_queued_message"
+			" WHERE chat_room_id = :chatRoomId AND NOT EXISTS ("
+			"  SELECT 1 FROM server_chat_room_queued_message_device WHERE message_id = server_chat_room_queued_message.id"
+			" )", soci::use(dbChatRoomId);
+	});
+#endif
+}
+
+void MainDb::deleteServerQueuedMessagesBefore (const ConferenceId &conferenceId, time_t time) {
+#ifdef HAVE_DB_STORAGE
+	L_D();
+
+	const string peerAddress = conferenceId.getPeerAddress().asString();
+	const string localAddress = conferenceId.getLocalAddress().asString();
+	const tm timeTm = Utils::getTimeTAsTm(time);
+	d->executeWrite("deleteServerQueuedMessagesBefore", "server_chat_room_queued_message", [peerAddress, localAddress, timeTm](const DbSession &dbSession) {
+		const long long dbChatRoomId = selectChatRoomIdInSession(dbSession, peerAddress, localAddress);
+		*dbSession.getBackendSession() << "DELETE FROM server_chat_room_queued_message"
+			" WHERE chat_room_id = :chatRoomId AND time < :time",
+			soci::use(dbChatRoomId), soci::use(timeTm);
+	});
+#endif
+}
 	
 // -----------------------------------------------------------------------------
 
+void MainDb::enableAsyncMode (bool enable) {
+#ifdef HAVE_DB_STORAGE
+	L_D();
+
+	if (enable == !!d->dbWorker)
+		return;
+
+	if (!enable) {
+		// Executes the pending tasks, their results are dropped.
+		d->dbWorker.reset();
+		d->asyncModeToken.reset();
+		lInfo() << "MainDb async mode disabled.";
+		return;
+	}
+
+	if (!d->dbSession) {
+		lWarning() << "Unable to enable MainDb async mode without database session.";
+		return;
+	}
+
+	if (getBackend() == Backend::Sqlite3) {
+		// The main session and the worker session may lock the database file at the same time.
+		*d->dbSession.getBackendSession() << "PRAGMA busy_timeout = 5000";
+	}
+
+	d->dbWorker = makeUnique<DbWorker>(d->uri, getBackend() == Backend::Sqlite3);
+	d->asyncModeToken = make_shared<bool>(true);
+	lInfo() << "MainDb async mode enabled.";
+#endif
+}
+
+bool MainDb::asyncModeEnabled () const {
+#ifdef HAVE_DB_STORAGE
+	L_D();
+	return !!d->dbWorker;
+#else
+	return false;
+#endif
+}
+
+void MainDb::getHistoryRangeAsync (
+	const ConferenceId &conferenceId,
+	int begin,
+	int end,
+	FilterMask mask,
+	const HistoryCallback &callback
+) const {
+#ifdef HAVE_DB_STORAGE
+	L_D();
+
+	if (!d->dbWorker) {
+		callback(getHistoryRange(conferenceId, begin, end, mask));
+		return;
+	}
+
+	if (begin < 0)
+		begin = 0;
+
+	if (end > 0 && begin > end) {
+		lWarning() << "Unable to get history. Invalid range.";
+		callback(list<shared_ptr<EventLog>>());
+		return;
+	}
+
+	// The worker looks for the most recent event of the range, this is where the cost of the offset is.
+	// Then the page is read with a keyset query by the core iterate thread, where events are created.
+	string query = d->getConferenceEventsQuery(mask);
+	query += " ORDER BY event_id DESC LIMIT 1";
+	if (begin > 0)
+		query += " OFFSET " + Utils::toString(begin);
+
+	const string peerAddress = conferenceId.getPeerAddress().asString();
+	const string localAddress = conferenceId.getLocalAddress().asString();
+	auto firstEventId = make_shared<long long>(-1);
+	d->executeAsync("getHistoryRangeAsync", [query, peerAddress, localAddress, firstEventId](const DbSession &dbSession) {
+		const long long dbChatRoomId = selectChatRoomIdInSession(dbSession, peerAddress, localAddress);
+		if (dbChatRoomId < 0)
+			return;
+
+		soci::rowset<soci::row> rows = (dbSession.getBackendSession()->prepare << query, soci::use(dbChatRoomId));
+		for (const auto &row : rows)
+			*firstEventId = dbSession.resolveId(row, 0);
+	}, [this, conferenceId, begin, end, mask, callback, firstEventId]() {
+		if (*firstEventId < 0) {
+			callback(list<shared_ptr<EventLog>>());
+			return;
+		}
+
+		const int count = end > 0 ? end - begin : numeric_limits<int>::max();
+		callback(getHistoryBefore(conferenceId, *firstEventId + 1, count, mask));
+	});
+#else
+	callback(list<shared_ptr<EventLog>>());
+#endif
+}
+
+void MainDb::getChatRoomsAsync (const ChatRoomsCallback &callback) const {
+#ifdef HAVE_DB_STORAGE
+	L_D();
+
+	if (!d->dbWorker) {
+		callback(getChatRooms());
+		return;
+	}
+
+	// Rows are read by the worker, chat rooms are created by the core iterate thread.
+	const bool isMysql = getBackend() == Backend::Mysql;
+	auto records = make_shared<list<MainDbPrivate::ChatRoomRecord>>();
+	d->executeAsync("getChatRoomsAsync", [isMysql, records](const DbSession &dbSession) {
+		*records = MainDbPrivate::selectChatRoomRecords(dbSession, isMysql);
+	}, [this, callback, records]() {
+		L_D();
+		callback(d->createChatRooms(*records));
+	});
+#else
+	callback(list<shared_ptr<AbstractChatRoom>>());
+#endif
+}
+
+// -----------------------------------------------------------------------------
+
 bool MainDb::import (Backend, const string &parameters) {
 #ifdef HAVE_DB_STORAGE
 	L_D();
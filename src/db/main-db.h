@@ -71,6 +71,26 @@ public:
 		time_t timestamp = 0;
 	};
 
+	// Lightweight description of a stored chat room, enough to find it without instantiating it.
+	struct ChatRoomSummary {
+		ConferenceId conferenceId;
+		int capabilities = 0;
+		time_t lastUpdateTime = 0;
+		long long lastMessageId = 0; // 0 if the chat room is empty.
+		int unreadChatMessageCount = 0;
+		std::list<ConferenceId> previousConferenceIds;
+	};
+
+	// Message received by a server group chat room and not yet delivered to some devices.
+	struct ServerQueuedMessage {
+		std::string fromAddress;
+		std::string contentType;
+		std::string body;
+		std::string headers; // "Name: value" lines.
+		time_t time = 0;
+		std::list<std::string> deviceAddresses;
+	};
+
 	MainDb (const std::shared_ptr<Core> &core);
 
 	// ---------------------------------------------------------------------------
@@ -78,10 +98,20 @@ public:
 	// ---------------------------------------------------------------------------
 
 	bool addEvent (const std::shared_ptr<EventLog> &eventLog);
+	// Insert all events in a single transaction. Returns false if at least one event was not inserted.
+	bool addEvents (const std::list<std::shared_ptr<EventLog>> &eventLogs);
 	bool updateEvent (const std::shared_ptr<EventLog> &eventLog);
 	static bool deleteEvent (const std::shared_ptr<const EventLog> &eventLog);
+	// Delete all events in a single transaction, the last message of each chat room is updated once.
+	bool deleteEvents (const std::list<std::shared_ptr<const EventLog>> &eventLogs);
 	int getEventCount (FilterMask mask = NoFilter) const;
 
+	// Write-behind queue: queued events are stored with addEvents() once maxSize events are pending
+	// or every windowMs milliseconds. A maxSize of 0 disables the queue and queueEvent() stores immediately.
+	void setEventQueueParameters (unsigned int maxSize, unsigned int windowMs);
+	void queueEvent (const std::shared_ptr<EventLog> &eventLog);
+	void flushQueuedEvents ();
+
 	static std::shared_ptr<EventLog> getEventFromKey (const MainDbKey &dbKey);
 	static std::shared_ptr<EventLog> getEvent (const std::unique_ptr<MainDb> &mainDb, const long long& storageId);
 
@@ -94,6 +124,11 @@ public:
 		unsigned int lastNotifyId
 	) const;
 
+	int getConferenceNotifiedEventCount (
+		const ConferenceId &conferenceId,
+		unsigned int lastNotifyId
+	) const;
+
 	// ---------------------------------------------------------------------------
 	// Conference chat message events.
 	// ---------------------------------------------------------------------------
@@ -125,7 +160,8 @@ public:
 		time_t stateChangeTime
 	);
 
-	std::list<std::shared_ptr<ChatMessage>> getEphemeralMessages () const;
+	// Started ephemeral messages ordered by expire time, at most maxCount of them.
+	std::list<std::shared_ptr<ChatMessage>> getEphemeralMessages (unsigned int maxCount = EPHEMERAL_MESSAGE_TASKS_MAX_NB) const;
 
 	bool isChatRoomEmpty (const ConferenceId &conferenceId) const;
 	std::shared_ptr<ChatMessage> getLastChatMessage (const ConferenceId &conferenceId) const;
@@ -155,6 +191,21 @@ public:
 		FilterMask mask = NoFilter
 	) const;
 
+	// Cursor based history: returns at most count events older than lastEventId (or the most recent ones
+	// if lastEventId is negative), sorted from oldest to most recent.
+	std::list<std::shared_ptr<EventLog>> getHistoryBefore (
+		const ConferenceId &conferenceId,
+		long long lastEventId,
+		int count,
+		FilterMask mask = NoFilter
+	) const;
+	std::list<std::shared_ptr<EventLog>> getHistoryBefore (
+		const ConferenceId &conferenceId,
+		const std::shared_ptr<const EventLog> &lastEvent,
+		int count,
+		FilterMask mask = NoFilter
+	) const;
+
 	int getHistorySize (const ConferenceId &conferenceId, FilterMask mask = NoFilter) const;
 
 	void cleanHistory (const ConferenceId &conferenceId, FilterMask mask = NoFilter);
@@ -173,6 +224,10 @@ public:
 	// ---------------------------------------------------------------------------
 
 	std::list<std::shared_ptr<AbstractChatRoom>> getChatRooms () const;
+	std::list<ChatRoomSummary> getChatRoomSummaries () const;
+	ChatRoomSummary getChatRoomSummary (const ConferenceId &conferenceId) const;
+	// Instantiates a single chat room with its participants.
+	std::shared_ptr<AbstractChatRoom> getChatRoom (const ConferenceId &conferenceId) const;
 	void insertChatRoom (const std::shared_ptr<AbstractChatRoom> &chatRoom, unsigned int notifyId = 0);
 	void deleteChatRoom (const ConferenceId &conferenceId);
 	void updateChatRoomConferenceId (const ConferenceId oldConferenceId, const ConferenceId &newConferenceId);
@@ -211,9 +266,37 @@ public:
 		const std::shared_ptr<ParticipantDevice> &device
 	);
 
+	void insertServerQueuedMessage (const ConferenceId &conferenceId, const ServerQueuedMessage &message);
+	std::list<ServerQueuedMessage> getServerQueuedMessages (const ConferenceId &conferenceId) const;
+	// Forget the messages queued for a device, messages queued for no other device are deleted.
+	void deleteServerQueuedMessages (const ConferenceId &conferenceId, const std::string &deviceAddress);
+	void deleteServerQueuedMessagesBefore (const ConferenceId &conferenceId, time_t time);
+
 	void insertNewPreviousConferenceId(const ConferenceId& currentConfId, const ConferenceId& previousConfId);
 	void removePreviousConferenceId(const ConferenceId& confId);
 
+	// ---------------------------------------------------------------------------
+	// Async mode.
+	// ---------------------------------------------------------------------------
+
+	using HistoryCallback = std::function<void (const std::list<std::shared_ptr<EventLog>> &events)>;
+	using ChatRoomsCallback = std::function<void (const std::list<std::shared_ptr<AbstractChatRoom>> &chatRooms)>;
+
+	// In async mode, writes that do not return data are executed by a thread owning its own session.
+	// Tasks are executed in submission order and synchronous operations wait for them before starting.
+	void enableAsyncMode (bool enable);
+	bool asyncModeEnabled () const;
+
+	// Callbacks are called from the core iterate thread, immediately if async mode is disabled.
+	void getHistoryRangeAsync (
+		const ConferenceId &conferenceId,
+		int begin,
+		int end,
+		FilterMask mask,
+		const HistoryCallback &callback
+	) const;
+	void getChatRoomsAsync (const ChatRoomsCallback &callback) const;
+
 	// ---------------------------------------------------------------------------
 	// Other.
 	// ---------------------------------------------------------------------------
@@ -17,6 +17,8 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <unordered_map>
+
 #include "linphone/utils/utils.h"
 
 #include "sqlite3_bctbx_vfs.h"
@@ -38,6 +40,11 @@ public:
 	} backend = Backend::None;
 
 	std::unique_ptr<soci::session> backendSession;
+
+	// Must be destroyed before the backend session.
+	mutable std::unordered_map<int, std::unique_ptr<soci::statement>> statementCache;
+	mutable unsigned long long statementCacheHits = 0;
+	mutable unsigned long long statementCacheMisses = 0;
 };
 
 DbSession::DbSession () : mPrivate(new DbSessionPrivate) {}
@@ -292,4 +299,38 @@ time_t DbSession::getTime (const soci::row &row, int col) const {
 	return 0;
 }
 
+soci::statement &DbSession::getCachedStatement (int id, const char *sql) const {
+	L_D();
+
+	auto it = d->statementCache.find(id);
+	if (it != d->statementCache.end()) {
+		++d->statementCacheHits;
+		return *it->second;
+	}
+
+	++d->statementCacheMisses;
+	unique_ptr<soci::statement> statement = makeUnique<soci::statement>(*d->backendSession);
+	statement->alloc();
+	statement->prepare(sql);
+
+	soci::statement &result = *statement;
+	d->statementCache[id] = move(statement);
+	return result;
+}
+
+void DbSession::clearStatementCache () {
+	L_D();
+	d->statementCache.clear();
+}
+
+unsigned long long DbSession::getStatementCacheHits () const {
+	L_D();
+	return d->statementCacheHits;
+}
+
+unsigned long long DbSession::getStatementCacheMisses () const {
+	L_D();
+	return d->statementCacheMisses;
+}
+
 LINPHONE_END_NAMESPACE
@@ -62,6 +62,15 @@ public:
 
 	std::time_t getTime (const soci::row &row, int col) const;
 
+	// Statements prepared once per connection and identified by a caller defined id.
+	// Bindings must be set with exchange() and define_and_bind() before each execution
+	// and released with bind_clean_up() afterwards.
+	soci::statement &getCachedStatement (int id, const char *sql) const;
+	void clearStatementCache ();
+
+	unsigned long long getStatementCacheHits () const;
+	unsigned long long getStatementCacheMisses () const;
+
 private:
 	DbSessionPrivate *mPrivate;
 
@@ -0,0 +1,288 @@
+/*
+ * Copyright (c) 2010-2021 Belledonne Communications SARL.
+ *
+ * This file is part of Liblinphone.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#include "log-collection-writer.h"
+
+// =============================================================================
+
+using namespace std;
+
+LINPHONE_BEGIN_NAMESPACE
+
+namespace {
+	constexpr chrono::milliseconds WriterPeriod(100);
+	// Longer lines are truncated.
+	constexpr size_t MaxLineSize = 4096;
+}
+
+// Single producer, single consumer ring. The counters only grow, positions are taken modulo the capacity.
+struct LogCollectionWriter::Ring {
+	explicit Ring (size_t capacity, const LogCollectionWriter *owner) : buffer(capacity), owner(owner) {}
+
+	size_t getFreeSize () const {
+		return buffer.size() - (head.load(memory_order_relaxed) - tail.load(memory_order_acquire));
+	}
+
+	void write (size_t position, const void *data, size_t size) {
+		const size_t offset = position % buffer.size();
+		const size_t first = min(size, buffer.size() - offset);
+		memcpy(&buffer[offset], data, first);
+		memcpy(&buffer[0], static_cast<const char *>(data) + first, size - first);
+	}
+
+	void read (size_t position, void *data, size_t size) const {
+		const size_t offset = position % buffer.size();
+		const size_t first = min(size, buffer.size() - offset);
+		memcpy(data, &buffer[offset], first);
+		memcpy(static_cast<char *>(data) + first, &buffer[0], size - first);
+	}
+
+	vector<char> buffer;
+	const LogCollectionWriter *owner;
+	atomic<size_t> head{0};
+	atomic<size_t> tail{0};
+	atomic<unsigned int> dropped{0};
+	// Set when the thread owning the ring has exited or logs to another writer, no more line will be pushed.
+	atomic<bool> exited{false};
+};
+
+struct LogCollectionWriter::Record {
+	int64_t sec;
+	int usec;
+	string text;
+};
+
+namespace {
+	struct RecordHeader {
+		int64_t sec;
+		int32_t usec;
+		uint32_t size;
+	};
+}
+
+// -----------------------------------------------------------------------------
+
+LogCollectionWriter::LogCollectionWriter (const string &programName, Sink sink) : mProgramName(programName), mSink(move(sink)) {}
+
+LogCollectionWriter::~LogCollectionWriter () {
+	stop();
+}
+
+void LogCollectionWriter::start () {
+	lock_guard<mutex> lock(mMutex);
+	if (mThread.joinable())
+		return;
+
+	mStopped = false;
+	mThread = thread(&LogCollectionWriter::run, this);
+	mRunning = true;
+}
+
+void LogCollectionWriter::stop () {
+	{
+		lock_guard<mutex> lock(mMutex);
+		if (!mThread.joinable())
+			return;
+		mRunning = false;
+		mStopped = true;
+	}
+	mCondition.notify_one();
+	mThread.join();
+	// Lines pushed while the thread was stopping.
+	drain();
+}
+
+void LogCollectionWriter::setBufferSize (size_t size) {
+	mBufferSize = max(size, MaxLineSize + sizeof(RecordHeader));
+}
+
+void LogCollectionWriter::push (const char *domain, const char *levelName, const char *fmt, va_list args) {
+	Ring *ring = getThreadRing();
+	if (!ring)
+		return;
+
+	const auto now = chrono::system_clock::now().time_since_epoch();
+	const auto usec = chrono::duration_cast<chrono::microseconds>(now).count();
+
+	char line[MaxLineSize];
+	int size = snprintf(line, sizeof(line), "[%s/%s] %s ", mProgramName.c_str(), domain ? domain : "", levelName);
+	if (size < 0)
+		return;
+	if (size_t(size) < sizeof(line)) {
+		const int messageSize = vsnprintf(line + size, sizeof(line) - size_t(size), fmt, args);
+		if (messageSize < 0)
+			return;
+		size += messageSize;
+	}
+	size = int(min(size_t(size), sizeof(line) - 1));
+
+	RecordHeader header;
+	header.sec = usec / 1000000;
+	header.usec = int32_t(usec % 1000000);
+	header.size = uint32_t(size);
+
+	const size_t recordSize = sizeof(header) + size_t(size);
+	if (ring->getFreeSize() < recordSize) {
+		ring->dropped.fetch_add(1, memory_order_relaxed);
+		mCondition.notify_one();
+		return;
+	}
+
+	const size_t head = ring->head.load(memory_order_relaxed);
+	ring->write(head, &header, sizeof(header));
+	ring->write(head + sizeof(header), line, size_t(size));
+	ring->head.store(head + recordSize, memory_order_release);
+
+	// Wake up the writer before the ring is full.
+	if (ring->getFreeSize() < ring->buffer.size() / 2)
+		mCondition.notify_one();
+}
+
+void LogCollectionWriter::flush () {
+	drain();
+}
+
+// -----------------------------------------------------------------------------
+
+LogCollectionWriter::Ring *LogCollectionWriter::getThreadRing () {
+	// The registry keeps the ring of an exited thread until the writer has drained it.
+	struct ThreadRing {
+		~ThreadRing () {
+			if (ring)
+				ring->exited.store(true, memory_order_release);
+		}
+		shared_ptr<Ring> ring;
+	};
+	static thread_local ThreadRing threadRing;
+	if (threadRing.ring && threadRing.ring->owner == this)
+		return threadRing.ring.get();
+
+	if (threadRing.ring)
+		threadRing.ring->exited.store(true, memory_order_release);
+	threadRing.ring = make_shared<Ring>(mBufferSize, this);
+	lock_guard<mutex> lock(mRingsMutex);
+	mRings.push_back(threadRing.ring);
+	return threadRing.ring.get();
+}
+
+void LogCollectionWriter::run () {
+	unique_lock<mutex> lock(mMutex);
+	while (!mStopped) {
+		mCondition.wait_for(lock, WriterPeriod);
+		lock.unlock();
+		drain();
+		lock.lock();
+	}
+}
+
+void LogCollectionWriter::drain () {
+	lock_guard<mutex> drainLock(mDrainMutex);
+
+	vector<shared_ptr<Ring>> rings;
+	{
+		lock_guard<mutex> lock(mRingsMutex);
+		rings = mRings;
+	}
+
+	vector<Record> records;
+	unsigned int dropped = 0;
+	for (const auto &ring : rings) {
+		const size_t head = ring->head.load(memory_order_acquire);
+		size_t tail = ring->tail.load(memory_order_relaxed);
+		while (tail < head) {
+			RecordHeader header;
+			ring->read(tail, &header, sizeof(header));
+
+			Record record;
+			record.sec = header.sec;
+			record.usec = header.usec;
+			record.text.resize(header.size);
+			ring->read(tail + sizeof(header), &record.text[0], header.size);
+			records.push_back(move(record));
+
+			tail += sizeof(header) + header.size;
+		}
+		ring->tail.store(tail, memory_order_release);
+		dropped += ring->dropped.exchange(0, memory_order_relaxed);
+	}
+
+	{
+		// The thread has exited, drop its ring once drained. The flag is read first so that its last line is seen.
+		lock_guard<mutex> lock(mRingsMutex);
+		mRings.erase(remove_if(mRings.begin(), mRings.end(), [](const shared_ptr<Ring> &ring) {
+			return ring->exited.load(memory_order_acquire) && ring->tail.load() == ring->head.load();
+		}), mRings.end());
+	}
+	rings.clear();
+
+	if (records.empty() && dropped == 0)
+		return;
+
+	// The rings are ordered per thread only.
+	stable_sort(records.begin(), records.end(), [](const Record &a, const Record &b) {
+		return a.sec < b.sec || (a.sec == b.sec && a.usec < b.usec);
+	});
+
+	string batch;
+	batch.reserve(BatchSize + MaxLineSize);
+	for (const Record &record : records) {
+		appendLine(batch, record.sec, record.usec, record.text.c_str(), record.text.size());
+		if (batch.size() >= BatchSize) {
+			mSink(batch.c_str(), batch.size());
+			batch.clear();
+		}
+	}
+
+	if (dropped > 0) {
+		const auto now = chrono::duration_cast<chrono::microseconds>(chrono::system_clock::now().time_since_epoch()).count();
+		char text[128];
+		const int size = snprintf(text, sizeof(text), "[%s/liblinphone] WARNING %u log lines dropped, the log collection buffer is full", mProgramName.c_str(), dropped);
+		if (size > 0)
+			appendLine(batch, now / 1000000, int(now % 1000000), text, min(size_t(size), sizeof(text) - 1));
+	}
+
+	if (!batch.empty())
+		mSink(batch.c_str(), batch.size());
+}
+
+void LogCollectionWriter::appendLine (string &batch, int64_t sec, int usec, const char *text, size_t size) const {
+	const time_t tt = time_t(sec);
+	struct tm lt;
+#ifdef _WIN32
+	localtime_s(&lt, &tt);
+#else
+	localtime_r(&tt, &lt);
+#endif
+
+	char date[32];
+	const int dateSize = snprintf(date, sizeof(date), "%i-%.2i-%.2i %.2i:%.2i:%.2i:%.3i ",
+		1900 + lt.tm_year, lt.tm_mon + 1, lt.tm_mday, lt.tm_hour, lt.tm_min, lt.tm_sec, usec / 1000);
+	if (dateSize > 0)
+		batch.append(date, min(size_t(dateSize), sizeof(date) - 1));
+	batch.append(text, size);
+	batch.append(1, '\n');
+}
+
+LINPHONE_END_NAMESPACE
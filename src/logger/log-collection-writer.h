@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2010-2021 Belledonne Communications SARL.
+ *
+ * This file is part of Liblinphone.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _L_LOG_COLLECTION_WRITER_H_
+#define _L_LOG_COLLECTION_WRITER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdarg>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "linphone/utils/general.h"
+
+// =============================================================================
+
+LINPHONE_BEGIN_NAMESPACE
+
+/*
+ * Buffered writer of the log collection.
+ * Each logging thread formats its lines into its own ring buffer, without lock. A single thread drains the rings,
+ * orders the lines by date and gives them by batches to the sink, which writes and rotates the files.
+ * When a ring is full the line is dropped, the number of dropped lines is reported in the collected logs.
+ */
+class LogCollectionWriter {
+public:
+	// Receives complete lines, always called with the same mutex held.
+	using Sink = std::function<void (const char *lines, size_t size)>;
+
+	LogCollectionWriter (const std::string &programName, Sink sink);
+	~LogCollectionWriter ();
+
+	void start ();
+	// Writes the buffered lines before joining the writer thread.
+	void stop ();
+
+	bool isRunning () const {
+		return mRunning;
+	}
+
+	// Size of the ring buffer of the threads logging for the first time.
+	void setBufferSize (size_t size);
+	size_t getBufferSize () const {
+		return mBufferSize;
+	}
+
+	// Never blocks on the disk, the line is dropped if the ring of the calling thread is full.
+	void push (const char *domain, const char *levelName, const char *fmt, va_list args);
+
+	// Writes the buffered lines from the calling thread.
+	void flush ();
+
+private:
+	struct Ring;
+	struct Record;
+
+	Ring *getThreadRing ();
+	void run ();
+	void drain ();
+	void appendLine (std::string &batch, int64_t sec, int usec, const char *text, size_t size) const;
+
+	static constexpr size_t DefaultBufferSize = 64 * 1024;
+	static constexpr size_t BatchSize = 16 * 1024;
+
+	std::string mProgramName;
+	Sink mSink;
+
+	std::atomic<bool> mRunning{false};
+	std::atomic<size_t> mBufferSize{DefaultBufferSize};
+
+	std::mutex mRingsMutex;
+	std::vector<std::shared_ptr<Ring>> mRings;
+
+	// Only one thread drains the rings at a time.
+	std::mutex mDrainMutex;
+
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	bool mStopped = false;
+	std::thread mThread;
+
+	L_DISABLE_COPY(LogCollectionWriter);
+};
+
+LINPHONE_END_NAMESPACE
+
+#endif // ifndef _L_LOG_COLLECTION_WRITER_H_
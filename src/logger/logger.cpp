@@ -77,6 +77,26 @@ ostringstream &Logger::getOutput () {
 	return d->os;
 }
 
+bool Logger::isEnabled (Level level) {
+	switch (level) {
+		case Debug:
+			#if DEBUG_LOGS
+				return !!bctbx_log_level_enabled(BCTBX_LOG_DOMAIN, BCTBX_LOG_DEBUG);
+			#else
+				return false;
+			#endif // if DEBUG_LOGS
+		case Info:
+			return !!bctbx_log_level_enabled(BCTBX_LOG_DOMAIN, BCTBX_LOG_MESSAGE);
+		case Warning:
+			return !!bctbx_log_level_enabled(BCTBX_LOG_DOMAIN, BCTBX_LOG_WARNING);
+		case Error:
+			return !!bctbx_log_level_enabled(BCTBX_LOG_DOMAIN, BCTBX_LOG_ERROR);
+		case Fatal:
+			return true;
+	}
+	return true;
+}
+
 // -----------------------------------------------------------------------------
 
 class DurationLoggerPrivate : public BaseObjectPrivate {
@@ -45,6 +45,9 @@ public:
 
 	std::ostringstream &getOutput ();
 
+	// Tells whether the liblinphone log domain outputs this level, use L_LOG_ENABLED() to include the compile-time check.
+	static bool isEnabled (Level level);
+
 private:
 	L_DECLARE_PRIVATE(Logger);
 	L_DISABLE_COPY(Logger);
@@ -62,12 +65,34 @@ private:
 	L_DISABLE_COPY(DurationLogger);
 };
 
+// Turns the stream expression of a log statement into void, so that it can be an operand of the ternary operator.
+class LoggerVoidify {
+public:
+	void operator& (const std::ostream &) {}
+};
+
 LINPHONE_END_NAMESPACE
 
-#define lDebug() LinphonePrivate::Logger(LinphonePrivate::Logger::Debug).getOutput()
-#define lInfo() LinphonePrivate::Logger(LinphonePrivate::Logger::Info).getOutput()
-#define lWarning() LinphonePrivate::Logger(LinphonePrivate::Logger::Warning).getOutput()
-#define lError() LinphonePrivate::Logger(LinphonePrivate::Logger::Error).getOutput()
+// Lower levels are removed at compile time. Debug logs are only kept with DEBUG_LOGS.
+#ifndef L_LOG_MIN_LEVEL
+	#if DEBUG_LOGS
+		#define L_LOG_MIN_LEVEL LinphonePrivate::Logger::Debug
+	#else
+		#define L_LOG_MIN_LEVEL LinphonePrivate::Logger::Info
+	#endif // if DEBUG_LOGS
+#endif // ifndef L_LOG_MIN_LEVEL
+
+#define L_LOG_ENABLED(LEVEL) \
+	(LinphonePrivate::Logger::LEVEL >= L_LOG_MIN_LEVEL && LinphonePrivate::Logger::isEnabled(LinphonePrivate::Logger::LEVEL))
+
+// Neither the logger nor the streamed operands are evaluated when the level is disabled.
+#define L_LOG(LEVEL) \
+	!L_LOG_ENABLED(LEVEL) ? (void)0 : LinphonePrivate::LoggerVoidify() & LinphonePrivate::Logger(LinphonePrivate::Logger::LEVEL).getOutput()
+
+#define lDebug() L_LOG(Debug)
+#define lInfo() L_LOG(Info)
+#define lWarning() L_LOG(Warning)
+#define lError() L_LOG(Error)
 #define lFatal() LinphonePrivate::Logger(LinphonePrivate::Logger::Fatal).getOutput()
 
 #define L_BEGIN_LOG_EXCEPTION try {
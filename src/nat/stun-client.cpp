@@ -21,9 +21,9 @@
 
 #include "logger/logger.h"
 
-#include "stun-client.h"
-#include "c-wrapper/internal/c-tools.h"
 #include "c-wrapper/internal/c-tools.h"
+#include "core/core-p.h"
+#include "stun-client.h"
 
 // =============================================================================
 
@@ -31,123 +31,105 @@ using namespace std;
 
 LINPHONE_BEGIN_NAMESPACE
 
-int StunClient::run (int audioPort, int videoPort, int textPort) {
+namespace {
+	constexpr unsigned int PollPeriodMs = 10;
+	constexpr uint64_t RetransmitPeriodMs = 200;
+	constexpr uint64_t DiscoveryTimeoutMs = 2000;
+	constexpr int DefaultCacheLifetime = 120;
+}
+
+StunClient::~StunClient () {
+	cancel();
+}
+
+bool StunClient::start (int audioPort, int videoPort, int textPort, const Callback &callback) {
+	cancel();
 	stunDiscoveryDone = false;
-	if (linphone_core_ipv6_enabled(getCore()->getCCore())) {
+	LinphoneCore *lc = getCore()->getCCore();
+	if (linphone_core_ipv6_enabled(lc)) {
 		lWarning() << "STUN support is not implemented for ipv6";
-		return -1;
+		return false;
 	}
-	if (!linphone_core_get_stun_server(getCore()->getCCore()))
-		return -1;
-	const struct addrinfo *ai = linphone_core_get_stun_server_addrinfo(getCore()->getCCore());
-	if (!ai) {
+	if (!linphone_core_get_stun_server(lc))
+		return false;
+	serverAddrInfo = linphone_core_get_stun_server_addrinfo(lc);
+	if (!serverAddrInfo) {
 		lError() << "Could not obtain STUN server addrinfo";
-		return -1;
+		return false;
 	}
 
-	/* Create the RTP sockets and send STUN messages to the STUN server */
-	ortp_socket_t sockAudio = createStunSocket(audioPort);
-	if (sockAudio == -1)
-		return -1;
-	ortp_socket_t sockVideo = -1;
-	if (linphone_core_video_enabled(getCore()->getCCore())) {
-		sockVideo = createStunSocket(videoPort);
-		if (sockVideo == -1)
-			return -1;
-	}
-	ortp_socket_t sockText = -1;
-	if (linphone_core_realtime_text_enabled(getCore()->getCCore())) {
-		sockText = createStunSocket(textPort);
-		if (sockText == -1)
-			return -1;
+	streams[AudioIndex] = Stream();
+	streams[AudioIndex].name = "audio";
+	streams[AudioIndex].id = 1;
+	streams[AudioIndex].localPort = audioPort;
+	streams[AudioIndex].enabled = true;
+	streams[VideoIndex] = Stream();
+	streams[VideoIndex].name = "video";
+	streams[VideoIndex].id = 2;
+	streams[VideoIndex].localPort = videoPort;
+	streams[VideoIndex].enabled = !!linphone_core_video_enabled(lc);
+	streams[TextIndex] = Stream();
+	streams[TextIndex].name = "text";
+	streams[TextIndex].id = 3;
+	streams[TextIndex].localPort = textPort;
+	streams[TextIndex].enabled = !!linphone_core_realtime_text_enabled(lc);
+
+	char localIp[LINPHONE_IPADDR_SIZE];
+	linphone_core_get_local_ip(lc, AF_INET, nullptr, localIp);
+	cacheKeyPrefix = string(linphone_core_get_stun_server(lc)) + "|" + localIp + "|";
+
+	int pingTime;
+	if (loadFromCache(pingTime)) {
+		stunDiscoveryDone = true;
+		if (callback)
+			callback(pingTime);
+		return true;
 	}
+	this->callback = callback;
 
-	int ret = 0;
-	int loops = 0;
-	bool gotAudio = false;
-	bool gotVideo = false;
-	bool gotText = false;
-	bool coneAudio = false;
-	bool coneVideo = false;
-	bool coneText = false;
-	double elapsed;
-	struct timeval init;
-	ortp_gettimeofday(&init, nullptr);
-
-	do {
-		int id;
-		if ((loops % 20) == 0) {
-			lInfo() << "Sending STUN requests...";
-			sendStunRequest(sockAudio, ai->ai_addr, (socklen_t)ai->ai_addrlen, 11, true);
-			sendStunRequest(sockAudio, ai->ai_addr, (socklen_t)ai->ai_addrlen, 1, false);
-			if (sockVideo != -1) {
-				sendStunRequest(sockVideo, ai->ai_addr, (socklen_t)ai->ai_addrlen, 22, true);
-				sendStunRequest(sockVideo, ai->ai_addr, (socklen_t)ai->ai_addrlen, 2, false);
-			}
-			if (sockText != -1) {
-				sendStunRequest(sockText, ai->ai_addr, (socklen_t)ai->ai_addrlen, 33, true);
-				sendStunRequest(sockText, ai->ai_addr, (socklen_t)ai->ai_addrlen, 3, false);
-			}
+	/* Create the RTP sockets and send STUN messages to the STUN server */
+	for (auto &stream : streams) {
+		if (!stream.enabled)
+			continue;
+		stream.sock = createStunSocket(stream.localPort);
+		if (stream.sock == -1) {
+			closeSockets();
+			return false;
 		}
-		ms_usleep(10000);
+	}
 
-		if (recvStunResponse(sockAudio, audioCandidate, id) > 0) {
-			lInfo() << "STUN test result: local audio port maps to " << audioCandidate.address << ":" << audioCandidate.port;
-			if (id == 11) coneAudio = true;
-			gotAudio = true;
-		}
-		if (recvStunResponse(sockVideo, videoCandidate, id) > 0) {
-			lInfo() << "STUN test result: local video port maps to " << videoCandidate.address << ":" << videoCandidate.port;
-			if (id == 22) coneVideo = true;
-			gotVideo = true;
-		}
-		if (recvStunResponse(sockText, textCandidate, id) > 0) {
-			lInfo() << "STUN test result: local text port maps to " << textCandidate.address << ":" << textCandidate.port;
-			if (id == 33) coneText = true;
-			gotText = true;
-		}
-		struct timeval cur;
-		ortp_gettimeofday(&cur, nullptr);
-		elapsed = static_cast<double>(cur.tv_sec - init.tv_sec) * 1000 + static_cast<double>(cur.tv_usec - init.tv_usec) / 1000;
-		if (elapsed > 2000.) {
-			lInfo() << "STUN responses timeout, going ahead";
-			ret = -1;
-			break;
+	startTime = bctbx_get_cur_time_ms();
+	sendStunRequests();
+	timer = getCore()->createTimer([this]() {
+		if (!receiveStunResponses())
+			return true;
+
+		bool gotAll = true;
+		for (const auto &stream : streams) {
+			if (stream.enabled && !stream.gotResponse)
+				gotAll = false;
 		}
-		loops++;
-	} while (!(gotAudio && (gotVideo || sockVideo == -1) && (gotText || sockText == -1)));
-
-	if (ret == 0)
-		ret = (int)elapsed;
-
-	if (!gotAudio)
-		lError() << "No STUN server response for audio port";
-	else if (!coneAudio)
-		lInfo() << "NAT is symmetric for audio port";
-
-	if (sockVideo != -1) {
-		if (!gotVideo)
-			lError() << "No STUN server response for video port";
-		else if (!coneVideo)
-			lInfo() << "NAT is symmetric for video port";
-	}
+		finish(gotAll ? int(bctbx_get_cur_time_ms() - startTime) : -1);
+		// The timer has been destroyed by finish().
+		return false;
+	}, PollPeriodMs, "STUN discovery");
+	return true;
+}
 
-	if (sockText != -1) {
-		if (!gotText)
-			lError() << "No STUN server response for text port";
-		else if (!coneText)
-			lInfo() << "NAT is symmetric for text port";
+void StunClient::cancel () {
+	if (timer) {
+		belle_sip_source_cancel(timer);
+		belle_sip_object_unref(timer);
+		timer = nullptr;
 	}
-
-	close_socket(sockAudio);
-	if (sockVideo != -1) close_socket(sockVideo);
-	if (sockText != -1) close_socket(sockText);
-	stunDiscoveryDone = true;
-	return ret;
+	closeSockets();
 }
 
 void StunClient::updateMediaDescription (std::shared_ptr<SalMediaDescription> & md) const {
 	if (!stunDiscoveryDone) return;
+	const Candidate &audioCandidate = getAudioCandidate();
+	const Candidate &videoCandidate = getVideoCandidate();
+	const Candidate &textCandidate = getTextCandidate();
 	for (auto & stream : md->streams) {
 		if (!stream.enabled())
 			continue;
@@ -176,6 +158,131 @@ void StunClient::updateMediaDescription (std::shared_ptr<SalMediaDescription> &
 
 // -----------------------------------------------------------------------------
 
+string StunClient::getCacheKey (const Stream &stream) const {
+	return cacheKeyPrefix + Utils::toString(stream.localPort);
+}
+
+bool StunClient::loadFromCache (int &pingTime) {
+	auto &cache = getCore()->getPrivate()->stunCache;
+	const time_t now = ms_time(nullptr);
+	pingTime = 0;
+	for (auto &stream : streams) {
+		if (!stream.enabled)
+			continue;
+		auto it = cache.find(getCacheKey(stream));
+		if (it == cache.end() || it->second.expireTime <= now)
+			return false;
+		stream.candidate = it->second.candidate;
+		pingTime = max(pingTime, it->second.pingTime);
+	}
+
+	for (const auto &stream : streams) {
+		if (stream.enabled)
+			lInfo() << "STUN cached result: local " << stream.name << " port maps to " << stream.candidate.address << ":" << stream.candidate.port;
+	}
+	return true;
+}
+
+void StunClient::saveToCache (int pingTime) {
+	const int lifetime = linphone_config_get_int(linphone_core_get_config(getCore()->getCCore()), "net", "stun_cache_lifetime", DefaultCacheLifetime);
+	if (lifetime <= 0)
+		return;
+
+	auto &cache = getCore()->getPrivate()->stunCache;
+	const time_t now = ms_time(nullptr);
+	for (auto it = cache.begin(); it != cache.end(); ) {
+		if (it->second.expireTime <= now)
+			it = cache.erase(it);
+		else
+			++it;
+	}
+	for (const auto &stream : streams) {
+		if (!stream.enabled)
+			continue;
+		CacheEntry &entry = cache[getCacheKey(stream)];
+		entry.candidate = stream.candidate;
+		entry.pingTime = pingTime;
+		entry.expireTime = now + lifetime;
+	}
+}
+
+void StunClient::sendStunRequests () {
+	lInfo() << "Sending STUN requests...";
+	for (const auto &stream : streams) {
+		if (stream.sock == -1 || stream.gotResponse)
+			continue;
+		sendStunRequest(stream.sock, serverAddrInfo->ai_addr, (socklen_t)serverAddrInfo->ai_addrlen, stream.id * 11, true);
+		sendStunRequest(stream.sock, serverAddrInfo->ai_addr, (socklen_t)serverAddrInfo->ai_addrlen, stream.id, false);
+	}
+	lastSendTime = bctbx_get_cur_time_ms();
+}
+
+bool StunClient::receiveStunResponses () {
+	bool done = true;
+	for (auto &stream : streams) {
+		if (stream.sock == -1)
+			continue;
+		int id;
+		// Drain the socket, the answers to both requests may be waiting.
+		while (recvStunResponse(stream.sock, stream.candidate, id) > 0) {
+			if (!stream.gotResponse)
+				lInfo() << "STUN test result: local " << stream.name << " port maps to " << stream.candidate.address << ":" << stream.candidate.port;
+			if (id == stream.id * 11)
+				stream.cone = true;
+			stream.gotResponse = true;
+		}
+		if (!stream.gotResponse)
+			done = false;
+	}
+	if (done)
+		return true;
+
+	const uint64_t now = bctbx_get_cur_time_ms();
+	if (now - startTime > DiscoveryTimeoutMs) {
+		lInfo() << "STUN responses timeout, going ahead";
+		return true;
+	}
+	if (now - lastSendTime >= RetransmitPeriodMs)
+		sendStunRequests();
+	return false;
+}
+
+void StunClient::finish (int pingTime) {
+	for (const auto &stream : streams) {
+		if (!stream.enabled)
+			continue;
+		if (!stream.gotResponse)
+			lError() << "No STUN server response for " << stream.name << " port";
+		else if (!stream.cone)
+			lInfo() << "NAT is symmetric for " << stream.name << " port";
+	}
+
+	if (timer) {
+		getCore()->destroyTimer(timer);
+		timer = nullptr;
+	}
+	closeSockets();
+	stunDiscoveryDone = true;
+	if (pingTime >= 0)
+		saveToCache(pingTime);
+
+	if (callback) {
+		// The callback may restart or destroy this client.
+		Callback cb = move(callback);
+		callback = nullptr;
+		cb(pingTime);
+	}
+}
+
+void StunClient::closeSockets () {
+	for (auto &stream : streams) {
+		if (stream.sock != -1) {
+			close_socket(stream.sock);
+			stream.sock = -1;
+		}
+	}
+}
+
 ortp_socket_t StunClient::createStunSocket (int localPort) {
 	if (localPort < 0)
 		return -1;
@@ -226,7 +333,9 @@ int StunClient::recvStunResponse (ortp_socket_t sock, Candidate &candidate, int
 			}
 			if (len > 0)
 				candidate.address = L_C_TO_STRING(inet_ntoa(ia));
-		}
+			ms_stun_message_destroy(resp);
+		} else
+			len = -1;
 	}
 	return len;
 }
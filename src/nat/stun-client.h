@@ -20,6 +20,7 @@
 #ifndef _L_STUN_CLIENT_H_
 #define _L_STUN_CLIENT_H_
 
+#include <functional>
 #include <string>
 
 #include <ortp/port.h>
@@ -35,28 +36,53 @@ LINPHONE_BEGIN_NAMESPACE
 
 class SalMediaDescription;
 
+/*
+ * Basic discovery of the public address and ports of the RTP sockets.
+ * The discovery is driven by a timer of the main loop, so that it does not block the core while waiting for the
+ * responses. The results are kept by the core for [net] stun_cache_lifetime seconds and reused by the next discoveries
+ * from the same local address to the same STUN server.
+ */
 class StunClient : public CoreAccessor {
+public:
 	struct Candidate {
 		std::string address;
 		int port = 0;
 	};
 
-public:
+	// Mapped address of a local port, by STUN server and local address.
+	struct CacheEntry {
+		Candidate candidate;
+		int pingTime = 0;
+		time_t expireTime = 0;
+	};
+
+	// Called with the round trip time in milliseconds, or -1 if the discovery failed.
+	using Callback = std::function<void (int pingTime)>;
+
 	StunClient (const std::shared_ptr<Core> &core) : CoreAccessor(core) {}
+	~StunClient ();
+
+	// Returns false if the discovery cannot be done. The callback is called before returning if all the candidates
+	// are found in the cache.
+	bool start (int audioPort, int videoPort, int textPort, const Callback &callback);
+	void cancel ();
+
+	bool isRunning () const {
+		return timer != nullptr;
+	}
 
-	int run (int audioPort, int videoPort, int textPort);
 	void updateMediaDescription (std::shared_ptr<SalMediaDescription> & md) const;
 
 	const Candidate &getAudioCandidate () const {
-		return audioCandidate;
+		return streams[AudioIndex].candidate;
 	}
 
 	const Candidate &getVideoCandidate () const {
-		return videoCandidate;
+		return streams[VideoIndex].candidate;
 	}
 
 	const Candidate &getTextCandidate () const {
-		return textCandidate;
+		return streams[TextIndex].candidate;
 	}
 
 	ortp_socket_t createStunSocket (int localPort);
@@ -64,9 +90,39 @@ public:
 	int sendStunRequest (ortp_socket_t sock, const struct sockaddr *server, socklen_t addrlen, int id, bool changeAddr);
 
 private:
-	Candidate audioCandidate;
-	Candidate videoCandidate;
-	Candidate textCandidate;
+	struct Stream {
+		const char *name = nullptr;
+		// Transaction id of the binding request, the one asking the server to change its address is id * 11.
+		int id = 0;
+		int localPort = -1;
+		ortp_socket_t sock = -1;
+		bool enabled = false;
+		bool gotResponse = false;
+		bool cone = false;
+		Candidate candidate;
+	};
+
+	static constexpr size_t AudioIndex = 0;
+	static constexpr size_t VideoIndex = 1;
+	static constexpr size_t TextIndex = 2;
+
+	std::string getCacheKey (const Stream &stream) const;
+	bool loadFromCache (int &pingTime);
+	void saveToCache (int pingTime);
+
+	void sendStunRequests ();
+	// Returns true once all the enabled streams got a response or the discovery timed out.
+	bool receiveStunResponses ();
+	void finish (int pingTime);
+	void closeSockets ();
+
+	Stream streams[3];
+	Callback callback;
+	belle_sip_source_t *timer = nullptr;
+	const struct addrinfo *serverAddrInfo = nullptr;
+	std::string cacheKeyPrefix;
+	uint64_t startTime = 0;
+	uint64_t lastSendTime = 0;
 	bool stunDiscoveryDone = false;
 };
 
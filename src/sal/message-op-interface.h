@@ -60,13 +60,14 @@ protected:
 				BELLE_SIP_HEADER(belle_sip_header_content_length_create(0))
 			);
 		} else {
-			std::string body = content.getBodyAsUtf8String();
+			// Copied only once, by belle-sip, the content may be shared by several requests.
+			const std::vector<char> &body = content.getBody();
 			size_t contentLength = body.size();
 			belle_sip_message_add_header(
 				BELLE_SIP_MESSAGE(req),
 				BELLE_SIP_HEADER(belle_sip_header_content_length_create(contentLength))
 			);
-			belle_sip_message_set_body(BELLE_SIP_MESSAGE(req), body.c_str(), contentLength);
+			belle_sip_message_set_body(BELLE_SIP_MESSAGE(req), body.data(), contentLength);
 		}
 	}
 
@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2010-2021 Belledonne Communications SARL.
+ *
+ * This file is part of Liblinphone.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include "linphone/core.h"
+
+#include "friend-search-index.h"
+#include "logger/logger.h"
+
+// TODO: From coreapi. Remove me later.
+#include "private.h"
+
+// =============================================================================
+
+using namespace std;
+
+LINPHONE_BEGIN_NAMESPACE
+
+// Odr-used by min(), a definition is required before C++17.
+constexpr size_t FriendSearchIndex::MaxGramSize;
+
+FriendSearchIndex::FriendSearchIndex (LinphoneCore *core) : mCore(core) {}
+
+void FriendSearchIndex::build () {
+	mEntries.clear();
+	mFriendsById.clear();
+	mPostings.clear();
+	mNormalizationKey = getNormalizationKey();
+
+	for (const bctbx_list_t *fl = linphone_core_get_friends_lists(mCore); fl != nullptr; fl = bctbx_list_next(fl)) {
+		const LinphoneFriendList *fList = static_cast<const LinphoneFriendList *>(fl->data);
+		for (const bctbx_list_t *f = fList->friends; f != nullptr; f = bctbx_list_next(f))
+			updateFriend(static_cast<const LinphoneFriend *>(f->data));
+	}
+
+	lInfo() << "Friend search index built with " << mEntries.size() << " friends and " << mPostings.size() << " n-grams.";
+}
+
+void FriendSearchIndex::updateFriend (const LinphoneFriend *lFriend) {
+	removeFriend(lFriend);
+
+	Entry entry;
+	entry.id = mNextId++;
+	entry.grams = computeGrams(lFriend);
+	for (uint32_t gram : entry.grams)
+		mPostings[gram].push_back(entry.id);
+
+	mFriendsById[entry.id] = lFriend;
+	mEntries[lFriend] = move(entry);
+}
+
+void FriendSearchIndex::removeFriend (const LinphoneFriend *lFriend) {
+	auto it = mEntries.find(lFriend);
+	if (it == mEntries.end())
+		return;
+
+	const uint32_t id = it->second.id;
+	for (uint32_t gram : it->second.grams) {
+		auto postingIt = mPostings.find(gram);
+		if (postingIt == mPostings.end())
+			continue;
+
+		vector<uint32_t> &posting = postingIt->second;
+		auto idIt = lower_bound(posting.begin(), posting.end(), id);
+		if (idIt != posting.end() && *idIt == id)
+			posting.erase(idIt);
+		if (posting.empty())
+			mPostings.erase(postingIt);
+	}
+
+	mFriendsById.erase(id);
+	mEntries.erase(it);
+}
+
+bool FriendSearchIndex::isUpToDate () const {
+	return mNormalizationKey == getNormalizationKey();
+}
+
+bool FriendSearchIndex::findCandidates (const string &filter, vector<const LinphoneFriend *> &candidates) const {
+	candidates.clear();
+	if (filter.empty())
+		return false;
+
+	string filterLC = filter;
+	transform(filterLC.begin(), filterLC.end(), filterLC.begin(), [](unsigned char c){ return tolower(c); });
+
+	// Use the longest n-grams, they are the most selective ones.
+	const size_t gramSize = min(filterLC.size(), MaxGramSize);
+	vector<uint32_t> filterGrams;
+	for (size_t i = 0; i + gramSize <= filterLC.size(); ++i)
+		filterGrams.push_back(makeGram(filterLC.c_str() + i, gramSize));
+	sort(filterGrams.begin(), filterGrams.end());
+	filterGrams.erase(unique(filterGrams.begin(), filterGrams.end()), filterGrams.end());
+
+	vector<const vector<uint32_t> *> postings;
+	for (uint32_t gram : filterGrams) {
+		auto it = mPostings.find(gram);
+		if (it == mPostings.end())
+			return true; // No friend has this n-gram.
+		postings.push_back(&it->second);
+	}
+
+	// Start from the smallest posting to keep the intersections short.
+	sort(postings.begin(), postings.end(), [](const vector<uint32_t> *a, const vector<uint32_t> *b) {
+		return a->size() < b->size();
+	});
+
+	vector<uint32_t> ids = *postings.front();
+	vector<uint32_t> intersection;
+	for (size_t i = 1; i < postings.size() && !ids.empty(); ++i) {
+		intersection.clear();
+		set_intersection(
+			ids.cbegin(), ids.cend(),
+			postings[i]->cbegin(), postings[i]->cend(),
+			back_inserter(intersection)
+		);
+		ids.swap(intersection);
+	}
+
+	candidates.reserve(ids.size());
+	for (uint32_t id : ids)
+		candidates.push_back(mFriendsById.at(id));
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+
+string FriendSearchIndex::getNormalizationKey () const {
+	LinphoneProxyConfig *proxy = linphone_core_get_default_proxy_config(mCore);
+	if (!proxy)
+		return string();
+
+	const char *prefix = linphone_proxy_config_get_dial_prefix(proxy);
+	return string(prefix ? prefix : "") + (linphone_proxy_config_get_dial_escape_plus(proxy) ? "|+" : "|");
+}
+
+vector<uint32_t> FriendSearchIndex::computeGrams (const LinphoneFriend *lFriend) const {
+	vector<uint32_t> grams;
+
+	// Same fields as MagicSearch::searchInFriend.
+	const char *name = linphone_friend_get_name(lFriend);
+	if (name)
+		addGrams(name, grams);
+	if (linphone_core_vcard_supported() && linphone_friend_get_vcard(lFriend)) {
+		const char *fullName = linphone_vcard_get_full_name(linphone_friend_get_vcard(lFriend));
+		if (fullName)
+			addGrams(fullName, grams);
+	}
+
+	for (const bctbx_list_t *a = linphone_friend_get_addresses(lFriend); a != nullptr; a = bctbx_list_next(a)) {
+		const LinphoneAddress *lAddress = static_cast<const LinphoneAddress *>(a->data);
+		if (!lAddress)
+			continue;
+		if (linphone_address_get_username(lAddress))
+			addGrams(linphone_address_get_username(lAddress), grams);
+		if (linphone_address_get_display_name(lAddress))
+			addGrams(linphone_address_get_display_name(lAddress), grams);
+	}
+
+	LinphoneProxyConfig *proxy = linphone_core_get_default_proxy_config(mCore);
+	bctbx_list_t *phoneNumbers = linphone_friend_get_phone_numbers(lFriend);
+	for (const bctbx_list_t *p = phoneNumbers; p != nullptr; p = bctbx_list_next(p)) {
+		const char *number = static_cast<const char *>(p->data);
+		if (!number)
+			continue;
+		addGrams(number, grams);
+
+		if (proxy) {
+			char *normalized = linphone_proxy_config_normalize_phone_number(proxy, number);
+			if (normalized) {
+				addGrams(normalized, grams);
+				bctbx_free(normalized);
+			}
+		}
+
+		const LinphonePresenceModel *presence = linphone_friend_get_presence_model_for_uri_or_tel(lFriend, number);
+		char *contact = presence ? linphone_presence_model_get_contact(presence) : nullptr;
+		if (contact) {
+			addGrams(contact, grams);
+			bctbx_free(contact);
+		}
+	}
+	if (phoneNumbers)
+		bctbx_list_free(phoneNumbers);
+
+	sort(grams.begin(), grams.end());
+	grams.erase(unique(grams.begin(), grams.end()), grams.end());
+	return grams;
+}
+
+void FriendSearchIndex::addGrams (const string &str, vector<uint32_t> &grams) {
+	string strLC = str;
+	transform(strLC.begin(), strLC.end(), strLC.begin(), [](unsigned char c){ return tolower(c); });
+
+	for (size_t size = 1; size <= MaxGramSize; ++size) {
+		for (size_t i = 0; i + size <= strLC.size(); ++i)
+			grams.push_back(makeGram(strLC.c_str() + i, size));
+	}
+}
+
+uint32_t FriendSearchIndex::makeGram (const char *str, size_t size) {
+	// The size is stored in the high byte so that "a" and "a\0\0" are different keys.
+	uint32_t gram = uint32_t(size) << 24;
+	for (size_t i = 0; i < size; ++i)
+		gram |= uint32_t(static_cast<unsigned char>(str[i])) << (8 * (2 - i));
+	return gram;
+}
+
+LINPHONE_END_NAMESPACE
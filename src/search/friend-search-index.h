@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2010-2021 Belledonne Communications SARL.
+ *
+ * This file is part of Liblinphone.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _L_FRIEND_SEARCH_INDEX_H_
+#define _L_FRIEND_SEARCH_INDEX_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "linphone/types.h"
+#include "linphone/utils/general.h"
+
+// =============================================================================
+
+LINPHONE_BEGIN_NAMESPACE
+
+/*
+ * Inverted index of the friends of the core lists, used by MagicSearch.
+ * Every searchable string of a friend (names, usernames, phone numbers, raw and normalized, and presence
+ * contacts) is case-folded and cut into n-grams of 1 to MaxGramSize bytes. A filter is matched by a friend only
+ * if all the n-grams of the filter belong to this friend, so the intersection of their postings gives a small
+ * superset of the friends that MagicSearch has to score.
+ */
+class FriendSearchIndex {
+public:
+	FriendSearchIndex (LinphoneCore *core);
+
+	// Index all the friends of the core lists.
+	void build ();
+
+	// Add a friend or refresh its entry after an update.
+	void updateFriend (const LinphoneFriend *lFriend);
+	void removeFriend (const LinphoneFriend *lFriend);
+
+	// False if phone numbers were normalized with other dial parameters than the current ones.
+	bool isUpToDate () const;
+
+	/**
+	 * Get the friends which may match a filter.
+	 * @param[in] filter word we search
+	 * @param[out] candidates friends to check, in index insertion order
+	 * @return false if the filter is empty, in this case all friends must be checked
+	 **/
+	bool findCandidates (const std::string &filter, std::vector<const LinphoneFriend *> &candidates) const;
+
+	size_t getFriendCount () const {
+		return mEntries.size();
+	}
+
+private:
+	struct Entry {
+		uint32_t id;
+		std::vector<uint32_t> grams;
+	};
+
+	std::string getNormalizationKey () const;
+	std::vector<uint32_t> computeGrams (const LinphoneFriend *lFriend) const;
+
+	static void addGrams (const std::string &str, std::vector<uint32_t> &grams);
+	static uint32_t makeGram (const char *str, size_t size);
+
+	static constexpr size_t MaxGramSize = 3;
+
+	LinphoneCore *mCore;
+	std::string mNormalizationKey;
+
+	uint32_t mNextId = 0;
+	std::unordered_map<const LinphoneFriend *, Entry> mEntries;
+	std::unordered_map<uint32_t, const LinphoneFriend *> mFriendsById;
+
+	// Sorted ids of the friends which own each n-gram. Ids only grow so insertions are appends.
+	std::unordered_map<uint32_t, std::vector<uint32_t>> mPostings;
+
+	L_DISABLE_COPY(FriendSearchIndex);
+};
+
+LINPHONE_END_NAMESPACE
+
+#endif // ifndef _L_FRIEND_SEARCH_INDEX_H_
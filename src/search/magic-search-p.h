@@ -41,7 +41,10 @@ private:
 	belle_sip_source_t * mIteration;
 
 	std::shared_ptr< std::list<SearchResult>> mCacheResult;
+	// Ranked results of the running asynchronous search. The cache is only set with the final results.
+	std::shared_ptr< std::list<SearchResult>> mPartialResults;
 	SearchAsyncData mAsyncData;
+	size_t mEndedProviderCount; // Providers whose results have already been notified
 
 	L_DECLARE_PUBLIC(MagicSearch);
 };
@@ -25,6 +25,9 @@
 
 #include "c-wrapper/c-wrapper.h"
 #include "c-wrapper/internal/c-tools.h"
+#include "chat/chat-room/abstract-chat-room.h"
+#include "conference/participant.h"
+#include "core/core-p.h"
 #include "linphone/utils/utils.h"
 #include "linphone/core.h"
 #include "linphone/types.h"
@@ -53,6 +56,7 @@ MagicSearch::MagicSearch (const std::shared_ptr<Core> &core) : CoreAccessor(core
 	d->mCacheResult = nullptr;
 	d->mIteration = nullptr;
 	d->mAutoResetCache = TRUE;
+	d->mEndedProviderCount = 0;
 }
 
 MagicSearch::~MagicSearch () {
@@ -165,6 +169,7 @@ bool MagicSearch::iterate(void){
 	bool continueLoop = d->mAsyncData.getCurrentRequest(&request);
 	
 	if(mState == STATE_START){
+		d->mPartialResults = nullptr;
 		if(!getContactListFromFilterStartAsync(request.first,request.second, &d->mAsyncData)){
 			d->mAsyncData.initStartTime();
 			mState = STATE_WAIT;
@@ -175,9 +180,11 @@ bool MagicSearch::iterate(void){
 		if(getAddressIsEndAsync(&d->mAsyncData)){
 			mergeResults(request.first, request.second, &d->mAsyncData);
 			mState = STATE_SEND;
-		}
+		}else if(d->mAsyncData.getEndedDataCount() > d->mEndedProviderCount)
+			notifyPartialResults(request.first, request.second, &d->mAsyncData);
 	}
 	if( mState == STATE_SEND){
+		d->mPartialResults = nullptr;
 		processResults (d->mAsyncData.mSearchResults);
 		_linphone_magic_search_notify_search_results_received(L_GET_C_BACK_PTR(this));
 		d->mAsyncData.clear();
@@ -240,14 +247,14 @@ bool MagicSearch::getContactListFromFilterStartAsync (const string &filter, cons
 }
 
 list<SearchResult> MagicSearch::processResults(std::shared_ptr<list<SearchResult>> pResultList) {
-   uniqueItemsList(*pResultList.get());
+   rankResults(*pResultList.get());
    setSearchCache(pResultList);
    return getLastSearch();
 }
 
 std::list<SearchResult> MagicSearch::getLastSearch()const{
 	L_D();
-	list<SearchResult> returnList = *getSearchCache();
+	list<SearchResult> returnList = d->mPartialResults ? *d->mPartialResults : *getSearchCache();
 	LinphoneProxyConfig *proxy = nullptr;
 	if (getLimitedSearch() && returnList.size() > getSearchLimit()) {
 		auto limitIterator = returnList.begin();
@@ -283,6 +290,77 @@ static int compareStringItems(const char *a, const char *b) {
 	return strcmp(a, b);
 }
 
+namespace {
+	// Sort keys of a result, computed once instead of on each comparison.
+	struct RankedResult {
+		list<SearchResult>::iterator result;
+		size_t index; // Position in the unranked list, keeps the ranking stable.
+		string name;
+		string nameLC;
+		const char *username;
+		const char *domain;
+	};
+}
+
+static RankedResult makeRankedResult (list<SearchResult>::iterator result, size_t index) {
+	RankedResult ranked;
+	ranked.result = result;
+	ranked.index = index;
+	ranked.name = getDisplayNameFromSearchResult(*result);
+	ranked.nameLC.reserve(ranked.name.size());
+	for (char c : ranked.name)
+		ranked.nameLC.push_back(char(tolower(c)));
+	const LinphoneAddress *addr = result->getAddress();
+	ranked.username = addr ? linphone_address_get_username(addr) : nullptr;
+	ranked.domain = addr ? linphone_address_get_domain(addr) : nullptr;
+	return ranked;
+}
+
+// Check in order: Friend's display name, address username, address domain, phone number.
+static bool isRankedBefore (const RankedResult &lrr, const RankedResult &rrr) {
+	if (lrr.name == rrr.name && lrr.result->getAddress() && rrr.result->getAddress()) {
+		int usernameComp = compareStringItems(lrr.username, rrr.username);
+		if (usernameComp != 0)
+			return usernameComp < 0;
+		int domainComp = compareStringItems(lrr.domain, rrr.domain);
+		if (domainComp != 0)
+			return domainComp < 0;
+		const string &phoneNumber1 = lrr.result->getPhoneNumber();
+		const string &phoneNumber2 = rrr.result->getPhoneNumber();
+		if (!phoneNumber1.empty() && !phoneNumber2.empty() && phoneNumber1 != phoneNumber2)
+			return phoneNumber1 < phoneNumber2;
+	}
+
+	size_t cpt = 0;
+	while (lrr.nameLC.size() > cpt && rrr.nameLC.size() > cpt) {
+		int char1 = lrr.nameLC[cpt];
+		int char2 = rrr.nameLC[cpt];
+		if (char1 != char2)
+			return char1 < char2;
+		cpt++;
+	}
+	if (lrr.nameLC.size() != rrr.nameLC.size())
+		return lrr.nameLC.size() < rrr.nameLC.size();
+	return lrr.index < rrr.index;
+}
+
+// Same results for uniqueItemsList.
+static bool isSameResult (const SearchResult &lsr, const SearchResult &rsr) {
+	bool sip_addresses = false;
+	const LinphoneAddress *left = lsr.getAddress();
+	const LinphoneAddress *right = rsr.getAddress();
+	if (left == nullptr && right == nullptr) {
+		sip_addresses = true;
+	} else if (left != nullptr && right != nullptr) {
+		sip_addresses = linphone_address_weak_equal(left, right);
+	}
+
+	bool phone_numbers = lsr.getPhoneNumber() == rsr.getPhoneNumber();
+	bool capabilities = lsr.getCapabilities() == rsr.getCapabilities();
+
+	return sip_addresses && phone_numbers && capabilities;
+}
+
 /////////////////////
 // Private Methods //
 /////////////////////
@@ -345,46 +423,29 @@ list<SearchResult> MagicSearch::getAddressFromGroupChatRoomParticipants (
 	const list<SearchResult> &currentList
 ) const {
 	list<SearchResult> resultList;
-	const bctbx_list_t *chatRooms = linphone_core_get_chat_rooms(this->getCore()->getCCore());
+	const auto addResult = [&](const IdentityAddress &address, bool matchAll) {
+		LinphoneAddress *addr = linphone_address_new(address.asString().c_str());
+		if (!addr)
+			return;
 
-	// For all call log or when we reach the search limit
-	for (const bctbx_list_t *f = chatRooms ; f != nullptr ; f = bctbx_list_next(f)) {
-		LinphoneChatRoom *room = static_cast<LinphoneChatRoom*>(f->data);
-		if (linphone_chat_room_get_capabilities(room) & LinphoneChatRoomCapabilitiesConference) {
-			bctbx_list_t *participants = linphone_chat_room_get_participants(room);
-			for (const bctbx_list_t *p = participants ; p != nullptr ; p = bctbx_list_next(p)) {
-				LinphoneParticipant *participant = static_cast<LinphoneParticipant*>(p->data);
-				const LinphoneAddress *addr = linphone_address_clone(linphone_participant_get_address(participant));
-				if (filter.empty() && withDomain.empty()) {
-					if (findAddress(currentList, addr)) continue;
-					resultList.push_back(SearchResult(0, addr, "", nullptr));
-				} else {
-					unsigned int weight = searchInAddress(addr, filter, withDomain);
-					if (weight > getMinWeight()) {
-						if (findAddress(currentList, addr)) continue;
-						resultList.push_back(SearchResult(weight, addr, "", nullptr));
-					}
-				}
-				if (addr) {
-					linphone_address_unref(const_cast<LinphoneAddress *>(addr));
-				}
-			}
-			bctbx_list_free_with_data(participants, (bctbx_list_free_func)linphone_participant_unref);
-		} else if (linphone_chat_room_get_capabilities(room) & LinphoneChatRoomCapabilitiesBasic) {
-			LinphoneAddress *addr = linphone_address_clone(linphone_chat_room_get_peer_address(room));
-			if (filter.empty()) {
-				if (findAddress(currentList, addr)) continue;
+		if (matchAll) {
+			if (!findAddress(currentList, addr))
 				resultList.push_back(SearchResult(0, addr, "", nullptr));
-			} else {
-				unsigned int weight = searchInAddress(addr, filter, withDomain);
-				if (weight > getMinWeight()) {
-					if (findAddress(currentList, addr)) continue;
-					resultList.push_back(SearchResult(weight, addr, "", nullptr));
-				}
-			}
-			linphone_address_unref(addr);
+		} else {
+			unsigned int weight = searchInAddress(addr, filter, withDomain);
+			if (weight > getMinWeight() && !findAddress(currentList, addr))
+				resultList.push_back(SearchResult(weight, addr, "", nullptr));
 		}
+		linphone_address_unref(addr);
+	};
+
+	// Group chat rooms are always loaded, the peers of basic chat rooms are known without loading them.
+	for (const auto &chatRoom : getCore()->getChatRooms(LinphoneChatRoomCapabilitiesConference)) {
+		for (const auto &participant : chatRoom->getParticipants())
+			addResult(participant->getAddress(), filter.empty() && withDomain.empty());
 	}
+	for (const auto &peerAddress : getCore()->getChatRoomPeerAddresses(LinphoneChatRoomCapabilitiesBasic))
+		addResult(peerAddress, filter.empty());
 
 	return resultList;
 }
@@ -453,88 +514,44 @@ std::list<list<SearchResult>> MagicSearch::getAddressFromLDAPServer (
 #endif
 
 // List all searchs to be done. Provider order will prioritize results : next contacts will be removed if already exist in results
-void MagicSearch::beginNewSearchAsync (const string &filter, const string &withDomain, SearchAsyncData * asyncData) const{
-	const bctbx_list_t *friend_lists = linphone_core_get_friends_lists(this->getCore()->getCCore());
+void MagicSearch::beginNewSearchAsync (const string &filter, const string &withDomain, SearchAsyncData * asyncData) {
 	asyncData->clear();
-	list<SearchResult> friendsList;
-	for (const bctbx_list_t *fl = friend_lists ; fl != nullptr ; fl = bctbx_list_next(fl)) {
-		LinphoneFriendList *fList = static_cast<LinphoneFriendList*>(fl->data);
-		// For all friends or when we reach the search limit
-		for (bctbx_list_t *f = fList->friends ; f != nullptr ; f = bctbx_list_next(f)) {
-			list<SearchResult> fResults = searchInFriend(static_cast<LinphoneFriend*>(f->data), filter, withDomain);
-			addResultsToResultsList(fResults, friendsList);
-		}
-	}
-	asyncData->createResult(friendsList);
+	asyncData->createResult(searchInFriends(filter, withDomain));
+	notifyPartialResults(filter, withDomain, asyncData);
 #ifdef LDAP_ENABLED
 	getAddressFromLDAPServerStartAsync(filter, withDomain, asyncData);
 #endif
+	// LDAP results are still ahead of the local ones in the merge even if they arrive later.
 	asyncData->createResult(getAddressFromCallLog(filter, withDomain, list<SearchResult>()));
+	notifyPartialResults(filter, withDomain, asyncData);
 	asyncData->createResult(getAddressFromGroupChatRoomParticipants(filter, withDomain, list<SearchResult>()));
+	notifyPartialResults(filter, withDomain, asyncData);
+}
+
+void MagicSearch::notifyPartialResults (const string &filter, const string &withDomain, SearchAsyncData *asyncData) {
+	L_D();
+	mergeResults(filter, withDomain, asyncData);
+	// Not cached, a refined search must not continue from incomplete results.
+	rankResults(*asyncData->mSearchResults);
+	d->mPartialResults = asyncData->mSearchResults;
+	d->mEndedProviderCount = asyncData->getEndedDataCount();
+	_linphone_magic_search_notify_partial_search_results_received(L_GET_C_BACK_PTR(this));
 }
 
 void MagicSearch::mergeResults (const std::string& filter, const std::string withDomain, SearchAsyncData * asyncData) {
 	std::shared_ptr<list<SearchResult>> resultList = std::make_shared<list<SearchResult>>();
 	for(auto it = asyncData->mProviderResults.begin() ; it != asyncData->mProviderResults.end() ; ++it){
-		addResultsToResultsList(*it, *resultList, filter, withDomain);
+		// Copy, provider results are merged again each time a provider ends.
+		list<SearchResult> results = *it;
+		addResultsToResultsList(results, *resultList, filter, withDomain);
 	}
-	resultList->sort([](const SearchResult& lsr, const SearchResult& rsr) {
-		string name1 = getDisplayNameFromSearchResult(lsr);
-		string name2 = getDisplayNameFromSearchResult(rsr);
-
-		// Check in order: Friend's display name, address username, address domain, phone number
-		if (name1 == name2) {
-			if (lsr.getAddress() && rsr.getAddress()) {
-				int usernameComp = compareStringItems(linphone_address_get_username(lsr.getAddress()), linphone_address_get_username(rsr.getAddress()));
-				if (usernameComp == 0) {
-					int domainComp = strcmp(linphone_address_get_domain(lsr.getAddress()), linphone_address_get_domain(rsr.getAddress()));
-					if (domainComp == 0) {
-						if (!lsr.getPhoneNumber().empty() && !rsr.getPhoneNumber().empty()) {
-							int phoneComp = strcmp(lsr.getPhoneNumber().c_str(), rsr.getPhoneNumber().c_str());
-							if (phoneComp == 0) {
-								return true;
-							} else {
-								return phoneComp < 0;
-							}
-						}
-					} else {
-						return domainComp < 0;
-					}
-				} else {
-					return usernameComp < 0;
-				}
-			}
-		}
-		unsigned int cpt = 0;
-		while (name1.size() > cpt && name2.size() > cpt) {
-			int char1 = tolower(name1.at(cpt));
-			int char2 = tolower(name2.at(cpt));
-			if (char1 < char2) {
-				return true;
-			} else if (char1 > char2) {
-				return false;
-			}
-			cpt++;
-		}
-		return name1.size() < name2.size();
-	});
 	asyncData->setSearchResults(resultList);
 }
 
 std::shared_ptr<list<SearchResult>> MagicSearch::beginNewSearch (const string &filter, const string &withDomain) {
 	list<SearchResult> clResults, crResults;
 	list<list<SearchResult>> multiClResults;
-	std::shared_ptr<list<SearchResult>> resultList = std::make_shared<list<SearchResult>>();
-	const bctbx_list_t *friend_lists = linphone_core_get_friends_lists(this->getCore()->getCCore());
-
-	for (const bctbx_list_t *fl = friend_lists ; fl != nullptr ; fl = bctbx_list_next(fl)) {
-		LinphoneFriendList *fList = static_cast<LinphoneFriendList*>(fl->data);
-		// For all friends or when we reach the search limit
-		for (bctbx_list_t *f = fList->friends ; f != nullptr ; f = bctbx_list_next(f)) {
-			list<SearchResult> fResults = searchInFriend(static_cast<LinphoneFriend*>(f->data), filter, withDomain);
-			addResultsToResultsList(fResults, *resultList);
-		}
-	}
+	std::shared_ptr<list<SearchResult>> resultList = std::make_shared<list<SearchResult>>(searchInFriends(filter, withDomain));
 #ifdef LDAP_ENABLED
 	multiClResults = getAddressFromLDAPServer(filter, withDomain);
 	for(auto it = multiClResults.begin() ; it != multiClResults.end() ; ++it)
@@ -545,48 +562,6 @@ std::shared_ptr<list<SearchResult>> MagicSearch::beginNewSearch (const string &f
 	crResults = getAddressFromGroupChatRoomParticipants(filter, withDomain, *resultList);
 	addResultsToResultsList(crResults, *resultList);
 
-	resultList->sort([](const SearchResult& lsr, const SearchResult& rsr) {
-		string name1 = getDisplayNameFromSearchResult(lsr);
-		string name2 = getDisplayNameFromSearchResult(rsr);
-
-		// Check in order: Friend's display name, address username, address domain, phone number
-		if (name1 == name2) {
-			if (lsr.getAddress() && rsr.getAddress()) {
-				int usernameComp = compareStringItems(linphone_address_get_username(lsr.getAddress()), linphone_address_get_username(rsr.getAddress()));
-				if (usernameComp == 0) {
-					int domainComp = strcmp(linphone_address_get_domain(lsr.getAddress()), linphone_address_get_domain(rsr.getAddress()));
-					if (domainComp == 0) {
-						if (!lsr.getPhoneNumber().empty() && !rsr.getPhoneNumber().empty()) {
-							int phoneComp = strcmp(lsr.getPhoneNumber().c_str(), rsr.getPhoneNumber().c_str());
-							if (phoneComp == 0) {
-								return true;
-							} else {
-								return phoneComp < 0;
-							}
-						}
-					} else {
-						return domainComp < 0;
-					}
-				} else {
-					return usernameComp < 0;
-				}
-			}
-		}
-
-		unsigned int cpt = 0;
-		while (name1.size() > cpt && name2.size() > cpt) {
-			int char1 = tolower(name1.at(cpt));
-			int char2 = tolower(name2.at(cpt));
-			if (char1 < char2) {
-				return true;
-			} else if (char1 > char2) {
-				return false;
-			}
-			cpt++;
-		}
-		return name1.size() < name2.size();
-	});
-
 	return resultList;
 }
 
@@ -613,6 +588,37 @@ std::shared_ptr<list<SearchResult>> MagicSearch::continueSearch (const string &f
 	return resultList;
 }
 
+list<SearchResult> MagicSearch::searchInFriends (const string &filter, const string &withDomain) const {
+	list<SearchResult> resultList;
+	unique_ptr<FriendSearchIndex> &index = getCore()->getPrivate()->friendSearchIndex;
+	if (!index || !index->isUpToDate()) {
+		index.reset(new FriendSearchIndex(getCore()->getCCore()));
+		index->build();
+	}
+
+	vector<const LinphoneFriend *> candidates;
+	if (index->findCandidates(filter, candidates)) {
+		// Candidates are in index order, which is not the friend lists order after updates.
+		// It does not matter, results are sorted afterwards.
+		for (const LinphoneFriend *lFriend : candidates) {
+			list<SearchResult> fResults = searchInFriend(lFriend, filter, withDomain);
+			addResultsToResultsList(fResults, resultList);
+		}
+		return resultList;
+	}
+
+	const bctbx_list_t *friend_lists = linphone_core_get_friends_lists(this->getCore()->getCCore());
+	for (const bctbx_list_t *fl = friend_lists ; fl != nullptr ; fl = bctbx_list_next(fl)) {
+		LinphoneFriendList *fList = static_cast<LinphoneFriendList*>(fl->data);
+		// For all friends or when we reach the search limit
+		for (bctbx_list_t *f = fList->friends ; f != nullptr ; f = bctbx_list_next(f)) {
+			list<SearchResult> fResults = searchInFriend(static_cast<LinphoneFriend*>(f->data), filter, withDomain);
+			addResultsToResultsList(fResults, resultList);
+		}
+	}
+	return resultList;
+}
+
 list<SearchResult> MagicSearch::searchInFriend (const LinphoneFriend *lFriend, const string &filter, const string &withDomain) const{
 	list<SearchResult> friendResult;
 	string phoneNumber = "";
@@ -788,21 +794,61 @@ void MagicSearch::addResultsToResultsList (std::list<SearchResult> &results, std
 }
 
 void MagicSearch::uniqueItemsList (list<SearchResult> &list) const {
-	list.unique([](const SearchResult& lsr, const SearchResult& rsr){
-		bool sip_addresses = false;
-		const LinphoneAddress *left = lsr.getAddress();
-		const LinphoneAddress *right = rsr.getAddress();
-		if (left == nullptr && right == nullptr) {
-			sip_addresses = true;
-		} else if (left != nullptr && right != nullptr) {
-			sip_addresses = linphone_address_weak_equal(left, right);
+	list.unique(isSameResult);
+}
+
+void MagicSearch::rankResults (list<SearchResult> &results) const {
+	vector<RankedResult> rankedResults;
+	rankedResults.reserve(results.size());
+	size_t index = 0;
+	for (auto it = results.begin(); it != results.end(); ++it)
+		rankedResults.push_back(makeRankedResult(it, index++));
+
+	list<SearchResult> rankedList;
+	const size_t limit = getSearchLimit();
+	if (!getLimitedSearch() || limit == 0 || rankedResults.size() <= limit) {
+		sort(rankedResults.begin(), rankedResults.end(), isRankedBefore);
+		for (const RankedResult &ranked : rankedResults)
+			rankedList.splice(rankedList.end(), results, ranked.result);
+		uniqueItemsList(rankedList);
+		results.swap(rankedList);
+		return;
+	}
+
+	// Only the first results are displayed: keep the best ones in a bounded max-heap whose front is the worst kept.
+	vector<RankedResult> heap;
+	heap.reserve(limit + 1);
+	for (RankedResult &ranked : rankedResults) {
+		if (heap.size() == limit && !isRankedBefore(ranked, heap.front()))
+			continue;
+
+		// Equivalent to uniqueItemsList, duplicates have the same keys.
+		bool isDuplicate = false;
+		for (const RankedResult &kept : heap) {
+			if (kept.name == ranked.name && isSameResult(*kept.result, *ranked.result)) {
+				isDuplicate = true;
+				break;
+			}
+		}
+		if (isDuplicate) {
+			results.erase(ranked.result);
+			continue;
 		}
 
-		bool phone_numbers = lsr.getPhoneNumber() == rsr.getPhoneNumber();
-		bool capabilities = lsr.getCapabilities() == rsr.getCapabilities();
+		heap.push_back(move(ranked));
+		push_heap(heap.begin(), heap.end(), isRankedBefore);
+		if (heap.size() > limit) {
+			pop_heap(heap.begin(), heap.end(), isRankedBefore);
+			heap.pop_back();
+		}
+	}
 
-		return sip_addresses && phone_numbers && capabilities;
-	});
+	sort_heap(heap.begin(), heap.end(), isRankedBefore);
+	for (const RankedResult &ranked : heap)
+		rankedList.splice(rankedList.end(), results, ranked.result);
+	// The other results are not ranked but are kept in the cache for continueSearch.
+	rankedList.splice(rankedList.end(), results);
+	results.swap(rankedList);
 }
 
 LINPHONE_END_NAMESPACE
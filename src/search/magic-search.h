@@ -232,6 +232,15 @@ private:
 	 **/
 	std::shared_ptr<std::list<SearchResult> > continueSearch (const std::string &filter, const std::string &withDomain) const;
 
+	/**
+	 * Search in the friends of the core lists, using the friend search index to only check the friends that may match
+	 * @param[in] filter word we search
+	 * @param[in] withDomain domain which we want to search only
+	 * @return list of results from friends
+	 * @private
+	 **/
+	std::list<SearchResult> searchInFriends (const std::string &filter, const std::string &withDomain) const;
+
 	/**
 	 * Search informations in friend given
 	 * @param[in] lFriend friend whose informations will be check
@@ -272,6 +281,14 @@ private:
 	void addResultsToResultsList (std::list<SearchResult> &results, std::list<SearchResult> &srL) const;
 
 	void uniqueItemsList (std::list<SearchResult> &list) const;
+
+	/**
+	 * Sort results and remove duplicates. On a limited search, only the best getSearchLimit() results are ranked at
+	 * the beginning of the list, followed by the other results in no particular order.
+	 * @param[in, out] results list of results to rank
+	 * @private
+	 **/
+	void rankResults (std::list<SearchResult> &results) const;
 	enum{
 		STATE_START,
 		STATE_WAIT,
@@ -315,18 +332,28 @@ private:
 	void mergeResults (const std::string& filter, const std::string withDomain, SearchAsyncData * asyncData);
 
 	/**
-	 * @brief processResults Clean for unique items and set the cache.
+	 * @brief notifyPartialResults Merge the results of the providers that ended, rank them and notify them.
+	 * They are returned by getLastSearch() until the search ends but are not cached.
+	 * @param filter word we search.
+	 * @param withDomain domain which we want to search only.
+	 * @param asyncData Instance to use for all data storage.
+	 */
+	void notifyPartialResults (const std::string &filter, const std::string &withDomain, SearchAsyncData *asyncData);
+
+	/**
+	 * @brief processResults Rank the results and set the cache.
 	 * @return the cleaned list.
 	 */
 	std::list<SearchResult> processResults(std::shared_ptr<std::list<SearchResult> >);
 	
 	/**
 	 * @brief beginNewSearchAsync Same as beginNewSearch but on an asynchronous version : it will build the SearchAsyncData from async providers like LDAP.
+	 * Partial results are notified each time a synchronous provider ends.
 	 * @param filter word we search.
 	 * @param withDomain domain which we want to search only.
 	 * @param asyncData Instance to use for all data storage.
 	 */
-	void beginNewSearchAsync (const std::string &filter, const std::string &withDomain, SearchAsyncData * asyncData) const;
+	void beginNewSearchAsync (const std::string &filter, const std::string &withDomain, SearchAsyncData * asyncData);
 
 	/**
 	 * @brief addResultsToResultsList Same as addResultsToResultsList but apply an unicity filtering before splicing. It is usefull to prioritize results based to the order of providers.
@@ -108,6 +108,14 @@ std::vector<std::shared_ptr<SearchAsyncData::CbData> >& SearchAsyncData::getData
 	return mProvidersCbData;
 }
 
+size_t SearchAsyncData::getEndedDataCount() const{
+	size_t endCount = mProviderResults.size() - mProvidersCbData.size();
+	for(const auto &data : mProvidersCbData)
+		if(data->mEnd)
+			++endCount;
+	return endCount;
+}
+
 void SearchAsyncData::clear(){
 	mProvidersCbData.clear();
 	mProviderResults.clear();
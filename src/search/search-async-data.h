@@ -163,6 +163,12 @@ public:
 	 */
 	std::vector<std::shared_ptr<CbData> >& getData();
 
+	/**
+	 * @brief getEndedDataCount Count the providers that ended, synchronous ones included.
+	 * @return The number of providers results that are complete.
+	 */
+	size_t getEndedDataCount() const;
+
 	/**
 	 * @brief clear Clear results and providers
 	 */
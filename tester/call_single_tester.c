@@ -5025,6 +5025,18 @@ static void call_logs_migrate(void) {
 		}
 	}
 
+	// The migration succeeds even if the rc holds more logs than are kept in memory
+	logs_rc = bc_tester_res("rcfiles/laure_call_logs_rc");
+	linphone_config_set_int(linphone_core_get_config(laure->lc), "misc", "call_logs_migration_done", 0);
+	linphone_config_set_int(linphone_core_get_config(laure->lc), "misc", "history_cache_size", 5);
+	linphone_config_read_file(linphone_core_get_config(laure->lc), logs_rc);
+	ms_free(logs_rc);
+	linphone_core_migrate_logs_from_rc_to_db(laure->lc);
+	BC_ASSERT_EQUAL((int)bctbx_list_size(linphone_core_get_call_logs(laure->lc)), 5, int , "%d");
+	BC_ASSERT_EQUAL(linphone_core_get_call_history_size(laure->lc), 20, int , "%d");
+	BC_ASSERT_EQUAL(linphone_config_get_int(linphone_core_get_config(laure->lc), "misc", "call_logs_migration_done", 0), 1, int, "%d");
+	BC_ASSERT_FALSE(linphone_config_has_section(linphone_core_get_config(laure->lc), "call_log_0"));
+
 	call_logs_attr = linphone_core_get_call_logs_attribute(laure->lc);
 	*call_logs_attr = bctbx_list_free_with_data(*call_logs_attr, (void (*)(void*))linphone_call_log_unref);
 	*call_logs_attr = linphone_core_read_call_logs_from_config_file(laure->lc);
@@ -5133,6 +5145,91 @@ static void call_logs_sqlite_storage(void) {
 	ms_free(logs_db);
 }
 
+static void call_logs_sqlite_storage_paging(void) {
+	LinphoneCoreManager* marie = linphone_core_manager_new_with_proxies_check("empty_rc", FALSE);
+	char *logs_db = bc_tester_file("call_logs.db");
+	LinphoneAddress *marie_addr = linphone_address_new("sip:marie@sip.example.org");
+	LinphoneAddress *peer_addrs[5];
+	LinphoneAddress *peer_with_params = linphone_address_new("\"Peer\" <sip:peer0@sip.example.org;transport=tcp>");
+	bctbx_list_t *logs = NULL;
+	LinphoneCallLog *last = NULL;
+	int expected_duration = 49;
+	int pages = 0;
+	int i;
+
+	unlink(logs_db);
+	linphone_config_set_int(linphone_core_get_config(marie->lc), "misc", "history_cache_size", 10);
+	linphone_core_set_call_logs_database_path(marie->lc, logs_db);
+
+	for (i = 0; i < 5; i++) {
+		char *uri = bctbx_strdup_printf("sip:peer%i@sip.example.org", i);
+		peer_addrs[i] = linphone_address_new(uri);
+		bctbx_free(uri);
+	}
+	for (i = 0; i < 50; i++) {
+		LinphoneAddress *peer = peer_addrs[i % 5];
+		LinphoneCallDir dir = (i % 2) ? LinphoneCallIncoming : LinphoneCallOutgoing;
+		linphone_call_log_unref(linphone_core_create_call_log(marie->lc,
+			dir == LinphoneCallOutgoing ? marie_addr : peer,
+			dir == LinphoneCallOutgoing ? peer : marie_addr,
+			dir, i, time(NULL), time(NULL), LinphoneCallSuccess, FALSE, 1.0));
+	}
+
+	BC_ASSERT_EQUAL(linphone_core_get_call_history_size(marie->lc), 50, int, "%d");
+	BC_ASSERT_EQUAL((int)bctbx_list_size(linphone_core_get_call_logs(marie->lc)), 10, int, "%d");
+
+	// Browse the whole history, from the most recent log to the oldest one.
+	do {
+		bctbx_list_t *it;
+		logs = linphone_core_get_call_history_page(marie->lc, last, 20);
+		if (last) linphone_call_log_unref(last);
+		last = NULL;
+		if (!logs) break;
+		if (pages == 0) {
+			BC_ASSERT_PTR_EQUAL(bctbx_list_get_data(logs), bctbx_list_get_data(linphone_core_get_call_logs(marie->lc)));
+		}
+		for (it = logs; it != NULL; it = bctbx_list_next(it)) {
+			BC_ASSERT_EQUAL(linphone_call_log_get_duration((LinphoneCallLog *)bctbx_list_get_data(it)), expected_duration, int, "%d");
+			expected_duration--;
+		}
+		last = linphone_call_log_ref((LinphoneCallLog *)bctbx_list_get_data(bctbx_list_last_elem(logs)));
+		bctbx_list_free_with_data(logs, (bctbx_list_free_func)linphone_call_log_unref);
+		pages++;
+	} while (pages < 10);
+	BC_ASSERT_EQUAL(pages, 3, int, "%d");
+	BC_ASSERT_EQUAL(expected_duration, -1, int, "%d");
+
+	logs = linphone_core_get_call_history_for_address(marie->lc, peer_addrs[0]);
+	BC_ASSERT_EQUAL((int)bctbx_list_size(logs), 10, int, "%d");
+	bctbx_list_free_with_data(logs, (bctbx_list_free_func)linphone_call_log_unref);
+
+	logs = linphone_core_get_call_history_for_address(marie->lc, peer_with_params);
+	BC_ASSERT_EQUAL((int)bctbx_list_size(logs), 10, int, "%d");
+	bctbx_list_free_with_data(logs, (bctbx_list_free_func)linphone_call_log_unref);
+
+	logs = linphone_core_get_call_history_2(marie->lc, peer_addrs[1], marie_addr);
+	BC_ASSERT_EQUAL((int)bctbx_list_size(logs), 10, int, "%d");
+	bctbx_list_free_with_data(logs, (bctbx_list_free_func)linphone_call_log_unref);
+
+	logs = linphone_core_get_call_history_2(marie->lc, marie_addr, peer_addrs[1]);
+	BC_ASSERT_EQUAL((int)bctbx_list_size(logs), 0, int, "%d");
+	bctbx_list_free_with_data(logs, (bctbx_list_free_func)linphone_call_log_unref);
+
+	// Reopening the database only loads the most recent logs.
+	linphone_core_set_call_logs_database_path(marie->lc, NULL);
+	linphone_core_set_call_logs_database_path(marie->lc, logs_db);
+	BC_ASSERT_EQUAL((int)bctbx_list_size(linphone_core_get_call_logs(marie->lc)), 10, int, "%d");
+	BC_ASSERT_EQUAL(linphone_core_get_call_history_size(marie->lc), 50, int, "%d");
+
+	for (i = 0; i < 5; i++)
+		linphone_address_unref(peer_addrs[i]);
+	linphone_address_unref(peer_with_params);
+	linphone_address_unref(marie_addr);
+	linphone_core_manager_destroy(marie);
+	unlink(logs_db);
+	ms_free(logs_db);
+}
+
 static void call_with_http_proxy(void) {
 	LinphoneCoreManager* marie = linphone_core_manager_create("marie_rc");
 	LinphoneCoreManager* pauline = linphone_core_manager_create("pauline_rc");
@@ -5778,6 +5875,7 @@ test_t call_tests[] = {
 	TEST_NO_TAG("Call log working if no db set", call_logs_if_no_db_set),
 	TEST_NO_TAG("Call log storage migration from rc to db", call_logs_migrate),
 	TEST_NO_TAG("Call log storage in sqlite database", call_logs_sqlite_storage),
+	TEST_NO_TAG("Call log paging in sqlite database", call_logs_sqlite_storage_paging),
 	TEST_NO_TAG("Call with custom RTP Modifier", call_with_custom_rtp_modifier),
 	TEST_NO_TAG("Call paused resumed with custom RTP Modifier", call_paused_resumed_with_custom_rtp_modifier),
 	TEST_NO_TAG("Call record with custom RTP Modifier", call_record_with_custom_rtp_modifier),
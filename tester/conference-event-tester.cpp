@@ -18,6 +18,7 @@
  */
 
 #include <map>
+#include <sstream>
 #include <string>
 
 #include "c-wrapper/c-wrapper.h"
@@ -26,6 +27,8 @@
 #include "call/call.h"
 #include "conference_private.h"
 #include "conference/conference-listener.h"
+#include "conference/handlers/conference-info-parser.h"
+#include "conference/handlers/local-audio-video-conference-event-handler.h"
 #include "conference/handlers/local-conference-event-handler.h"
 #include "conference/handlers/remote-conference-event-handler.h"
 #include "conference/local-conference.h"
@@ -571,6 +574,9 @@ static const char *confUri = "sips:conf233@example.com";
 
 L_ENABLE_ATTR_ACCESS(LocalConference, shared_ptr<LocalConferenceEventHandler>, eventHandler);
 
+typedef MediaConference::LocalConference MediaLocalConference;
+L_ENABLE_ATTR_ACCESS(MediaLocalConference, shared_ptr<LocalAudioVideoConferenceEventHandler>, eventHandler);
+
 class ConferenceEventTester : public RemoteConference {
 public:
 	ConferenceEventTester (const shared_ptr<Core> &core, const Address &confAddr);
@@ -781,6 +787,17 @@ void first_notify_parsing() {
 
 	snprintf(notify, size, first_notify, confUri);
 
+	// A malformed notify leaves the conference and its version untouched.
+	string truncated(notify);
+	truncated.resize(truncated.size() / 2);
+	Content truncatedContent;
+	truncatedContent.setBodyFromUtf8(truncated);
+	truncatedContent.setContentType(ContentType::ConferenceInfo);
+	tester->handler->notifyReceived(truncatedContent);
+	BC_ASSERT_EQUAL(tester->handler->getLastNotify(), 0, unsigned int, "%u");
+	BC_ASSERT_TRUE(tester->confSubject.empty());
+	BC_ASSERT_EQUAL((int)tester->participants.size(), 0, int, "%d");
+
 	Content content;
 	content.setBodyFromUtf8(notify);
 	content.setContentType(ContentType::ConferenceInfo);
@@ -1241,6 +1258,59 @@ void send_first_notify() {
 	linphone_core_manager_destroy(pauline);
 }
 
+void send_full_state_snapshot() {
+	LinphoneCoreManager *marie = linphone_core_manager_new("marie_rc");
+	LinphoneCoreManager *pauline = linphone_core_manager_new(transport_supported(LinphoneTransportTls) ? "pauline_rc" : "pauline_tcp_rc");
+	char *identityStr = linphone_address_as_string(pauline->identity);
+	Address addr(identityStr);
+	bctbx_free(identityStr);
+	shared_ptr<ConferenceEventTester> tester = make_shared<ConferenceEventTester>(marie->lc->cppPtr, addr);
+	shared_ptr<LocalConference> localConf = make_shared<LocalConference>(pauline->lc->cppPtr, addr, nullptr, ConferenceParams::create(pauline->lc));
+	LinphoneAddress *cBobAddr = linphone_core_interpret_url(marie->lc, bobUri);
+	char *bobAddrStr = linphone_address_as_string(cBobAddr);
+	Address bobAddr(bobAddrStr);
+	bctbx_free(bobAddrStr);
+	linphone_address_unref(cBobAddr);
+	LinphoneAddress *cAliceAddr = linphone_core_interpret_url(marie->lc, aliceUri);
+	char *aliceAddrStr = linphone_address_as_string(cAliceAddr);
+	Address aliceAddr(aliceAddrStr);
+	bctbx_free(aliceAddrStr);
+	linphone_address_unref(cAliceAddr);
+
+	localConf->addParticipant(bobAddr);
+	localConf->setSubject("A random test subject");
+
+	LocalConferenceEventHandler *localHandler = (L_ATTR_GET(localConf.get(), eventHandler)).get();
+	localConf->setConferenceAddress(ConferenceAddress(addr));
+	string notify = localHandler->createNotifyFullState(NULL);
+
+	// Subscribers at the same version get the same body, even if the free-text time changed.
+	ms_sleep(1);
+	BC_ASSERT_STRING_EQUAL(localHandler->createNotifyFullState(NULL).c_str(), notify.c_str());
+
+	localConf->addParticipant(aliceAddr);
+	localConf->setSubject("Another random test subject...");
+	string newNotify = localHandler->createNotifyFullState(NULL);
+	BC_ASSERT_STRING_NOT_EQUAL(newNotify.c_str(), notify.c_str());
+
+	const_cast<ConferenceAddress &>(tester->handler->getConferenceId().getPeerAddress()) = ConferenceAddress(addr);
+
+	Content content;
+	content.setBodyFromUtf8(newNotify);
+	content.setContentType(ContentType::ConferenceInfo);
+	tester->handler->notifyReceived(content);
+
+	BC_ASSERT_STRING_EQUAL(tester->confSubject.c_str(), "Another random test subject...");
+	BC_ASSERT_EQUAL((int)tester->participants.size(), 2, int, "%d");
+	BC_ASSERT_TRUE(tester->participants.find(bobAddr.asString()) != tester->participants.end());
+	BC_ASSERT_TRUE(tester->participants.find(aliceAddr.asString()) != tester->participants.end());
+
+	tester = nullptr;
+	localConf = nullptr;
+	linphone_core_manager_destroy(marie);
+	linphone_core_manager_destroy(pauline);
+}
+
 void send_added_notify_through_address() {
 	LinphoneCoreManager *marie = linphone_core_manager_new("marie_rc");
 	LinphoneCoreManager *pauline = linphone_core_manager_new(transport_supported(LinphoneTransportTls) ? "pauline_rc" : "pauline_tcp_rc");
@@ -1668,6 +1738,97 @@ void send_removed_notify_through_call() {
 
 
 
+void send_notifies_in_batches() {
+	LinphoneCoreManager *pauline = create_mgr_for_conference(transport_supported(LinphoneTransportTls) ? "pauline_rc" : "pauline_tcp_rc", TRUE);
+	LinphoneCoreManager *marie = NULL;
+	LinphoneCoreManager *laure = NULL;
+	LinphoneCoreManager *chloe = NULL;
+
+	// Only one NOTIFY is sent per main loop iteration, the next ones are queued.
+	linphone_config_set_int(linphone_core_get_config(pauline->lc), "misc", "conference_notify_batch_size", 1);
+
+	bctbx_list_t *lcs = NULL;
+	lcs = bctbx_list_append(lcs, pauline->lc);
+
+	bctbx_list_t *mgrs = NULL;
+	mgrs = bctbx_list_append(mgrs, pauline);
+
+	char *identityStr = linphone_address_as_string(pauline->identity);
+	Address addr(identityStr);
+	bctbx_free(identityStr);
+	stats initialPaulineStats = pauline->stat;
+	{
+		shared_ptr<MediaConference::LocalConference> localConf = std::shared_ptr<MediaConference::LocalConference>(new MediaConference::LocalConference(pauline->lc->cppPtr, addr, nullptr, ConferenceParams::create(pauline->lc)), [](MediaConference::LocalConference * c){c->unref();});
+
+		BC_ASSERT_TRUE(wait_for_list(lcs, &pauline->stat.number_of_LinphoneConferenceStateCreationPending, initialPaulineStats.number_of_LinphoneConferenceStateCreationPending + 1, 5000));
+
+		std::shared_ptr<ConferenceListenerInterfaceTester> confListener = std::make_shared<ConferenceListenerInterfaceTester>();
+		localConf->addListener(confListener);
+
+		// Add participants
+		marie = create_core_and_add_to_conference("marie_rc", &mgrs, &lcs, confListener, localConf, pauline, FALSE);
+		chloe = create_core_and_add_to_conference("chloe_rc", &mgrs, &lcs, confListener, localConf, pauline, FALSE);
+		laure = create_core_and_add_to_conference((liblinphone_tester_ipv6_available()) ? "laure_tcp_rc" : "laure_rc_udp", &mgrs, &lcs, confListener, localConf, pauline, FALSE);
+		BC_ASSERT_TRUE(wait_for_list(lcs, &laure->stat.number_of_LinphoneConferenceStateCreated, 1, 5000));
+		BC_ASSERT_TRUE(wait_for_list(lcs, &pauline->stat.number_of_LinphoneConferenceStateCreated, initialPaulineStats.number_of_LinphoneConferenceStateCreated + 1, 5000));
+		BC_ASSERT_TRUE(wait_for_list(lcs, &marie->stat.number_of_LinphoneConferenceStateCreated, 1, 5000));
+		BC_ASSERT_TRUE(wait_for_list(lcs, &chloe->stat.number_of_LinphoneConferenceStateCreated, 1, 5000));
+
+		stats initialMarieStats = marie->stat;
+		stats initialChloeStats = chloe->stat;
+		stats initialLaureStats = laure->stat;
+
+		// Without iterating the cores, all the NOTIFYs but the first one stay queued.
+		localConf->setSubject("First subject");
+		localConf->setSubject("Second subject");
+		localConf->setSubject("Third subject");
+
+		// Laure subscribes again before the queue is drained: her full state replaces her pending NOTIFYs.
+		LocalConferenceEventHandler *localHandler = (L_ATTR_GET(localConf.get(), eventHandler)).get();
+		char *laureIdentityStr = linphone_address_as_string(laure->identity);
+		std::shared_ptr<Participant> laureParticipant = localConf->findParticipant(IdentityAddress(laureIdentityStr));
+		bctbx_free(laureIdentityStr);
+		BC_ASSERT_PTR_NOT_NULL(laureParticipant);
+		if (laureParticipant) {
+			std::shared_ptr<ParticipantDevice> laureDevice = laureParticipant->getDevices().front();
+			localHandler->subscribeReceived(laureDevice->getConferenceSubscribeEvent());
+		}
+
+		// Marie and Chloe get the three subject changes and the device added by Laure's subscription.
+		BC_ASSERT_TRUE(wait_for_list(lcs, &marie->stat.number_of_NotifyReceived, initialMarieStats.number_of_NotifyReceived + 4, 5000));
+		BC_ASSERT_TRUE(wait_for_list(lcs, &chloe->stat.number_of_NotifyReceived, initialChloeStats.number_of_NotifyReceived + 4, 5000));
+		BC_ASSERT_TRUE(wait_for_list(lcs, &laure->stat.number_of_NotifyReceived, initialLaureStats.number_of_NotifyReceived + 1, 5000));
+
+		// Let the timer run on an empty queue: no other NOTIFY is sent to Laure.
+		BC_ASSERT_FALSE(wait_for_list(lcs, &laure->stat.number_of_NotifyReceived, initialLaureStats.number_of_NotifyReceived + 2, 1000));
+		BC_ASSERT_EQUAL(laure->stat.number_of_NotifyReceived, initialLaureStats.number_of_NotifyReceived + 1, int, "%d");
+		BC_ASSERT_EQUAL(marie->stat.number_of_NotifyReceived, initialMarieStats.number_of_NotifyReceived + 4, int, "%d");
+		BC_ASSERT_EQUAL(chloe->stat.number_of_NotifyReceived, initialChloeStats.number_of_NotifyReceived + 4, int, "%d");
+
+		localConf->terminate();
+
+		for (bctbx_list_t *it = mgrs; it; it = bctbx_list_next(it)) {
+			LinphoneCoreManager * m = reinterpret_cast<LinphoneCoreManager *>(bctbx_list_get_data(it));
+			// Wait for all calls to be terminated
+			BC_ASSERT_TRUE(wait_for_list(lcs, &m->stat.number_of_LinphoneCallEnd, (int)bctbx_list_size(linphone_core_get_calls(m->lc)), 5000));
+			BC_ASSERT_TRUE(wait_for_list(lcs, &m->stat.number_of_LinphoneCallReleased, (int)bctbx_list_size(linphone_core_get_calls(m->lc)), 5000));
+
+			// Wait for all conferences to be terminated
+			BC_ASSERT_TRUE(wait_for_list(lcs, &m->stat.number_of_LinphoneConferenceStateTerminationPending, m->stat.number_of_LinphoneConferenceStateCreated, 5000));
+			BC_ASSERT_TRUE(wait_for_list(lcs, &m->stat.number_of_LinphoneConferenceStateTerminated, m->stat.number_of_LinphoneConferenceStateCreated, 5000));
+			BC_ASSERT_TRUE(wait_for_list(lcs, &m->stat.number_of_LinphoneConferenceStateDeleted, m->stat.number_of_LinphoneConferenceStateCreated, 5000));
+		}
+	}
+
+	destroy_mgr_in_conference(marie);
+	destroy_mgr_in_conference(pauline);
+	destroy_mgr_in_conference(laure);
+	destroy_mgr_in_conference(chloe);
+
+	bctbx_list_free(lcs);
+	bctbx_list_free(mgrs);
+}
+
 void send_removed_notify() {
 	LinphoneCoreManager *marie = linphone_core_manager_new("marie_rc");
 	LinphoneCoreManager *pauline = linphone_core_manager_new(transport_supported(LinphoneTransportTls) ? "pauline_rc" : "pauline_tcp_rc");
@@ -2016,6 +2177,215 @@ void one_to_one_keyword () {
 	linphone_core_manager_destroy(pauline);
 }
 
+static const char *conference_info_edge_cases = \
+"<?xml version=\"1.0\" encoding=\"UTF-8\"?>"\
+"<conference-info xmlns=\"urn:ietf:params:xml:ns:conference-info\" xmlns:linphone-cie=\"linphone:xml:ns:conference-info-linphone-extension\" entity=\"%s\" state=\"partial\" version=\"7\">"\
+" <conference-description>"\
+"  <display-text>Edge cases</display-text>"\
+"  <subject><![CDATA[Subject & <cdata>]]></subject>"\
+"  <free-text>1234567890</free-text>"\
+"  <keywords>one-to-one  secured</keywords>"\
+"  <available-media>"\
+"   <entry label=\"1\"><type>audio</type><status>sendrecv</status></entry>"\
+"   <entry label=\"2\"><type>video</type><status>recvonly</status></entry>"\
+"   <entry label=\"3\"><type>text</type></entry>"\
+"  </available-media>"\
+"  <linphone-cie:ephemeral><linphone-cie:mode>admin-managed</linphone-cie:mode><linphone-cie:lifetime>86400</linphone-cie:lifetime></linphone-cie:ephemeral>"\
+" </conference-description>"\
+" <conference-state><user-count>3</user-count></conference-state>"\
+" <users>"\
+"  <user state=\"full\"><endpoint entity=\"sip:nobody@example.com;gr=1\"/></user>"\
+"  <user entity=\"sip:bob@example.com\" state=\"deleted\"/>"\
+"  <user entity=\"sip:alice@example.com\" state=\"partial\">"\
+"   <roles><entry>participant</entry></roles>"\
+"   <endpoint entity=\"sip:alice@example.com;gr=1\" state=\"deleted\"/>"\
+"   <endpoint><display-text>No entity</display-text></endpoint>"\
+"   <endpoint entity=\"sip:alice@example.com;gr=2\">"\
+"    <display-text>Alice &amp; co</display-text>"\
+"    <media id=\"1\"><type>audio</type><src-id>42</src-id><status>sendonly</status></media>"\
+"    <media id=\"2\"><type>video</type><status>inactive</status></media>"\
+"    <linphone-cie:service-description><linphone-cie:service-id>ephemeral</linphone-cie:service-id><linphone-cie:version>1.1</linphone-cie:version></linphone-cie:service-description>"\
+"   </endpoint>"\
+"  </user>"\
+" </users>"\
+" <sidebars-by-val>"\
+"  <entry entity=\"sips:sidebar@example.com\">"\
+"   <users><user entity=\"sip:sidebar-user@example.com\"/></users>"\
+"  </entry>"\
+" </sidebars-by-val>"\
+"</conference-info>";
+
+static const char *conferenceInfoStateToString (ConferenceInfoParser::State state) {
+	switch (state) {
+		case ConferenceInfoParser::State::Full:
+			return "full";
+		case ConferenceInfoParser::State::Partial:
+			return "partial";
+		case ConferenceInfoParser::State::Deleted:
+			return "deleted";
+	}
+	return "";
+}
+
+// Records the events of a conference-info parser as text lines.
+class ConferenceInfoRecorder : public ConferenceInfoParser::Listener {
+public:
+	bool onConferenceInfo (const ConferenceInfoParser::ConferenceInfo &conferenceInfo) override {
+		events << "conference-info " << conferenceInfo.entity << " " << conferenceInfoStateToString(conferenceInfo.state);
+		if (conferenceInfo.hasVersion)
+			events << " " << conferenceInfo.version;
+		events << "\n";
+		return true;
+	}
+
+	void onConferenceDescription (const ConferenceInfoParser::ConferenceDescription &description) override {
+		events << "conference-description [" << description.subject << "]";
+		if (description.hasFreeText)
+			events << " [" << description.freeText << "]";
+		for (const auto &keyword : description.keywords)
+			events << " " << keyword;
+		for (const auto &media : description.availableMedia)
+			events << " " << media.type << "=" << (int)media.direction;
+		if (description.hasEphemeral)
+			events << " ephemeral " << description.ephemeralMode << " " << description.ephemeralLifetime;
+		events << "\n";
+	}
+
+	void onUsers () override {
+		events << "users\n";
+	}
+
+	void onUser (const ConferenceInfoParser::User &user) override {
+		events << "user " << user.entity << " " << conferenceInfoStateToString(user.state);
+		if (user.hasRoles) {
+			events << " roles";
+			for (const auto &role : user.roles)
+				events << " " << role;
+		}
+		events << "\n";
+	}
+
+	void onEndpoint (const ConferenceInfoParser::User &user, const ConferenceInfoParser::Endpoint &endpoint) override {
+		events << "endpoint " << user.entity << " " << endpoint.entity << " " << conferenceInfoStateToString(endpoint.state)
+			<< " [" << endpoint.displayText << "]";
+		for (const auto &media : endpoint.media)
+			events << " " << media.type << "=" << (int)media.direction << "/" << media.srcId;
+		events << "\n";
+	}
+
+	ostringstream events;
+};
+
+static bool parse_conference_info_with_xsd (const string &body, ConferenceInfoParser::Listener &listener) {
+	istringstream data(body);
+	try {
+		unique_ptr<Xsd::ConferenceInfo::ConferenceType> confInfo = Xsd::ConferenceInfo::parseConferenceInfo(data, Xsd::XmlSchema::Flags::dont_validate);
+		ConferenceInfoParser::walk(*confInfo, listener);
+	} catch (const exception &) {
+		return false;
+	}
+	return true;
+}
+
+static string format_conference_info (const char *format) {
+	size_t size = strlen(format) + strlen(confUri);
+	char *notify = new char[size];
+	snprintf(notify, size, format, confUri);
+	string body(notify);
+	delete[] notify;
+	return body;
+}
+
+static string make_large_conference_info (int userCount, int endpointCount) {
+	ostringstream body;
+	body << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+		<< "<conference-info xmlns=\"urn:ietf:params:xml:ns:conference-info\" entity=\"" << confUri << "\" state=\"full\" version=\"1\">"
+		<< "<conference-description><subject>Large conference</subject><keywords>secured</keywords></conference-description>"
+		<< "<users>";
+	for (int i = 0; i < userCount; ++i) {
+		body << "<user entity=\"sip:user-" << i << "@example.com\" state=\"full\"><display-text>User " << i << "</display-text>"
+			<< "<roles><entry>" << (i == 0 ? "admin" : "participant") << "</entry></roles>";
+		for (int j = 0; j < endpointCount; ++j) {
+			body << "<endpoint entity=\"sip:user-" << i << "@example.com;gr=" << j << "\" state=\"full\">"
+				<< "<display-text>Device " << j << "</display-text><status>connected</status>"
+				<< "<media id=\"1\"><type>audio</type><src-id>" << (i * endpointCount + j) << "</src-id><status>sendrecv</status></media>"
+				<< "<media id=\"2\"><type>video</type><status>sendonly</status></media>"
+				<< "</endpoint>";
+		}
+		body << "</user>";
+	}
+	body << "</users></conference-info>";
+	return body.str();
+}
+
+static void conference_info_parser_matches_xsd () {
+	vector<string> corpus = {
+		format_conference_info(first_notify),
+		format_conference_info(participant_added_notify),
+		format_conference_info(participant_not_added_notify),
+		format_conference_info(participant_deleted_notify),
+		format_conference_info(participant_admined_notify),
+		format_conference_info(participant_unadmined_notify),
+		format_conference_info(conference_info_edge_cases),
+		make_large_conference_info(50, 3)
+	};
+
+	for (const auto &body : corpus) {
+		ConferenceInfoRecorder streamed;
+		ConferenceInfoRecorder reference;
+		BC_ASSERT_TRUE(ConferenceInfoParser::parse(body, streamed));
+		BC_ASSERT_TRUE(parse_conference_info_with_xsd(body, reference));
+		BC_ASSERT_STRING_EQUAL(streamed.events.str().c_str(), reference.events.str().c_str());
+	}
+
+	// Sidebar users and users without entity are not reported.
+	ConferenceInfoRecorder recorder;
+	ConferenceInfoParser::parse(format_conference_info(conference_info_edge_cases), recorder);
+	BC_ASSERT_TRUE(recorder.events.str().find("sidebar-user") == string::npos);
+	BC_ASSERT_TRUE(recorder.events.str().find("nobody") == string::npos);
+
+	// Malformed documents are rejected.
+	string truncated = format_conference_info(first_notify);
+	truncated.resize(truncated.size() / 2);
+	ConferenceInfoRecorder truncatedRecorder;
+	BC_ASSERT_FALSE(ConferenceInfoParser::parse(truncated, truncatedRecorder));
+	BC_ASSERT_TRUE(truncatedRecorder.events.str().empty());
+	ConferenceInfoRecorder otherRecorder;
+	BC_ASSERT_FALSE(ConferenceInfoParser::parse("<?xml version=\"1.0\"?><resource-lists/>", otherRecorder));
+}
+
+static void conference_info_parser_throughput () {
+	const int userCounts[] = { 10, 100, 500 };
+	const int iterations = 20;
+
+	for (int userCount : userCounts) {
+		const string body = make_large_conference_info(userCount, 3);
+
+		ConferenceInfoRecorder streamed;
+		ConferenceInfoRecorder reference;
+		BC_ASSERT_TRUE(ConferenceInfoParser::parse(body, streamed));
+		BC_ASSERT_TRUE(parse_conference_info_with_xsd(body, reference));
+		BC_ASSERT_STRING_EQUAL(streamed.events.str().c_str(), reference.events.str().c_str());
+
+		uint64_t start = ms_get_cur_time_ms();
+		for (int i = 0; i < iterations; ++i) {
+			ConferenceInfoRecorder recorder;
+			ConferenceInfoParser::parse(body, recorder);
+		}
+		uint64_t streamingMs = ms_get_cur_time_ms() - start;
+
+		start = ms_get_cur_time_ms();
+		for (int i = 0; i < iterations; ++i) {
+			ConferenceInfoRecorder recorder;
+			parse_conference_info_with_xsd(body, recorder);
+		}
+		uint64_t xsdMs = ms_get_cur_time_ms() - start;
+
+		ms_message("Conference-info of %d users (%d bytes) parsed %d times: %d ms with the streaming parser, %d ms with the XSD bindings",
+			userCount, (int)body.size(), iterations, (int)streamingMs, (int)xsdMs);
+	}
+}
+
 test_t conference_event_tests[] = {
 	TEST_NO_TAG("First notify parsing", first_notify_parsing),
 	TEST_NO_TAG("First notify with extensions parsing", first_notify_with_extensions_parsing),
@@ -2026,16 +2396,20 @@ test_t conference_event_tests[] = {
 	TEST_NO_TAG("Participant admined", participant_admined_parsing),
 	TEST_NO_TAG("Participant unadmined", participant_unadmined_parsing),
 	TEST_NO_TAG("Send first notify", send_first_notify),
+	TEST_NO_TAG("Send full state snapshot", send_full_state_snapshot),
 	TEST_NO_TAG("Send participant added notify through address", send_added_notify_through_address),
 	TEST_NO_TAG("Send participant added notify through call", send_added_notify_through_call),
 	TEST_NO_TAG("Send participant removed notify through call", send_removed_notify_through_call),
+	TEST_NO_TAG("Send notifies in batches", send_notifies_in_batches),
 	TEST_NO_TAG("Send participant removed notify", send_removed_notify),
 	TEST_NO_TAG("Send participant admined notify", send_admined_notify),
 	TEST_NO_TAG("Send participant unadmined notify", send_unadmined_notify),
 	TEST_NO_TAG("Send subject changed notify", send_subject_changed_notify),
 	TEST_NO_TAG("Send device added notify", send_device_added_notify),
 	TEST_NO_TAG("Send device removed notify", send_device_removed_notify),
-	TEST_NO_TAG("one-to-one keyword", one_to_one_keyword)
+	TEST_NO_TAG("one-to-one keyword", one_to_one_keyword),
+	TEST_NO_TAG("Conference info parser matches XSD", conference_info_parser_matches_xsd),
+	TEST_ONE_TAG("Conference info parser throughput", conference_info_parser_throughput, "longterm")
 };
 
 test_suite_t conference_event_test_suite = {
@@ -32,8 +32,13 @@
 #include "chat/chat-room/chat-room.h"
 #include "core/core.h"
 #include "conference/participant.h"
+#include "conference/participant-device.h"
 #include "address/identity-address.h"
 #include "chat/chat-room/server-group-chat-room-p.h"
+#include "conference/handlers/local-conference-event-handler.h"
+#include "conference/local-conference.h"
+#include "content/content-manager.h"
+#include "tools/private-access.h"
 
 #if __clang__ || ((__GNUC__ == 4 && __GNUC_MINOR__ >= 6) || __GNUC__ > 4)
 #pragma GCC diagnostic push
@@ -44,6 +49,9 @@
 
 using namespace LinphonePrivate;
 using namespace std;
+
+L_ENABLE_ATTR_ACCESS(LocalConference, shared_ptr<LocalConferenceEventHandler>, eventHandler);
+
 namespace LinphoneTest {
 
 class BcAssert {
@@ -541,6 +549,104 @@ static void group_chat_room_server_deletion (void) {
 	
 }
 
+// Gives access to the protected members used to simulate large chat rooms.
+class LocalConferenceTester {
+public:
+	static shared_ptr<ParticipantDevice> addDevice (const shared_ptr<Participant> &participant, const IdentityAddress &gruu) {
+		return participant->addDevice(gruu);
+	}
+	static void removeDevice (const shared_ptr<Participant> &participant, const IdentityAddress &gruu) {
+		participant->removeDevice(gruu);
+	}
+};
+
+static void group_chat_room_message_fan_out (void) {
+	Focus focus("chloe_rc");
+	{//to make sure focus is destroyed after clients.
+		ClientConference marie("marie_rc", focus.getIdentity().asAddress());
+		ClientConference pauline("pauline_rc", focus.getIdentity().asAddress());
+
+		focus.registerAsParticipantDevice(marie);
+		focus.registerAsParticipantDevice(pauline);
+
+		bctbx_list_t * coresList = bctbx_list_append(NULL, focus.getLc());
+		coresList = bctbx_list_append(coresList, marie.getLc());
+		coresList = bctbx_list_append(coresList, pauline.getLc());
+		Address paulineAddr(pauline.getIdentity().asAddress());
+		bctbx_list_t *participantsAddresses = bctbx_list_append(NULL, linphone_address_ref(L_GET_C_BACK_PTR(&paulineAddr)));
+
+		stats initialMarieStats = marie.getStats();
+		stats initialPaulineStats = pauline.getStats();
+
+		const char *initialSubject = "Fan-out";
+		LinphoneChatRoom *marieCr = create_chat_room_client_side(coresList, marie.getCMgr(), &initialMarieStats, participantsAddresses, initialSubject, FALSE, LinphoneChatRoomEphemeralModeDeviceManaged);
+		const LinphoneAddress *confAddr = linphone_chat_room_get_conference_address(marieCr);
+		LinphoneChatRoom *paulineCr = check_creation_chat_room_client_side(coresList, pauline.getCMgr(), &initialPaulineStats, confAddr, initialSubject, 1, FALSE);
+		BC_ASSERT_PTR_NOT_NULL(paulineCr);
+
+		BC_ASSERT_TRUE(CoreManagerAssert({focus,marie,pauline}).wait([&focus] {
+			for (auto chatRoom :focus.getCore().getChatRooms()) {
+				for (auto participant: chatRoom->getParticipants()) {
+					for (auto device: participant->getDevices())
+						if (device->getState() != ParticipantDevice::State::Present) {
+							return false;
+						}
+				}
+			}
+			return true;
+		}));
+
+		BC_ASSERT_EQUAL((int)focus.getCore().getChatRooms().size(), 1, int, "%d");
+		shared_ptr<AbstractChatRoom> focusCr = focus.getCore().getChatRooms().front();
+		shared_ptr<Participant> focusPauline = focusCr->findParticipant(pauline.getIdentity());
+		BC_ASSERT_PTR_NOT_NULL(focusPauline);
+		if (!focusPauline) {
+			bctbx_list_free(coresList);
+			return;
+		}
+
+		// Every device of the room but Marie's receives the message, the other devices of Pauline are fake ones.
+		list<IdentityAddress> fakeDevices;
+		for (int roomSize : {10, 100, 1000}) {
+			while ((int)fakeDevices.size() < roomSize - 1) {
+				IdentityAddress gruu(pauline.getIdentity());
+				gruu.setGruu("urn:uuid:fan-out-" + to_string(fakeDevices.size()));
+				LocalConferenceTester::addDevice(focusPauline, gruu)->setState(ParticipantDevice::State::Present);
+				fakeDevices.push_back(gruu);
+			}
+
+			const int initialReceived = pauline.getStats().number_of_LinphoneMessageReceived;
+			LinphoneChatMessage *msg = linphone_chat_room_create_message_from_utf8(marieCr, "Fan-out benchmark");
+			linphone_chat_message_send(msg);
+
+			// The MESSAGE is forwarded to all the devices in a single iteration of the focus.
+			chrono::microseconds focusDuration(0);
+			auto start = chrono::steady_clock::now();
+			while (pauline.getStats().number_of_LinphoneMessageReceived == initialReceived
+				&& chrono::steady_clock::now() - start < chrono::seconds(10)
+			) {
+				linphone_core_iterate(marie.getLc());
+				auto iterateStart = chrono::steady_clock::now();
+				linphone_core_iterate(focus.getLc());
+				focusDuration += chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - iterateStart);
+				linphone_core_iterate(pauline.getLc());
+				ms_usleep(10000);
+			}
+			BC_ASSERT_EQUAL(pauline.getStats().number_of_LinphoneMessageReceived, initialReceived + 1, int, "%d");
+
+			const long long duration = (long long)focusDuration.count();
+			ms_message("Message forwarded to %d devices in %lld us (%lld messages/s)",
+				roomSize - 1, duration, duration > 0 ? (long long)(roomSize - 1) * 1000000 / duration : 0);
+			linphone_chat_message_unref(msg);
+		}
+
+		for (const auto &gruu : fakeDevices)
+			LocalConferenceTester::removeDevice(focusPauline, gruu);
+
+		bctbx_list_free(coresList);
+	}
+}
+
 static void group_chat_room_server_deletion_with_rmt_lst_event_handler (void) {
 	Focus focus("chloe_rc");
 	{//to make sure focus is destroyed after clients.
@@ -1652,6 +1758,145 @@ static void group_chat_room_bulk_notify_to_participant (void) {
 	}
 }
 
+static void group_chat_room_full_state_to_late_subscriber (void) {
+	Focus focus("chloe_rc");
+	{//to make sure focus is destroyed after clients.
+		ClientConference marie("marie_rc", focus.getIdentity().asAddress());
+		ClientConference pauline("pauline_rc", focus.getIdentity().asAddress());
+		ClientConference michelle("michelle_rc_udp", focus.getIdentity().asAddress());
+
+		focus.registerAsParticipantDevice(marie);
+		focus.registerAsParticipantDevice(pauline);
+		focus.registerAsParticipantDevice(michelle);
+
+		bctbx_list_t * coresList = bctbx_list_append(NULL, focus.getLc());
+		coresList = bctbx_list_append(coresList, marie.getLc());
+		coresList = bctbx_list_append(coresList, pauline.getLc());
+		coresList = bctbx_list_append(coresList, michelle.getLc());
+		Address paulineAddr(pauline.getIdentity().asAddress());
+		bctbx_list_t *participantsAddresses = bctbx_list_append(NULL, linphone_address_ref(L_GET_C_BACK_PTR(&paulineAddr)));
+		Address michelleAddr(michelle.getIdentity().asAddress());
+		participantsAddresses = bctbx_list_append(participantsAddresses, linphone_address_ref(L_GET_C_BACK_PTR(&michelleAddr)));
+
+		stats initialMarieStats = marie.getStats();
+		stats initialPaulineStats = pauline.getStats();
+		stats initialMichelleStats = michelle.getStats();
+
+		// Marie creates a new group chat room
+		const char *initialSubject = "Colleagues";
+		LinphoneChatRoom *marieCr = create_chat_room_client_side(coresList, marie.getCMgr(), &initialMarieStats, participantsAddresses, initialSubject, FALSE, LinphoneChatRoomEphemeralModeDeviceManaged);
+		const LinphoneAddress *confAddr = linphone_chat_room_get_conference_address(marieCr);
+
+		// Check that the chat room is correctly created on Pauline's and Michelle's side
+		LinphoneChatRoom *paulineCr = check_creation_chat_room_client_side(coresList, pauline.getCMgr(), &initialPaulineStats, confAddr, initialSubject, 2, FALSE);
+		LinphoneChatRoom *michelleCr = check_creation_chat_room_client_side(coresList, michelle.getCMgr(), &initialMichelleStats, confAddr, initialSubject, 2, FALSE);
+		BC_ASSERT_PTR_NOT_NULL(michelleCr);
+
+		BC_ASSERT_TRUE(CoreManagerAssert({focus,marie,pauline,michelle}).wait([&focus] {
+			for (auto chatRoom :focus.getCore().getChatRooms()) {
+				for (auto participant: chatRoom->getParticipants()) {
+					for (auto device: participant->getDevices())
+						if (device->getState() != ParticipantDevice::State::Present) {
+							return false;
+						}
+				}
+			}
+			return true;
+		}));
+
+		BC_ASSERT_TRUE(wait_for_list(coresList, &pauline.getStats().number_of_LinphoneConferenceStateCreated, initialPaulineStats.number_of_LinphoneConferenceStateCreated + 1, 5000));
+		BC_ASSERT_TRUE(wait_for_list(coresList, &michelle.getStats().number_of_LinphoneConferenceStateCreated, initialMichelleStats.number_of_LinphoneConferenceStateCreated + 1, 5000));
+
+		shared_ptr<AbstractChatRoom> paulineChatRoom = L_GET_CPP_PTR_FROM_C_OBJECT(paulineCr);
+		const unsigned int paulineLastNotify = paulineChatRoom->getConference()->getLastNotify();
+
+		// Pauline goes offline
+		linphone_core_set_network_reachable(pauline.getLc(), FALSE);
+
+		// Marie changes the subject so many times that the missed NOTIFYs are bigger than a full state
+		const int nbSubjectChanges = 10;
+		string lastSubject;
+		for (int i = 0; i < nbSubjectChanges; i++) {
+			initialMarieStats = marie.getStats();
+			initialMichelleStats = michelle.getStats();
+			lastSubject = "Subject #" + to_string(i);
+			linphone_chat_room_set_subject(marieCr, lastSubject.c_str());
+			BC_ASSERT_TRUE(wait_for_list(coresList, &marie.getStats().number_of_subject_changed, initialMarieStats.number_of_subject_changed + 1, 5000));
+			BC_ASSERT_TRUE(wait_for_list(coresList, &michelle.getStats().number_of_subject_changed, initialMichelleStats.number_of_subject_changed + 1, 5000));
+		}
+		BC_ASSERT_STRING_EQUAL(linphone_chat_room_get_subject(michelleCr), lastSubject.c_str());
+
+		// The server answers a notify id that old with a full state, and a recent one with the missed events
+		unsigned int serverLastNotify = 0;
+		BC_ASSERT_EQUAL((int)focus.getCore().getChatRooms().size(), 1, int, "%d");
+		for (auto chatRoom :focus.getCore().getChatRooms()) {
+			shared_ptr<LocalConference> localConf = static_pointer_cast<LocalConference>(chatRoom->getConference());
+			LocalConferenceEventHandler *localHandler = (L_ATTR_GET(localConf.get(), eventHandler)).get();
+			serverLastNotify = localConf->getLastNotify();
+			BC_ASSERT_GREATER(serverLastNotify, paulineLastNotify + nbSubjectChanges, unsigned int, "%u");
+
+			string notify = localHandler->getNotifyForId(static_cast<int>(paulineLastNotify), nullptr);
+			BC_ASSERT_TRUE(notify.find("state=\"full\"") != string::npos);
+			BC_ASSERT_TRUE(notify.find(MultipartBoundary) == string::npos);
+			BC_ASSERT_TRUE(notify.find(lastSubject) != string::npos);
+
+			// A display name change does not increment the version, the full state is built again
+			const string deviceName = "Renamed device";
+			shared_ptr<ParticipantDevice> device = localConf->getParticipants().front()->getDevices().front();
+			const string previousDeviceName = device->getName();
+			device->setName(deviceName);
+			notify = localHandler->getNotifyForId(static_cast<int>(paulineLastNotify), nullptr);
+			BC_ASSERT_TRUE(notify.find(deviceName) != string::npos);
+			device->setName(previousDeviceName);
+
+			notify = localHandler->getNotifyForId(static_cast<int>(serverLastNotify - 1), nullptr);
+			BC_ASSERT_TRUE(notify.find(MultipartBoundary) != string::npos);
+			BC_ASSERT_EQUAL(localConf->getLastNotify(), serverLastNotify, unsigned int, "%u");
+		}
+
+		// Pauline comes up online and subscribes again with her old notify id
+		initialPaulineStats = pauline.getStats();
+		linphone_core_set_network_reachable(pauline.getLc(), TRUE);
+		BC_ASSERT_TRUE(wait_for_list(coresList, &pauline.getCMgr()->stat.number_of_LinphoneRegistrationOk, initialPaulineStats.number_of_LinphoneRegistrationOk + 1, 10000));
+
+		// The full state updates the subject at once, none of the missed subject changes is reported
+		BC_ASSERT_TRUE(CoreManagerAssert({focus,marie,pauline,michelle}).wait([paulineChatRoom, serverLastNotify] {
+			return paulineChatRoom->getConference()->getLastNotify() == serverLastNotify;
+		}));
+		BC_ASSERT_STRING_EQUAL(linphone_chat_room_get_subject(paulineCr), lastSubject.c_str());
+		BC_ASSERT_EQUAL(pauline.getStats().number_of_subject_changed, initialPaulineStats.number_of_subject_changed, int, "%d");
+		BC_ASSERT_EQUAL(linphone_chat_room_get_nb_participants(paulineCr), 2, int, "%d");
+
+		for (auto chatRoom :focus.getCore().getChatRooms()) {
+			for (auto participant: chatRoom->getParticipants()) {
+				//  force deletion by removing devices
+				Address participantAddress(participant->getAddress().asAddress());
+				linphone_chat_room_set_participant_devices(  L_GET_C_BACK_PTR(chatRoom)
+														   , L_GET_C_BACK_PTR(&participantAddress)
+														   , NULL);
+			}
+		}
+
+		//wait until chatroom is deleted server side
+		BC_ASSERT_TRUE(CoreManagerAssert({focus,marie,pauline,michelle}).wait([&focus] {
+			return focus.getCore().getChatRooms().size() == 0;
+		}));
+
+		//wait bit more to detect side effect if any
+		CoreManagerAssert({focus,marie,pauline,michelle}).waitUntil(chrono::seconds(2),[] {
+			return false;
+		});
+
+		//to avoid creation attempt of a new chatroom
+		LinphoneProxyConfig *config = linphone_core_get_default_proxy_config(focus.getLc());
+		linphone_proxy_config_edit(config);
+		linphone_proxy_config_set_conference_factory_uri(config, NULL);
+		linphone_proxy_config_done(config);
+
+		bctbx_list_free(coresList);
+	}
+}
+
 static void group_chat_room_add_participant_with_invalid_address (void) {
 	Focus focus("chloe_rc");
 	{//to make sure focus is destroyed after clients.
@@ -2383,9 +2628,11 @@ static void group_chat_room_server_ephemeral_mode_changed (void) {
 static test_t local_conference_tests[] = {
 	TEST_ONE_TAG("Group chat room creation local server", LinphoneTest::group_chat_room_creation_server,"LeaksMemory"), /* beacause of coreMgr restart*/
 	TEST_NO_TAG("Group chat Server chat room deletion", LinphoneTest::group_chat_room_server_deletion),
+	TEST_ONE_TAG("Group chat Server chat room message fan-out", LinphoneTest::group_chat_room_message_fan_out, "longterm"),
 	TEST_NO_TAG("Group chat Add participant with invalid address", LinphoneTest::group_chat_room_add_participant_with_invalid_address),
 	TEST_NO_TAG("Group chat Only participant with invalid address", LinphoneTest::group_chat_room_with_only_participant_with_invalid_address),
 	TEST_ONE_TAG("Group chat room bulk notify to participant", LinphoneTest::group_chat_room_bulk_notify_to_participant,"LeaksMemory"), /* because of network up and down*/
+	TEST_ONE_TAG("Group chat room full state to late subscriber", LinphoneTest::group_chat_room_full_state_to_late_subscriber,"LeaksMemory"), /* because of network up and down*/
 	TEST_ONE_TAG("One to one chatroom exhumed while participant is offline", LinphoneTest::one_to_one_chatroom_exhumed_while_offline,"LeaksMemory"), /* because of network up and down*/
 	TEST_ONE_TAG("Group chat Server chat room deletion with remote list event handler", LinphoneTest::group_chat_room_server_deletion_with_rmt_lst_event_handler,"LeaksMemory"), /* because of coreMgr restart*/
 	TEST_NO_TAG("Unencrypted group chat server chat room with admin managed ephemeral messages", LinphoneTest::group_chat_room_server_admin_managed_messages_unencrypted),
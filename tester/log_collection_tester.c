@@ -255,6 +255,74 @@ static void collect_files_filled(void) {
 	collect_cleanup(marie);
 }
 
+static void collect_files_filled_buffered(void) {
+	LinphoneCoreManager* marie;
+	linphone_core_enable_log_collection_buffering(TRUE);
+	BC_ASSERT_TRUE(linphone_core_log_collection_buffering_enabled());
+	marie = setup(LinphoneLogCollectionEnabled);
+	/* the buffered lines are written before the files are compressed */
+	check_file(marie);
+	collect_cleanup(marie);
+	linphone_core_enable_log_collection_buffering(FALSE);
+}
+
+static int count_collected_lines(const char *pattern) {
+	char *filepath = linphone_core_compress_log_collection();
+	FILE *file = NULL;
+	char *line = NULL;
+	size_t line_size = 256;
+	int count = 0;
+
+	if (!BC_ASSERT_PTR_NOT_NULL(filepath)) return 0;
+#if HAVE_ZLIB
+	file = gzuncompress(filepath);
+#else
+	file = fopen(filepath, "rb");
+#endif
+	ms_free(filepath);
+	if (!BC_ASSERT_PTR_NOT_NULL(file)) return 0;
+	while (getline(&line, &line_size, file) != -1) {
+		if (strstr(line, pattern)) count++;
+	}
+	free(line);
+	fclose(file);
+	return count;
+}
+
+#define LOGGING_THREADS_COUNT 20
+
+static void *logging_thread_run(void *data) {
+	int index = *(int *)data;
+	ms_error("(thread log) first line of thread %d", index);
+	/* let the writer drain the ring of the thread before its last line */
+	ms_usleep(150000);
+	ms_error("(thread log) last line of thread %d", index);
+	return NULL;
+}
+
+static void collect_files_filled_buffered_from_threads(void) {
+	LinphoneCoreManager* marie;
+	ms_thread_t threads[LOGGING_THREADS_COUNT];
+	int indexes[LOGGING_THREADS_COUNT];
+	int i;
+
+	linphone_core_enable_log_collection_buffering(TRUE);
+	marie = setup(LinphoneLogCollectionEnabled);
+	/* the threads register their ring while the writer is draining the others */
+	for (i = 0; i < LOGGING_THREADS_COUNT; i++) {
+		indexes[i] = i;
+		ms_thread_create(&threads[i], NULL, logging_thread_run, &indexes[i]);
+		ms_usleep(10000);
+	}
+	for (i = 0; i < LOGGING_THREADS_COUNT; i++)
+		ms_thread_join(threads[i], NULL);
+
+	BC_ASSERT_EQUAL(count_collected_lines("(thread log) first line"), LOGGING_THREADS_COUNT, int, "%d");
+	BC_ASSERT_EQUAL(count_collected_lines("(thread log) last line"), LOGGING_THREADS_COUNT, int, "%d");
+	collect_cleanup(marie);
+	linphone_core_enable_log_collection_buffering(FALSE);
+}
+
 static void collect_files_small_size(void)  {
 	LinphoneCoreManager* marie = setup(LinphoneLogCollectionEnabled);
 	linphone_core_set_log_collection_max_file_size(5000);
@@ -342,6 +410,8 @@ static void upload_collected_traces(void)  {
 test_t log_collection_tests[] = {
 	TEST_NO_TAG("No file when disabled", collect_files_disabled),
 	TEST_NO_TAG("Collect files filled when enabled", collect_files_filled),
+	TEST_NO_TAG("Collect files filled when buffered", collect_files_filled_buffered),
+	TEST_NO_TAG("Collect files filled when buffered from threads", collect_files_filled_buffered_from_threads),
 	TEST_NO_TAG("Logs collected into small file", collect_files_small_size),
 	TEST_NO_TAG("Logs collected when decreasing max size", collect_files_changing_size),
 	TEST_NO_TAG("Log upload to wrong URL", upload_wrong_url),
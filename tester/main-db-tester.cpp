@@ -17,10 +17,16 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <limits>
+
 #include "address/address.h"
+#include "chat/chat-message/chat-message-p.h"
 #include "core/core-p.h"
+#include "db/main-db-p.h"
 #include "db/main-db.h"
 #include "event-log/events.h"
+#include "logger/logger.h"
 
 // TODO: Remove me. <3
 #include "private.h"
@@ -40,12 +46,13 @@ class MainDbProvider {
 public:
 	MainDbProvider () : MainDbProvider("db/linphone.db") { }
 
-	MainDbProvider (const char *db_file) {
+	MainDbProvider (const char *db_file, bool lazyChatRoomLoading = false) {
 		mCoreManager = linphone_core_manager_create("empty_rc");
 		char *roDbPath = bc_tester_res(db_file);
 		char *rwDbPath = bc_tester_file("linphone.db");
 		BC_ASSERT_FALSE(liblinphone_tester_copy_file(roDbPath, rwDbPath));
 		linphone_config_set_string(linphone_core_get_config(mCoreManager->lc), "storage", "uri", rwDbPath);
+		linphone_config_set_bool(linphone_core_get_config(mCoreManager->lc), "storage", "lazy_chat_room_loading", lazyChatRoomLoading);
 		bc_free(roDbPath);
 		bc_free(rwDbPath);
 		linphone_core_manager_start(mCoreManager, false);
@@ -59,6 +66,10 @@ public:
 		return *L_GET_PRIVATE(mCoreManager->lc->cppPtr)->mainDb;
 	}
 
+	LinphoneCore *getCCore () const {
+		return mCoreManager->lc;
+	}
+
 private:
 	LinphoneCoreManager *mCoreManager;
 };
@@ -281,6 +292,368 @@ static void load_a_lot_of_chatrooms(void) {
 #endif
 }
 
+static void lazy_chat_room_loading (void) {
+	MainDbProvider provider("db/linphone.db", true);
+	MainDb &mainDb = provider.getMainDb();
+	shared_ptr<Core> core = provider.getCCore()->cppPtr;
+
+	list<MainDb::ChatRoomSummary> summaries = mainDb.getChatRoomSummaries();
+	BC_ASSERT_EQUAL((int)summaries.size(), 86, int, "%d");
+	int unreadCount = 0;
+	for (const auto &summary : summaries)
+		unreadCount += summary.unreadChatMessageCount;
+	BC_ASSERT_EQUAL(unreadCount, 2, int, "%d");
+
+	ConferenceId conferenceId(IdentityAddress("sip:test-3@sip.linphone.org"), IdentityAddress("sip:test-1@sip.linphone.org"));
+	MainDb::ChatRoomSummary summary = mainDb.getChatRoomSummary(conferenceId);
+	BC_ASSERT_TRUE(summary.conferenceId == conferenceId);
+	BC_ASSERT_NOT_EQUAL((int)summary.lastMessageId, 0, int, "%d");
+
+	// The chat room is built on first lookup.
+	shared_ptr<AbstractChatRoom> chatRoom = core->findChatRoom(conferenceId);
+	if (!BC_ASSERT_PTR_NOT_NULL(chatRoom)) return;
+	BC_ASSERT_EQUAL(chatRoom->getMessageHistorySize(), 861, int, "%d");
+	BC_ASSERT_PTR_EQUAL(core->findChatRoom(conferenceId), chatRoom);
+
+	// An idle chat room goes back to its summary and is loaded again when needed.
+	weak_ptr<AbstractChatRoom> weakChatRoom = chatRoom;
+	chatRoom.reset();
+	L_GET_PRIVATE(core)->releaseIdleChatRooms(0);
+	BC_ASSERT_TRUE(weakChatRoom.expired());
+	chatRoom = core->findChatRoom(conferenceId);
+	if (!BC_ASSERT_PTR_NOT_NULL(chatRoom)) return;
+	BC_ASSERT_EQUAL(chatRoom->getMessageHistorySize(), 861, int, "%d");
+
+	// A chat room stays loaded while one of its messages is in use.
+	shared_ptr<ChatMessage> chatMessage = chatRoom->getLastChatMessageInHistory();
+	if (!BC_ASSERT_PTR_NOT_NULL(chatMessage)) return;
+	weakChatRoom = chatRoom;
+	chatRoom.reset();
+	L_GET_PRIVATE(core)->releaseIdleChatRooms(0);
+	BC_ASSERT_FALSE(weakChatRoom.expired());
+	BC_ASSERT_PTR_EQUAL(chatMessage->getChatRoom(), weakChatRoom.lock());
+	chatMessage.reset();
+	L_GET_PRIVATE(core)->releaseIdleChatRooms(0);
+	BC_ASSERT_TRUE(weakChatRoom.expired());
+
+	// Lookups only load the chat rooms that can match.
+	const size_t loadedCount = L_GET_PRIVATE(core)->chatRoomsById.size();
+	BC_ASSERT_FALSE(core->getChatRoomPeerAddresses(LinphoneChatRoomCapabilitiesBasic).empty());
+	BC_ASSERT_EQUAL((int)L_GET_PRIVATE(core)->chatRoomsById.size(), (int)loadedCount, int, "%d");
+	chatRoom = core->findOneToOneChatRoom(
+		conferenceId.getLocalAddress(), conferenceId.getPeerAddress(), true, false, false
+	);
+	if (BC_ASSERT_PTR_NOT_NULL(chatRoom))
+		BC_ASSERT_TRUE(chatRoom->getConferenceId() == conferenceId);
+	BC_ASSERT_EQUAL((int)L_GET_PRIVATE(core)->chatRoomsById.size(), (int)loadedCount + 1, int, "%d");
+}
+
+static void statement_cache (void) {
+	MainDbProvider provider;
+	MainDb &mainDb = provider.getMainDb();
+	const DbSession &dbSession = L_GET_PRIVATE(&mainDb)->dbSession;
+	const ConferenceId conferenceId(IdentityAddress("sip:test-3@sip.linphone.org"), IdentityAddress("sip:test-1@sip.linphone.org"));
+
+	// The first lookup may prepare the statements, the next ones reuse them.
+	BC_ASSERT_EQUAL(mainDb.getChatMessageCount(conferenceId), 861, int, "%d");
+	const unsigned long long hits = dbSession.getStatementCacheHits();
+	const unsigned long long misses = dbSession.getStatementCacheMisses();
+	BC_ASSERT_EQUAL(mainDb.getChatMessageCount(conferenceId), 861, int, "%d");
+	// Two sip address ids and the chat room id.
+	BC_ASSERT_EQUAL((int)(dbSession.getStatementCacheHits() - hits), 3, int, "%d");
+	BC_ASSERT_EQUAL((int)(dbSession.getStatementCacheMisses() - misses), 0, int, "%d");
+
+	// Unknown addresses go through the same statements.
+	const ConferenceId unknownId(IdentityAddress("sip:unknown@sip.linphone.org"), IdentityAddress("sip:test-1@sip.linphone.org"));
+	BC_ASSERT_EQUAL(mainDb.getChatMessageCount(unknownId), 0, int, "%d");
+	BC_ASSERT_EQUAL((int)(dbSession.getStatementCacheMisses() - misses), 0, int, "%d");
+
+	// The cached statements do not keep a read transaction open, another connection can write.
+	DbSession otherSession(L_GET_PRIVATE(&mainDb)->uri);
+	if (!BC_ASSERT_PTR_NOT_NULL(otherSession.getBackendSession())) return;
+	bool written = true;
+	try {
+		*otherSession.getBackendSession() << "CREATE TABLE IF NOT EXISTS statement_cache_test (id INTEGER)";
+		*otherSession.getBackendSession() << "DROP TABLE statement_cache_test";
+	} catch (const exception &e) {
+		lError() << "Cannot write from another connection: " << e.what();
+		written = false;
+	}
+	BC_ASSERT_TRUE(written);
+}
+
+static void add_events_throughput (void) {
+	MainDbProvider provider;
+	MainDb &mainDb = provider.getMainDb();
+	shared_ptr<AbstractChatRoom> chatRoom = mainDb.getChatRooms().front();
+	if (!BC_ASSERT_PTR_NOT_NULL(chatRoom)) return;
+
+	const int eventCount = 500;
+	auto createEvents = [&chatRoom, eventCount]() {
+		list<shared_ptr<EventLog>> events;
+		for (int i = 0; i < eventCount; ++i) {
+			shared_ptr<ChatMessage> message = chatRoom->createChatMessageFromUtf8("Throughput test message");
+			events.push_back(make_shared<ConferenceChatMessageEvent>(time(nullptr), message));
+		}
+		return events;
+	};
+
+	const int initialCount = mainDb.getEventCount();
+
+	list<shared_ptr<EventLog>> events = createEvents();
+	chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+	for (const auto &event : events)
+		mainDb.addEvent(event);
+	chrono::high_resolution_clock::time_point end = chrono::high_resolution_clock::now();
+	long perEventMs = (long) chrono::duration_cast<chrono::milliseconds>(end - start).count();
+
+	events = createEvents();
+	start = chrono::high_resolution_clock::now();
+	BC_ASSERT_TRUE(mainDb.addEvents(events));
+	end = chrono::high_resolution_clock::now();
+	long batchedMs = (long) chrono::duration_cast<chrono::milliseconds>(end - start).count();
+
+	for (const auto &event : events)
+		BC_ASSERT_TRUE(static_pointer_cast<ConferenceChatMessageEvent>(event)->getChatMessage()->isValid());
+	BC_ASSERT_EQUAL(mainDb.getEventCount(), initialCount + 2 * eventCount, int, "%d");
+
+	lInfo() << "Inserted " << eventCount << " events in " << perEventMs << " ms one by one and in "
+		<< batchedMs << " ms with a single batch.";
+}
+
+static void get_history_page_latency (void) {
+	MainDbProvider provider;
+	MainDb &mainDb = provider.getMainDb();
+	shared_ptr<AbstractChatRoom> chatRoom = mainDb.getChatRooms().front();
+	if (!BC_ASSERT_PTR_NOT_NULL(chatRoom)) return;
+
+	const ConferenceId &conferenceId = chatRoom->getConferenceId();
+	const int pageSize = 50;
+	const int depths[] = { 0, 10000, 100000 };
+
+	// Fill the chat room so that the deepest page is reachable.
+	const int batchSize = 10000;
+	while (mainDb.getHistorySize(conferenceId) < depths[2] + pageSize) {
+		list<shared_ptr<EventLog>> events;
+		for (int i = 0; i < batchSize; ++i) {
+			shared_ptr<ChatMessage> message = chatRoom->createChatMessageFromUtf8("History page test message");
+			events.push_back(make_shared<ConferenceChatMessageEvent>(time(nullptr), message));
+		}
+		if (!BC_ASSERT_TRUE(mainDb.addEvents(events))) return;
+	}
+
+	for (int depth : depths) {
+		shared_ptr<EventLog> cursor;
+		if (depth > 0) {
+			list<shared_ptr<EventLog>> events = mainDb.getHistoryRange(conferenceId, depth - 1, depth);
+			if (!BC_ASSERT_EQUAL((int)events.size(), 1, int, "%d")) return;
+			cursor = events.front();
+		}
+
+		chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+		list<shared_ptr<EventLog>> offsetPage = mainDb.getHistoryRange(conferenceId, depth, depth + pageSize);
+		chrono::high_resolution_clock::time_point end = chrono::high_resolution_clock::now();
+		long offsetUs = (long) chrono::duration_cast<chrono::microseconds>(end - start).count();
+
+		start = chrono::high_resolution_clock::now();
+		list<shared_ptr<EventLog>> keysetPage = mainDb.getHistoryBefore(conferenceId, cursor, pageSize);
+		end = chrono::high_resolution_clock::now();
+		long keysetUs = (long) chrono::duration_cast<chrono::microseconds>(end - start).count();
+
+		BC_ASSERT_EQUAL((int)keysetPage.size(), pageSize, int, "%d");
+		BC_ASSERT_TRUE(offsetPage == keysetPage);
+		lInfo() << "History page of " << pageSize << " events at depth " << depth << ": "
+			<< offsetUs << " us with LIMIT/OFFSET, " << keysetUs << " us with keyset pagination.";
+	}
+}
+
+static void ephemeral_messages_batches (void) {
+	MainDbProvider provider;
+	MainDb &mainDb = provider.getMainDb();
+	shared_ptr<AbstractChatRoom> chatRoom = mainDb.getChatRooms().front();
+	if (!BC_ASSERT_PTR_NOT_NULL(chatRoom)) return;
+
+	const int messageCount = 250;
+	const unsigned int batchSize = 100;
+	const size_t initialCount = mainDb.getEphemeralMessages(numeric_limits<unsigned int>::max()).size();
+
+	// Inserted in reverse expire time order.
+	const time_t now = time(nullptr);
+	list<shared_ptr<EventLog>> events;
+	for (int i = 0; i < messageCount; ++i) {
+		shared_ptr<ChatMessage> message = chatRoom->createChatMessageFromUtf8("Ephemeral test message");
+		message->getPrivate()->enableEphemeralWithTime(3600);
+		message->getPrivate()->setEphemeralExpireTime(now + 3600 + messageCount - i);
+		events.push_back(make_shared<ConferenceChatMessageEvent>(now, message));
+	}
+	if (!BC_ASSERT_TRUE(mainDb.addEvents(events))) return;
+	BC_ASSERT_EQUAL((int)mainDb.getEphemeralMessages(numeric_limits<unsigned int>::max()).size(), (int)initialCount + messageCount, int, "%d");
+
+	const int eventCount = mainDb.getEventCount();
+	list<shared_ptr<ChatMessage>> messages = mainDb.getEphemeralMessages(batchSize);
+	BC_ASSERT_EQUAL((int)messages.size(), (int)batchSize, int, "%d");
+	BC_ASSERT_TRUE(is_sorted(messages.cbegin(), messages.cend(), [](const shared_ptr<ChatMessage> &a, const shared_ptr<ChatMessage> &b) {
+		return a->getEphemeralExpireTime() < b->getEphemeralExpireTime();
+	}));
+	if (messages.empty()) return;
+	const time_t lastExpireTime = messages.back()->getEphemeralExpireTime();
+
+	// The first batch is deleted in a single transaction, the next one starts after it.
+	list<shared_ptr<const EventLog>> expiredEvents;
+	for (const auto &message : messages)
+		expiredEvents.push_back(MainDb::getEvent(L_GET_PRIVATE(provider.getCCore()->cppPtr)->mainDb, message->getStorageId()));
+	BC_ASSERT_TRUE(mainDb.deleteEvents(expiredEvents));
+	BC_ASSERT_EQUAL(mainDb.getEventCount(), eventCount - (int)batchSize, int, "%d");
+	for (const auto &message : messages)
+		BC_ASSERT_FALSE(message->isValid());
+
+	messages = mainDb.getEphemeralMessages(batchSize);
+	BC_ASSERT_EQUAL((int)messages.size(), (int)batchSize, int, "%d");
+	if (!messages.empty())
+		BC_ASSERT_GREATER((long)messages.front()->getEphemeralExpireTime(), (long)lastExpireTime, long, "%li");
+}
+
+static void async_mode (void) {
+	MainDbProvider provider;
+	MainDb &mainDb = provider.getMainDb();
+	mainDb.enableAsyncMode(true);
+	if (!BC_ASSERT_TRUE(mainDb.asyncModeEnabled())) return;
+
+	ConferenceId conferenceId(IdentityAddress("sip:test-4@sip.linphone.org"), IdentityAddress("sip:test-1@sip.linphone.org"));
+
+	// Results are delivered by the core iterate thread.
+	int historyReceived = 0;
+	int historySize = 0;
+	mainDb.getHistoryRangeAsync(conferenceId, 0, -1, MainDb::Filter::ConferenceChatMessageFilter,
+		[&historyReceived, &historySize](const list<shared_ptr<EventLog>> &events) {
+			historySize = (int)events.size();
+			historyReceived++;
+		}
+	);
+	BC_ASSERT_EQUAL(historyReceived, 0, int, "%d");
+	BC_ASSERT_TRUE(wait_for_until(provider.getCCore(), NULL, &historyReceived, 1, 5000));
+	BC_ASSERT_EQUAL(historySize, mainDb.getHistorySize(conferenceId, MainDb::Filter::ConferenceChatMessageFilter), int, "%d");
+
+	int pageReceived = 0;
+	list<shared_ptr<EventLog>> page;
+	mainDb.getHistoryRangeAsync(conferenceId, 10, 20, MainDb::Filter::ConferenceChatMessageFilter,
+		[&pageReceived, &page](const list<shared_ptr<EventLog>> &events) {
+			page = events;
+			pageReceived++;
+		}
+	);
+	BC_ASSERT_TRUE(wait_for_until(provider.getCCore(), NULL, &pageReceived, 1, 5000));
+	BC_ASSERT_TRUE(page == mainDb.getHistoryRange(conferenceId, 10, 20, MainDb::Filter::ConferenceChatMessageFilter));
+
+	int chatRoomsReceived = 0;
+	int chatRoomCount = 0;
+	mainDb.getChatRoomsAsync([&chatRoomsReceived, &chatRoomCount](const list<shared_ptr<AbstractChatRoom>> &chatRooms) {
+		chatRoomCount = (int)chatRooms.size();
+		chatRoomsReceived++;
+	});
+	BC_ASSERT_TRUE(wait_for_until(provider.getCCore(), NULL, &chatRoomsReceived, 1, 5000));
+	BC_ASSERT_EQUAL(chatRoomCount, (int)mainDb.getChatRooms().size(), int, "%d");
+
+	// Writes are executed by the worker, synchronous reads of the same tables wait for them.
+	const int unreadCount = mainDb.getUnreadChatMessageCount();
+	ConferenceId unreadConferenceId;
+	int roomUnreadCount = 0;
+	for (const auto &chatRoom : mainDb.getChatRooms()) {
+		roomUnreadCount = mainDb.getUnreadChatMessageCount(chatRoom->getConferenceId());
+		if (roomUnreadCount > 0) {
+			unreadConferenceId = chatRoom->getConferenceId();
+			break;
+		}
+	}
+	if (BC_ASSERT_TRUE(unreadConferenceId.isValid())) {
+		mainDb.markChatMessagesAsRead(unreadConferenceId);
+		BC_ASSERT_EQUAL(mainDb.getUnreadChatMessageCount(unreadConferenceId), 0, int, "%d");
+		BC_ASSERT_EQUAL(mainDb.getUnreadChatMessageCount(), unreadCount - roomUnreadCount, int, "%d");
+	}
+
+	mainDb.enableAsyncMode(false);
+	BC_ASSERT_FALSE(mainDb.asyncModeEnabled());
+}
+
+static void server_queued_messages (void) {
+	MainDbProvider provider;
+	MainDb &mainDb = provider.getMainDb();
+
+	ConferenceId conferenceId(IdentityAddress("sip:test-4@sip.linphone.org"), IdentityAddress("sip:test-1@sip.linphone.org"));
+	const string firstDevice = "sip:test-2@sip.linphone.org;gr=urn:uuid:00000000-0000-0000-0000-000000000001";
+	const string secondDevice = "sip:test-3@sip.linphone.org;gr=urn:uuid:00000000-0000-0000-0000-000000000002";
+	const time_t now = time(nullptr);
+
+	// Inserted out of time order, they are read back by time.
+	MainDb::ServerQueuedMessage message;
+	message.fromAddress = "sip:test-2@sip.linphone.org";
+	message.contentType = "text/plain";
+	message.body = "First";
+	message.headers = "Priority: normal";
+	message.time = now - 10;
+	message.deviceAddresses = { firstDevice, secondDevice };
+	mainDb.insertServerQueuedMessage(conferenceId, message);
+	message.body = "Second";
+	message.headers = "";
+	message.time = now - 5;
+	message.deviceAddresses = { firstDevice };
+	mainDb.insertServerQueuedMessage(conferenceId, message);
+	message.body = "Oldest";
+	message.time = now - 20;
+	message.deviceAddresses = { secondDevice };
+	mainDb.insertServerQueuedMessage(conferenceId, message);
+
+	const auto countForDevice = [](const list<MainDb::ServerQueuedMessage> &messages, const string &device) {
+		return (int)count_if(messages.cbegin(), messages.cend(), [&device](const MainDb::ServerQueuedMessage &message) {
+			return find(message.deviceAddresses.cbegin(), message.deviceAddresses.cend(), device) != message.deviceAddresses.cend();
+		});
+	};
+
+	// The queue survives a new connection to the database.
+	BC_ASSERT_EQUAL((int)mainDb.getServerQueuedMessages(conferenceId).size(), 3, int, "%d");
+	char *dbPath = bc_tester_file("linphone.db");
+	{
+		MainDb reopenedDb(provider.getCCore()->cppPtr);
+		BC_ASSERT_TRUE(reopenedDb.connect(MainDb::Sqlite3, dbPath));
+		list<MainDb::ServerQueuedMessage> messages = reopenedDb.getServerQueuedMessages(conferenceId);
+		BC_ASSERT_EQUAL((int)messages.size(), 3, int, "%d");
+		if (messages.size() == 3) {
+			auto it = messages.cbegin();
+			BC_ASSERT_STRING_EQUAL(it->body.c_str(), "Oldest");
+			++it;
+			BC_ASSERT_STRING_EQUAL(it->body.c_str(), "First");
+			BC_ASSERT_STRING_EQUAL(it->fromAddress.c_str(), "sip:test-2@sip.linphone.org");
+			BC_ASSERT_STRING_EQUAL(it->contentType.c_str(), "text/plain");
+			BC_ASSERT_STRING_EQUAL(it->headers.c_str(), "Priority: normal");
+			BC_ASSERT_EQUAL((long)it->time, (long)(now - 10), long, "%li");
+			BC_ASSERT_EQUAL((int)it->deviceAddresses.size(), 2, int, "%d");
+			++it;
+			BC_ASSERT_STRING_EQUAL(it->body.c_str(), "Second");
+		}
+		BC_ASSERT_EQUAL(countForDevice(messages, firstDevice), 2, int, "%d");
+		BC_ASSERT_EQUAL(countForDevice(messages, secondDevice), 2, int, "%d");
+		reopenedDb.disconnect();
+	}
+	bc_free(dbPath);
+
+	// Draining a device keeps the messages still queued for the other ones.
+	mainDb.deleteServerQueuedMessages(conferenceId, firstDevice);
+	list<MainDb::ServerQueuedMessage> messages = mainDb.getServerQueuedMessages(conferenceId);
+	BC_ASSERT_EQUAL((int)messages.size(), 2, int, "%d");
+	BC_ASSERT_EQUAL(countForDevice(messages, firstDevice), 0, int, "%d");
+	BC_ASSERT_EQUAL(countForDevice(messages, secondDevice), 2, int, "%d");
+
+	// Messages older than the limit are purged whatever their devices.
+	mainDb.deleteServerQueuedMessagesBefore(conferenceId, now - 15);
+	messages = mainDb.getServerQueuedMessages(conferenceId);
+	BC_ASSERT_EQUAL((int)messages.size(), 1, int, "%d");
+	if (!messages.empty())
+		BC_ASSERT_STRING_EQUAL(messages.front().body.c_str(), "First");
+
+	mainDb.deleteServerQueuedMessages(conferenceId, secondDevice);
+	BC_ASSERT_TRUE(mainDb.getServerQueuedMessages(conferenceId).empty());
+}
+
 test_t main_db_tests[] = {
 	TEST_NO_TAG("Get events count", get_events_count),
 	TEST_NO_TAG("Get messages count", get_messages_count),
@@ -288,7 +661,14 @@ test_t main_db_tests[] = {
 	TEST_NO_TAG("Get history", get_history),
 	TEST_NO_TAG("Get conference events", get_conference_notified_events),
 	TEST_NO_TAG("Get chat rooms", get_chat_rooms),
-	TEST_NO_TAG("Load a lot of chatrooms", load_a_lot_of_chatrooms)
+	TEST_NO_TAG("Load a lot of chatrooms", load_a_lot_of_chatrooms),
+	TEST_NO_TAG("Lazy chat room loading", lazy_chat_room_loading),
+	TEST_NO_TAG("Statement cache", statement_cache),
+	TEST_NO_TAG("Add events throughput", add_events_throughput),
+	TEST_NO_TAG("Ephemeral messages batches", ephemeral_messages_batches),
+	TEST_NO_TAG("Async mode", async_mode),
+	TEST_NO_TAG("Server queued messages", server_queued_messages),
+	TEST_ONE_TAG("Get history page latency", get_history_page_latency, "longterm")
 };
 
 test_suite_t main_db_test_suite = {
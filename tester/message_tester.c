@@ -323,6 +323,100 @@ static void file_transfer_content(void) {
 	linphone_core_manager_destroy(pauline);
 }
 
+static size_t xor_file_transfer_uploaded_bytes = 0;
+static size_t xor_file_transfer_downloaded_bytes = 0;
+
+static bool_t xor_file_transfer_is_encryption_enabled(LinphoneImEncryptionEngine *engine, LinphoneChatRoom *room) {
+	return TRUE;
+}
+
+static void xor_file_transfer_generate_key(LinphoneImEncryptionEngine *engine, LinphoneChatRoom *room, LinphoneChatMessage *msg) {
+}
+
+static int xor_file_transfer_process_uploading_file(LinphoneImEncryptionEngine *engine, LinphoneChatMessage *msg, size_t offset, const uint8_t *buffer, size_t *size, uint8_t *encrypted_buffer) {
+	size_t i;
+	if (!buffer) /* end of the upload, no authentication tag to compute */
+		return 0;
+	for (i = 0; i < *size; i++)
+		encrypted_buffer[i] = buffer[i] ^ 0x5A;
+	xor_file_transfer_uploaded_bytes += *size;
+	return 0;
+}
+
+static int xor_file_transfer_process_downloading_file(LinphoneImEncryptionEngine *engine, LinphoneChatMessage *msg, size_t offset, const uint8_t *buffer, size_t size, uint8_t *decrypted_buffer) {
+	size_t i;
+	if (!buffer) /* end of the download, no authentication tag to check */
+		return 0;
+	for (i = 0; i < size; i++)
+		decrypted_buffer[i] = buffer[i] ^ 0x5A;
+	xor_file_transfer_downloaded_bytes += size;
+	return 0;
+}
+
+static LinphoneImEncryptionEngine *xor_file_transfer_engine_new(void) {
+	LinphoneImEncryptionEngine *imee = linphone_im_encryption_engine_new();
+	LinphoneImEncryptionEngineCbs *cbs = linphone_im_encryption_engine_get_callbacks(imee);
+	linphone_im_encryption_engine_cbs_set_is_encryption_enabled_for_file_transfer(cbs, xor_file_transfer_is_encryption_enabled);
+	linphone_im_encryption_engine_cbs_set_generate_file_transfer_key(cbs, xor_file_transfer_generate_key);
+	linphone_im_encryption_engine_cbs_set_process_uploading_file(cbs, xor_file_transfer_process_uploading_file);
+	linphone_im_encryption_engine_cbs_set_process_downloading_file(cbs, xor_file_transfer_process_downloading_file);
+	return imee;
+}
+
+/*
+ * Sends the same file through an encryption engine twice, once from its path (encrypted by chunks) and once from
+ * a buffer (encrypted at once), and checks that the received file is intact.
+ */
+static void encrypted_file_transfer(void) {
+	LinphoneCoreManager *marie = linphone_core_manager_new("marie_rc");
+	LinphoneCoreManager *pauline = linphone_core_manager_new("pauline_tcp_rc");
+	LinphoneImEncryptionEngine *marie_imee = xor_file_transfer_engine_new();
+	LinphoneImEncryptionEngine *pauline_imee = xor_file_transfer_engine_new();
+	char *send_filepath = bc_tester_res("sounds/sintel_trailer_opus_h264.mkv");
+	char *receive_filepath = bc_tester_file("receive_file.dump");
+	bctbx_list_t *coresList = NULL;
+	LinphoneChatRoom *chat_room;
+	size_t file_size;
+	FILE *file;
+	int use_buffer;
+
+	file = fopen(send_filepath, "rb");
+	fseek(file, 0, SEEK_END);
+	file_size = (size_t)ftell(file);
+	fclose(file);
+
+	linphone_core_set_im_encryption_engine(marie->lc, marie_imee);
+	linphone_core_set_im_encryption_engine(pauline->lc, pauline_imee);
+	linphone_core_set_file_transfer_server(pauline->lc, file_transfer_url);
+	coresList = bctbx_list_append(coresList, marie->lc);
+	coresList = bctbx_list_append(coresList, pauline->lc);
+	chat_room = linphone_core_get_chat_room(pauline->lc, marie->identity);
+
+	for (use_buffer = 0; use_buffer <= 1; use_buffer++) {
+		stats initial_marie_stats = marie->stat;
+		uint64_t start = ms_get_cur_time_ms();
+
+		xor_file_transfer_uploaded_bytes = 0;
+		xor_file_transfer_downloaded_bytes = 0;
+		remove(receive_filepath);
+		_send_file(chat_room, send_filepath, NULL, (bool_t)use_buffer);
+		_receive_file(coresList, marie, &initial_marie_stats, receive_filepath, send_filepath, NULL, (bool_t)use_buffer);
+		BC_ASSERT_EQUAL((int)xor_file_transfer_uploaded_bytes, (int)file_size, int, "%d");
+		BC_ASSERT_EQUAL((int)xor_file_transfer_downloaded_bytes, (int)file_size, int, "%d");
+		ms_message("Encrypted file transfer of %d bytes from a %s done in %d ms",
+			(int)file_size, use_buffer ? "buffer" : "file", (int)(ms_get_cur_time_ms() - start));
+	}
+
+	remove(receive_filepath);
+	bc_free(receive_filepath);
+	bc_free(send_filepath);
+	bctbx_list_free(coresList);
+	linphone_im_encryption_engine_unref(marie_imee);
+	linphone_im_encryption_engine_unref(pauline_imee);
+	linphone_core_manager_destroy(marie);
+	linphone_core_manager_destroy(pauline);
+}
+
 static void create_two_basic_chat_room_with_same_remote(void) {
 	LinphoneCoreManager* laure = linphone_core_manager_new("laure_tcp_rc");
 	LinphoneCoreManager* pauline = linphone_core_manager_new("pauline_tcp_rc");
@@ -347,6 +441,132 @@ static void create_two_basic_chat_room_with_same_remote(void) {
 	linphone_core_manager_destroy(pauline);
 }
 
+/* Looks up the one to one chat rooms of peers[(i * 7919) % count] for i in [0, lookups). */
+static uint64_t search_basic_chat_rooms(LinphoneCore *lc, const LinphoneChatRoomParams *params, const LinphoneAddress *local_addr, LinphoneAddress **peers, int count, int lookups, int *found) {
+	uint64_t start = ms_get_cur_time_ms();
+	int i;
+	*found = 0;
+	for (i = 0; i < lookups; i++) {
+		bctbx_list_t *participants = bctbx_list_append(NULL, peers[(i * 7919) % count]);
+		if (linphone_core_search_chat_room(lc, params, local_addr, NULL, participants))
+			(*found)++;
+		bctbx_list_free(participants);
+	}
+	return ms_get_cur_time_ms() - start;
+}
+
+static void chat_room_lookup(void) {
+	const int sizes[] = { 100, 1000, 5000 };
+	const int lookups = 1000;
+	const int peer_count = 5000 + lookups;
+	LinphoneCoreManager *marie = linphone_core_manager_new("marie_rc");
+	LinphoneChatRoomParams *params = linphone_core_create_default_chat_room_params(marie->lc);
+	LinphoneAddress **peers = ms_new0(LinphoneAddress *, peer_count);
+	int created = 0;
+	size_t s;
+	int i;
+
+	linphone_chat_room_params_set_backend(params, LinphoneChatRoomBackendBasic);
+	linphone_chat_room_params_enable_encryption(params, FALSE);
+	linphone_chat_room_params_enable_group(params, FALSE);
+
+	for (i = 0; i < peer_count; i++) {
+		char *uri = bctbx_strdup_printf("sip:peer-%d@sip.example.org", i);
+		peers[i] = linphone_address_new(uri);
+		bctbx_free(uri);
+	}
+
+	for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		int found;
+		uint64_t hit, miss;
+
+		for (; created < sizes[s]; created++) {
+			bctbx_list_t *participants = bctbx_list_append(NULL, peers[created]);
+			LinphoneChatRoom *cr = linphone_core_create_chat_room_6(marie->lc, params, marie->identity, participants);
+			BC_ASSERT_PTR_NOT_NULL(cr);
+			if (cr)
+				linphone_chat_room_unref(cr);
+			bctbx_list_free(participants);
+		}
+
+		hit = search_basic_chat_rooms(marie->lc, params, marie->identity, peers, created, lookups, &found);
+		BC_ASSERT_EQUAL(found, lookups, int, "%d");
+		/* The last peers never get a chat room. */
+		miss = search_basic_chat_rooms(marie->lc, params, marie->identity, peers + 5000, lookups, lookups, &found);
+		BC_ASSERT_EQUAL(found, 0, int, "%d");
+
+		ms_message("Chat room lookup among %d chat rooms: %d hits in %d ms, %d misses in %d ms",
+			created, lookups, (int)hit, lookups, (int)miss);
+	}
+
+	/* A deleted chat room must not be found anymore. */
+	{
+		bctbx_list_t *participants = bctbx_list_append(NULL, peers[0]);
+		LinphoneChatRoom *cr = linphone_core_search_chat_room(marie->lc, params, marie->identity, NULL, participants);
+		BC_ASSERT_PTR_NOT_NULL(cr);
+		if (cr)
+			linphone_core_delete_chat_room(marie->lc, cr);
+		BC_ASSERT_PTR_NULL(linphone_core_search_chat_room(marie->lc, params, marie->identity, NULL, participants));
+		BC_ASSERT_PTR_NULL(linphone_core_find_one_to_one_chat_room_2(marie->lc, marie->identity, peers[0], FALSE));
+		BC_ASSERT_PTR_NOT_NULL(linphone_core_find_one_to_one_chat_room_2(marie->lc, marie->identity, peers[1], FALSE));
+		bctbx_list_free(participants);
+	}
+
+	for (i = 0; i < peer_count; i++)
+		linphone_address_unref(peers[i]);
+	ms_free(peers);
+	linphone_chat_room_params_unref(params);
+	linphone_core_manager_destroy(marie);
+}
+
+static void chat_room_lookup_with_other_scheme(void) {
+	LinphoneCoreManager *marie = linphone_core_manager_new("marie_rc");
+	LinphoneChatRoomParams *params = linphone_core_create_default_chat_room_params(marie->lc);
+	LinphoneAddress *sip_peer = linphone_address_new("sip:peer-sip@sip.example.org");
+	LinphoneAddress *sips_peer = linphone_address_new("sips:peer-sip@sip.example.org");
+	LinphoneAddress *sip_other = linphone_address_new("sip:peer-sips@sip.example.org");
+	LinphoneAddress *sips_other = linphone_address_new("sips:peer-sips@sip.example.org");
+	bctbx_list_t *participants;
+	LinphoneChatRoom *sip_cr;
+	LinphoneChatRoom *sips_cr;
+
+	linphone_chat_room_params_set_backend(params, LinphoneChatRoomBackendBasic);
+	linphone_chat_room_params_enable_encryption(params, FALSE);
+	linphone_chat_room_params_enable_group(params, FALSE);
+
+	/* The scheme does not tell people apart: a room is found whatever scheme it was created and looked up with. */
+	participants = bctbx_list_append(NULL, sip_peer);
+	sip_cr = linphone_core_create_chat_room_6(marie->lc, params, marie->identity, participants);
+	bctbx_list_free(participants);
+	participants = bctbx_list_append(NULL, sips_other);
+	sips_cr = linphone_core_create_chat_room_6(marie->lc, params, marie->identity, participants);
+	bctbx_list_free(participants);
+	if (!BC_ASSERT_PTR_NOT_NULL(sip_cr) || !BC_ASSERT_PTR_NOT_NULL(sips_cr))
+		goto end;
+
+	participants = bctbx_list_append(NULL, sips_peer);
+	BC_ASSERT_PTR_EQUAL(linphone_core_search_chat_room(marie->lc, params, marie->identity, NULL, participants), sip_cr);
+	bctbx_list_free(participants);
+	BC_ASSERT_PTR_EQUAL(linphone_core_search_chat_room(marie->lc, params, marie->identity, sips_peer, NULL), sip_cr);
+	BC_ASSERT_PTR_EQUAL(linphone_core_find_one_to_one_chat_room_2(marie->lc, marie->identity, sips_peer, FALSE), sip_cr);
+
+	participants = bctbx_list_append(NULL, sip_other);
+	BC_ASSERT_PTR_EQUAL(linphone_core_search_chat_room(marie->lc, params, marie->identity, NULL, participants), sips_cr);
+	bctbx_list_free(participants);
+	BC_ASSERT_PTR_EQUAL(linphone_core_search_chat_room(marie->lc, params, marie->identity, sip_other, NULL), sips_cr);
+	BC_ASSERT_PTR_EQUAL(linphone_core_find_one_to_one_chat_room_2(marie->lc, marie->identity, sip_other, FALSE), sips_cr);
+
+end:
+	if (sip_cr) linphone_chat_room_unref(sip_cr);
+	if (sips_cr) linphone_chat_room_unref(sips_cr);
+	linphone_address_unref(sip_peer);
+	linphone_address_unref(sips_peer);
+	linphone_address_unref(sip_other);
+	linphone_address_unref(sips_other);
+	linphone_chat_room_params_unref(params);
+	linphone_core_manager_destroy(marie);
+}
+
 static void text_message(void) {
 	LinphoneCoreManager* marie = linphone_core_manager_new("marie_rc");
 	LinphoneCoreManager* pauline = linphone_core_manager_new( "pauline_tcp_rc");
@@ -926,6 +1146,20 @@ void transfer_message_base4(LinphoneCoreManager* marie, LinphoneCoreManager* pau
 					if (linphone_factory_is_imdn_available(linphone_factory_get())) {
 						BC_ASSERT_FALSE(wait_for_until(pauline->lc, marie->lc, &pauline->stat.number_of_LinphoneMessageDisplayed, 1, 5000));
 					}
+					if (use_file_body_handler_in_download) {
+						/* the partial file and its resume marker are kept, downloading again only fetches the missing part */
+						char *marker_path = bctbx_strdup_printf("%s.resume", linphone_chat_message_get_file_transfer_filepath(recv_msg));
+						BC_ASSERT_EQUAL(bctbx_file_exist(marker_path), 0, int, "%d");
+						linphone_chat_message_download_file(recv_msg);
+						if (BC_ASSERT_TRUE(wait_for_until(pauline->lc,marie->lc,&marie->stat.number_of_LinphoneFileTransferDownloadSuccessful,1,55000))) {
+							compare_files(send_filepath, linphone_chat_message_get_file_transfer_filepath(recv_msg));
+							/* the marker is removed once the file is complete */
+							BC_ASSERT_NOT_EQUAL(bctbx_file_exist(marker_path), 0, int, "%d");
+						}
+						remove(linphone_chat_message_get_file_transfer_filepath(recv_msg));
+						remove(marker_path);
+						bctbx_free(marker_path);
+					}
 				} else {
 					/* wait for a long time in case the DNS SRV resolution takes times - it should be immediate though */
 					if (BC_ASSERT_TRUE(wait_for_until(pauline->lc,marie->lc,&marie->stat.number_of_LinphoneFileTransferDownloadSuccessful,1,55000))) {
@@ -1414,6 +1648,10 @@ static void transfer_message_with_download_io_error(void) {
 	transfer_message_base(FALSE, TRUE, FALSE, FALSE, FALSE, TRUE, -1, FALSE, FALSE);
 }
 
+static void transfer_message_with_download_io_error_resumed(void) {
+	transfer_message_base(FALSE, TRUE, FALSE, TRUE, FALSE, TRUE, -1, FALSE, FALSE);
+}
+
 static void transfer_message_upload_cancelled(void) {
 	if (transport_supported(LinphoneTransportTls)) {
 		LinphoneCoreManager* marie = linphone_core_manager_new( "marie_rc");
@@ -1448,6 +1686,44 @@ static void transfer_message_upload_cancelled(void) {
 	}
 }
 
+static void transfer_message_upload_retried(void) {
+	if (transport_supported(LinphoneTransportTls)) {
+		LinphoneCoreManager* marie = linphone_core_manager_new( "marie_rc");
+		LinphoneChatRoom* chat_room;
+		LinphoneChatMessage* msg;
+		LinphoneCoreManager* pauline = linphone_core_manager_new( "pauline_tcp_rc");
+		int dummy = 0;
+
+		/* Globally configure an http file transfer server. */
+		linphone_core_set_file_transfer_server(pauline->lc, file_transfer_url);
+		linphone_config_set_int(linphone_core_get_config(pauline->lc), "misc", "file_transfer_upload_max_retries", 3);
+
+		/* create a chatroom on pauline's side */
+		chat_room = linphone_core_get_chat_room(pauline->lc, marie->identity);
+
+		msg = create_message_from_sintel_trailer(chat_room);
+		linphone_chat_message_send(msg);
+
+		/*wait for file to be 25% uploaded and simulate a network error long enough to make the first retry fail too */
+		BC_ASSERT_TRUE(wait_for_until(pauline->lc,marie->lc,&pauline->stat.progress_of_LinphoneFileTransfer, 25, 60000));
+		sal_set_send_error(linphone_core_get_sal(pauline->lc), -1);
+		wait_for_until(pauline->lc, marie->lc, &dummy, 1, 1500);
+		BC_ASSERT_EQUAL(pauline->stat.number_of_LinphoneMessageNotDelivered, 0, int, "%d");
+		BC_ASSERT_EQUAL((int)linphone_chat_message_get_state(msg), (int)LinphoneChatMessageStateFileTransferInProgress, int, "%d");
+		sal_set_send_error(linphone_core_get_sal(pauline->lc), 0);
+		linphone_core_refresh_registers(pauline->lc); /*to make sure registration is back in registered and so it can be later unregistered*/
+
+		/* the next retry uploads the whole file again and the message is sent */
+		BC_ASSERT_TRUE(wait_for_until(pauline->lc,marie->lc,&pauline->stat.number_of_LinphoneMessageDelivered, 1, 60000));
+		BC_ASSERT_TRUE(wait_for(pauline->lc,marie->lc,&marie->stat.number_of_LinphoneMessageReceivedWithFile, 1));
+		BC_ASSERT_EQUAL(pauline->stat.number_of_LinphoneMessageNotDelivered, 0, int, "%d");
+
+		linphone_chat_message_unref(msg);
+		linphone_core_manager_destroy(pauline);
+		linphone_core_manager_destroy(marie);
+	}
+}
+
 static void transfer_message_upload_finished_during_stop(void) {
 	if (transport_supported(LinphoneTransportTls)) {
 		LinphoneCoreManager* marie = linphone_core_manager_new( "marie_rc");
@@ -3794,7 +4070,10 @@ static void migration_from_messages_db (void) {
 
 test_t message_tests[] = {
 	TEST_NO_TAG("File transfer content", file_transfer_content),
+	TEST_NO_TAG("Encrypted file transfer", encrypted_file_transfer),
 	TEST_NO_TAG("Create two basic chat rooms with same remote", create_two_basic_chat_room_with_same_remote),
+	TEST_ONE_TAG("Chat room lookup", chat_room_lookup, "longterm"),
+	TEST_NO_TAG("Chat room lookup with other scheme", chat_room_lookup_with_other_scheme),
 	TEST_NO_TAG("Text message", text_message),
 	TEST_NO_TAG("Text forward message", text_forward_message),
 	TEST_NO_TAG("Text reply message", text_reply_message),
@@ -3827,7 +4106,9 @@ test_t message_tests[] = {
 	TEST_NO_TAG("Transfer message with http proxy", file_transfer_with_http_proxy),
 	TEST_NO_TAG("Transfer message with upload io error", transfer_message_with_upload_io_error),
 	TEST_NO_TAG("Transfer message with download io error", transfer_message_with_download_io_error),
+	TEST_NO_TAG("Transfer message with download io error resumed", transfer_message_with_download_io_error_resumed),
 	TEST_NO_TAG("Transfer message upload cancelled", transfer_message_upload_cancelled),
+	TEST_NO_TAG("Transfer message upload retried", transfer_message_upload_retried),
 	TEST_NO_TAG("Transfer message upload finished during stop", transfer_message_upload_finished_during_stop),
 	TEST_NO_TAG("Transfer message download cancelled", transfer_message_download_cancelled),
 	TEST_NO_TAG("Transfer message auto download aborted", transfer_message_auto_download_aborted),
@@ -426,6 +426,119 @@ static void linphone_lpconfig_from_buffer_zerolen_value(void){
 	linphone_config_destroy(conf);
 }
 
+static void linphone_lpconfig_lookup_benchmark(void){
+	/* 100 sections of 20 entries, the size of a large provisioning config. */
+	const int section_count = 100;
+	const int entry_count = 20;
+	const int rounds = 200;
+	char *buffer = NULL;
+	char *dump = NULL;
+	LpConfig *conf;
+	uint64_t start, elapsed;
+	int64_t sum = 0;
+	int i, j, r;
+
+	for (i = 0; i < section_count; i++) {
+		char *tmp = bctbx_strdup_printf("%s[section_%i]\n# comment of section %i\n", buffer ? buffer : "", i, i);
+		if (buffer) bctbx_free(buffer);
+		buffer = tmp;
+		for (j = 0; j < entry_count; j++) {
+			tmp = bctbx_strdup_printf("%sentry_%i=%i\n", buffer, j, i * entry_count + j);
+			bctbx_free(buffer);
+			buffer = tmp;
+		}
+	}
+	conf = linphone_config_new_from_buffer(buffer);
+	bctbx_free(buffer);
+
+	start = bctbx_get_cur_time_ms();
+	for (r = 0; r < rounds; r++) {
+		for (i = 0; i < section_count; i++) {
+			char section[32];
+			snprintf(section, sizeof(section), "section_%i", i);
+			for (j = 0; j < entry_count; j++) {
+				char key[32];
+				snprintf(key, sizeof(key), "entry_%i", j);
+				sum += linphone_config_get_int(conf, section, key, -1);
+			}
+		}
+	}
+	elapsed = bctbx_get_cur_time_ms() - start;
+	ms_message("%i config lookups on %i entries done in %i ms", rounds * section_count * entry_count, section_count * entry_count, (int)elapsed);
+	BC_ASSERT_EQUAL((long long)sum, (long long)rounds * (section_count * entry_count) * (section_count * entry_count - 1) / 2, long long, "%lld");
+
+	/* Missing sections and keys. */
+	BC_ASSERT_EQUAL(linphone_config_get_int(conf, "section_100", "entry_0", -1), -1, int, "%d");
+	BC_ASSERT_EQUAL(linphone_config_get_int(conf, "section_0", "entry_20", -1), -1, int, "%d");
+
+	/* The parsed values are invalidated on set. */
+	BC_ASSERT_EQUAL(linphone_config_get_int(conf, "section_42", "entry_7", -1), 42 * entry_count + 7, int, "%d");
+	linphone_config_set_int(conf, "section_42", "entry_7", 12);
+	BC_ASSERT_EQUAL(linphone_config_get_int(conf, "section_42", "entry_7", -1), 12, int, "%d");
+	BC_ASSERT_EQUAL((int)linphone_config_get_float(conf, "section_42", "entry_7", -1.0f), 12, int, "%d");
+	linphone_config_set_string(conf, "section_42", "entry_7", NULL);
+	BC_ASSERT_EQUAL(linphone_config_get_int(conf, "section_42", "entry_7", -1), -1, int, "%d");
+	linphone_config_set_int(conf, "section_42", "entry_7", 13);
+	BC_ASSERT_EQUAL(linphone_config_get_int(conf, "section_42", "entry_7", -1), 13, int, "%d");
+
+	/* Removed sections are no longer found, and new ones are. */
+	linphone_config_clean_section(conf, "section_0");
+	BC_ASSERT_EQUAL(linphone_config_get_int(conf, "section_0", "entry_0", -1), -1, int, "%d");
+	linphone_config_set_int(conf, "section_0", "entry_0", 5);
+	BC_ASSERT_EQUAL(linphone_config_get_int(conf, "section_0", "entry_0", -1), 5, int, "%d");
+
+	/* The order of the entries is kept, a removed entry set again goes at the end of its section. */
+	dump = linphone_config_dump(conf);
+	BC_ASSERT_PTR_NOT_NULL(strstr(dump, "\tentry_6=846\n\tentry_8=848\n"));
+	BC_ASSERT_PTR_NOT_NULL(strstr(dump, "\tentry_19=859\n\tentry_7=13\n"));
+	bctbx_free(dump);
+
+	linphone_config_destroy(conf);
+}
+
+static void linphone_lpconfig_background_sync(void){
+	char *rc_path = bc_tester_file("background_sync_rc");
+	LinphoneCore *lc;
+	LpConfig *conf;
+	int dummy = 0;
+	int i;
+
+	unlink(rc_path);
+	lc = linphone_factory_create_core_3(linphone_factory_get(), rc_path, NULL, system_context);
+	if (BC_ASSERT_PTR_NOT_NULL(lc)) {
+		linphone_core_start(lc);
+		conf = linphone_core_get_config(lc);
+
+		/* The snapshots are written in the background while the core iterates. */
+		for (i = 0; i < 3; i++) {
+			int j;
+			for (j = 0; j < 100; j++) {
+				char key[32];
+				snprintf(key, sizeof(key), "entry_%i", j);
+				linphone_config_set_int(conf, "background_sync", key, i * 100 + j);
+			}
+			wait_for_until(lc, NULL, &dummy, 1, 1100);
+			BC_ASSERT_FALSE(linphone_config_needs_commit(conf));
+		}
+
+		/* Changes done after the last snapshot are written when the core stops. */
+		linphone_config_set_string(conf, "background_sync", "last", "stop");
+		linphone_core_stop(lc);
+		linphone_core_unref(lc);
+
+		conf = linphone_config_new(rc_path);
+		if (BC_ASSERT_PTR_NOT_NULL(conf)) {
+			BC_ASSERT_EQUAL(linphone_config_get_int(conf, "background_sync", "entry_0", -1), 200, int, "%d");
+			BC_ASSERT_EQUAL(linphone_config_get_int(conf, "background_sync", "entry_99", -1), 299, int, "%d");
+			BC_ASSERT_STRING_EQUAL(linphone_config_get_string(conf, "background_sync", "last", ""), "stop");
+			linphone_config_destroy(conf);
+		}
+	}
+
+	unlink(rc_path);
+	bctbx_free(rc_path);
+}
+
 static void linphone_lpconfig_from_file_zerolen_value(void){
 	/* parameters that have no value should return NULL, not "". */
 	const char* zero_rc_file = "zero_length_params_rc";
@@ -1269,7 +1382,40 @@ static void search_friend_with_phone_number_2(void) {
 	lf = linphone_friend_list_find_friend_by_phone_number(lfl, "+ (33) 6 12 13 14 15");
 	BC_ASSERT_PTR_NULL(lf);
 
+	// Phone numbers edited after the first lookup
+	linphone_friend_add_phone_number(laureFriend, "0612131415");
+	lf = linphone_friend_list_find_friend_by_phone_number(lfl, "+33612131415");
+	BC_ASSERT_PTR_NOT_NULL(lf);
+	if (lf) {
+		BC_ASSERT_PTR_EQUAL(lf, laureFriend);
+	}
+	linphone_friend_remove_phone_number(laureFriend, "0612131415");
+	lf = linphone_friend_list_find_friend_by_phone_number(lfl, "+33612131415");
+	BC_ASSERT_PTR_NULL(lf);
+
+	// A number shared by several friends matches the first one of the list, whatever the order they got it
+	const bctbx_list_t *it;
+	LinphoneFriend *firstFriend = NULL;
+	for (it = linphone_friend_list_get_friends(lfl); it != NULL && !firstFriend; it = bctbx_list_next(it)) {
+		if (bctbx_list_get_data(it) == laureFriend || bctbx_list_get_data(it) == stephanieFriend)
+			firstFriend = (LinphoneFriend *)bctbx_list_get_data(it);
+	}
+	linphone_friend_add_phone_number(stephanieFriend, "0699887766");
+	linphone_friend_add_phone_number(laureFriend, "+33699887766");
+	lf = linphone_friend_list_find_friend_by_phone_number(lfl, "+33699887766");
+	BC_ASSERT_PTR_EQUAL(lf, firstFriend);
+	linphone_friend_remove_phone_number(stephanieFriend, "0699887766");
+	linphone_friend_remove_phone_number(laureFriend, "+33699887766");
+	linphone_friend_add_phone_number(laureFriend, "+33699887766");
+	linphone_friend_add_phone_number(stephanieFriend, "0699887766");
+	lf = linphone_friend_list_find_friend_by_phone_number(lfl, "+33699887766");
+	BC_ASSERT_PTR_EQUAL(lf, firstFriend);
+	linphone_friend_remove_phone_number(stephanieFriend, "0699887766");
+	linphone_friend_remove_phone_number(laureFriend, "+33699887766");
+
 	linphone_friend_list_remove_friend(lfl, stephanieFriend);
+	lf = linphone_friend_list_find_friend_by_phone_number(lfl, "0633889977");
+	BC_ASSERT_PTR_NULL(lf);
 	if (stephanieFriend) linphone_friend_unref(stephanieFriend);
 	if (stephanieVcard) linphone_vcard_unref(stephanieVcard);
 
@@ -1798,6 +1944,183 @@ static void search_friend_large_database(void) {
 	bc_free(dbPath);
 }
 
+static void search_friend_limited_search_ranking(void) {
+	LinphoneCoreManager* manager = linphone_core_manager_new_with_proxies_check("empty_rc", FALSE);
+	LinphoneFriendList *lfl = linphone_core_get_default_friend_list(manager->lc);
+	char uri[64];
+	int i;
+
+	/* Added in reverse order so that ranking is needed. */
+	for (i = 49 ; i >= 0 ; i--) {
+		snprintf(uri, sizeof(uri), "sip:user%02d@sip.example.org", i);
+		LinphoneFriend *fr = linphone_core_create_friend_with_address(manager->lc, uri);
+		linphone_friend_enable_subscribes(fr, FALSE);
+		linphone_friend_list_add_local_friend(lfl, fr);
+		linphone_friend_unref(fr);
+	}
+
+	LinphoneMagicSearch *magicSearch = linphone_magic_search_new(manager->lc);
+	linphone_magic_search_set_limited_search(magicSearch, TRUE);
+	linphone_magic_search_set_search_limit(magicSearch, 10);
+
+	bctbx_list_t *resultList = linphone_magic_search_get_contact_list_from_filter(magicSearch, "user", "");
+	if (BC_ASSERT_PTR_NOT_NULL(resultList)) {
+		BC_ASSERT_EQUAL((int)bctbx_list_size(resultList), 10, int, "%d");
+		for (i = 0 ; i < 10 ; i++) {
+			snprintf(uri, sizeof(uri), "sip:user%02d@sip.example.org", i);
+			_check_friend_result_list(manager->lc, resultList, (unsigned int)i, uri, NULL);
+		}
+		bctbx_list_free_with_data(resultList, (bctbx_list_free_func)linphone_magic_search_unref);
+	}
+
+	/* Continue from the cache, which holds more than the displayed results. */
+	resultList = linphone_magic_search_get_contact_list_from_filter(magicSearch, "user3", "");
+	if (BC_ASSERT_PTR_NOT_NULL(resultList)) {
+		BC_ASSERT_EQUAL((int)bctbx_list_size(resultList), 10, int, "%d");
+		for (i = 0 ; i < 10 ; i++) {
+			snprintf(uri, sizeof(uri), "sip:user%02d@sip.example.org", 30 + i);
+			_check_friend_result_list(manager->lc, resultList, (unsigned int)i, uri, NULL);
+		}
+		bctbx_list_free_with_data(resultList, (bctbx_list_free_func)linphone_magic_search_unref);
+	}
+
+	linphone_magic_search_reset_search_cache(magicSearch);
+	linphone_magic_search_set_limited_search(magicSearch, FALSE);
+	resultList = linphone_magic_search_get_contact_list_from_filter(magicSearch, "user", "");
+	if (BC_ASSERT_PTR_NOT_NULL(resultList)) {
+		BC_ASSERT_EQUAL((int)bctbx_list_size(resultList), 50, int, "%d");
+		_check_friend_result_list(manager->lc, resultList, 0, "sip:user00@sip.example.org", NULL);
+		_check_friend_result_list(manager->lc, resultList, 49, "sip:user49@sip.example.org", NULL);
+		bctbx_list_free_with_data(resultList, (bctbx_list_free_func)linphone_magic_search_unref);
+	}
+
+	linphone_magic_search_unref(magicSearch);
+	linphone_core_manager_destroy(manager);
+}
+
+typedef struct {
+	int partialResultsCount;
+	int partialResultsSize;
+	int resultsCount;
+} MagicSearchAsyncStats;
+
+static void _magic_search_partial_results_received(LinphoneMagicSearch *magic_search) {
+	MagicSearchAsyncStats *stats = (MagicSearchAsyncStats *)linphone_magic_search_cbs_get_user_data(linphone_magic_search_get_current_callbacks(magic_search));
+	bctbx_list_t *resultList = linphone_magic_search_get_last_search(magic_search);
+	stats->partialResultsCount++;
+	stats->partialResultsSize = (int)bctbx_list_size(resultList);
+	bctbx_list_free_with_data(resultList, (bctbx_list_free_func)linphone_magic_search_unref);
+}
+
+static void _magic_search_results_received(LinphoneMagicSearch *magic_search) {
+	MagicSearchAsyncStats *stats = (MagicSearchAsyncStats *)linphone_magic_search_cbs_get_user_data(linphone_magic_search_get_current_callbacks(magic_search));
+	stats->resultsCount++;
+}
+
+static void search_friend_async_partial_results(void) {
+	LinphoneCoreManager* manager = linphone_core_manager_new_with_proxies_check("empty_rc", FALSE);
+	LinphoneFriendList *lfl = linphone_core_get_default_friend_list(manager->lc);
+	MagicSearchAsyncStats stats = {0};
+
+	_create_friends_from_tab(manager->lc, lfl, sFriends, sSizeFriend);
+
+	LinphoneMagicSearch *magicSearch = linphone_magic_search_new(manager->lc);
+	LinphoneMagicSearchCbs *cbs = linphone_factory_create_magic_search_cbs(linphone_factory_get());
+	linphone_magic_search_cbs_set_partial_search_results_received(cbs, _magic_search_partial_results_received);
+	linphone_magic_search_cbs_set_search_results_received(cbs, _magic_search_results_received);
+	linphone_magic_search_cbs_set_user_data(cbs, &stats);
+	linphone_magic_search_add_callbacks(magicSearch, cbs);
+	linphone_magic_search_cbs_unref(cbs);
+
+	linphone_magic_search_get_contact_list_from_filter_async(magicSearch, "llo", "");
+	BC_ASSERT_TRUE(wait_for_until(manager->lc, NULL, &stats.resultsCount, 1, 5000));
+	/* Friends, call logs and chat rooms. */
+	BC_ASSERT_GREATER(stats.partialResultsCount, 3, int, "%d");
+	/* Partial results are available without being cached. */
+	BC_ASSERT_EQUAL(stats.partialResultsSize, 3, int, "%d");
+
+	bctbx_list_t *resultList = linphone_magic_search_get_last_search(magicSearch);
+	if (BC_ASSERT_PTR_NOT_NULL(resultList)) {
+		BC_ASSERT_EQUAL((int)bctbx_list_size(resultList), 3, int, "%d");
+		_check_friend_result_list(manager->lc, resultList, 0, sFriends[2], NULL);//"sip:allo@sip.example.org"
+		_check_friend_result_list(manager->lc, resultList, 1, sFriends[3], NULL);//"sip:hello@sip.example.org"
+		_check_friend_result_list(manager->lc, resultList, 2, sFriends[4], NULL);//"sip:hello@sip.test.org"
+		bctbx_list_free_with_data(resultList, (bctbx_list_free_func)linphone_magic_search_unref);
+	}
+
+	_remove_friends_from_list(lfl, sFriends, sSizeFriend);
+
+	linphone_magic_search_unref(magicSearch);
+	linphone_core_manager_destroy(manager);
+}
+
+static void _search_friend_in_many_friends(unsigned int count) {
+	LinphoneCoreManager* manager = linphone_core_manager_new_with_proxies_check("empty_rc", FALSE);
+	LinphoneFriendList *lfl = linphone_core_get_default_friend_list(manager->lc);
+	const char *filters[] = {"u", "user", "user04242", "example.org", "unknown"};
+	char uri[64];
+	unsigned int i;
+
+	for (i = 0 ; i < count ; i++) {
+		snprintf(uri, sizeof(uri), "sip:user%05u@sip.example.org", i);
+		LinphoneFriend *fr = linphone_core_create_friend_with_address(manager->lc, uri);
+		linphone_friend_enable_subscribes(fr, FALSE);
+		linphone_friend_list_add_local_friend(lfl, fr);
+		linphone_friend_unref(fr);
+	}
+
+	LinphoneMagicSearch *magicSearch = linphone_magic_search_new(manager->lc);
+	for (i = 0 ; i < sizeof(filters) / sizeof(filters[0]) ; i++) {
+		MSTimeSpec start, current;
+		long long time;
+		linphone_magic_search_reset_search_cache(magicSearch);
+		liblinphone_tester_clock_start(&start);
+		bctbx_list_t *resultList = linphone_magic_search_get_contact_list_from_filter(magicSearch, filters[i], "");
+		ms_get_cur_time(&current);
+		time = ((current.tv_sec - start.tv_sec) * 1000LL) + ((current.tv_nsec - start.tv_nsec) / 1000000LL);
+		ms_message("Searching [%s] in %u friends: %lld ms, %zu results", filters[i], count, time, bctbx_list_size(resultList));
+		if (strcmp(filters[i], "user04242") == 0 && count > 4242) {
+			BC_ASSERT_EQUAL((int)bctbx_list_size(resultList), 1, int, "%d");
+		} else if (strcmp(filters[i], "unknown") == 0) {
+			BC_ASSERT_PTR_NULL(resultList);
+		}
+		bctbx_list_free_with_data(resultList, (bctbx_list_free_func)linphone_magic_search_unref);
+	}
+
+	/* The index must follow the friends added after it was built. */
+	LinphoneFriend *fr = linphone_core_create_friend_with_address(manager->lc, "sip:newcomer@sip.example.org");
+	linphone_friend_enable_subscribes(fr, FALSE);
+	linphone_friend_list_add_local_friend(lfl, fr);
+	linphone_magic_search_reset_search_cache(magicSearch);
+	bctbx_list_t *resultList = linphone_magic_search_get_contact_list_from_filter(magicSearch, "newcomer", "");
+	if (BC_ASSERT_PTR_NOT_NULL(resultList)) {
+		BC_ASSERT_EQUAL((int)bctbx_list_size(resultList), 1, int, "%d");
+		bctbx_list_free_with_data(resultList, (bctbx_list_free_func)linphone_magic_search_unref);
+	}
+	linphone_friend_list_remove_friend(lfl, fr);
+	linphone_friend_unref(fr);
+
+	linphone_magic_search_reset_search_cache(magicSearch);
+	resultList = linphone_magic_search_get_contact_list_from_filter(magicSearch, "newcomer", "");
+	BC_ASSERT_PTR_NULL(resultList);
+	if (resultList) bctbx_list_free_with_data(resultList, (bctbx_list_free_func)linphone_magic_search_unref);
+
+	linphone_magic_search_unref(magicSearch);
+	linphone_core_manager_destroy(manager);
+}
+
+static void search_friend_in_1k_friends(void) {
+	_search_friend_in_many_friends(1000);
+}
+
+static void search_friend_in_10k_friends(void) {
+	_search_friend_in_many_friends(10000);
+}
+
+static void search_friend_in_100k_friends(void) {
+	_search_friend_in_many_friends(100000);
+}
+
 static void search_friend_get_capabilities(void) {
 	LinphoneMagicSearch *magicSearch = NULL;
 	bctbx_list_t *resultList = NULL;
@@ -2338,6 +2661,8 @@ test_t setup_tests[] = {
 	TEST_NO_TAG("Linphone interpret url", linphone_interpret_url_test),
 	TEST_NO_TAG("LPConfig from buffer", linphone_lpconfig_from_buffer),
 	TEST_NO_TAG("LPConfig zero_len value from buffer", linphone_lpconfig_from_buffer_zerolen_value),
+	TEST_NO_TAG("LPConfig lookup benchmark", linphone_lpconfig_lookup_benchmark),
+	TEST_NO_TAG("LPConfig background sync", linphone_lpconfig_background_sync),
 	TEST_NO_TAG("LPConfig zero_len value from file", linphone_lpconfig_from_file_zerolen_value),
 	TEST_NO_TAG("LPConfig zero_len value from XML", linphone_lpconfig_from_xml_zerolen_value),
 	TEST_NO_TAG("LPConfig invalid friend", linphone_lpconfig_invalid_friend),
@@ -2367,6 +2692,11 @@ test_t setup_tests[] = {
 	TEST_ONE_TAG("Search friend with multiple sip address", search_friend_with_multiple_sip_address, "MagicSearch"),
 	TEST_ONE_TAG("Search friend with same address", search_friend_with_same_address, "MagicSearch"),
 	TEST_ONE_TAG("Search friend in large friends database", search_friend_large_database, "MagicSearch"),
+	TEST_ONE_TAG("Search friend with limited search ranking", search_friend_limited_search_ranking, "MagicSearch"),
+	TEST_ONE_TAG("Search friend asynchronously with partial results", search_friend_async_partial_results, "MagicSearch"),
+	TEST_TWO_TAGS("Search friend in 1k friends", search_friend_in_1k_friends, "MagicSearch", "longterm"),
+	TEST_TWO_TAGS("Search friend in 10k friends", search_friend_in_10k_friends, "MagicSearch", "longterm"),
+	TEST_TWO_TAGS("Search friend in 100k friends", search_friend_in_100k_friends, "MagicSearch", "longterm"),
 	TEST_ONE_TAG("Search friend result has capabilities", search_friend_get_capabilities, "MagicSearch"),
 	TEST_ONE_TAG("Search friend result chat room remote", search_friend_chat_room_remote, "MagicSearch"),
 	TEST_ONE_TAG("Search friend in non default friend list", search_friend_non_default_list, "MagicSearch"),
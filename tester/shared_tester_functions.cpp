@@ -273,6 +273,13 @@ void check_result_desc_rtp_rtcp_ports (LinphoneCall *call, int rtp_port, int rtc
 	}
 }
 
+void check_local_desc_audio_rtp_addr (LinphoneCall *call, const char *rtp_addr) {
+	SalMediaDescription *desc = _linphone_call_get_local_desc(call);
+	const SalStreamDescription & stream = desc->findBestStream(SalAudio);
+	if (!BC_ASSERT_FALSE(stream == Utils::getEmptyConstRefObject<SalStreamDescription>())) return;
+	BC_ASSERT_STRING_EQUAL(stream.rtp_addr.c_str(), rtp_addr);
+}
+
 void check_local_desc_stream (LinphoneCall *call) {
 	const auto & desc = _linphone_call_get_local_desc(call);
 	const auto & core = linphone_call_get_core(call);
@@ -32,6 +32,7 @@ bool_t is_srtp_secured (LinphoneCall *call, LinphoneStreamType ctype);
 void check_media_stream(LinphoneCall *call, bool_t is_null);
 void check_local_desc_stream (LinphoneCall *call);
 void check_result_desc_rtp_rtcp_ports (LinphoneCall *call, int rtp_port, int rtcp_port);
+void check_local_desc_audio_rtp_addr (LinphoneCall *call, const char *rtp_addr);
 
 #ifdef __cplusplus
 }
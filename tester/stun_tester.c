@@ -92,6 +92,265 @@ end:
 	linphone_core_manager_destroy(lc_stun);
 }
 
+/* Minimal STUN server answering the binding requests with the source address, run in its own thread. */
+typedef struct _StunStandIn {
+	ortp_socket_t sock;
+	int port;
+	ms_thread_t thread;
+	volatile bool_t running;
+	volatile bool_t answer;
+	volatile int requests;
+} StunStandIn;
+
+static void *stun_stand_in_run(void *data) {
+	StunStandIn *stand_in = (StunStandIn *)data;
+	while (stand_in->running) {
+		char buf[MS_STUN_MAX_MESSAGE_SIZE];
+		struct sockaddr_in from;
+		socklen_t fromlen = sizeof(from);
+		int len = (int)recvfrom(stand_in->sock, buf, sizeof(buf), 0, (struct sockaddr *)&from, &fromlen);
+		MSStunMessage *req;
+		if (len <= 0) {
+			ms_usleep(5000);
+			continue;
+		}
+		req = ms_stun_message_create_from_buffer_parsing((uint8_t *)buf, (ssize_t)len);
+		if (!req)
+			continue;
+		stand_in->requests++;
+		if (stand_in->answer) {
+			MSStunMessage *resp = ms_stun_binding_success_response_create();
+			MSStunAddress mapped;
+			char *out = NULL;
+			size_t outlen;
+			memset(&mapped, 0, sizeof(mapped));
+			mapped.family = MS_STUN_ADDR_FAMILY_IPV4;
+			mapped.ip.v4.addr = ntohl(from.sin_addr.s_addr);
+			mapped.ip.v4.port = ntohs(from.sin_port);
+			ms_stun_message_set_tr_id(resp, ms_stun_message_get_tr_id(req));
+			ms_stun_message_set_xor_mapped_address(resp, mapped);
+			outlen = ms_stun_message_encode(resp, &out);
+			if (outlen > 0)
+				bctbx_sendto(stand_in->sock, out, outlen, 0, (struct sockaddr *)&from, fromlen);
+			if (out)
+				ms_free(out);
+			ms_stun_message_destroy(resp);
+		}
+		ms_stun_message_destroy(req);
+	}
+	return NULL;
+}
+
+static bool_t stun_stand_in_start(StunStandIn *stand_in) {
+	struct sockaddr_in addr;
+	socklen_t addrlen = sizeof(addr);
+	memset(stand_in, 0, sizeof(*stand_in));
+	stand_in->sock = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (stand_in->sock == (ortp_socket_t)-1)
+		return FALSE;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = 0;
+	if (bind(stand_in->sock, (struct sockaddr *)&addr, sizeof(addr)) < 0
+		|| getsockname(stand_in->sock, (struct sockaddr *)&addr, &addrlen) < 0) {
+		close_socket(stand_in->sock);
+		return FALSE;
+	}
+	set_non_blocking_socket(stand_in->sock);
+	stand_in->port = ntohs(addr.sin_port);
+	stand_in->answer = TRUE;
+	stand_in->running = TRUE;
+	ms_thread_create(&stand_in->thread, NULL, stun_stand_in_run, stand_in);
+	return TRUE;
+}
+
+static void stun_stand_in_stop(StunStandIn *stand_in) {
+	stand_in->running = FALSE;
+	ms_thread_join(stand_in->thread, NULL);
+	close_socket(stand_in->sock);
+}
+
+static void linphone_stun_test_local_server(void) {
+	LinphoneCoreManager* lc_stun = linphone_core_manager_new_with_proxies_check("stun_rc", FALSE);
+	StunStandIn stand_in;
+	char server[64];
+	int ping_time;
+	int requests;
+	int tmp = 0;
+	char audio_addr[LINPHONE_IPADDR_SIZE] = { 0 };
+	char video_addr[LINPHONE_IPADDR_SIZE] = { 0 };
+	char text_addr[LINPHONE_IPADDR_SIZE] = { 0 };
+	int audio_port = 0;
+	int video_port = 0;
+	int text_port = 0;
+
+	if (!BC_ASSERT_TRUE(stun_stand_in_start(&stand_in)))
+		goto end;
+	linphone_core_enable_ipv6(lc_stun->lc, FALSE);
+	snprintf(server, sizeof(server), "127.0.0.1:%d", stand_in.port);
+	linphone_core_set_stun_server(lc_stun->lc, server);
+	wait_for(lc_stun->lc, lc_stun->lc, &tmp, 1);
+
+	/* The discovery is driven by the main loop, linphone_run_stun_tests() iterates the core until it is done. */
+	ping_time = linphone_run_stun_tests(lc_stun->lc, 17078, 19078, 21078, audio_addr, &audio_port, video_addr, &video_port, text_addr, &text_port);
+	BC_ASSERT_TRUE(ping_time >= 0);
+	BC_ASSERT_STRING_EQUAL(audio_addr, "127.0.0.1");
+	BC_ASSERT_EQUAL(audio_port, 17078, int, "%d");
+	requests = stand_in.requests;
+	BC_ASSERT_TRUE(requests > 0);
+
+	/* The same ports on the same network are found in the cache, without request. */
+	memset(audio_addr, 0, sizeof(audio_addr));
+	audio_port = 0;
+	ping_time = linphone_run_stun_tests(lc_stun->lc, 17078, 19078, 21078, audio_addr, &audio_port, video_addr, &video_port, text_addr, &text_port);
+	BC_ASSERT_TRUE(ping_time >= 0);
+	BC_ASSERT_STRING_EQUAL(audio_addr, "127.0.0.1");
+	BC_ASSERT_EQUAL(audio_port, 17078, int, "%d");
+	BC_ASSERT_EQUAL(stand_in.requests, requests, int, "%d");
+
+	/* Other ports are not in the cache, the discovery times out if the server does not answer. */
+	stand_in.answer = FALSE;
+	ping_time = linphone_run_stun_tests(lc_stun->lc, 17080, 19080, 21080, audio_addr, &audio_port, video_addr, &video_port, text_addr, &text_port);
+	BC_ASSERT_EQUAL(ping_time, -1, int, "%d");
+	BC_ASSERT_TRUE(stand_in.requests > requests);
+
+	stun_stand_in_stop(&stand_in);
+
+end:
+	linphone_core_manager_destroy(lc_stun);
+}
+
+static void stun_auto_accept_call_state_changed(LinphoneCore *lc, LinphoneCall *call, LinphoneCallState cstate, const char *msg) {
+	if (cstate == LinphoneCallIncomingReceived) {
+		LinphoneCoreCbs *cbs = linphone_core_get_current_callbacks(lc);
+		int *deferred_accepts = (int *)linphone_core_cbs_get_user_data(cbs);
+		linphone_call_accept(call);
+		/* The STUN discovery started when the INVITE was received is still running, the answer must wait for it. */
+		if (linphone_call_get_state(call) == LinphoneCallIncomingReceived)
+			(*deferred_accepts)++;
+	}
+}
+
+static void configure_local_stun_policy(LinphoneCore *lc, int port) {
+	LinphoneNatPolicy *nat_policy = linphone_core_create_nat_policy(lc);
+	char server[64];
+	snprintf(server, sizeof(server), "127.0.0.1:%d", port);
+	linphone_core_enable_ipv6(lc, FALSE);
+	/* Make sure each call runs a discovery. */
+	linphone_config_set_int(linphone_core_get_config(lc), "net", "stun_cache_lifetime", 0);
+	linphone_nat_policy_enable_stun(nat_policy, TRUE);
+	linphone_nat_policy_set_stun_server(nat_policy, server);
+	linphone_core_set_nat_policy(lc, nat_policy);
+	linphone_nat_policy_unref(nat_policy);
+}
+
+static void call_with_local_stun_server(void) {
+	LinphoneCoreManager *marie = linphone_core_manager_create("marie_rc");
+	LinphoneCoreManager *pauline = linphone_core_manager_create(transport_supported(LinphoneTransportTls) ? "pauline_rc" : "pauline_tcp_rc");
+	LinphoneCoreCbs *cbs;
+	LinphoneCall *marie_call;
+	LinphoneCall *pauline_call;
+	StunStandIn stand_in;
+	int deferred_accepts = 0;
+
+	if (!BC_ASSERT_TRUE(stun_stand_in_start(&stand_in)))
+		goto end;
+	configure_local_stun_policy(marie->lc, stand_in.port);
+	configure_local_stun_policy(pauline->lc, stand_in.port);
+
+	/* Pauline answers as soon as the call is received. */
+	cbs = linphone_factory_create_core_cbs(linphone_factory_get());
+	linphone_core_cbs_set_call_state_changed(cbs, stun_auto_accept_call_state_changed);
+	linphone_core_cbs_set_user_data(cbs, &deferred_accepts);
+	linphone_core_add_callbacks(pauline->lc, cbs);
+	linphone_core_cbs_unref(cbs);
+
+	linphone_core_manager_start(marie, TRUE);
+	linphone_core_manager_start(pauline, TRUE);
+
+	/* The INVITE waits for the STUN discovery. */
+	marie_call = linphone_core_invite_address(marie->lc, pauline->identity);
+	if (!BC_ASSERT_PTR_NOT_NULL(marie_call))
+		goto stop;
+	BC_ASSERT_EQUAL(linphone_call_get_state(marie_call), LinphoneCallOutgoingInit, int, "%d");
+
+	BC_ASSERT_TRUE(wait_for(marie->lc, pauline->lc, &pauline->stat.number_of_LinphoneCallIncomingReceived, 1));
+	BC_ASSERT_TRUE(wait_for(marie->lc, pauline->lc, &marie->stat.number_of_LinphoneCallStreamsRunning, 1));
+	BC_ASSERT_TRUE(wait_for(marie->lc, pauline->lc, &pauline->stat.number_of_LinphoneCallStreamsRunning, 1));
+	BC_ASSERT_EQUAL(deferred_accepts, 1, int, "%d");
+	BC_ASSERT_TRUE(stand_in.requests > 0);
+
+	/* Both the offer and the answer advertise the mapped addresses, and the RTP sockets receive the media. */
+	pauline_call = linphone_core_get_current_call(pauline->lc);
+	if (BC_ASSERT_PTR_NOT_NULL(pauline_call)) {
+		check_local_desc_audio_rtp_addr(marie_call, "127.0.0.1");
+		check_local_desc_audio_rtp_addr(pauline_call, "127.0.0.1");
+		liblinphone_tester_check_rtcp(marie, pauline);
+	}
+	end_call(marie, pauline);
+
+stop:
+	stun_stand_in_stop(&stand_in);
+
+end:
+	linphone_core_manager_destroy(marie);
+	linphone_core_manager_destroy(pauline);
+}
+
+static void stun_early_media_call_state_changed(LinphoneCore *lc, LinphoneCall *call, LinphoneCallState cstate, const char *msg) {
+	if (cstate == LinphoneCallIncomingReceived)
+		linphone_call_accept_early_media(call);
+}
+
+static void early_media_call_with_local_stun_server(void) {
+	LinphoneCoreManager *marie = linphone_core_manager_create("marie_rc");
+	LinphoneCoreManager *pauline = linphone_core_manager_create(transport_supported(LinphoneTransportTls) ? "pauline_rc" : "pauline_tcp_rc");
+	LinphoneCoreCbs *cbs;
+	LinphoneCall *marie_call;
+	LinphoneCall *pauline_call;
+	StunStandIn stand_in;
+
+	if (!BC_ASSERT_TRUE(stun_stand_in_start(&stand_in)))
+		goto end;
+	configure_local_stun_policy(marie->lc, stand_in.port);
+	configure_local_stun_policy(pauline->lc, stand_in.port);
+
+	/* Pauline sends early media as soon as the call is received, while her STUN discovery is running. */
+	cbs = linphone_factory_create_core_cbs(linphone_factory_get());
+	linphone_core_cbs_set_call_state_changed(cbs, stun_early_media_call_state_changed);
+	linphone_core_add_callbacks(pauline->lc, cbs);
+	linphone_core_cbs_unref(cbs);
+
+	linphone_core_manager_start(marie, TRUE);
+	linphone_core_manager_start(pauline, TRUE);
+
+	marie_call = linphone_core_invite_address(marie->lc, pauline->identity);
+	if (!BC_ASSERT_PTR_NOT_NULL(marie_call))
+		goto stop;
+	BC_ASSERT_TRUE(wait_for(marie->lc, pauline->lc, &pauline->stat.number_of_LinphoneCallIncomingEarlyMedia, 1));
+	BC_ASSERT_TRUE(wait_for(marie->lc, pauline->lc, &marie->stat.number_of_LinphoneCallOutgoingEarlyMedia, 1));
+
+	/* The early media SDP already advertises the mapped address. */
+	pauline_call = linphone_core_get_current_call(pauline->lc);
+	if (BC_ASSERT_PTR_NOT_NULL(pauline_call)) {
+		check_local_desc_audio_rtp_addr(pauline_call, "127.0.0.1");
+		linphone_call_accept(pauline_call);
+		BC_ASSERT_TRUE(wait_for(marie->lc, pauline->lc, &marie->stat.number_of_LinphoneCallStreamsRunning, 1));
+		BC_ASSERT_TRUE(wait_for(marie->lc, pauline->lc, &pauline->stat.number_of_LinphoneCallStreamsRunning, 1));
+		check_local_desc_audio_rtp_addr(pauline_call, "127.0.0.1");
+		liblinphone_tester_check_rtcp(marie, pauline);
+	}
+	end_call(marie, pauline);
+
+stop:
+	stun_stand_in_stop(&stand_in);
+
+end:
+	linphone_core_manager_destroy(marie);
+	linphone_core_manager_destroy(pauline);
+}
+
 static void configure_nat_policy(LinphoneCore *lc, bool_t turn_enabled, bool_t turn_tcp, bool_t turn_tls) {
 	const char *username = "liblinphone-tester";
 	const char *password = "retset-enohpnilbil";
@@ -332,6 +591,9 @@ static void relayed_ice_turn_to_ice_with_dtls_srtp(void){
 test_t stun_tests[] = {
 	TEST_ONE_TAG("Basic Stun test (Ping/public IP)", linphone_stun_test_grab_ip, "STUN"),
 	TEST_ONE_TAG("STUN encode", linphone_stun_test_encode, "STUN"),
+	TEST_ONE_TAG("STUN discovery with local server", linphone_stun_test_local_server, "STUN"),
+	TEST_ONE_TAG("Call with local STUN server", call_with_local_stun_server, "STUN"),
+	TEST_ONE_TAG("Early media call with local STUN server", early_media_call_with_local_stun_server, "STUN"),
 	TEST_TWO_TAGS("Basic ICE+TURN call", basic_ice_turn_call, "ICE", "TURN"),
 	TEST_TWO_TAGS("Basic IPv6 ICE+TURN call", basic_ipv6_ice_turn_call, "ICE", "TURN"),
 	TEST_TWO_TAGS("Basic ICE+TURN call with TCP", basic_ice_turn_call_tcp, "ICE", "TURN"),
@@ -17,10 +17,18 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <atomic>
+#include <thread>
+
 #include "linphone/utils/utils.h"
 
+#include "bctoolbox/logging.h"
 #include "bctoolbox/utils.hh"
 
+#include "address/address.h"
+#include "containers/sharded-lru-cache.h"
+#include "logger/logger.h"
+
 #include "liblinphone_tester.h"
 #include "tester_utils.h"
 
@@ -103,11 +111,93 @@ static void parse_capabilities(void){
 	BC_ASSERT_TRUE(caps["ephemeral"] == Version(1, 0));
 }
 
+static int evaluatedOperands = 0;
+
+static string countEvaluation (const Address &address) {
+	evaluatedOperands++;
+	return address.asString();
+}
+
+static void disabled_logs_cost () {
+	// Same statements as the ones logged for each received chat message.
+	const Address from("sip:marie@sip.example.org;gr=urn:uuid:5f3ee4d8-4d2d-4a1f-a1b8-1c1a5d1b7fa1");
+	const Address to("sip:pauline@sip.example.org");
+	const int messageCount = 20000;
+	const unsigned int previousMask = bctbx_get_log_level_mask("liblinphone");
+
+	bctbx_set_log_level_mask("liblinphone", BCTBX_LOG_WARNING | BCTBX_LOG_ERROR | BCTBX_LOG_FATAL);
+	BC_ASSERT_FALSE(L_LOG_ENABLED(Info));
+	BC_ASSERT_TRUE(L_LOG_ENABLED(Warning));
+
+	uint64_t start = bctbx_get_cur_time_ms();
+	for (int i = 0; i < messageCount; i++) {
+		// Previous definition of lInfo(), which always builds the message.
+		Logger(Logger::Info).getOutput() << "Chat message received from [" << countEvaluation(from) << "] to [" << countEvaluation(to) << "]";
+	}
+	const uint64_t unconditionalDuration = bctbx_get_cur_time_ms() - start;
+	BC_ASSERT_EQUAL(evaluatedOperands, 2 * messageCount, int, "%d");
+
+	evaluatedOperands = 0;
+	start = bctbx_get_cur_time_ms();
+	for (int i = 0; i < messageCount; i++) {
+		lInfo() << "Chat message received from [" << countEvaluation(from) << "] to [" << countEvaluation(to) << "]";
+		lDebug() << "Chat message received from [" << countEvaluation(from) << "] to [" << countEvaluation(to) << "]";
+	}
+	const uint64_t gatedDuration = bctbx_get_cur_time_ms() - start;
+	BC_ASSERT_EQUAL(evaluatedOperands, 0, int, "%d");
+
+	ms_message("%d disabled log statements: %d ms when built unconditionally, %d ms when gated by level",
+		messageCount, (int)unconditionalDuration, (int)gatedDuration);
+
+	// Enabled levels still evaluate their operands.
+	lWarning() << "Disabled logs cost measured, last destination: " << countEvaluation(to);
+	BC_ASSERT_EQUAL(evaluatedOperands, 1, int, "%d");
+
+	bctbx_set_log_level_mask("liblinphone", (int)previousMask);
+}
+
+static void sharded_lru_cache () {
+	const int capacity = 160;
+	const int threadCount = 4;
+	const int keyCount = 2000;
+	ShardedLruCache<string, int> cache(capacity);
+
+	// Each thread looks up and inserts overlapping ranges of keys.
+	atomic<int> wrongValues(0);
+	vector<thread> threads;
+	for (int t = 0; t < threadCount; t++) {
+		threads.emplace_back([&cache, &wrongValues, t]() {
+			for (int i = 0; i < keyCount; i++) {
+				const string key = "sip:user" + to_string((i + t * keyCount / 2) % keyCount) + "@sip.example.org";
+				int found = -1;
+				if (!cache.find(key, [&found](int value) { found = value; }))
+					cache.insert(key, int(key.size()));
+				else if (found != int(key.size()))
+					wrongValues++;
+			}
+		});
+	}
+	for (thread &t : threads)
+		t.join();
+	BC_ASSERT_EQUAL(wrongValues.load(), 0, int, "%d");
+
+	BC_ASSERT_TRUE(cache.getSize() <= capacity);
+	LruCacheStats stats = cache.getStats();
+	BC_ASSERT_EQUAL((int)(stats.hits + stats.misses), threadCount * keyCount, int, "%d");
+	BC_ASSERT_TRUE(stats.evictions > 0);
+
+	cache.setCapacity(2 * capacity);
+	BC_ASSERT_EQUAL(cache.getSize(), 0, int, "%d");
+	BC_ASSERT_EQUAL(cache.getCapacity(), 2 * capacity, int, "%d");
+}
+
 test_t utils_tests[] = {
 	TEST_NO_TAG("split", split),
 	TEST_NO_TAG("trim", trim),
 	TEST_NO_TAG("Version comparisons", version_comparisons),
-	TEST_NO_TAG("Parse capabilities", parse_capabilities)
+	TEST_NO_TAG("Parse capabilities", parse_capabilities),
+	TEST_NO_TAG("Disabled logs cost", disabled_logs_cost),
+	TEST_NO_TAG("Sharded LRU cache", sharded_lru_cache)
 };
 
 test_suite_t utils_test_suite = {
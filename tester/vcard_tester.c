@@ -113,6 +113,71 @@ static void linphone_vcard_import_a_lot_of_friends_test(void) {
 	linphone_core_manager_destroy(manager);
 }
 
+typedef struct _LinphoneFriendListImportStats {
+	int progress_count;
+	int last_imported_count;
+	int last_total_count;
+} LinphoneFriendListImportStats;
+
+static void friend_list_import_progress(LinphoneFriendList *list, int imported_count, int total_count) {
+	LinphoneFriendListCbs *cbs = linphone_friend_list_get_current_callbacks(list);
+	LinphoneFriendListImportStats *stats = (LinphoneFriendListImportStats *)linphone_friend_list_cbs_get_user_data(cbs);
+	BC_ASSERT_GREATER(imported_count, stats->last_imported_count, int, "%d");
+	stats->progress_count++;
+	stats->last_imported_count = imported_count;
+	stats->last_total_count = total_count;
+}
+
+static void linphone_vcard_import_a_lot_of_friends_in_db_test(void) {
+	LinphoneCoreManager* manager = linphone_core_manager_new_with_proxies_check("empty_rc", FALSE);
+	LinphoneFriendList *lfl = NULL;
+	LinphoneFriendListCbs *cbs = NULL;
+	LinphoneFriendListImportStats stats = {0};
+	bctbx_list_t *friends_lists_from_db = NULL;
+	const bctbx_list_t *it;
+	unsigned int friends_in_db = 0;
+	char *import_filepath = bc_tester_res("vcards/thousand_vcards.vcf");
+	char *friends_db = bc_tester_file("friends.db");
+	clock_t start, end;
+
+	unlink(friends_db);
+	linphone_core_set_friends_database_path(manager->lc, friends_db);
+
+	lfl = linphone_core_create_friend_list(manager->lc);
+	linphone_friend_list_set_display_name(lfl, "Imported");
+	linphone_core_add_friend_list(manager->lc, lfl);
+	cbs = linphone_factory_create_friend_list_cbs(linphone_factory_get());
+	linphone_friend_list_cbs_set_user_data(cbs, &stats);
+	linphone_friend_list_cbs_set_import_progress(cbs, friend_list_import_progress);
+	linphone_friend_list_add_callbacks(lfl, cbs);
+	linphone_friend_list_cbs_unref(cbs);
+
+	start = clock();
+	BC_ASSERT_EQUAL(linphone_friend_list_import_friends_from_vcard4_file(lfl, import_filepath), 1000, int, "%d");
+	end = clock();
+	ms_message("Imported a thousand of vCards in database in %f seconds", (double)(end - start) / CLOCKS_PER_SEC);
+
+	BC_ASSERT_EQUAL(stats.progress_count, 10, int, "%d");
+	BC_ASSERT_EQUAL(stats.last_imported_count, 1000, int, "%d");
+	BC_ASSERT_EQUAL(stats.last_total_count, 1000, int, "%d");
+	BC_ASSERT_NOT_EQUAL(linphone_friend_get_storage_id((LinphoneFriend *)bctbx_list_get_data(linphone_friend_list_get_friends(lfl))), 0, unsigned int, "%u");
+
+	friends_lists_from_db = linphone_core_fetch_friends_lists_from_db(manager->lc);
+	for (it = friends_lists_from_db; it != NULL; it = bctbx_list_next(it)) {
+		LinphoneFriendList *list = (LinphoneFriendList *)bctbx_list_get_data(it);
+		if (linphone_friend_list_get_storage_id(list) == linphone_friend_list_get_storage_id(lfl))
+			friends_in_db = (unsigned int)bctbx_list_size(*linphone_friend_list_get_friends_attribute(list));
+	}
+	BC_ASSERT_EQUAL(friends_in_db, 1000, unsigned int, "%u");
+	friends_lists_from_db = bctbx_list_free_with_data(friends_lists_from_db, (void (*)(void *))linphone_friend_list_unref);
+
+	linphone_friend_list_unref(lfl);
+	unlink(friends_db);
+	bc_free(friends_db);
+	bc_free(import_filepath);
+	linphone_core_manager_destroy(manager);
+}
+
 #if __clang__ || ((__GNUC__ == 4 && __GNUC_MINOR__ >= 6) || __GNUC__ > 4)
 #pragma GCC diagnostic push
 #endif
@@ -1021,6 +1086,7 @@ end:
 test_t vcard_tests[] = {
 	TEST_NO_TAG("Import / Export friends from vCards", linphone_vcard_import_export_friends_test),
 	TEST_NO_TAG("Import a lot of friends from vCards", linphone_vcard_import_a_lot_of_friends_test),
+	TEST_NO_TAG("Import a lot of friends from vCards in database", linphone_vcard_import_a_lot_of_friends_in_db_test),
 	TEST_NO_TAG("vCard creation for existing friends", linphone_vcard_update_existing_friends_test),
 	TEST_NO_TAG("vCard phone numbers and SIP addresses", linphone_vcard_phone_numbers_and_sip_addresses),
 	TEST_NO_TAG("Friends working if no db set", friends_if_no_db_set),